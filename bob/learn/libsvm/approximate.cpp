@@ -0,0 +1,542 @@
+/**
+ * @date Wed 14 Oct 2026 18:24:07 CEST
+ *
+ * @brief Bindings for approximate kernel machines
+ *
+ * Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+ */
+
+#define BOB_LEARN_LIBSVM_MODULE
+#include <bob.blitz/cppapi.h>
+#include <bob.blitz/cleanup.h>
+#include <bob.io.base/api.h>
+#include <bob.learn.libsvm/api.h>
+
+/********************************************************
+ * Implementation of bob.learn.libsvm.ApproximateMachine *
+ ********************************************************/
+
+PyDoc_STRVAR(s_approx_str, BOB_EXT_MODULE_PREFIX ".ApproximateMachine");
+
+PyDoc_STRVAR(s_approx_doc,
+"ApproximateMachine(hdf5file)\n\
+\n\
+A linear classifier working on an explicit map of its inputs,\n\
+whose dot products approximate an RBF kernel: either random\n\
+Fourier features or a Nyström basis. Prediction costs depend on\n\
+the number of :py:attr:`components` of the map, instead of the\n\
+number of support vectors. Binary machines (labels +1 and -1)\n\
+produce a single score per input, positive for +1, while\n\
+multi-class machines produce one score per class, one-vs-rest.\n\
+\n\
+Such machines are created by :py:meth:`Trainer.train_approximate`\n\
+and can be saved to and reloaded from a\n\
+:py:class:`bob.io.base.HDF5File`, together with their map and\n\
+their scaling parameters.\n\
+\n\
+");
+
+static int PyBobLearnLibsvmApproximateMachine_init
+(PyBobLearnLibsvmApproximateMachineObject* self, PyObject* args,
+ PyObject* kwds) {
+
+  /* Parses input arguments in a single shot */
+  static const char* const_kwlist[] = {"config", 0};
+  static char** kwlist = const_cast<char**>(const_kwlist);
+
+  PyObject* config = 0;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!", kwlist,
+        &PyBobIoHDF5File_Type, &config)) return -1;
+
+  auto h5f = reinterpret_cast<PyBobIoHDF5FileObject*>(config);
+
+  try {
+    self->cxx = new bob::learn::libsvm::ApproximateMachine(*(h5f->f));
+  }
+  catch (std::exception& ex) {
+    PyErr_SetString(PyExc_RuntimeError, ex.what());
+    return -1;
+  }
+  catch (...) {
+    PyErr_Format(PyExc_RuntimeError, "cannot create new object of type `%s' - unknown exception thrown", Py_TYPE(self)->tp_name);
+    return -1;
+  }
+
+  return 0;
+
+}
+
+static void PyBobLearnLibsvmApproximateMachine_delete
+(PyBobLearnLibsvmApproximateMachineObject* self) {
+
+  delete self->cxx;
+  Py_TYPE(self)->tp_free((PyObject*)self);
+
+}
+
+PyDoc_STRVAR(s_shape_str, "shape");
+PyDoc_STRVAR(s_shape_doc,
+"A tuple with the size of the input vector, followed by the\n\
+number of scores per input, in the format ``(input, output)``.\n\
+");
+
+static PyObject* PyBobLearnLibsvmApproximateMachine_getShape
+(PyBobLearnLibsvmApproximateMachineObject* self, void* /*closure*/) {
+  return Py_BuildValue("(nn)", self->cxx->inputSize(),
+      self->cxx->outputSize());
+}
+
+PyDoc_STRVAR(s_labels_str, "labels");
+PyDoc_STRVAR(s_labels_doc, "The class labels this machine will output");
+
+static PyObject* PyBobLearnLibsvmApproximateMachine_getLabels
+(PyBobLearnLibsvmApproximateMachineObject* self, void* /*closure*/) {
+  PyObject* retval = PyList_New(self->cxx->numberOfClasses());
+  for (size_t k=0; k<self->cxx->numberOfClasses(); ++k) {
+    PyList_SET_ITEM(retval, k, Py_BuildValue("i", self->cxx->classLabel(k)));
+  }
+  return retval;
+}
+
+PyDoc_STRVAR(s_approximation_str, "approximation");
+PyDoc_STRVAR(s_approximation_doc,
+"The kernel map used by this machine, either ``'FOURIER'`` or\n\
+``'NYSTROM'``");
+
+static PyObject* PyBobLearnLibsvmApproximateMachine_getApproximation
+(PyBobLearnLibsvmApproximateMachineObject* self, void* /*closure*/) {
+  return PyBobLearnLibsvm_ApproximationAsString(self->cxx->map().approximation());
+}
+
+PyDoc_STRVAR(s_components_str, "components");
+PyDoc_STRVAR(s_components_doc,
+"The number of components of the kernel map");
+
+static PyObject* PyBobLearnLibsvmApproximateMachine_getComponents
+(PyBobLearnLibsvmApproximateMachineObject* self, void* /*closure*/) {
+  return Py_BuildValue("n", self->cxx->map().outputSize());
+}
+
+PyDoc_STRVAR(s_gamma_str, "gamma");
+PyDoc_STRVAR(s_gamma_doc,
+"The :math:`\\gamma` of the approximated RBF kernel");
+
+static PyObject* PyBobLearnLibsvmApproximateMachine_getGamma
+(PyBobLearnLibsvmApproximateMachineObject* self, void* /*closure*/) {
+  return Py_BuildValue("d", self->cxx->map().gamma());
+}
+
+PyDoc_STRVAR(s_input_subtract_str, "input_subtract");
+PyDoc_STRVAR(s_input_subtract_doc,
+"Input subtraction factor, applied before the kernel map, like\n\
+for :py:attr:`Machine.input_subtract`");
+
+static PyObject* PyBobLearnLibsvmApproximateMachine_getInputSubtraction
+(PyBobLearnLibsvmApproximateMachineObject* self, void* /*closure*/) {
+  return PyBlitzArray_NUMPY_WRAP(PyBlitzArrayCxx_NewFromConstArray(self->cxx->getInputSubtraction()));
+}
+
+static int PyBobLearnLibsvmApproximateMachine_setInputSubtraction
+(PyBobLearnLibsvmApproximateMachineObject* self, PyObject* o, void* /*closure*/) {
+
+  PyBlitzArrayObject* input_subtract = 0;
+  if (!PyBlitzArray_Converter(o, &input_subtract)) return -1;
+  auto input_subtract_ = make_safe(input_subtract);
+
+  if (input_subtract->type_num != NPY_FLOAT64 || input_subtract->ndim != 1) {
+    PyErr_Format(PyExc_TypeError, "`%s' only supports 64-bit floats 1D arrays for property array `input_subtract'", Py_TYPE(self)->tp_name);
+    return -1;
+  }
+
+  try {
+    self->cxx->setInputSubtraction(*PyBlitzArrayCxx_AsBlitz<double,1>(input_subtract));
+  }
+  catch (std::exception& ex) {
+    PyErr_SetString(PyExc_RuntimeError, ex.what());
+    return -1;
+  }
+  catch (...) {
+    PyErr_Format(PyExc_RuntimeError, "cannot reset `input_subtract' of %s: unknown exception caught", Py_TYPE(self)->tp_name);
+    return -1;
+  }
+
+  return 0;
+
+}
+
+PyDoc_STRVAR(s_input_divide_str, "input_divide");
+PyDoc_STRVAR(s_input_divide_doc,
+"Input division factor, applied after :py:attr:`input_subtract`\n\
+and before the kernel map, like for :py:attr:`Machine.input_divide`");
+
+static PyObject* PyBobLearnLibsvmApproximateMachine_getInputDivision
+(PyBobLearnLibsvmApproximateMachineObject* self, void* /*closure*/) {
+  return PyBlitzArray_NUMPY_WRAP(PyBlitzArrayCxx_NewFromConstArray(self->cxx->getInputDivision()));
+}
+
+static int PyBobLearnLibsvmApproximateMachine_setInputDivision
+(PyBobLearnLibsvmApproximateMachineObject* self, PyObject* o, void* /*closure*/) {
+
+  PyBlitzArrayObject* input_divide = 0;
+  if (!PyBlitzArray_Converter(o, &input_divide)) return -1;
+  auto input_divide_ = make_safe(input_divide);
+
+  if (input_divide->type_num != NPY_FLOAT64 || input_divide->ndim != 1) {
+    PyErr_Format(PyExc_TypeError, "`%s' only supports 64-bit floats 1D arrays for property array `input_divide'", Py_TYPE(self)->tp_name);
+    return -1;
+  }
+
+  try {
+    self->cxx->setInputDivision(*PyBlitzArrayCxx_AsBlitz<double,1>(input_divide));
+  }
+  catch (std::exception& ex) {
+    PyErr_SetString(PyExc_RuntimeError, ex.what());
+    return -1;
+  }
+  catch (...) {
+    PyErr_Format(PyExc_RuntimeError, "cannot reset `input_divide' of %s: unknown exception caught", Py_TYPE(self)->tp_name);
+    return -1;
+  }
+
+  return 0;
+
+}
+
+static PyGetSetDef PyBobLearnLibsvmApproximateMachine_getseters[] = {
+    {
+      s_shape_str,
+      (getter)PyBobLearnLibsvmApproximateMachine_getShape,
+      0,
+      s_shape_doc,
+      0
+    },
+    {
+      s_labels_str,
+      (getter)PyBobLearnLibsvmApproximateMachine_getLabels,
+      0,
+      s_labels_doc,
+      0
+    },
+    {
+      s_approximation_str,
+      (getter)PyBobLearnLibsvmApproximateMachine_getApproximation,
+      0,
+      s_approximation_doc,
+      0
+    },
+    {
+      s_components_str,
+      (getter)PyBobLearnLibsvmApproximateMachine_getComponents,
+      0,
+      s_components_doc,
+      0
+    },
+    {
+      s_gamma_str,
+      (getter)PyBobLearnLibsvmApproximateMachine_getGamma,
+      0,
+      s_gamma_doc,
+      0
+    },
+    {
+      s_input_subtract_str,
+      (getter)PyBobLearnLibsvmApproximateMachine_getInputSubtraction,
+      (setter)PyBobLearnLibsvmApproximateMachine_setInputSubtraction,
+      s_input_subtract_doc,
+      0
+    },
+    {
+      s_input_divide_str,
+      (getter)PyBobLearnLibsvmApproximateMachine_getInputDivision,
+      (setter)PyBobLearnLibsvmApproximateMachine_setInputDivision,
+      s_input_divide_doc,
+      0
+    },
+    {0}  /* Sentinel */
+};
+
+/**
+ * Predicts the classes (and scores, if ``scores`` is set) of a 1D or 2D
+ * array, allocating the outputs
+ */
+static PyObject* PyBobLearnLibsvmApproximateMachine_predict
+(PyBobLearnLibsvmApproximateMachineObject* self, PyObject* X,
+ Py_ssize_t threads, bool scores) {
+
+  if (threads < 0) {
+    PyErr_Format(PyExc_ValueError, "`%s' requires a non-negative number of `threads' (or zero, to use all available cores), not %" PY_FORMAT_SIZE_T "d", Py_TYPE(self)->tp_name, threads);
+    return 0;
+  }
+
+  PyBlitzArrayObject* input = 0;
+  if (!PyBlitzArray_Converter(X, &input)) return 0;
+  auto input_ = make_safe(input);
+
+  if (input->type_num != NPY_FLOAT64) {
+    PyErr_Format(PyExc_TypeError, "`%s' only supports 64-bit float arrays for input array `input'", Py_TYPE(self)->tp_name);
+    return 0;
+  }
+
+  if (input->ndim < 1 || input->ndim > 2) {
+    PyErr_Format(PyExc_TypeError, "`%s' only accepts 1 or 2-dimensional arrays (not %" PY_FORMAT_SIZE_T "dD arrays)", Py_TYPE(self)->tp_name, input->ndim);
+    return 0;
+  }
+
+  Py_ssize_t ndim = input->ndim;
+  Py_ssize_t columns = input->shape[ndim-1];
+  if (columns != (Py_ssize_t)self->cxx->inputSize()) {
+    PyErr_Format(PyExc_RuntimeError, "`input' array should have %" PY_FORMAT_SIZE_T "d columns, matching `%s' input size, not %" PY_FORMAT_SIZE_T "d", self->cxx->inputSize(), Py_TYPE(self)->tp_name, columns);
+    return 0;
+  }
+  Py_ssize_t rows = (ndim == 1) ? 1 : input->shape[0];
+
+  PyObject* cls = PyBlitzArray_SimpleNew(NPY_INT64, 1, &rows);
+  if (!cls) return 0;
+  auto cls_ = make_safe(cls);
+
+  Py_ssize_t osize[2] = {rows, (Py_ssize_t)self->cxx->outputSize()};
+  PyObject* score = PyBlitzArray_SimpleNew(NPY_FLOAT64, 2, osize);
+  if (!score) return 0;
+  auto score_ = make_safe(score);
+
+  try {
+    auto bzcls = PyBlitzArrayCxx_AsBlitz<int64_t,1>(reinterpret_cast<PyBlitzArrayObject*>(cls));
+    auto bzscore = PyBlitzArrayCxx_AsBlitz<double,2>(reinterpret_cast<PyBlitzArrayObject*>(score));
+    if (ndim == 1) {
+      blitz::Array<double,1> row((*bzscore)(0, blitz::Range::all()));
+      (*bzcls)(0) = self->cxx->predictClassAndScores(*PyBlitzArrayCxx_AsBlitz<double,1>(input), row);
+    }
+    else {
+      auto bzin = PyBlitzArrayCxx_AsBlitz<double,2>(input);
+      PyBobLearnLibsvmNoGIL nogil;
+      self->cxx->predictClassAndScores(*bzin, *bzcls, *bzscore, threads);
+    }
+  }
+  catch (std::exception& e) {
+    PyErr_SetString(PyExc_RuntimeError, e.what());
+    return 0;
+  }
+  catch (...) {
+    PyErr_Format(PyExc_RuntimeError, "%s cannot forward data: unknown exception caught", Py_TYPE(self)->tp_name);
+    return 0;
+  }
+
+  //1D inputs produce 1D scores
+  if (ndim == 1) {
+    Py_ssize_t k = self->cxx->outputSize();
+    PyObject* flat = PyBlitzArray_SimpleNew(NPY_FLOAT64, 1, &k);
+    if (!flat) return 0;
+    *PyBlitzArrayCxx_AsBlitz<double,1>(reinterpret_cast<PyBlitzArrayObject*>(flat)) = (*PyBlitzArrayCxx_AsBlitz<double,2>(reinterpret_cast<PyBlitzArrayObject*>(score)))(0, blitz::Range::all());
+    score_ = make_safe(flat);
+    score = flat;
+  }
+
+  if (!scores) {
+    Py_INCREF(cls);
+    return PyBlitzArray_NUMPY_WRAP(cls);
+  }
+
+  Py_INCREF(cls);
+  Py_INCREF(score);
+  return Py_BuildValue("OO",
+      PyBlitzArray_NUMPY_WRAP(cls),
+      PyBlitzArray_NUMPY_WRAP(score)
+      );
+
+}
+
+PyDoc_STRVAR(s_forward_str, "forward");
+PyDoc_STRVAR(s_forward_doc,
+"o.forward(input, [threads=1]) -> array\n\
+\n\
+o.predict_class(input, [threads=1]) -> array\n\
+\n\
+o(input, [threads=1]) -> array\n\
+\n\
+Calculates the **predicted class** of one single feature vector\n\
+or of multiple ones, returned in a 1D ``int64`` array.\n\
+\n\
+The ``input`` may be a 1D or 2D 64-bit float array. Rows are\n\
+scaled, mapped and scored in batches, split between ``threads``\n\
+workers (zero means one per core). The Python global\n\
+interpreter lock is released during the computation.\n\
+\n\
+");
+
+static PyObject* PyBobLearnLibsvmApproximateMachine_forward
+(PyBobLearnLibsvmApproximateMachineObject* self, PyObject* args,
+ PyObject* kwds) {
+
+  static const char* const_kwlist[] = {"input", "threads", 0};
+  static char** kwlist = const_cast<char**>(const_kwlist);
+
+  PyObject* X = 0;
+  Py_ssize_t threads = 1;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|n", kwlist,
+        &X, &threads)) return 0;
+
+  return PyBobLearnLibsvmApproximateMachine_predict(self, X, threads, false);
+
+}
+
+PyDoc_STRVAR(s_scores_str, "predict_class_and_scores");
+PyDoc_STRVAR(s_scores_doc,
+"o.predict_class_and_scores(input, [threads=1]) -> (array, array)\n\
+\n\
+Calculates the **predicted class** and the scores, given one\n\
+single feature vector or multiple ones. Returns a tuple with the\n\
+predicted classes, in a 1D ``int64`` array, and the scores, in a\n\
+``float64`` array with one column per score (1D if ``input`` is\n\
+1D): a single one for binary machines, positive for the first\n\
+label, otherwise one per class, in the order of\n\
+:py:attr:`labels`. Inputs and ``threads`` are like for\n\
+:py:meth:`forward`.\n\
+\n\
+");
+
+static PyObject* PyBobLearnLibsvmApproximateMachine_predictClassAndScores
+(PyBobLearnLibsvmApproximateMachineObject* self, PyObject* args,
+ PyObject* kwds) {
+
+  static const char* const_kwlist[] = {"input", "threads", 0};
+  static char** kwlist = const_cast<char**>(const_kwlist);
+
+  PyObject* X = 0;
+  Py_ssize_t threads = 1;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|n", kwlist,
+        &X, &threads)) return 0;
+
+  return PyBobLearnLibsvmApproximateMachine_predict(self, X, threads, true);
+
+}
+
+PyDoc_STRVAR(s_save_str, "save");
+PyDoc_STRVAR(s_save_doc,
+"o.save(hdf5file) -> None\n\
+\n\
+Saves itself into a :py:class:`bob.io.base.HDF5File`: the class\n\
+labels, the weights and the scaling parameters go to the current\n\
+group and the kernel map to a sub-group called ``map``.\n\
+");
+
+static PyObject* PyBobLearnLibsvmApproximateMachine_Save
+(PyBobLearnLibsvmApproximateMachineObject* self, PyObject* f) {
+
+  if (!PyBobIoHDF5File_Check(f)) {
+    PyErr_Format(PyExc_TypeError, "`%s' can only save to HDF5 files, not to objects of type `%s'", Py_TYPE(self)->tp_name, Py_TYPE(f)->tp_name);
+    return 0;
+  }
+
+  auto h5f = reinterpret_cast<PyBobIoHDF5FileObject*>(f);
+  try {
+    self->cxx->save(*h5f->f);
+  }
+  catch (std::exception& e) {
+    PyErr_SetString(PyExc_RuntimeError, e.what());
+    return 0;
+  }
+  catch (...) {
+    PyErr_Format(PyExc_RuntimeError, "`%s' cannot write data to file `%s' (at group `%s'): unknown exception caught", Py_TYPE(self)->tp_name,
+        h5f->f->filename().c_str(), h5f->f->cwd().c_str());
+    return 0;
+  }
+
+  Py_RETURN_NONE;
+
+}
+
+static PyMethodDef PyBobLearnLibsvmApproximateMachine_methods[] = {
+  {
+    s_forward_str,
+    (PyCFunction)PyBobLearnLibsvmApproximateMachine_forward,
+    METH_VARARGS|METH_KEYWORDS,
+    s_forward_doc
+  },
+  {
+    "predict_class",
+    (PyCFunction)PyBobLearnLibsvmApproximateMachine_forward,
+    METH_VARARGS|METH_KEYWORDS,
+    s_forward_doc
+  },
+  {
+    s_scores_str,
+    (PyCFunction)PyBobLearnLibsvmApproximateMachine_predictClassAndScores,
+    METH_VARARGS|METH_KEYWORDS,
+    s_scores_doc,
+  },
+  {
+    s_save_str,
+    (PyCFunction)PyBobLearnLibsvmApproximateMachine_Save,
+    METH_O,
+    s_save_doc
+  },
+  {0} /* Sentinel */
+};
+
+static PyObject* PyBobLearnLibsvmApproximateMachine_new
+(PyTypeObject* type, PyObject*, PyObject*) {
+
+  /* Allocates the python object itself */
+  PyBobLearnLibsvmApproximateMachineObject* self =
+    (PyBobLearnLibsvmApproximateMachineObject*)type->tp_alloc(type, 0);
+
+  self->cxx = 0;
+
+  return reinterpret_cast<PyObject*>(self);
+
+}
+
+PyObject* PyBobLearnLibsvmApproximateMachine_NewFromMachine
+(bob::learn::libsvm::ApproximateMachine* m) {
+
+  PyBobLearnLibsvmApproximateMachineObject* retval = (PyBobLearnLibsvmApproximateMachineObject*)PyBobLearnLibsvmApproximateMachine_new(&PyBobLearnLibsvmApproximateMachine_Type, 0, 0);
+
+  retval->cxx = m; ///< takes ownership
+
+  return reinterpret_cast<PyObject*>(retval);
+
+}
+
+PyTypeObject PyBobLearnLibsvmApproximateMachine_Type = {
+    PyVarObject_HEAD_INIT(0, 0)
+    s_approx_str,                                     /* tp_name */
+    sizeof(PyBobLearnLibsvmApproximateMachineObject), /* tp_basicsize */
+    0,                                                /* tp_itemsize */
+    (destructor)PyBobLearnLibsvmApproximateMachine_delete, /* tp_dealloc */
+    0,                                                /* tp_print */
+    0,                                                /* tp_getattr */
+    0,                                                /* tp_setattr */
+    0,                                                /* tp_compare */
+    0,                                                /* tp_repr */
+    0,                                                /* tp_as_number */
+    0,                                                /* tp_as_sequence */
+    0,                                                /* tp_as_mapping */
+    0,                                                /* tp_hash */
+    (ternaryfunc)PyBobLearnLibsvmApproximateMachine_forward, /* tp_call */
+    0,                                                /* tp_str */
+    0,                                                /* tp_getattro */
+    0,                                                /* tp_setattro */
+    0,                                                /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,         /* tp_flags */
+    s_approx_doc,                                     /* tp_doc */
+    0,                                                /* tp_traverse */
+    0,                                                /* tp_clear */
+    0,                                                /* tp_richcompare */
+    0,                                                /* tp_weaklistoffset */
+    0,                                                /* tp_iter */
+    0,                                                /* tp_iternext */
+    PyBobLearnLibsvmApproximateMachine_methods,       /* tp_methods */
+    0,                                                /* tp_members */
+    PyBobLearnLibsvmApproximateMachine_getseters,     /* tp_getset */
+    0,                                                /* tp_base */
+    0,                                                /* tp_dict */
+    0,                                                /* tp_descr_get */
+    0,                                                /* tp_descr_set */
+    0,                                                /* tp_dictoffset */
+    (initproc)PyBobLearnLibsvmApproximateMachine_init, /* tp_init */
+    0,                                                /* tp_alloc */
+    PyBobLearnLibsvmApproximateMachine_new,           /* tp_new */
+};
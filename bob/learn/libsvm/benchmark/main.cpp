@@ -0,0 +1,449 @@
+/**
+ * @date Thu 15 Oct 2026 10:02:53 CEST
+ *
+ * @brief Benchmarks for predictions, training and I/O of bob.learn.libsvm
+ *
+ * Runs each benchmark on synthetic data, repeating it until it has run at
+ * least ``--repeat`` times and for at least ``--min-time`` seconds, and
+ * prints one result per line, as JSON (default) or as tab-separated values.
+ * Timings are given in seconds and throughputs in items (samples) per
+ * second, computed from the median timing.
+ *
+ * Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+ */
+
+#include <bob.learn.libsvm/machine.h>
+#include <bob.learn.libsvm/trainer.h>
+#include <bob.learn.libsvm/file.h>
+#include <bob.io.base/HDF5File.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/format.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/scoped_ptr.hpp>
+
+namespace svm = bob::learn::libsvm;
+
+/**
+ * Command line options
+ */
+struct options {
+  std::string filter; ///< only run benchmarks whose name contains this
+  double min_time; ///< minimum time to spend on each benchmark, in seconds
+  size_t repeat; ///< minimum number of timed runs of each benchmark
+  double scale; ///< multiplies all dataset sizes
+  size_t threads; ///< workers for batch predictions, training and parsing
+  bool tsv; ///< prints tab-separated values instead of JSON
+  unsigned seed; ///< seed for the synthetic datasets
+
+  options(): min_time(0.5), repeat(5), scale(1.), threads(1), tsv(false),
+    seed(0) {}
+};
+
+/**
+ * Benchmark parameters, as (key, value) pairs. Values are stored already
+ * formatted for JSON output.
+ */
+typedef std::vector<std::pair<std::string, std::string> > params_t;
+
+static std::pair<std::string, std::string> param(const std::string& key,
+    size_t value) {
+  return std::make_pair(key, (boost::format("%d") % value).str());
+}
+
+static std::pair<std::string, std::string> param(const std::string& key,
+    const std::string& value) {
+  return std::make_pair(key, "\"" + value + "\"");
+}
+
+static const char* kernel_name(svm::kernel_t kernel) {
+  switch (kernel) {
+    case svm::LINEAR: return "linear";
+    case svm::POLY: return "poly";
+    case svm::RBF: return "rbf";
+    case svm::SIGMOID: return "sigmoid";
+    default: return "precomputed";
+  }
+}
+
+static const char* engine_name(svm::engine_t engine) {
+  switch (engine) {
+    case svm::DENSE_ENGINE: return "dense";
+    case svm::DENSE_SINGLE_ENGINE: return "dense32";
+    default: return "libsvm";
+  }
+}
+
+/**
+ * Times ``body`` and prints the results. ``items`` is the number of samples
+ * processed by each call to ``body``.
+ */
+static void run(const options& opt, const std::string& name,
+    const params_t& params, size_t items, const std::function<void()>& body) {
+
+  if (name.find(opt.filter) == std::string::npos) return;
+
+  typedef std::chrono::steady_clock clock;
+
+  body(); ///< warm up caches, pages and lazy initializations
+
+  std::vector<double> times;
+  double total = 0.;
+  while (times.size() < opt.repeat || (total < opt.min_time &&
+        times.size() < 1000)) {
+    clock::time_point start = clock::now();
+    body();
+    double elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    times.push_back(elapsed);
+    total += elapsed;
+  }
+
+  std::sort(times.begin(), times.end());
+  double median = times[times.size()/2];
+  if (times.size() % 2 == 0)
+    median = (median + times[times.size()/2-1]) / 2.;
+
+  if (opt.tsv) {
+    std::cout << name;
+    for (size_t k=0; k<params.size(); ++k) {
+      std::string value = params[k].second;
+      value.erase(std::remove(value.begin(), value.end(), '"'), value.end());
+      std::cout << '\t' << params[k].first << '=' << value;
+    }
+    std::cout << boost::format("\t%d\t%.9g\t%.9g\t%.9g\t%.9g")
+      % times.size() % times.front() % median % (total/times.size())
+      % (items/median) << std::endl;
+    return;
+  }
+
+  std::cout << "{\"benchmark\": \"" << name << "\", \"params\": {";
+  for (size_t k=0; k<params.size(); ++k) {
+    if (k) std::cout << ", ";
+    std::cout << '"' << params[k].first << "\": " << params[k].second;
+  }
+  std::cout << boost::format("}, \"items\": %d, \"repeats\": %d, \"min\": %.9g, \"median\": %.9g, \"mean\": %.9g, \"items_per_second\": %.9g}")
+    % items % times.size() % times.front() % median % (total/times.size())
+    % (items/median) << std::endl;
+}
+
+/**
+ * Generates ``classes`` Gaussian blobs of ``samples`` samples each, with
+ * ``features`` features. Each feature is zeroed with probability
+ * ``1-density``, to produce sparse data.
+ */
+static std::vector<blitz::Array<double,2> > make_classes(size_t classes,
+    size_t samples, size_t features, double density, unsigned seed) {
+
+  std::mt19937 rng(seed);
+  std::normal_distribution<double> normal(0., 1.);
+  std::uniform_real_distribution<double> uniform(0., 1.);
+
+  std::vector<blitz::Array<double,2> > retval;
+  for (size_t c=0; c<classes; ++c) {
+    std::vector<double> center(features);
+    for (size_t i=0; i<features; ++i) center[i] = normal(rng);
+    blitz::Array<double,2> data(samples, features);
+    for (size_t k=0; k<samples; ++k) {
+      for (size_t i=0; i<features; ++i) {
+        if (uniform(rng) >= density) data(k,i) = 0.;
+        else data(k,i) = (center[i] + normal(rng)) / 4.;
+      }
+    }
+    retval.push_back(data);
+  }
+  return retval;
+}
+
+/**
+ * Stacks all classes into a single array, in order
+ */
+static blitz::Array<double,2> stack(
+    const std::vector<blitz::Array<double,2> >& data) {
+  int rows = 0;
+  for (size_t c=0; c<data.size(); ++c) rows += data[c].extent(0);
+  blitz::Array<double,2> retval(rows, data[0].extent(1));
+  int row = 0;
+  for (size_t c=0; c<data.size(); ++c) {
+    retval(blitz::Range(row, row + data[c].extent(0) - 1), blitz::Range::all()) = data[c];
+    row += data[c].extent(0);
+  }
+  return retval;
+}
+
+/**
+ * Writes all classes into a libsvm data file, with labels 1, 2, 3, ...
+ */
+static void write_file(const std::string& filename,
+    const std::vector<blitz::Array<double,2> >& data) {
+  std::ofstream out(filename.c_str());
+  out.precision(17);
+  for (size_t c=0; c<data.size(); ++c) {
+    for (int k=0; k<data[c].extent(0); ++k) {
+      out << (c+1);
+      for (int i=0; i<data[c].extent(1); ++i)
+        if (data[c](k,i)) out << ' ' << (i+1) << ':' << data[c](k,i);
+      out << '\n';
+    }
+  }
+  if (!out) {
+    boost::format m("cannot write benchmark data to '%s'");
+    m % filename;
+    throw std::runtime_error(m.str());
+  }
+}
+
+static size_t support_vectors(const svm::Machine& machine) {
+  size_t retval = 0;
+  for (size_t k=0; k<machine.numberOfClasses(); ++k)
+    retval += machine.classNSupportVectors(k);
+  return retval;
+}
+
+static size_t scaled(const options& opt, size_t n) {
+  return std::max<size_t>(1, n * opt.scale);
+}
+
+static void predict_benchmarks(const options& opt) {
+
+  static const size_t FEATURES = 32;
+  static const size_t CLASSES = 3;
+
+  std::vector<blitz::Array<double,2> > train = make_classes(CLASSES,
+      scaled(opt, 300), FEATURES, 1., opt.seed);
+  blitz::Array<double,2> test = stack(make_classes(CLASSES,
+        scaled(opt, 1000), FEATURES, 1., opt.seed + 1));
+  size_t n = test.extent(0);
+
+  // rows are sliced once, so that views are not timed
+  std::vector<blitz::Array<double,1> > rows;
+  for (size_t k=0; k<n; ++k)
+    rows.push_back(test(k, blitz::Range::all()));
+
+  svm::kernel_t kernels[] = {svm::LINEAR, svm::POLY, svm::RBF, svm::SIGMOID};
+  svm::engine_t engines[] = {svm::LIBSVM_ENGINE, svm::DENSE_ENGINE,
+    svm::DENSE_SINGLE_ENGINE};
+
+  for (size_t k=0; k<4; ++k) {
+    svm::Trainer trainer(svm::C_SVC, kernels[k]);
+    trainer.setProbabilityEstimates(kernels[k] == svm::RBF);
+    boost::scoped_ptr<svm::Machine> machine(trainer.train(train, opt.threads));
+
+    for (size_t e=0; e<3; ++e) {
+      machine->setEngine(engines[e]);
+      if (machine->engine() != engines[e]) continue; ///< not suitable
+
+      params_t params;
+      params.push_back(param("kernel", kernel_name(kernels[k])));
+      params.push_back(param("engine", engine_name(engines[e])));
+      params.push_back(param("support_vectors", support_vectors(*machine)));
+      params.push_back(param("features", FEATURES));
+      params.push_back(param("classes", CLASSES));
+
+      svm::Machine::Workspace ws;
+      run(opt, "predict_class_single", params, n, [&]() {
+        for (size_t i=0; i<n; ++i) machine->predictClass_(rows[i], ws);
+      });
+
+      params.push_back(param("threads", opt.threads));
+      blitz::Array<int64_t,1> labels(n);
+      run(opt, "predict_class_batch", params, n, [&]() {
+        machine->predictClass_(test, labels, opt.threads);
+      });
+
+      size_t outputs = machine->outputSize();
+      blitz::Array<double,2> scores(n, outputs < 2 ? 1 : outputs*(outputs-1)/2);
+      run(opt, "predict_scores_batch", params, n, [&]() {
+        machine->predictClassAndScores_(test, labels, scores, opt.threads);
+      });
+
+      if (!machine->supportsProbability()) continue;
+      blitz::Array<double,2> probabilities(n, machine->numberOfClasses());
+      run(opt, "predict_probabilities_batch", params, n, [&]() {
+        machine->predictClassAndProbabilities_(test, labels, probabilities,
+            opt.threads);
+      });
+    }
+  }
+}
+
+static void train_benchmarks(const options& opt) {
+
+  static const size_t FEATURES = 32;
+  static const size_t CLASSES = 2;
+
+  svm::kernel_t kernels[] = {svm::LINEAR, svm::RBF};
+  size_t samples[] = {250, 1000, 2500}; ///< per class
+  double cache_sizes[] = {1., 100.}; ///< in megabytes
+
+  for (size_t s=0; s<3; ++s) {
+    std::vector<blitz::Array<double,2> > data = make_classes(CLASSES,
+        scaled(opt, samples[s]), FEATURES, 1., opt.seed);
+    for (size_t k=0; k<2; ++k) {
+      for (size_t c=0; c<2; ++c) {
+        svm::Trainer trainer(svm::C_SVC, kernels[k], cache_sizes[c]);
+        params_t params;
+        params.push_back(param("kernel", kernel_name(kernels[k])));
+        params.push_back(param("samples", CLASSES * data[0].extent(0)));
+        params.push_back(param("features", FEATURES));
+        params.push_back(param("cache_mb", (size_t)cache_sizes[c]));
+        params.push_back(param("threads", opt.threads));
+        run(opt, "train", params, CLASSES * data[0].extent(0), [&]() {
+          boost::scoped_ptr<svm::Machine> machine(trainer.train(data,
+                opt.threads));
+        });
+      }
+    }
+  }
+}
+
+static void file_benchmarks(const options& opt, std::vector<std::string>& temporaries) {
+
+  struct { const char* name; size_t features; double density; } kinds[] = {
+    {"dense", 64, 1.},
+    {"sparse", 2000, 0.02},
+  };
+
+  for (size_t d=0; d<2; ++d) {
+    std::string filename = svm::_tmpfile(".svmdata");
+    temporaries.push_back(filename);
+    write_file(filename, make_classes(2, scaled(opt, 10000),
+          kinds[d].features, kinds[d].density, opt.seed));
+
+    svm::File file(filename);
+    size_t n = file.samples();
+
+    params_t params;
+    params.push_back(param("data", kinds[d].name));
+    params.push_back(param("features", file.shape()));
+    params.push_back(param("non_zeros", file.nonZeros()));
+    params.push_back(param("bytes", (size_t)boost::filesystem::file_size(filename)));
+
+    run(opt, "file_open", params, n, [&]() { svm::File f(filename); });
+
+    params.push_back(param("threads", opt.threads));
+
+    blitz::Array<int64_t,1> labels(n);
+    if (kinds[d].density == 1.) {
+      blitz::Array<double,2> values(n, file.shape());
+      run(opt, "file_read_all", params, n, [&]() {
+        file.readAll(labels, values, opt.threads);
+      });
+    }
+
+    blitz::Array<int64_t,1> indptr(n+1);
+    blitz::Array<int64_t,1> indices(file.nonZeros());
+    blitz::Array<double,1> values(file.nonZeros());
+    run(opt, "file_read_csr", params, n, [&]() {
+      file.readCSR(labels, indptr, indices, values, opt.threads);
+    });
+  }
+}
+
+static void model_benchmarks(const options& opt, std::vector<std::string>& temporaries) {
+
+  std::vector<blitz::Array<double,2> > data = make_classes(2,
+      scaled(opt, 2500), 32, 1., opt.seed);
+  svm::Trainer trainer;
+  trainer.setCost(0.1); ///< lots of support vectors
+  boost::scoped_ptr<svm::Machine> machine(trainer.train(data, opt.threads));
+
+  std::string hdf5 = svm::_tmpfile(".hdf5");
+  std::string binary = svm::_tmpfile(".bin");
+  temporaries.push_back(hdf5);
+  temporaries.push_back(binary);
+
+  params_t params;
+  params.push_back(param("support_vectors", support_vectors(*machine)));
+  params.push_back(param("features", machine->inputSize()));
+
+  run(opt, "model_hdf5_save", params, 1, [&]() {
+    bob::io::base::HDF5File f(hdf5, bob::io::base::HDF5File::trunc);
+    machine->save(f);
+  });
+
+  run(opt, "model_hdf5_load", params, 1, [&]() {
+    bob::io::base::HDF5File f(hdf5, bob::io::base::HDF5File::in);
+    svm::Machine m(f);
+  });
+
+  blitz::Array<uint8_t,1> buffer;
+  {
+    bob::io::base::HDF5File f(hdf5, bob::io::base::HDF5File::in);
+    buffer.reference(f.readArray<uint8_t,1>("svm_model"));
+  }
+  boost::shared_ptr<svm_model> model = svm::svm_unpickle(buffer);
+  params.push_back(param("bytes", buffer.extent(0)));
+
+  run(opt, "model_pickle", params, 1, [&]() { svm::svm_pickle(model); });
+  run(opt, "model_unpickle", params, 1, [&]() { svm::svm_unpickle(buffer); });
+
+  machine->saveBinary(binary);
+  run(opt, "model_binary_load", params, 1, [&]() { svm::Machine m(binary); });
+}
+
+static void usage(const char* program) {
+  std::cout << "usage: " << program << " [options]" << std::endl
+    << std::endl
+    << "Benchmarks predictions, training and I/O of bob.learn.libsvm on synthetic" << std::endl
+    << "data. Prints one JSON object per benchmark, on its own line." << std::endl
+    << std::endl
+    << "options:" << std::endl
+    << "  --filter NAME    only runs benchmarks whose name contains NAME" << std::endl
+    << "  --min-time SECS  minimum time spent on each benchmark (default: 0.5)" << std::endl
+    << "  --repeat N       minimum number of runs of each benchmark (default: 5)" << std::endl
+    << "  --scale X        multiplies the size of all datasets (default: 1)" << std::endl
+    << "  --threads N      threads for batch operations, 0 for all (default: 1)" << std::endl
+    << "  --seed N         seed for the synthetic datasets (default: 0)" << std::endl
+    << "  --tsv            prints tab-separated values: name, parameters, repeats," << std::endl
+    << "                   min, median and mean times and items per second" << std::endl;
+}
+
+int main(int argc, char** argv) {
+
+  options opt;
+  for (int k=1; k<argc; ++k) {
+    std::string arg = argv[k];
+    bool has_value = (k+1 < argc);
+    if (arg == "--help" || arg == "-h") { usage(argv[0]); return 0; }
+    else if (arg == "--tsv") opt.tsv = true;
+    else if (arg == "--filter" && has_value) opt.filter = argv[++k];
+    else if (arg == "--min-time" && has_value) opt.min_time = std::atof(argv[++k]);
+    else if (arg == "--repeat" && has_value) opt.repeat = std::max(1, std::atoi(argv[++k]));
+    else if (arg == "--scale" && has_value) opt.scale = std::atof(argv[++k]);
+    else if (arg == "--threads" && has_value) opt.threads = std::max(0, std::atoi(argv[++k]));
+    else if (arg == "--seed" && has_value) opt.seed = std::atoi(argv[++k]);
+    else {
+      std::cerr << "invalid argument `" << arg << "'" << std::endl;
+      usage(argv[0]);
+      return 2;
+    }
+  }
+
+  std::vector<std::string> temporaries;
+  int retval = 0;
+
+  try {
+    predict_benchmarks(opt);
+    train_benchmarks(opt);
+    file_benchmarks(opt, temporaries);
+    model_benchmarks(opt, temporaries);
+  }
+  catch (std::exception& e) {
+    std::cerr << "benchmark failed: " << e.what() << std::endl;
+    retval = 1;
+  }
+
+  for (size_t k=0; k<temporaries.size(); ++k)
+    boost::filesystem::remove(temporaries[k]);
+
+  return retval;
+}
@@ -0,0 +1,523 @@
+/**
+ * @date Wed 14 Oct 2026 18:24:07 CEST
+ *
+ * @brief Implementation of approximate kernel maps and of the linear
+ * machines using them
+ *
+ * Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+ */
+
+#include <bob.learn.libsvm/approximate.h>
+#include <bob.learn.libsvm/parallel.h>
+
+#include <cmath>
+#include <algorithm>
+#include <boost/format.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <boost/random/uniform_real_distribution.hpp>
+#include <bob.core/array_copy.h>
+
+/**
+ * Number of doubles rows are padded to, so that all rows stay aligned
+ */
+static const size_t PADDING =
+  bob::learn::libsvm::ENGINE_ALIGNMENT / sizeof(double);
+
+/**
+ * Number of inputs mapped and scored at once, during batch predictions
+ */
+static const size_t MAP_BATCH = 64;
+
+/**
+ * Relative size under which pivots of the Cholesky factorization of the
+ * landmark kernel matrix are considered to be zero: the matching landmarks
+ * are (almost) combinations of the previous ones and are not used
+ */
+static const double NYSTROM_TOLERANCE = 1e-10;
+
+static size_t padded(size_t n) {
+  return ((n + PADDING - 1) / PADDING) * PADDING;
+}
+
+bob::learn::libsvm::KernelMap::KernelMap(approximation_t approximation,
+    size_t input_size, size_t components, double gamma):
+  m_approximation(approximation),
+  m_gamma(gamma),
+  m_input_size(input_size),
+  m_output_size(components),
+  m_padded_input(padded(input_size)),
+  m_padded_output(padded(components))
+{
+  if (!input_size || !components) {
+    boost::format m("kernel maps require, at least, one input and one component, but %d inputs and %d components were asked for");
+    m % input_size % components;
+    throw std::runtime_error(m.str());
+  }
+  if (gamma <= 0.) {
+    boost::format m("kernel maps require a positive gamma, not %g");
+    m % gamma;
+    throw std::runtime_error(m.str());
+  }
+  m_isa = DenseEngine::kernels(m_dot, m_gemm);
+}
+
+boost::shared_ptr<bob::learn::libsvm::KernelMap>
+bob::learn::libsvm::KernelMap::fourier(size_t input_size, size_t components,
+    double gamma, uint32_t seed) {
+
+  boost::shared_ptr<KernelMap> retval(new KernelMap(FOURIER, input_size,
+        components, gamma));
+
+  //the Fourier transform of exp(-gamma*||d||^2) is a normal distribution
+  //with variance 2*gamma in each direction
+  boost::random::mt19937 generator(seed);
+  boost::random::normal_distribution<double> normal(0., std::sqrt(2.*gamma));
+  boost::random::uniform_real_distribution<double> phase(0., 2.*M_PI);
+
+  blitz::Array<double,2> basis(components, input_size);
+  retval->m_offset.resize(components);
+  for (size_t i=0; i<components; ++i) {
+    for (size_t j=0; j<input_size; ++j) basis(i,j) = normal(generator);
+    retval->m_offset[i] = phase(generator);
+  }
+  retval->setBasis(basis);
+  return retval;
+
+}
+
+boost::shared_ptr<bob::learn::libsvm::KernelMap>
+bob::learn::libsvm::KernelMap::nystrom
+(const blitz::Array<double,2>& landmarks, double gamma) {
+  boost::shared_ptr<KernelMap> retval(new KernelMap(NYSTROM,
+        landmarks.extent(1), landmarks.extent(0), gamma));
+  retval->setBasis(landmarks);
+  retval->factorize();
+  return retval;
+}
+
+bob::learn::libsvm::KernelMap::KernelMap(bob::io::base::HDF5File& config) {
+
+  std::string approximation = config.read<std::string>("approximation");
+  if (approximation == "fourier") m_approximation = FOURIER;
+  else if (approximation == "nystrom") m_approximation = NYSTROM;
+  else {
+    boost::format m("unknown kernel map `%s' at `%s:%s'");
+    m % approximation % config.filename() % config.cwd();
+    throw std::runtime_error(m.str());
+  }
+
+  m_gamma = config.read<double>("gamma");
+  blitz::Array<double,2> basis = config.readArray<double,2>("basis");
+  m_input_size = basis.extent(1);
+  m_output_size = basis.extent(0);
+  m_padded_input = padded(m_input_size);
+  m_padded_output = padded(m_output_size);
+  m_isa = DenseEngine::kernels(m_dot, m_gemm);
+
+  setBasis(basis);
+  if (m_approximation == FOURIER) {
+    blitz::Array<double,1> offset = config.readArray<double,1>("offset");
+    if ((size_t)offset.extent(0) != m_output_size) {
+      boost::format m("kernel map at `%s:%s' has %d components, but %d offsets");
+      m % config.filename() % config.cwd() % m_output_size % offset.extent(0);
+      throw std::runtime_error(m.str());
+    }
+    m_offset.resize(m_output_size);
+    for (size_t i=0; i<m_output_size; ++i) m_offset[i] = offset(i);
+  }
+  else factorize();
+
+}
+
+void bob::learn::libsvm::KernelMap::setBasis
+(const blitz::Array<double,2>& basis) {
+  m_basis.assign(m_output_size * m_padded_input, 0.);
+  for (size_t i=0; i<m_output_size; ++i)
+    for (size_t j=0; j<m_input_size; ++j)
+      m_basis[i*m_padded_input + j] = basis(i,j);
+}
+
+void bob::learn::libsvm::KernelMap::factorize() {
+
+  size_t d = m_output_size;
+  size_t p = m_padded_input;
+
+  m_basis_norm.resize(d);
+  for (size_t i=0; i<d; ++i) m_dot(&m_basis[i*p], &m_basis[i*p], 1, p,
+      &m_basis_norm[i]);
+
+  //kernel matrix of the landmarks, with exact squared distances
+  std::vector<double> L(d * d, 0.);
+  for (size_t i=0; i<d; ++i) {
+    for (size_t j=0; j<=i; ++j) {
+      double sum = 0.;
+      for (size_t k=0; k<m_input_size; ++k) {
+        double diff = m_basis[i*p + k] - m_basis[j*p + k];
+        sum += diff * diff;
+      }
+      L[i*d + j] = std::exp(-m_gamma * sum);
+    }
+  }
+
+  //in-place Cholesky factorization, lower triangle: landmarks whose pivot
+  //vanishes get a zero column and are ignored from there on
+  std::vector<bool> used(d, true);
+  for (size_t j=0; j<d; ++j) {
+    double pivot = L[j*d + j];
+    for (size_t k=0; k<j; ++k) pivot -= L[j*d + k] * L[j*d + k];
+    if (pivot <= NYSTROM_TOLERANCE) {
+      used[j] = false;
+      for (size_t i=j; i<d; ++i) L[i*d + j] = 0.;
+      continue;
+    }
+    pivot = std::sqrt(pivot);
+    L[j*d + j] = pivot;
+    for (size_t i=j+1; i<d; ++i) {
+      double sum = L[i*d + j];
+      for (size_t k=0; k<j; ++k) sum -= L[i*d + k] * L[j*d + k];
+      L[i*d + j] = sum / pivot;
+    }
+  }
+
+  //inverse of the factor, by forward substitution, one column at a time
+  size_t q = m_padded_output;
+  m_transform.assign(d * q, 0.);
+  for (size_t c=0; c<d; ++c) {
+    if (!used[c]) continue;
+    m_transform[c*q + c] = 1. / L[c*d + c];
+    for (size_t i=c+1; i<d; ++i) {
+      if (!used[i]) continue;
+      double sum = 0.;
+      for (size_t k=c; k<i; ++k) sum += L[i*d + k] * m_transform[k*q + c];
+      m_transform[i*q + c] = -sum / L[i*d + i];
+    }
+  }
+
+}
+
+size_t bob::learn::libsvm::KernelMap::workspaceSize(size_t n) const {
+  return 2 * n * m_padded_output;
+}
+
+void bob::learn::libsvm::KernelMap::map(const double* input, size_t n,
+    double* output, double* work) const {
+
+  size_t d = m_output_size;
+  size_t q = m_padded_output;
+
+  //dot products with all projections (or landmarks), n rows of d values
+  double* products = work;
+  m_gemm(input, n, &m_basis[0], d, m_padded_input, products);
+
+  if (m_approximation == FOURIER) {
+    double scale = std::sqrt(2. / d);
+    for (size_t i=0; i<n; ++i) {
+      const double* in = products + i*d;
+      double* out = output + i*q;
+      for (size_t j=0; j<d; ++j) out[j] = scale * std::cos(in[j] + m_offset[j]);
+      std::fill(out + d, out + q, 0.);
+    }
+    return;
+  }
+
+  //Nyström: kernel values with the landmarks, then the transform
+  double* kvalue = work + n*q;
+  for (size_t i=0; i<n; ++i) {
+    double norm;
+    const double* x = input + i*m_padded_input;
+    m_dot(x, x, 1, m_padded_input, &norm);
+    const double* in = products + i*d;
+    double* out = kvalue + i*q;
+    for (size_t j=0; j<d; ++j) {
+      double distance = std::max(0., norm + m_basis_norm[j] - 2.*in[j]);
+      out[j] = std::exp(-m_gamma * distance);
+    }
+    std::fill(out + d, out + q, 0.);
+  }
+  m_gemm(kvalue, n, &m_transform[0], d, q, products);
+  for (size_t i=0; i<n; ++i) {
+    double* out = output + i*q;
+    std::copy(products + i*d, products + (i+1)*d, out);
+    std::fill(out + d, out + q, 0.);
+  }
+
+}
+
+void bob::learn::libsvm::KernelMap::save
+(bob::io::base::HDF5File& config) const {
+  config.set("approximation", std::string(m_approximation == FOURIER ?
+        "fourier" : "nystrom"));
+  config.set("gamma", m_gamma);
+  blitz::Array<double,2> basis(m_output_size, m_input_size);
+  for (size_t i=0; i<m_output_size; ++i)
+    for (size_t j=0; j<m_input_size; ++j)
+      basis(i,j) = m_basis[i*m_padded_input + j];
+  config.setArray("basis", basis);
+  if (m_approximation == FOURIER) {
+    blitz::Array<double,1> offset(m_output_size);
+    for (size_t i=0; i<m_output_size; ++i) offset(i) = m_offset[i];
+    config.setArray("offset", offset);
+  }
+}
+
+bob::learn::libsvm::ApproximateMachine::ApproximateMachine
+(boost::shared_ptr<const KernelMap> map,
+ const blitz::Array<double,2>& weights, const blitz::Array<double,1>& bias,
+ const std::vector<int>& labels):
+  m_map(map),
+  m_bias(bias.extent(0)),
+  m_labels(labels)
+{
+  if (!m_map) {
+    throw std::runtime_error("approximate machines require a kernel map");
+  }
+  if ((size_t)weights.extent(1) != m_map->outputSize() ||
+      weights.extent(0) != bias.extent(0)) {
+    boost::format m("approximate machines require one row of %d weights per bias, but there are %d rows of %d weights for %d biases");
+    m % m_map->outputSize() % weights.extent(0) % weights.extent(1) % bias.extent(0);
+    throw std::runtime_error(m.str());
+  }
+  size_t q = m_map->paddedOutputSize();
+  m_weights.assign(weights.extent(0) * q, 0.);
+  for (int i=0; i<weights.extent(0); ++i) {
+    for (int j=0; j<weights.extent(1); ++j)
+      m_weights[i*q + j] = weights(i,j);
+    m_bias[i] = bias(i);
+  }
+  m_input_sub.resize(inputSize());
+  m_input_sub = 0.;
+  m_input_div.resize(inputSize());
+  m_input_div = 1.;
+  check();
+}
+
+/**
+ * Reads the scaling vector ``name``, with the stored shape, checking it has
+ * one position per input
+ */
+static blitz::Array<double,1> read_scaling(bob::io::base::HDF5File& config,
+    const char* name, size_t size) {
+  blitz::Array<double,1> retval = config.readArray<double,1>(name);
+  if ((size_t)retval.extent(0) != size) {
+    boost::format m("approximate machine at `%s:%s' maps inputs of %d features, but `%s' has %d positions");
+    m % config.filename() % config.cwd() % size % name % retval.extent(0);
+    throw std::runtime_error(m.str());
+  }
+  return retval;
+}
+
+bob::learn::libsvm::ApproximateMachine::ApproximateMachine
+(bob::io::base::HDF5File& config) {
+  config.cd("map");
+  m_map.reset(new KernelMap(config));
+  config.cd("..");
+  blitz::Array<int64_t,1> labels = config.readArray<int64_t,1>("labels");
+  for (int k=0; k<labels.extent(0); ++k) m_labels.push_back((int)labels(k));
+  blitz::Array<double,2> weights = config.readArray<double,2>("weights");
+  blitz::Array<double,1> bias = config.readArray<double,1>("bias");
+  if ((size_t)weights.extent(1) != m_map->outputSize() ||
+      weights.extent(0) != bias.extent(0)) {
+    boost::format m("approximate machine at `%s:%s' should have one row of %d weights per bias, but has %d rows of %d weights for %d biases");
+    m % config.filename() % config.cwd() % m_map->outputSize() % weights.extent(0) % weights.extent(1) % bias.extent(0);
+    throw std::runtime_error(m.str());
+  }
+  size_t q = m_map->paddedOutputSize();
+  m_weights.assign(weights.extent(0) * q, 0.);
+  m_bias.resize(bias.extent(0));
+  for (int i=0; i<weights.extent(0); ++i) {
+    for (int j=0; j<weights.extent(1); ++j)
+      m_weights[i*q + j] = weights(i,j);
+    m_bias[i] = bias(i);
+  }
+  check();
+  m_input_sub.reference(read_scaling(config, "input_subtract", inputSize()));
+  m_input_div.reference(read_scaling(config, "input_divide", inputSize()));
+}
+
+bob::learn::libsvm::ApproximateMachine::ApproximateMachine
+(const bob::learn::libsvm::ApproximateMachine& other):
+  m_map(other.m_map),
+  m_weights(other.m_weights),
+  m_bias(other.m_bias),
+  m_labels(other.m_labels),
+  m_input_sub(bob::core::array::ccopy(other.m_input_sub)),
+  m_input_div(bob::core::array::ccopy(other.m_input_div))
+{
+}
+
+bob::learn::libsvm::ApproximateMachine::~ApproximateMachine() { }
+
+void bob::learn::libsvm::ApproximateMachine::check() const {
+  size_t scores = (m_labels.size() == 2) ? 1 : m_labels.size();
+  if (m_labels.size() < 2 || m_bias.size() != scores) {
+    boost::format m("approximate machines require one score for 2 classes, or one per class for more, but there are %d scores for %d classes");
+    m % m_bias.size() % m_labels.size();
+    throw std::runtime_error(m.str());
+  }
+}
+
+blitz::Array<double,2>
+bob::learn::libsvm::ApproximateMachine::getWeights() const {
+  size_t q = m_map->paddedOutputSize();
+  blitz::Array<double,2> retval(m_bias.size(), m_map->outputSize());
+  for (int i=0; i<retval.extent(0); ++i)
+    for (int j=0; j<retval.extent(1); ++j)
+      retval(i,j) = m_weights[i*q + j];
+  return retval;
+}
+
+blitz::Array<double,1>
+bob::learn::libsvm::ApproximateMachine::getBias() const {
+  blitz::Array<double,1> retval(m_bias.size());
+  for (size_t i=0; i<m_bias.size(); ++i) retval(i) = m_bias[i];
+  return retval;
+}
+
+void bob::learn::libsvm::ApproximateMachine::setInputSubtraction
+(const blitz::Array<double,1>& v) {
+  if (inputSize() > (size_t)v.extent(0)) {
+    boost::format m("mismatch on the input subtraction dimension: expected a vector with **at least** %d positions, but you input %d");
+    m % inputSize() % v.extent(0);
+    throw std::runtime_error(m.str());
+  }
+  m_input_sub.reference(bob::core::array::ccopy(v));
+}
+
+void bob::learn::libsvm::ApproximateMachine::setInputDivision
+(const blitz::Array<double,1>& v) {
+  if (inputSize() > (size_t)v.extent(0)) {
+    boost::format m("mismatch on the input division dimension: expected a vector with **at least** %d positions, but you input %d");
+    m % inputSize() % v.extent(0);
+    throw std::runtime_error(m.str());
+  }
+  m_input_div.reference(bob::core::array::ccopy(v));
+}
+
+void bob::learn::libsvm::ApproximateMachine::predict_
+(const blitz::Array<double,2>& input, size_t start, size_t end,
+ blitz::Array<int64_t,1>& labels, blitz::Array<double,2>& scores) const {
+
+  const KernelMap& map = *m_map;
+  size_t p = map.paddedInputSize();
+  size_t q = map.paddedOutputSize();
+  size_t n_scores = m_bias.size();
+  size_t batch = std::min(MAP_BATCH, end - start);
+
+  bob::learn::libsvm::aligned_vector scaled(batch * p, 0.);
+  bob::learn::libsvm::aligned_vector features(batch * q);
+  bob::learn::libsvm::aligned_vector work(map.workspaceSize(batch));
+  std::vector<double> values(batch * n_scores);
+
+  for (size_t first=start; first<end; first+=batch) {
+    size_t n = std::min(batch, end - first);
+
+    for (size_t i=0; i<n; ++i) {
+      double* row = &scaled[i*p];
+      for (size_t j=0; j<map.inputSize(); ++j)
+        row[j] = (input(first+i, j) - m_input_sub(j)) / m_input_div(j);
+    }
+
+    map.map(&scaled[0], n, &features[0], &work[0]);
+    map.gemm()(&features[0], n, &m_weights[0], n_scores, q, &values[0]);
+
+    for (size_t i=0; i<n; ++i) {
+      double* value = &values[i*n_scores];
+      size_t best = 0;
+      for (size_t k=0; k<n_scores; ++k) {
+        value[k] += m_bias[k];
+        scores(first+i, k) = value[k];
+        if (value[k] > value[best]) best = k;
+      }
+      if (n_scores == 1) labels(first+i) = m_labels[value[0] > 0. ? 0 : 1];
+      else labels(first+i) = m_labels[best];
+    }
+  }
+
+}
+
+int bob::learn::libsvm::ApproximateMachine::predictClass
+(const blitz::Array<double,1>& input) const {
+  blitz::Array<double,1> scores(outputSize());
+  return predictClassAndScores(input, scores);
+}
+
+int bob::learn::libsvm::ApproximateMachine::predictClassAndScores
+(const blitz::Array<double,1>& input, blitz::Array<double,1>& scores) const {
+
+  if ((size_t)input.extent(0) < inputSize()) {
+    boost::format s("input for this approximate machine should have **at least** %d components, but you provided an array with %d elements instead");
+    s % inputSize() % input.extent(0);
+    throw std::runtime_error(s.str());
+  }
+
+  if ((size_t)scores.extent(0) != outputSize()) {
+    boost::format s("output scores for this approximate machine should have %d components, but you provided an array with %d elements instead");
+    s % outputSize() % scores.extent(0);
+    throw std::runtime_error(s.str());
+  }
+
+  blitz::Array<double,2> row(1, input.extent(0));
+  row(0, blitz::Range::all()) = input;
+  blitz::Array<int64_t,1> label(1);
+  blitz::Array<double,2> score(1, outputSize());
+  predict_(row, 0, 1, label, score);
+  scores = score(0, blitz::Range::all());
+  return label(0);
+}
+
+void bob::learn::libsvm::ApproximateMachine::predictClass
+(const blitz::Array<double,2>& input, blitz::Array<int64_t,1>& labels,
+ size_t threads) const {
+  blitz::Array<double,2> scores(input.extent(0), outputSize());
+  predictClassAndScores(input, labels, scores, threads);
+}
+
+void bob::learn::libsvm::ApproximateMachine::predictClassAndScores
+(const blitz::Array<double,2>& input, blitz::Array<int64_t,1>& labels,
+ blitz::Array<double,2>& scores, size_t threads) const {
+
+  size_t rows = input.extent(0);
+
+  if ((size_t)input.extent(1) < inputSize()) {
+    boost::format s("input for this approximate machine should have **at least** %d columns, but you provided an array with %d columns instead");
+    s % inputSize() % input.extent(1);
+    throw std::runtime_error(s.str());
+  }
+
+  if ((size_t)labels.extent(0) != rows) {
+    boost::format s("output labels should have %d components (one per input row), but you provided an array with %d elements instead");
+    s % rows % labels.extent(0);
+    throw std::runtime_error(s.str());
+  }
+
+  if ((size_t)scores.extent(0) != rows ||
+      (size_t)scores.extent(1) != outputSize()) {
+    boost::format s("output scores for this approximate machine should have shape (%d, %d), but you provided an array with shape (%d, %d) instead");
+    s % rows % outputSize() % scores.extent(0) % scores.extent(1);
+    throw std::runtime_error(s.str());
+  }
+
+  if (!rows) return;
+
+  bob::learn::libsvm::parallel_for(rows, threads, MAP_BATCH,
+      [&](size_t start, size_t end) {
+    predict_(input, start, end, labels, scores);
+  });
+
+}
+
+void bob::learn::libsvm::ApproximateMachine::save
+(bob::io::base::HDF5File& config) const {
+  blitz::Array<int64_t,1> labels(m_labels.size());
+  for (size_t k=0; k<m_labels.size(); ++k) labels(k) = m_labels[k];
+  config.setArray("labels", labels);
+  config.setArray("weights", getWeights());
+  config.setArray("bias", getBias());
+  config.setArray("input_subtract", m_input_sub);
+  config.setArray("input_divide", m_input_div);
+  config.createGroup("map");
+  config.cd("map");
+  m_map->save(config);
+  config.cd("..");
+}
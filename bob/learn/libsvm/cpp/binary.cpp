@@ -0,0 +1,387 @@
+/**
+ * @date Tue 13 Oct 2026 15:47:12 CEST
+ *
+ * @brief Binary, memory-mappable, storage for libsvm models
+ *
+ * Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+ */
+
+#include <bob.learn.libsvm/machine.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <boost/format.hpp>
+#include <bob.core/check.h>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+/**
+ * Identifies binary model files, written at the very beginning
+ */
+static const char BINARY_MAGIC[8] = {'B','O','B','S','V','M','\x01','\n'};
+
+static const uint32_t BINARY_VERSION = 1;
+
+/**
+ * Written in native byte order: allows the detection of files created on
+ * machines with a different endianness
+ */
+static const uint32_t BINARY_BYTE_ORDER = 0x01020304;
+
+/**
+ * All arrays in the file start at offsets that are multiple of this value
+ */
+static const uint64_t BINARY_ALIGNMENT = 64;
+
+enum binary_flags {
+  HAS_LABEL = 1,
+  HAS_PROBA = 2,
+  HAS_PROBB = 4,
+  HAS_NSV = 8
+};
+
+/**
+ * The file header. Only fixed size types are used and everything is padded
+ * explicitly, so the layout does not depend on the compiler. Offsets are
+ * counted in bytes from the beginning of the file.
+ */
+struct binary_header {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint32_t node_size; ///< sizeof(svm_node) when the file was written
+  int32_t svm_type;
+  int32_t kernel_type;
+  int32_t degree;
+  double gamma;
+  double coef0;
+  int32_t nr_class;
+  int32_t l; ///< total number of support vectors
+  uint64_t n_nodes; ///< total number of nodes, including terminators
+  uint64_t input_size; ///< largest feature index in the support vectors
+  uint64_t flags; ///< which optional arrays are present
+  uint64_t nodes; ///< svm_node[n_nodes]
+  uint64_t sv_start; ///< uint64_t[l], position of each SV at ``nodes``
+  uint64_t sv_coef; ///< double[nr_class-1][l]
+  uint64_t rho; ///< double[nr_class*(nr_class-1)/2]
+  uint64_t probA; ///< double[nr_class*(nr_class-1)/2]
+  uint64_t probB; ///< double[nr_class*(nr_class-1)/2]
+  uint64_t label; ///< int32_t[nr_class]
+  uint64_t nSV; ///< int32_t[nr_class]
+  uint64_t input_subtract; ///< double[input_size]
+  uint64_t input_divide; ///< double[input_size]
+  uint64_t file_size; ///< total, for consistency checks
+};
+
+/**
+ * Tells if ``bytes`` starting at ``offset`` are within a file of ``size``
+ * bytes and if the offset is properly aligned
+ */
+static bool fits(uint64_t offset, uint64_t bytes, uint64_t size) {
+  return (offset % sizeof(double)) == 0 && offset <= size &&
+    bytes <= size - offset;
+}
+
+/**
+ * Same as above, for an array of ``count`` elements of ``element`` bytes,
+ * without overflowing
+ */
+static bool fits(uint64_t offset, uint64_t count, uint64_t element,
+    uint64_t size) {
+  return count <= size / element && fits(offset, count * element, size);
+}
+
+static uint64_t align(uint64_t offset) {
+  return ((offset + BINARY_ALIGNMENT - 1) / BINARY_ALIGNMENT) * BINARY_ALIGNMENT;
+}
+
+bool bob::learn::libsvm::svm_is_binary(const std::string& filename) {
+  std::ifstream f(filename.c_str(), std::ios::binary);
+  char magic[sizeof(BINARY_MAGIC)];
+  if (!f.read(magic, sizeof(magic))) return false;
+  return !std::memcmp(magic, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+}
+
+/**
+ * Writes ``size`` bytes at ``offset``, padding the file with zeros up to
+ * there
+ */
+static void write_at(std::ofstream& f, uint64_t offset, const void* data,
+    uint64_t size) {
+  static const char zeros[BINARY_ALIGNMENT] = {0};
+  uint64_t current = f.tellp();
+  while (current < offset) {
+    uint64_t n = std::min<uint64_t>(offset - current, sizeof(zeros));
+    f.write(zeros, n);
+    current += n;
+  }
+  if (size) f.write(reinterpret_cast<const char*>(data), size);
+}
+
+void bob::learn::libsvm::svm_save_binary(const std::string& filename,
+    const boost::shared_ptr<svm_model> model, size_t input_size,
+    const blitz::Array<double,1>& input_subtract,
+    const blitz::Array<double,1>& input_divide) {
+
+  const svm_model* m = model.get();
+  size_t pairs = (m->nr_class*(m->nr_class-1))/2;
+  size_t n_coef = m->nr_class - 1;
+
+  if ((size_t)input_subtract.extent(0) != input_size ||
+      (size_t)input_divide.extent(0) != input_size) {
+    boost::format s("scaling vectors should have %d components each, but they have %d and %d instead");
+    s % input_size % input_subtract.extent(0) % input_divide.extent(0);
+    throw std::runtime_error(s.str());
+  }
+
+  //collects the position of every support vector in the node array
+  std::vector<uint64_t> sv_start(m->l);
+  uint64_t n_nodes = 0;
+  for (int i=0; i<m->l; ++i) {
+    sv_start[i] = n_nodes;
+    const svm_node* p = m->SV[i];
+    while (p->index != -1) ++p;
+    n_nodes += (p - m->SV[i]) + 1;
+  }
+
+  binary_header h;
+  std::memset(&h, 0, sizeof(h));
+  std::memcpy(h.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+  h.version = BINARY_VERSION;
+  h.byte_order = BINARY_BYTE_ORDER;
+  h.node_size = sizeof(svm_node);
+  h.svm_type = m->param.svm_type;
+  h.kernel_type = m->param.kernel_type;
+  h.degree = m->param.degree;
+  h.gamma = m->param.gamma;
+  h.coef0 = m->param.coef0;
+  h.nr_class = m->nr_class;
+  h.l = m->l;
+  h.n_nodes = n_nodes;
+  h.input_size = input_size;
+  h.flags = (m->label ? HAS_LABEL : 0) | (m->probA ? HAS_PROBA : 0) |
+    (m->probB ? HAS_PROBB : 0) | (m->nSV ? HAS_NSV : 0);
+
+  uint64_t offset = align(sizeof(h));
+  h.nodes = offset; offset = align(offset + n_nodes * sizeof(svm_node));
+  h.sv_start = offset; offset = align(offset + m->l * sizeof(uint64_t));
+  h.sv_coef = offset; offset = align(offset + n_coef * m->l * sizeof(double));
+  h.rho = offset; offset = align(offset + pairs * sizeof(double));
+  if (m->probA) { h.probA = offset; offset = align(offset + pairs * sizeof(double)); }
+  if (m->probB) { h.probB = offset; offset = align(offset + pairs * sizeof(double)); }
+  if (m->label) { h.label = offset; offset = align(offset + m->nr_class * sizeof(int32_t)); }
+  if (m->nSV) { h.nSV = offset; offset = align(offset + m->nr_class * sizeof(int32_t)); }
+  h.input_subtract = offset; offset += input_size * sizeof(double);
+  h.input_divide = offset; offset += input_size * sizeof(double);
+  h.file_size = offset;
+
+  std::ofstream f(filename.c_str(), std::ios::binary | std::ios::trunc);
+  if (!f) {
+    boost::format s("cannot open file '%s' for writing SVM model");
+    s % filename;
+    throw std::runtime_error(s.str());
+  }
+
+  write_at(f, 0, &h, sizeof(h));
+
+  //support vectors, one after the other
+  write_at(f, h.nodes, 0, 0);
+  for (int i=0; i<m->l; ++i) {
+    uint64_t size = (i+1 < m->l ? sv_start[i+1] : n_nodes) - sv_start[i];
+    f.write(reinterpret_cast<const char*>(m->SV[i]), size*sizeof(svm_node));
+  }
+  write_at(f, h.sv_start, sv_start.data(), m->l * sizeof(uint64_t));
+
+  write_at(f, h.sv_coef, 0, 0);
+  for (size_t k=0; k<n_coef; ++k)
+    f.write(reinterpret_cast<const char*>(m->sv_coef[k]), m->l*sizeof(double));
+
+  write_at(f, h.rho, m->rho, pairs * sizeof(double));
+  if (m->probA) write_at(f, h.probA, m->probA, pairs * sizeof(double));
+  if (m->probB) write_at(f, h.probB, m->probB, pairs * sizeof(double));
+  if (m->label) write_at(f, h.label, m->label, m->nr_class * sizeof(int32_t));
+  if (m->nSV) write_at(f, h.nSV, m->nSV, m->nr_class * sizeof(int32_t));
+
+  blitz::Array<double,1> sub = bob::core::array::ccopy(input_subtract);
+  blitz::Array<double,1> div = bob::core::array::ccopy(input_divide);
+  write_at(f, h.input_subtract, sub.data(), input_size * sizeof(double));
+  write_at(f, h.input_divide, div.data(), input_size * sizeof(double));
+
+  if (!f) {
+    boost::format s("error writing SVM model to file '%s'");
+    s % filename;
+    throw std::runtime_error(s.str());
+  }
+}
+
+/**
+ * Releases models pointing to mapped memory. Only the pointer tables are
+ * allocated on the heap, everything else belongs to the mapped region.
+ */
+struct mapped_model_deleter {
+  boost::shared_ptr<boost::interprocess::mapped_region> region;
+  void operator() (svm_model* m) {
+    std::free(m->SV);
+    std::free(m->sv_coef);
+    std::free(m);
+  }
+};
+
+boost::shared_ptr<svm_model> bob::learn::libsvm::svm_map_binary
+(const std::string& filename, size_t& input_size,
+ blitz::Array<double,1>& input_subtract,
+ blitz::Array<double,1>& input_divide) {
+
+  namespace bip = boost::interprocess;
+
+  boost::shared_ptr<bip::mapped_region> region;
+  try {
+    bip::file_mapping file(filename.c_str(), bip::read_only);
+    region.reset(new bip::mapped_region(file, bip::read_only));
+  }
+  catch (bip::interprocess_exception& e) {
+    boost::format s("cannot map SVM model file '%s': %s");
+    s % filename % e.what();
+    throw std::runtime_error(s.str());
+  }
+
+  const char* base = static_cast<const char*>(region->get_address());
+  uint64_t size = region->get_size();
+
+  boost::format error("SVM model file '%s' is not valid: %s");
+  error % filename;
+
+  if (size < sizeof(binary_header)) {
+    error % "file is too short";
+    throw std::runtime_error(error.str());
+  }
+  const binary_header& h = *reinterpret_cast<const binary_header*>(base);
+  if (std::memcmp(h.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC))) {
+    error % "not a binary model file";
+    throw std::runtime_error(error.str());
+  }
+  if (h.byte_order != BINARY_BYTE_ORDER) {
+    error % "file was written on a machine with a different byte order";
+    throw std::runtime_error(error.str());
+  }
+  if (h.version != BINARY_VERSION || h.node_size != sizeof(svm_node)) {
+    error % "unsupported version or node layout";
+    throw std::runtime_error(error.str());
+  }
+  if (h.svm_type < C_SVC || h.svm_type > NU_SVR ||
+      h.kernel_type < LINEAR || h.kernel_type > PRECOMPUTED) {
+    error % "unknown machine or kernel type";
+    throw std::runtime_error(error.str());
+  }
+  bool classifier = (h.svm_type == C_SVC || h.svm_type == NU_SVC);
+  if (h.nr_class < 1 || h.l < 0 || (!classifier && h.nr_class != 2)) {
+    error % "invalid number of classes or support vectors";
+    throw std::runtime_error(error.str());
+  }
+  if (classifier && (!(h.flags & HAS_LABEL) || !(h.flags & HAS_NSV))) {
+    error % "classifiers need labels and numbers of support vectors per class";
+    throw std::runtime_error(error.str());
+  }
+  //both are positive 32-bit numbers: products of two of them cannot
+  //overflow, the sizes in bytes are checked by fits()
+  uint64_t l = h.l;
+  uint64_t nr_class = h.nr_class;
+  uint64_t pairs = (nr_class*(nr_class-1))/2;
+  bool ok = h.file_size == size &&
+    fits(h.nodes, h.n_nodes, sizeof(svm_node), size) &&
+    fits(h.sv_start, l, sizeof(uint64_t), size) &&
+    fits(h.sv_coef, (nr_class-1) * l, sizeof(double), size) &&
+    fits(h.rho, pairs, sizeof(double), size) &&
+    (!(h.flags & HAS_PROBA) || fits(h.probA, pairs, sizeof(double), size)) &&
+    (!(h.flags & HAS_PROBB) || fits(h.probB, pairs, sizeof(double), size)) &&
+    (!(h.flags & HAS_LABEL) || fits(h.label, nr_class, sizeof(int32_t), size)) &&
+    (!(h.flags & HAS_NSV) || fits(h.nSV, nr_class, sizeof(int32_t), size)) &&
+    fits(h.input_subtract, h.input_size, sizeof(double), size) &&
+    fits(h.input_divide, h.input_size, sizeof(double), size);
+  if (!ok) {
+    error % "file is truncated or corrupted";
+    throw std::runtime_error(error.str());
+  }
+
+  //each support vector must start within the nodes, after the previous
+  //one, and end with a terminator right before the next one starts. Feature
+  //indices must be within the input size (precomputed kernels only keep the
+  //sample serial number, at index 0).
+  svm_node* nodes = reinterpret_cast<svm_node*>(const_cast<char*>(base + h.nodes));
+  const uint64_t* sv_start = reinterpret_cast<const uint64_t*>(base + h.sv_start);
+  int64_t first_index = (h.kernel_type == PRECOMPUTED) ? 0 : 1;
+  int64_t last_index = (h.kernel_type == PRECOMPUTED) ? 0 : h.input_size;
+  for (uint64_t i=0; i<l; ++i) {
+    uint64_t end = (i+1 < l) ? sv_start[i+1] : h.n_nodes;
+    if (sv_start[i] >= end || end > h.n_nodes ||
+        nodes[end-1].index != -1) {
+      error % "support vectors are not properly terminated";
+      throw std::runtime_error(error.str());
+    }
+    for (uint64_t n=sv_start[i]; n<end-1; ++n) {
+      if (nodes[n].index < first_index || nodes[n].index > last_index) {
+        error % "feature index of support vector out of range";
+        throw std::runtime_error(error.str());
+      }
+    }
+  }
+
+  if (h.flags & HAS_NSV) {
+    const int32_t* nSV = reinterpret_cast<const int32_t*>(base + h.nSV);
+    bool valid = true;
+    int64_t total = 0; ///< cannot overflow with 32-bit terms
+    for (uint64_t k=0; k<nr_class; ++k) {
+      valid = valid && nSV[k] >= 0;
+      total += nSV[k];
+    }
+    if (!valid || total != h.l) {
+      error % "numbers of support vectors per class do not sum up to the total";
+      throw std::runtime_error(error.str());
+    }
+  }
+
+  //builds the model around the mapped memory; libsvm only reads from models
+  //while predicting, so the read-only mapping is fine.
+  svm_model* m = static_cast<svm_model*>(std::calloc(1, sizeof(svm_model)));
+  if (!m) throw std::bad_alloc();
+  mapped_model_deleter deleter;
+  deleter.region = region;
+  boost::shared_ptr<svm_model> retval(m, deleter);
+
+  m->param.svm_type = h.svm_type;
+  m->param.kernel_type = h.kernel_type;
+  m->param.degree = h.degree;
+  m->param.gamma = h.gamma;
+  m->param.coef0 = h.coef0;
+  m->nr_class = h.nr_class;
+  m->l = h.l;
+  m->free_sv = 0;
+
+  m->SV = static_cast<svm_node**>(std::malloc(h.l * sizeof(svm_node*)));
+  m->sv_coef = static_cast<double**>(std::malloc((h.nr_class-1) * sizeof(double*)));
+  if ((h.l && !m->SV) || (h.nr_class > 1 && !m->sv_coef)) throw std::bad_alloc();
+  for (int i=0; i<h.l; ++i) m->SV[i] = nodes + sv_start[i];
+  double* sv_coef = reinterpret_cast<double*>(const_cast<char*>(base + h.sv_coef));
+  for (int k=0; k<h.nr_class-1; ++k) m->sv_coef[k] = sv_coef + k * h.l;
+
+  char* b = const_cast<char*>(base);
+  m->rho = reinterpret_cast<double*>(b + h.rho);
+  if (h.flags & HAS_PROBA) m->probA = reinterpret_cast<double*>(b + h.probA);
+  if (h.flags & HAS_PROBB) m->probB = reinterpret_cast<double*>(b + h.probB);
+  if (h.flags & HAS_LABEL) m->label = reinterpret_cast<int*>(b + h.label);
+  if (h.flags & HAS_NSV) m->nSV = reinterpret_cast<int*>(b + h.nSV);
+
+  //scaling is small and may be changed by the user: copy it
+  input_size = h.input_size;
+  input_subtract.resize(input_size);
+  input_divide.resize(input_size);
+  if (input_size) {
+    std::memcpy(input_subtract.data(), base + h.input_subtract,
+        input_size * sizeof(double));
+    std::memcpy(input_divide.data(), base + h.input_divide,
+        input_size * sizeof(double));
+  }
+
+  return retval;
+}
@@ -0,0 +1,415 @@
+/**
+ * @date Wed 14 Oct 2026 20:37:15 CEST
+ *
+ * @brief Support vector reduction of trained machines
+ *
+ * Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+ */
+
+#include <bob.learn.libsvm/machine.h>
+#include <bob.learn.libsvm/parallel.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <boost/format.hpp>
+#include <bob.core/array_copy.h>
+
+/**
+ * Nearest neighbours are searched for in groups of this many vectors
+ */
+static const size_t NEIGHBOUR_GRAIN = 16;
+
+/**
+ * A candidate reduction: merging support vector ``i`` with ``j`` or, if
+ * ``j`` is equal to ``i``, pruning it. ``cost`` is the largest bound on the
+ * change of the decision functions it takes part in.
+ */
+struct reduction {
+  size_t i;
+  size_t j;
+  double cost;
+  bool operator< (const reduction& other) const { return cost < other.cost; }
+};
+
+/**
+ * State of a compression: dense copies of the support vectors, their
+ * coefficients and what has been spent on each decision function
+ */
+struct reducer {
+
+  size_t size; ///< number of features
+  size_t rows; ///< number of coefficients for each vector
+  size_t classes; ///< number of classes (zero if there are no labels)
+  double gamma;
+
+  std::vector<double> x; ///< one row of ``size`` features per vector
+  std::vector<double> coef; ///< one row of ``rows`` coefficients per vector
+  std::vector<size_t> group; ///< class of each vector
+  std::vector<bool> alive; ///< if the vector was not removed
+  std::vector<bool> changed; ///< if the vector is not an original one
+  std::vector<bool> moved; ///< if the vector changed during this pass
+  std::vector<size_t> neighbour; ///< nearest neighbour of each vector
+  std::vector<bool> stale; ///< if ``neighbour`` must be searched for again
+  std::vector<double> spent; ///< error bound of each decision function
+
+  /**
+   * Index of the decision function that row ``r`` of the coefficients of a
+   * vector of class ``c`` contributes to, in libsvm's order
+   */
+  size_t function(size_t c, size_t r) const {
+    if (!classes) return 0;
+    size_t o = (r < c) ? r : r + 1;
+    size_t i = std::min(c, o), j = std::max(c, o);
+    return i*(2*classes-i-1)/2 + (j-i-1);
+  }
+
+  double distance(size_t i, size_t j) const {
+    const double* a = &x[i*size];
+    const double* b = &x[j*size];
+    double sum = 0.;
+    for (size_t k=0; k<size; ++k) {
+      double d = a[k] - b[k];
+      sum += d*d;
+    }
+    return sum;
+  }
+
+  /**
+   * Weight of a vector in merges: the magnitude of its coefficients
+   */
+  double weight(size_t i) const {
+    double sum = 0.;
+    for (size_t r=0; r<rows; ++r) sum += std::fabs(coef[i*rows+r]);
+    return sum;
+  }
+
+  /**
+   * Kernel values between vectors ``i``, ``j`` and the point they would be
+   * merged into, which is on the segment between them
+   */
+  void kernels(size_t i, size_t j, double& kij, double& kiz, double& kjz)
+    const {
+    double wi = weight(i), wj = weight(j), w = wi + wj;
+    double d = distance(i, j);
+    double ti = (w > 0.) ? wj/w : 0.; ///< distance from i to z, relative
+    double tj = 1. - ti;
+    kij = std::exp(-gamma*d);
+    kiz = std::exp(-gamma*d*ti*ti);
+    kjz = std::exp(-gamma*d*tj*tj);
+  }
+
+  /**
+   * The norm of what merging ``i`` with ``j`` leaves out of row ``r``, and
+   * the new coefficient
+   */
+  double residual(size_t i, size_t j, size_t r, double kij, double kiz,
+      double kjz, double& beta) const {
+    double ai = coef[i*rows+r], aj = coef[j*rows+r];
+    beta = ai*kiz + aj*kjz;
+    double sq = ai*ai + aj*aj + 2.*ai*aj*kij - beta*beta;
+    return std::sqrt(std::max(sq, 0.));
+  }
+
+  double cost(size_t i, size_t j) const {
+    double retval = 0.;
+    if (i == j) {
+      for (size_t r=0; r<rows; ++r)
+        retval = std::max(retval, std::fabs(coef[i*rows+r]));
+      return retval;
+    }
+    double kij, kiz, kjz, beta;
+    kernels(i, j, kij, kiz, kjz);
+    for (size_t r=0; r<rows; ++r)
+      retval = std::max(retval, residual(i, j, r, kij, kiz, kjz, beta));
+    return retval;
+  }
+
+  /**
+   * Applies a reduction if the bounds of all decision functions it takes
+   * part in stay within ``max_error``. Returns true if it was applied.
+   */
+  bool apply(size_t i, size_t j, double max_error) {
+
+    std::vector<double> change(rows);
+    std::vector<double> beta(rows);
+    if (i == j) {
+      for (size_t r=0; r<rows; ++r) change[r] = std::fabs(coef[i*rows+r]);
+    }
+    else {
+      double kij, kiz, kjz;
+      kernels(i, j, kij, kiz, kjz);
+      for (size_t r=0; r<rows; ++r)
+        change[r] = residual(i, j, r, kij, kiz, kjz, beta[r]);
+    }
+
+    size_t c = group[i];
+    for (size_t r=0; r<rows; ++r) {
+      if (spent[function(c, r)] + change[r] > max_error) return false;
+    }
+    for (size_t r=0; r<rows; ++r) spent[function(c, r)] += change[r];
+
+    if (i == j) {
+      alive[i] = false;
+      return true;
+    }
+
+    double wi = weight(i), wj = weight(j), w = wi + wj;
+    double ti = (w > 0.) ? wj/w : 0.;
+    double* a = &x[i*size];
+    const double* b = &x[j*size];
+    for (size_t k=0; k<size; ++k) a[k] += ti*(b[k] - a[k]);
+    for (size_t r=0; r<rows; ++r) coef[i*rows+r] = beta[r];
+    alive[j] = false;
+    changed[i] = true;
+    moved[i] = true;
+    return true;
+
+  }
+
+};
+
+bob::learn::libsvm::Machine* bob::learn::libsvm::Machine::compress
+(double max_error, size_t size, size_t threads) const {
+
+  const svm_model* model = m_model.get();
+
+  if (model->param.kernel_type != RBF) {
+    boost::format m("support vectors can only be merged for machines with RBF kernels, but this machine uses kernel type %d");
+    m % model->param.kernel_type;
+    throw std::runtime_error(m.str());
+  }
+
+  if (!(max_error >= 0.)) {
+    boost::format m("the maximum error of a compressed machine should be non-negative, not %g");
+    m % max_error;
+    throw std::runtime_error(m.str());
+  }
+
+  size_t l = model->l;
+  reducer state;
+  state.size = m_input_size;
+  state.rows = model->nr_class - 1;
+  state.classes = model->nSV ? model->nr_class : 0;
+  state.gamma = model->param.gamma;
+  state.x.assign(l*state.size, 0.);
+  state.coef.resize(l*state.rows);
+  state.group.resize(l);
+  state.alive.assign(l, true);
+  state.changed.assign(l, false);
+  state.moved.assign(l, false);
+  state.neighbour.assign(l, 0);
+  state.stale.assign(l, true);
+  state.spent.assign(std::max(1, model->nr_class*(model->nr_class-1)/2), 0.);
+
+  //vectors of each class, in the order they are stored
+  std::vector<std::vector<size_t> > members(std::max<size_t>(state.classes,
+        1));
+  for (size_t c=0, i=0; i<l; ++c) {
+    size_t count = state.classes ? model->nSV[c] : l;
+    for (size_t k=0; k<count; ++k, ++i) {
+      state.group[i] = c;
+      members[c].push_back(i);
+    }
+  }
+
+  for (size_t i=0; i<l; ++i) {
+    for (const svm_node* p = model->SV[i]; p->index != -1; ++p) {
+      if (p->index >= 1 && (size_t)p->index <= state.size)
+        state.x[i*state.size + p->index - 1] = p->value;
+    }
+    for (size_t r=0; r<state.rows; ++r)
+      state.coef[i*state.rows+r] = model->sv_coef[r][i];
+  }
+
+  size_t left = l;
+  std::vector<size_t> remaining(members.size());
+  for (size_t c=0; c<members.size(); ++c) remaining[c] = members[c].size();
+
+  while (!size || left > size) {
+
+    //nearest neighbours of new vectors, or of those whose neighbour changed
+    std::vector<size_t> search;
+    for (size_t i=0; i<l; ++i) {
+      if (!state.alive[i]) continue;
+      size_t j = state.neighbour[i];
+      if (state.stale[i] || !state.alive[j] || state.moved[j])
+        search.push_back(i);
+    }
+    const std::vector<size_t>& search_ = search;
+    bob::learn::libsvm::parallel_for(search.size(), threads, NEIGHBOUR_GRAIN,
+        [&](size_t start, size_t end) {
+      for (size_t k=start; k<end; ++k) {
+        size_t i = search_[k];
+        double best = std::numeric_limits<double>::infinity();
+        size_t found = i;
+        for (size_t j : members[state.group[i]]) {
+          if (j == i || !state.alive[j]) continue;
+          double d = state.distance(i, j);
+          if (d < best) { best = d; found = j; }
+        }
+        state.neighbour[i] = found;
+      }
+    });
+    for (size_t i=0; i<l; ++i) {
+      state.stale[i] = false;
+      state.moved[i] = false;
+    }
+
+    //the cheapest reduction of each vector, cheapest first
+    std::vector<reduction> candidates;
+    for (size_t i=0; i<l; ++i) {
+      if (!state.alive[i]) continue;
+      if (remaining[state.group[i]] < 2) continue;
+      reduction prune = {i, i, state.cost(i, i)};
+      reduction merge = {i, state.neighbour[i],
+        state.cost(i, state.neighbour[i])};
+      candidates.push_back(merge.cost < prune.cost ? merge : prune);
+    }
+    std::stable_sort(candidates.begin(), candidates.end());
+
+    //vectors are only touched once per pass, so costs remain valid
+    std::vector<bool> touched(l, false);
+    size_t applied = 0;
+    for (size_t k=0; k<candidates.size(); ++k) {
+      if (size && left <= size) break;
+      if (candidates[k].cost > max_error) break;
+      size_t i = candidates[k].i, j = candidates[k].j;
+      if (touched[i] || touched[j] || !state.alive[i] || !state.alive[j])
+        continue;
+      if (remaining[state.group[i]] < 2) continue;
+      if (!state.apply(i, j, max_error)) continue;
+      touched[i] = touched[j] = true;
+      if (i != j) state.stale[i] = true;
+      --remaining[state.group[i]];
+      --left;
+      ++applied;
+    }
+
+    if (!applied) break;
+
+  }
+
+  //packs what is left into a new model
+  std::vector<int> nSV(members.size(), 0);
+  std::vector<size_t> kept;
+  size_t elements = 0;
+  for (size_t i=0; i<l; ++i) {
+    if (!state.alive[i]) continue;
+    kept.push_back(i);
+    ++nSV[state.group[i]];
+    if (!state.changed[i]) continue;
+    for (size_t k=0; k<state.size; ++k)
+      if (state.x[i*state.size+k] != 0.) ++elements;
+    ++elements; ///< terminator
+  }
+
+  std::vector<svm_node> nodes(elements);
+  std::vector<svm_node*> SV(kept.size());
+  std::vector<std::vector<double> > coef(state.rows,
+      std::vector<double>(kept.size()));
+  std::vector<double*> sv_coef(state.rows);
+  svm_node* p = nodes.empty() ? 0 : &nodes[0];
+  for (size_t k=0; k<kept.size(); ++k) {
+    size_t i = kept[k];
+    for (size_t r=0; r<state.rows; ++r) coef[r][k] = state.coef[i*state.rows+r];
+    if (!state.changed[i]) {
+      SV[k] = model->SV[i];
+      continue;
+    }
+    SV[k] = p;
+    for (size_t f=0; f<state.size; ++f) {
+      double v = state.x[i*state.size+f];
+      if (v == 0.) continue;
+      p->index = f + 1;
+      p->value = v;
+      ++p;
+    }
+    p->index = -1;
+    p->value = 0.;
+    ++p;
+  }
+  for (size_t r=0; r<state.rows; ++r)
+    sv_coef[r] = coef[r].empty() ? 0 : &coef[r][0];
+
+  svm_model reduced = svm_model();
+  reduced.param = model->param;
+  reduced.nr_class = model->nr_class;
+  reduced.l = kept.size();
+  reduced.SV = SV.empty() ? 0 : &SV[0];
+  reduced.sv_coef = sv_coef.empty() ? 0 : &sv_coef[0];
+  reduced.rho = model->rho;
+  reduced.probA = model->probA;
+  reduced.probB = model->probB;
+#if LIBSVM_VERSION >= 330
+  reduced.prob_density_marks = model->prob_density_marks;
+#endif
+  reduced.label = model->label;
+  reduced.nSV = state.classes ? &nSV[0] : 0;
+
+  boost::shared_ptr<svm_model> copy = bob::learn::libsvm::svm_copy
+    (boost::shared_ptr<svm_model>(&reduced, [](svm_model*) {}));
+
+  bob::learn::libsvm::Machine* retval = new bob::learn::libsvm::Machine(copy);
+  retval->m_input_size = m_input_size; ///< may have lost some features
+  retval->m_input_sub.reference(bob::core::array::ccopy(m_input_sub));
+  retval->m_input_div.reference(bob::core::array::ccopy(m_input_div));
+  retval->updateScaling();
+  retval->m_memory = m_memory; ///< before the engine is built
+  retval->setEngine(engine());
+  return retval;
+
+}
+
+bob::learn::libsvm::Fidelity bob::learn::libsvm::Machine::fidelity
+(const Machine& other, const blitz::Array<double,2>& validation,
+ size_t threads) const {
+
+  if (other.numberOfClasses() != numberOfClasses() ||
+      other.inputSize() != inputSize()) {
+    boost::format m("machines with %d classes and %d inputs cannot be compared to machines with %d classes and %d inputs");
+    m % other.numberOfClasses() % other.inputSize();
+    m % numberOfClasses() % inputSize();
+    throw std::runtime_error(m.str());
+  }
+
+  if (m_model->label && other.m_model->label) {
+    for (size_t c=0; c<numberOfClasses(); ++c) {
+      if (m_model->label[c] != other.m_model->label[c]) {
+        boost::format m("label of class %d (%d) differs from the one of the other machine (%d)");
+        m % c % m_model->label[c] % other.m_model->label[c];
+        throw std::runtime_error(m.str());
+      }
+    }
+  }
+
+  size_t rows = validation.extent(0);
+  if (!rows) {
+    throw std::runtime_error("machines cannot be compared without validation samples");
+  }
+
+  size_t N = numberOfClasses();
+  size_t scores = (N == 2) ? 1 : (N*(N-1))/2;
+  blitz::Array<int64_t,1> labels(rows), other_labels(rows);
+  blitz::Array<double,2> values(rows, scores), other_values(rows, scores);
+  predictClassAndScores(validation, labels, values, threads);
+  other.predictClassAndScores(validation, other_labels, other_values, threads);
+
+  bob::learn::libsvm::Fidelity retval;
+  retval.samples = rows;
+  retval.max_error = 0.;
+  size_t agree = 0;
+  double sum = 0.;
+  for (int i=0; i<(int)rows; ++i) {
+    if (labels(i) == other_labels(i)) ++agree;
+    for (int k=0; k<(int)scores; ++k) {
+      double d = std::fabs(values(i,k) - other_values(i,k));
+      retval.max_error = std::max(retval.max_error, d);
+      sum += d;
+    }
+  }
+  retval.agreement = static_cast<double>(agree) / rows;
+  retval.mean_error = sum / (rows*scores);
+  return retval;
+
+}
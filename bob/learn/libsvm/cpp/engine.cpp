@@ -0,0 +1,1011 @@
+/**
+ * @date Wed 14 Oct 2026 09:03:18 CEST
+ *
+ * @brief Dense, vectorized, evaluation of libsvm models
+ *
+ * Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+ */
+
+#include <bob.learn.libsvm/engine.h>
+
+#include <cmath>
+#include <stdint.h>
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  define BOB_LEARN_LIBSVM_X86_SIMD
+#  include <immintrin.h>
+#endif
+
+/**
+ * Number of doubles rows are padded to: the width of an AVX-512 register
+ */
+static const size_t PADDING = 8;
+
+/**
+ * Same as above, for floats (in single precision engines)
+ */
+static const size_t FLOAT_PADDING = 16;
+
+static inline size_t padded_size(size_t size, bool single) {
+  size_t padding = single ? FLOAT_PADDING : PADDING;
+  return ((size + padding - 1) / padding) * padding;
+}
+
+/**
+ * Rounds a pointer in a workspace up to the engine's alignment
+ */
+static inline float* aligned_floats(double* p) {
+  uintptr_t a = reinterpret_cast<uintptr_t>(p);
+  const uintptr_t mask = bob::learn::libsvm::ENGINE_ALIGNMENT - 1;
+  return reinterpret_cast<float*>((a + mask) & ~mask);
+}
+
+/*************************
+ * Plain C++ block kernels
+ *************************/
+
+static void dot_generic(const double* x, const double* matrix, size_t rows,
+    size_t size, double* out) {
+  for (size_t r=0; r<rows; ++r, matrix+=size) {
+    double sum = 0.;
+    for (size_t k=0; k<size; ++k) sum += x[k]*matrix[k];
+    out[r] = sum;
+  }
+}
+
+static void gemm_generic(const double* x, size_t nx, const double* matrix,
+    size_t rows, size_t size, double* out) {
+  for (size_t i=0; i<nx; ++i)
+    dot_generic(x + i*size, matrix, rows, size, out + i*rows);
+}
+
+/**
+ * Without SIMD lanes, products of floats are simply summed in double
+ * precision
+ */
+static void dot_float_generic(const float* x, const float* matrix,
+    size_t rows, size_t size, double* out) {
+  for (size_t r=0; r<rows; ++r, matrix+=size) {
+    double sum = 0.;
+    for (size_t k=0; k<size; ++k) sum += (double)x[k]*matrix[k];
+    out[r] = sum;
+  }
+}
+
+static void gemm_float_generic(const float* x, size_t nx,
+    const float* matrix, size_t rows, size_t size, double* out) {
+  for (size_t i=0; i<nx; ++i)
+    dot_float_generic(x + i*size, matrix, rows, size, out + i*rows);
+}
+
+#ifdef BOB_LEARN_LIBSVM_X86_SIMD
+
+/*******************************************************************
+ * AVX2 + FMA: 4 rows are processed at once, sharing loads from ``x``
+ *******************************************************************/
+
+__attribute__((target("avx2,fma")))
+static inline double hsum_avx2(__m256d v) {
+  __m128d lo = _mm256_castpd256_pd128(v);
+  __m128d hi = _mm256_extractf128_pd(v, 1);
+  lo = _mm_add_pd(lo, hi);
+  return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+}
+
+__attribute__((target("avx2,fma")))
+static void dot_avx2(const double* x, const double* matrix, size_t rows,
+    size_t size, double* out) {
+  size_t r = 0;
+  for (; r+4<=rows; r+=4) {
+    const double* m0 = matrix + r*size;
+    const double* m1 = m0 + size;
+    const double* m2 = m1 + size;
+    const double* m3 = m2 + size;
+    __m256d a0 = _mm256_setzero_pd(), a1 = _mm256_setzero_pd();
+    __m256d a2 = _mm256_setzero_pd(), a3 = _mm256_setzero_pd();
+    for (size_t k=0; k<size; k+=4) {
+      __m256d xv = _mm256_load_pd(x+k);
+      a0 = _mm256_fmadd_pd(xv, _mm256_load_pd(m0+k), a0);
+      a1 = _mm256_fmadd_pd(xv, _mm256_load_pd(m1+k), a1);
+      a2 = _mm256_fmadd_pd(xv, _mm256_load_pd(m2+k), a2);
+      a3 = _mm256_fmadd_pd(xv, _mm256_load_pd(m3+k), a3);
+    }
+    out[r] = hsum_avx2(a0);
+    out[r+1] = hsum_avx2(a1);
+    out[r+2] = hsum_avx2(a2);
+    out[r+3] = hsum_avx2(a3);
+  }
+  for (; r<rows; ++r) {
+    const double* m0 = matrix + r*size;
+    __m256d a0 = _mm256_setzero_pd();
+    for (size_t k=0; k<size; k+=4)
+      a0 = _mm256_fmadd_pd(_mm256_load_pd(x+k), _mm256_load_pd(m0+k), a0);
+    out[r] = hsum_avx2(a0);
+  }
+}
+
+/**
+ * 2 inputs x 4 rows at a time, with the same per-lane operations as
+ * dot_avx2(), so results are bit-for-bit the same
+ */
+__attribute__((target("avx2,fma")))
+static void gemm_avx2(const double* x, size_t nx, const double* matrix,
+    size_t rows, size_t size, double* out) {
+  size_t i = 0;
+  for (; i+2<=nx; i+=2) {
+    const double* x0 = x + i*size;
+    const double* x1 = x0 + size;
+    double* o0 = out + i*rows;
+    double* o1 = o0 + rows;
+    size_t r = 0;
+    for (; r+4<=rows; r+=4) {
+      const double* m0 = matrix + r*size;
+      const double* m1 = m0 + size;
+      const double* m2 = m1 + size;
+      const double* m3 = m2 + size;
+      __m256d a00 = _mm256_setzero_pd(), a01 = _mm256_setzero_pd();
+      __m256d a02 = _mm256_setzero_pd(), a03 = _mm256_setzero_pd();
+      __m256d a10 = _mm256_setzero_pd(), a11 = _mm256_setzero_pd();
+      __m256d a12 = _mm256_setzero_pd(), a13 = _mm256_setzero_pd();
+      for (size_t k=0; k<size; k+=4) {
+        __m256d xv0 = _mm256_load_pd(x0+k);
+        __m256d xv1 = _mm256_load_pd(x1+k);
+        __m256d mv = _mm256_load_pd(m0+k);
+        a00 = _mm256_fmadd_pd(xv0, mv, a00);
+        a10 = _mm256_fmadd_pd(xv1, mv, a10);
+        mv = _mm256_load_pd(m1+k);
+        a01 = _mm256_fmadd_pd(xv0, mv, a01);
+        a11 = _mm256_fmadd_pd(xv1, mv, a11);
+        mv = _mm256_load_pd(m2+k);
+        a02 = _mm256_fmadd_pd(xv0, mv, a02);
+        a12 = _mm256_fmadd_pd(xv1, mv, a12);
+        mv = _mm256_load_pd(m3+k);
+        a03 = _mm256_fmadd_pd(xv0, mv, a03);
+        a13 = _mm256_fmadd_pd(xv1, mv, a13);
+      }
+      o0[r] = hsum_avx2(a00);
+      o0[r+1] = hsum_avx2(a01);
+      o0[r+2] = hsum_avx2(a02);
+      o0[r+3] = hsum_avx2(a03);
+      o1[r] = hsum_avx2(a10);
+      o1[r+1] = hsum_avx2(a11);
+      o1[r+2] = hsum_avx2(a12);
+      o1[r+3] = hsum_avx2(a13);
+    }
+    if (r < rows) {
+      dot_avx2(x0, matrix + r*size, rows-r, size, o0 + r);
+      dot_avx2(x1, matrix + r*size, rows-r, size, o1 + r);
+    }
+  }
+  if (i < nx) dot_avx2(x + i*size, matrix, rows, size, out + i*rows);
+}
+
+/************************************************
+ * AVX-512: same as above, with 8 lanes at a time
+ ************************************************/
+
+__attribute__((target("avx512f")))
+static void dot_avx512(const double* x, const double* matrix, size_t rows,
+    size_t size, double* out) {
+  size_t r = 0;
+  for (; r+4<=rows; r+=4) {
+    const double* m0 = matrix + r*size;
+    const double* m1 = m0 + size;
+    const double* m2 = m1 + size;
+    const double* m3 = m2 + size;
+    __m512d a0 = _mm512_setzero_pd(), a1 = _mm512_setzero_pd();
+    __m512d a2 = _mm512_setzero_pd(), a3 = _mm512_setzero_pd();
+    for (size_t k=0; k<size; k+=8) {
+      __m512d xv = _mm512_load_pd(x+k);
+      a0 = _mm512_fmadd_pd(xv, _mm512_load_pd(m0+k), a0);
+      a1 = _mm512_fmadd_pd(xv, _mm512_load_pd(m1+k), a1);
+      a2 = _mm512_fmadd_pd(xv, _mm512_load_pd(m2+k), a2);
+      a3 = _mm512_fmadd_pd(xv, _mm512_load_pd(m3+k), a3);
+    }
+    out[r] = _mm512_reduce_add_pd(a0);
+    out[r+1] = _mm512_reduce_add_pd(a1);
+    out[r+2] = _mm512_reduce_add_pd(a2);
+    out[r+3] = _mm512_reduce_add_pd(a3);
+  }
+  for (; r<rows; ++r) {
+    const double* m0 = matrix + r*size;
+    __m512d a0 = _mm512_setzero_pd();
+    for (size_t k=0; k<size; k+=8)
+      a0 = _mm512_fmadd_pd(_mm512_load_pd(x+k), _mm512_load_pd(m0+k), a0);
+    out[r] = _mm512_reduce_add_pd(a0);
+  }
+}
+
+__attribute__((target("avx512f")))
+static void gemm_avx512(const double* x, size_t nx, const double* matrix,
+    size_t rows, size_t size, double* out) {
+  size_t i = 0;
+  for (; i+2<=nx; i+=2) {
+    const double* x0 = x + i*size;
+    const double* x1 = x0 + size;
+    double* o0 = out + i*rows;
+    double* o1 = o0 + rows;
+    size_t r = 0;
+    for (; r+4<=rows; r+=4) {
+      const double* m0 = matrix + r*size;
+      const double* m1 = m0 + size;
+      const double* m2 = m1 + size;
+      const double* m3 = m2 + size;
+      __m512d a00 = _mm512_setzero_pd(), a01 = _mm512_setzero_pd();
+      __m512d a02 = _mm512_setzero_pd(), a03 = _mm512_setzero_pd();
+      __m512d a10 = _mm512_setzero_pd(), a11 = _mm512_setzero_pd();
+      __m512d a12 = _mm512_setzero_pd(), a13 = _mm512_setzero_pd();
+      for (size_t k=0; k<size; k+=8) {
+        __m512d xv0 = _mm512_load_pd(x0+k);
+        __m512d xv1 = _mm512_load_pd(x1+k);
+        __m512d mv = _mm512_load_pd(m0+k);
+        a00 = _mm512_fmadd_pd(xv0, mv, a00);
+        a10 = _mm512_fmadd_pd(xv1, mv, a10);
+        mv = _mm512_load_pd(m1+k);
+        a01 = _mm512_fmadd_pd(xv0, mv, a01);
+        a11 = _mm512_fmadd_pd(xv1, mv, a11);
+        mv = _mm512_load_pd(m2+k);
+        a02 = _mm512_fmadd_pd(xv0, mv, a02);
+        a12 = _mm512_fmadd_pd(xv1, mv, a12);
+        mv = _mm512_load_pd(m3+k);
+        a03 = _mm512_fmadd_pd(xv0, mv, a03);
+        a13 = _mm512_fmadd_pd(xv1, mv, a13);
+      }
+      o0[r] = _mm512_reduce_add_pd(a00);
+      o0[r+1] = _mm512_reduce_add_pd(a01);
+      o0[r+2] = _mm512_reduce_add_pd(a02);
+      o0[r+3] = _mm512_reduce_add_pd(a03);
+      o1[r] = _mm512_reduce_add_pd(a10);
+      o1[r+1] = _mm512_reduce_add_pd(a11);
+      o1[r+2] = _mm512_reduce_add_pd(a12);
+      o1[r+3] = _mm512_reduce_add_pd(a13);
+    }
+    if (r < rows) {
+      dot_avx512(x0, matrix + r*size, rows-r, size, o0 + r);
+      dot_avx512(x1, matrix + r*size, rows-r, size, o1 + r);
+    }
+  }
+  if (i < nx) dot_avx512(x + i*size, matrix, rows, size, out + i*rows);
+}
+
+/***************************************************************
+ * Single precision: twice as many lanes, added up in double
+ * precision. Loops are organized like for the kernels above.
+ ***************************************************************/
+
+__attribute__((target("avx2,fma")))
+static inline double hsum_float_avx2(__m256 v) {
+  __m256d lo = _mm256_cvtps_pd(_mm256_castps256_ps128(v));
+  __m256d hi = _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1));
+  return hsum_avx2(_mm256_add_pd(lo, hi));
+}
+
+__attribute__((target("avx2,fma")))
+static void dot_float_avx2(const float* x, const float* matrix, size_t rows,
+    size_t size, double* out) {
+  size_t r = 0;
+  for (; r+4<=rows; r+=4) {
+    const float* m0 = matrix + r*size;
+    const float* m1 = m0 + size;
+    const float* m2 = m1 + size;
+    const float* m3 = m2 + size;
+    __m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps();
+    __m256 a2 = _mm256_setzero_ps(), a3 = _mm256_setzero_ps();
+    for (size_t k=0; k<size; k+=8) {
+      __m256 xv = _mm256_load_ps(x+k);
+      a0 = _mm256_fmadd_ps(xv, _mm256_load_ps(m0+k), a0);
+      a1 = _mm256_fmadd_ps(xv, _mm256_load_ps(m1+k), a1);
+      a2 = _mm256_fmadd_ps(xv, _mm256_load_ps(m2+k), a2);
+      a3 = _mm256_fmadd_ps(xv, _mm256_load_ps(m3+k), a3);
+    }
+    out[r] = hsum_float_avx2(a0);
+    out[r+1] = hsum_float_avx2(a1);
+    out[r+2] = hsum_float_avx2(a2);
+    out[r+3] = hsum_float_avx2(a3);
+  }
+  for (; r<rows; ++r) {
+    const float* m0 = matrix + r*size;
+    __m256 a0 = _mm256_setzero_ps();
+    for (size_t k=0; k<size; k+=8)
+      a0 = _mm256_fmadd_ps(_mm256_load_ps(x+k), _mm256_load_ps(m0+k), a0);
+    out[r] = hsum_float_avx2(a0);
+  }
+}
+
+__attribute__((target("avx2,fma")))
+static void gemm_float_avx2(const float* x, size_t nx, const float* matrix,
+    size_t rows, size_t size, double* out) {
+  size_t i = 0;
+  for (; i+2<=nx; i+=2) {
+    const float* x0 = x + i*size;
+    const float* x1 = x0 + size;
+    double* o0 = out + i*rows;
+    double* o1 = o0 + rows;
+    size_t r = 0;
+    for (; r+4<=rows; r+=4) {
+      const float* m0 = matrix + r*size;
+      const float* m1 = m0 + size;
+      const float* m2 = m1 + size;
+      const float* m3 = m2 + size;
+      __m256 a00 = _mm256_setzero_ps(), a01 = _mm256_setzero_ps();
+      __m256 a02 = _mm256_setzero_ps(), a03 = _mm256_setzero_ps();
+      __m256 a10 = _mm256_setzero_ps(), a11 = _mm256_setzero_ps();
+      __m256 a12 = _mm256_setzero_ps(), a13 = _mm256_setzero_ps();
+      for (size_t k=0; k<size; k+=8) {
+        __m256 xv0 = _mm256_load_ps(x0+k);
+        __m256 xv1 = _mm256_load_ps(x1+k);
+        __m256 mv = _mm256_load_ps(m0+k);
+        a00 = _mm256_fmadd_ps(xv0, mv, a00);
+        a10 = _mm256_fmadd_ps(xv1, mv, a10);
+        mv = _mm256_load_ps(m1+k);
+        a01 = _mm256_fmadd_ps(xv0, mv, a01);
+        a11 = _mm256_fmadd_ps(xv1, mv, a11);
+        mv = _mm256_load_ps(m2+k);
+        a02 = _mm256_fmadd_ps(xv0, mv, a02);
+        a12 = _mm256_fmadd_ps(xv1, mv, a12);
+        mv = _mm256_load_ps(m3+k);
+        a03 = _mm256_fmadd_ps(xv0, mv, a03);
+        a13 = _mm256_fmadd_ps(xv1, mv, a13);
+      }
+      o0[r] = hsum_float_avx2(a00);
+      o0[r+1] = hsum_float_avx2(a01);
+      o0[r+2] = hsum_float_avx2(a02);
+      o0[r+3] = hsum_float_avx2(a03);
+      o1[r] = hsum_float_avx2(a10);
+      o1[r+1] = hsum_float_avx2(a11);
+      o1[r+2] = hsum_float_avx2(a12);
+      o1[r+3] = hsum_float_avx2(a13);
+    }
+    if (r < rows) {
+      dot_float_avx2(x0, matrix + r*size, rows-r, size, o0 + r);
+      dot_float_avx2(x1, matrix + r*size, rows-r, size, o1 + r);
+    }
+  }
+  if (i < nx) dot_float_avx2(x + i*size, matrix, rows, size, out + i*rows);
+}
+
+__attribute__((target("avx512f")))
+static inline double hsum_float_avx512(__m512 v) {
+  __m512d lo = _mm512_cvtps_pd(_mm512_castps512_ps256(v));
+  __m512d hi = _mm512_cvtps_pd(_mm256_castpd_ps(
+        _mm512_extractf64x4_pd(_mm512_castps_pd(v), 1)));
+  return _mm512_reduce_add_pd(_mm512_add_pd(lo, hi));
+}
+
+__attribute__((target("avx512f")))
+static void dot_float_avx512(const float* x, const float* matrix,
+    size_t rows, size_t size, double* out) {
+  size_t r = 0;
+  for (; r+4<=rows; r+=4) {
+    const float* m0 = matrix + r*size;
+    const float* m1 = m0 + size;
+    const float* m2 = m1 + size;
+    const float* m3 = m2 + size;
+    __m512 a0 = _mm512_setzero_ps(), a1 = _mm512_setzero_ps();
+    __m512 a2 = _mm512_setzero_ps(), a3 = _mm512_setzero_ps();
+    for (size_t k=0; k<size; k+=16) {
+      __m512 xv = _mm512_load_ps(x+k);
+      a0 = _mm512_fmadd_ps(xv, _mm512_load_ps(m0+k), a0);
+      a1 = _mm512_fmadd_ps(xv, _mm512_load_ps(m1+k), a1);
+      a2 = _mm512_fmadd_ps(xv, _mm512_load_ps(m2+k), a2);
+      a3 = _mm512_fmadd_ps(xv, _mm512_load_ps(m3+k), a3);
+    }
+    out[r] = hsum_float_avx512(a0);
+    out[r+1] = hsum_float_avx512(a1);
+    out[r+2] = hsum_float_avx512(a2);
+    out[r+3] = hsum_float_avx512(a3);
+  }
+  for (; r<rows; ++r) {
+    const float* m0 = matrix + r*size;
+    __m512 a0 = _mm512_setzero_ps();
+    for (size_t k=0; k<size; k+=16)
+      a0 = _mm512_fmadd_ps(_mm512_load_ps(x+k), _mm512_load_ps(m0+k), a0);
+    out[r] = hsum_float_avx512(a0);
+  }
+}
+
+__attribute__((target("avx512f")))
+static void gemm_float_avx512(const float* x, size_t nx, const float* matrix,
+    size_t rows, size_t size, double* out) {
+  size_t i = 0;
+  for (; i+2<=nx; i+=2) {
+    const float* x0 = x + i*size;
+    const float* x1 = x0 + size;
+    double* o0 = out + i*rows;
+    double* o1 = o0 + rows;
+    size_t r = 0;
+    for (; r+4<=rows; r+=4) {
+      const float* m0 = matrix + r*size;
+      const float* m1 = m0 + size;
+      const float* m2 = m1 + size;
+      const float* m3 = m2 + size;
+      __m512 a00 = _mm512_setzero_ps(), a01 = _mm512_setzero_ps();
+      __m512 a02 = _mm512_setzero_ps(), a03 = _mm512_setzero_ps();
+      __m512 a10 = _mm512_setzero_ps(), a11 = _mm512_setzero_ps();
+      __m512 a12 = _mm512_setzero_ps(), a13 = _mm512_setzero_ps();
+      for (size_t k=0; k<size; k+=16) {
+        __m512 xv0 = _mm512_load_ps(x0+k);
+        __m512 xv1 = _mm512_load_ps(x1+k);
+        __m512 mv = _mm512_load_ps(m0+k);
+        a00 = _mm512_fmadd_ps(xv0, mv, a00);
+        a10 = _mm512_fmadd_ps(xv1, mv, a10);
+        mv = _mm512_load_ps(m1+k);
+        a01 = _mm512_fmadd_ps(xv0, mv, a01);
+        a11 = _mm512_fmadd_ps(xv1, mv, a11);
+        mv = _mm512_load_ps(m2+k);
+        a02 = _mm512_fmadd_ps(xv0, mv, a02);
+        a12 = _mm512_fmadd_ps(xv1, mv, a12);
+        mv = _mm512_load_ps(m3+k);
+        a03 = _mm512_fmadd_ps(xv0, mv, a03);
+        a13 = _mm512_fmadd_ps(xv1, mv, a13);
+      }
+      o0[r] = hsum_float_avx512(a00);
+      o0[r+1] = hsum_float_avx512(a01);
+      o0[r+2] = hsum_float_avx512(a02);
+      o0[r+3] = hsum_float_avx512(a03);
+      o1[r] = hsum_float_avx512(a10);
+      o1[r+1] = hsum_float_avx512(a11);
+      o1[r+2] = hsum_float_avx512(a12);
+      o1[r+3] = hsum_float_avx512(a13);
+    }
+    if (r < rows) {
+      dot_float_avx512(x0, matrix + r*size, rows-r, size, o0 + r);
+      dot_float_avx512(x1, matrix + r*size, rows-r, size, o1 + r);
+    }
+  }
+  if (i < nx) dot_float_avx512(x + i*size, matrix, rows, size, out + i*rows);
+}
+
+#endif /* BOB_LEARN_LIBSVM_X86_SIMD */
+
+/**
+ * Same as libsvm's powi()
+ */
+static inline double powi(double base, int times) {
+  double tmp = base, ret = 1.0;
+  for (int t=times; t>0; t/=2) {
+    if (t%2==1) ret *= tmp;
+    tmp = tmp * tmp;
+  }
+  return ret;
+}
+
+const size_t bob::learn::libsvm::DenseEngine::BATCH_SIZE;
+
+/**
+ * Number of decision functions in a model: one per pair of classes for
+ * classification, a single one otherwise
+ */
+static size_t number_of_functions(const svm_model* model) {
+  int svm_type = model->param.svm_type;
+  if (svm_type == ONE_CLASS || svm_type == EPSILON_SVR || svm_type == NU_SVR)
+    return 1;
+  return (model->nr_class*(model->nr_class-1))/2;
+}
+
+/**
+ * Size, in bytes, of the tiles of support vectors used in batch mode, so
+ * that one tile stays in the (L2) cache while it is used for all inputs
+ */
+static const size_t TILE_BYTES = 128 * 1024;
+
+const char* bob::learn::libsvm::DenseEngine::kernels(block_function& dot,
+    gemm_function& gemm) {
+#ifdef BOB_LEARN_LIBSVM_X86_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    dot = dot_avx512;
+    gemm = gemm_avx512;
+    return "avx512";
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    dot = dot_avx2;
+    gemm = gemm_avx2;
+    return "avx2";
+  }
+#endif
+  dot = dot_generic;
+  gemm = gemm_generic;
+  return "generic";
+}
+
+const char* bob::learn::libsvm::DenseEngine::kernels(float_block_function& dot,
+    float_gemm_function& gemm) {
+#ifdef BOB_LEARN_LIBSVM_X86_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    dot = dot_float_avx512;
+    gemm = gemm_float_avx512;
+    return "avx512";
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    dot = dot_float_avx2;
+    gemm = gemm_float_avx2;
+    return "avx2";
+  }
+#endif
+  dot = dot_float_generic;
+  gemm = gemm_float_generic;
+  return "generic";
+}
+
+bool bob::learn::libsvm::DenseEngine::suitable(const svm_model* model,
+    size_t input_size, bool single) {
+
+  if (model->param.kernel_type == PRECOMPUTED) return false;
+
+  size_t nnz = 0;
+  for (int i=0; i<model->l; ++i)
+    for (const svm_node* p = model->SV[i]; p->index != -1; ++p) ++nnz;
+
+  //do not use more than 4x the memory of the sparse representation (that
+  //is, at least 1/8th of all features must be non-zero, or 1/16th in single
+  //precision)
+  size_t padded = padded_size(input_size, single);
+  size_t rows = model->l;
+  if (model->param.kernel_type == LINEAR) rows = number_of_functions(model);
+  size_t element = single ? sizeof(float) : sizeof(double);
+  return (rows * padded * element) <=
+    4 * (nnz + model->l) * sizeof(svm_node);
+}
+
+/**
+ * Adds ``coef`` times the sparse vector ``sv`` to the dense vector ``row``.
+ * Features beyond the input size are never used by libsvm and are skipped.
+ */
+void bob::learn::libsvm::DenseEngine::accumulate(const svm_node* sv,
+    double coef, double* row) const {
+  for (const svm_node* p = sv; p->index != -1; ++p) {
+    if (p->index >= 1 && (size_t)p->index <= m_input_size)
+      row[p->index-1] += coef * p->value;
+  }
+}
+
+bob::learn::libsvm::DenseEngine::DenseEngine(const svm_model* model,
+    size_t input_size, bool single, pages_t pages):
+  m_svm_type(model->param.svm_type),
+  m_kernel_type(model->param.kernel_type),
+  m_degree(model->param.degree),
+  m_gamma(model->param.gamma),
+  m_coef0(model->param.coef0),
+  m_nr_class(model->nr_class),
+  m_l(model->l),
+  m_input_size(input_size),
+  m_padded_size(padded_size(input_size, single)),
+  m_functions(number_of_functions(model)),
+  m_tile(0),
+  m_single(single),
+  m_estimator(model),
+  m_sv(model_allocator<double>(pages)),
+  m_weights(model_allocator<double>(pages)),
+  m_sv32(model_allocator<float>(pages)),
+  m_weights32(model_allocator<float>(pages)),
+  m_dot(dot_generic),
+  m_gemm(gemm_generic),
+  m_dot32(dot_float_generic),
+  m_gemm32(gemm_float_generic),
+  m_isa("generic")
+{
+  if (m_kernel_type == PRECOMPUTED) {
+    throw std::runtime_error("dense engines do not support pre-computed kernels");
+  }
+
+  size_t pairs = (m_nr_class*(m_nr_class-1))/2;
+  m_sv_coef.resize((m_nr_class-1) * m_l);
+  for (int k=0; k<m_nr_class-1; ++k)
+    std::copy(model->sv_coef[k], model->sv_coef[k] + m_l,
+        m_sv_coef.begin() + k*m_l);
+  m_rho.assign(model->rho, model->rho + pairs);
+  if (model->label) m_label.assign(model->label, model->label + m_nr_class);
+  if (model->nSV) {
+    m_nSV.assign(model->nSV, model->nSV + m_nr_class);
+    m_start.resize(m_nr_class, 0);
+    for (int i=1; i<m_nr_class; ++i) m_start[i] = m_start[i-1] + m_nSV[i-1];
+  }
+
+  m_isa = kernels(m_dot, m_gemm);
+  kernels(m_dot32, m_gemm32);
+
+  if (m_kernel_type == LINEAR && m_functions) {
+    //collapses the support vectors of each decision function into a single
+    //weight vector: sum_i coef_i * <x, SV_i> == <x, sum_i coef_i * SV_i>
+    m_weights.assign(m_functions * m_padded_size, 0.);
+    if (m_functions == 1) {
+      for (size_t i=0; i<m_l; ++i)
+        accumulate(model->SV[i], m_sv_coef[i], &m_weights[0]);
+    }
+    else {
+      int p = 0;
+      for (int i=0; i<m_nr_class; ++i) {
+        for (int j=i+1; j<m_nr_class; ++j, ++p) {
+          double* w = &m_weights[p * m_padded_size];
+          const double* coef1 = &m_sv_coef[(j-1)*m_l];
+          const double* coef2 = &m_sv_coef[i*m_l];
+          for (int k=0; k<m_nSV[i]; ++k) {
+            int sv = m_start[i] + k;
+            accumulate(model->SV[sv], coef1[sv], w);
+          }
+          for (int k=0; k<m_nSV[j]; ++k) {
+            int sv = m_start[j] + k;
+            accumulate(model->SV[sv], coef2[sv], w);
+          }
+        }
+      }
+    }
+    if (m_single) { //weights are summed in double precision, then rounded
+      m_weights32.assign(m_weights.begin(), m_weights.end());
+      model_vector(m_weights.get_allocator()).swap(m_weights);
+    }
+    return;
+  }
+
+  m_sv.assign(m_l * m_padded_size, 0.);
+  for (size_t i=0; i<m_l; ++i)
+    accumulate(model->SV[i], 1., &m_sv[i * m_padded_size]);
+  if (m_single) {
+    m_sv32.assign(m_sv.begin(), m_sv.end());
+    model_vector(m_sv.get_allocator()).swap(m_sv);
+  }
+
+  if (m_kernel_type == RBF) {
+    //||x-sv||^2 = ||x||^2 + ||sv||^2 - 2<x,sv>: caches ||sv||^2, of the
+    //support vectors as they are stored
+    m_sv_norm.resize(m_l);
+    for (size_t i=0; i<m_l; ++i) {
+      if (m_single) m_sv_norm[i] = norm(&m_sv32[i * m_padded_size]);
+      else m_sv_norm[i] = norm(&m_sv[i * m_padded_size]);
+    }
+  }
+
+  //tiles hold a multiple of 4 support vectors, the block size of kernels
+  size_t element = m_single ? sizeof(float) : sizeof(double);
+  m_tile = TILE_BYTES / (m_padded_size * element);
+  m_tile = std::max<size_t>(4, m_tile - (m_tile % 4));
+  m_tile = std::min(m_tile, m_l);
+}
+
+/**
+ * The workspace is organized like this: kernel values (l, none in primal
+ * mode), votes (nr_class), decision values (pairs), the scratch space for
+ * probabilities (see ProbabilityEstimator) and, in single precision, the
+ * rounded input.
+ */
+size_t bob::learn::libsvm::DenseEngine::kernelSize() const {
+  return primal() ? 0 : m_l;
+}
+
+/**
+ * Rounded inputs take half as many doubles as they have elements, plus
+ * space for aligning them
+ */
+size_t bob::learn::libsvm::DenseEngine::roundedSize(size_t n) const {
+  if (!m_single) return 0;
+  return (n * m_padded_size) / 2 + ENGINE_ALIGNMENT / sizeof(double);
+}
+
+size_t bob::learn::libsvm::DenseEngine::workspaceSize() const {
+  size_t pairs = std::max(1, (m_nr_class*(m_nr_class-1))/2);
+  return kernelSize() + m_nr_class + pairs + m_estimator.workspaceSize(1) +
+    roundedSize(1);
+}
+
+/**
+ * In batch mode, the workspace holds: kernel values for one tile of
+ * support vectors (BATCH_SIZE x tile), the squared norms of the inputs
+ * (BATCH_SIZE), decision values (BATCH_SIZE x functions), votes
+ * (nr_class), the scratch space for the probabilities of BATCH_SIZE inputs
+ * (see ProbabilityEstimator) and, in single precision, the rounded inputs.
+ */
+size_t bob::learn::libsvm::DenseEngine::batchWorkspaceSize() const {
+  return BATCH_SIZE*m_tile + BATCH_SIZE + BATCH_SIZE*std::max<size_t>(1,
+      m_functions) + m_nr_class + m_estimator.workspaceSize(BATCH_SIZE) +
+    roundedSize(BATCH_SIZE);
+}
+
+void bob::learn::libsvm::DenseEngine::round(const double* input, size_t n,
+    float* rounded) const {
+  for (size_t k=0; k<n*m_padded_size; ++k) rounded[k] = input[k];
+}
+
+double bob::learn::libsvm::DenseEngine::norm(const double* input) const {
+  double retval = 0.;
+  m_dot(input, input, 1, m_padded_size, &retval);
+  return retval;
+}
+
+double bob::learn::libsvm::DenseEngine::norm(const float* input) const {
+  double retval = 0.;
+  for (size_t k=0; k<m_padded_size; ++k)
+    retval += (double)input[k]*input[k];
+  return retval;
+}
+
+void bob::learn::libsvm::DenseEngine::gemm(const double* input, size_t n,
+    const double* matrix, size_t rows, double* out) const {
+  m_gemm(input, n, matrix, rows, m_padded_size, out);
+}
+
+void bob::learn::libsvm::DenseEngine::gemm(const float* input, size_t n,
+    const float* matrix, size_t rows, double* out) const {
+  m_gemm32(input, n, matrix, rows, m_padded_size, out);
+}
+
+void bob::learn::libsvm::DenseEngine::transform(double* values, size_t n,
+    double input_norm, const double* sv_norm) const {
+
+  switch (m_kernel_type) {
+    case POLY:
+      for (size_t i=0; i<n; ++i)
+        values[i] = powi(m_gamma*values[i]+m_coef0, m_degree);
+      break;
+    case RBF:
+      for (size_t i=0; i<n; ++i) {
+        double d = std::max(0., input_norm + sv_norm[i] - 2*values[i]);
+        values[i] = std::exp(-m_gamma*d);
+      }
+      break;
+    case SIGMOID:
+      for (size_t i=0; i<n; ++i)
+        values[i] = std::tanh(m_gamma*values[i]+m_coef0);
+      break;
+    default: //LINEAR
+      break;
+  }
+
+}
+
+template <typename T>
+void bob::learn::libsvm::DenseEngine::kernel(const T* input, const T* sv,
+    double* kvalue) const {
+  double input_norm = 0.;
+  if (m_kernel_type == RBF) input_norm = norm(input);
+  gemm(input, 1, sv, m_l, kvalue);
+  transform(kvalue, m_l, input_norm, m_sv_norm.data());
+}
+
+void bob::learn::libsvm::DenseEngine::decide(const double* kvalue,
+    double* dec_values) const {
+
+  if (m_svm_type == ONE_CLASS || m_svm_type == EPSILON_SVR ||
+      m_svm_type == NU_SVR) {
+    const double* coef = m_sv_coef.data();
+    double sum = 0;
+    for (size_t i=0; i<m_l; ++i) sum += coef[i] * kvalue[i];
+    *dec_values = sum - m_rho[0];
+    return;
+  }
+
+  //classification: one-versus-one, in libsvm's order
+  int nr_class = m_nr_class;
+  int p = 0;
+  for (int i=0; i<nr_class; ++i) {
+    for (int j=i+1; j<nr_class; ++j) {
+      double sum = 0;
+      int si = m_start[i];
+      int sj = m_start[j];
+      int ci = m_nSV[i];
+      int cj = m_nSV[j];
+      const double* coef1 = &m_sv_coef[(j-1)*m_l];
+      const double* coef2 = &m_sv_coef[i*m_l];
+      for (int k=0; k<ci; ++k) sum += coef1[si+k] * kvalue[si+k];
+      for (int k=0; k<cj; ++k) sum += coef2[sj+k] * kvalue[sj+k];
+      dec_values[p] = sum - m_rho[p];
+      ++p;
+    }
+  }
+}
+
+/**
+ * Adds the contributions of support vectors [start, end) to a running sum,
+ * where ``kvalue`` holds the kernel values from ``start`` onwards (up to
+ * ``tile_end``)
+ */
+static inline double partial_sum(double sum, const double* coef,
+    const double* kvalue, size_t start, size_t end, size_t tile_start,
+    size_t tile_end) {
+  size_t lo = std::max(start, tile_start);
+  size_t hi = std::min(end, tile_end);
+  for (size_t k=lo; k<hi; ++k) sum += coef[k] * kvalue[k-tile_start];
+  return sum;
+}
+
+void bob::learn::libsvm::DenseEngine::decideTile(const double* kvalue,
+    size_t n, size_t tile_start, size_t tile_end, double* dec_values) const {
+
+  size_t rows = tile_end - tile_start;
+
+  if (m_svm_type == ONE_CLASS || m_svm_type == EPSILON_SVR ||
+      m_svm_type == NU_SVR) {
+    for (size_t i=0; i<n; ++i, kvalue+=rows, dec_values+=m_functions)
+      *dec_values = partial_sum(*dec_values, m_sv_coef.data(), kvalue, 0,
+          m_l, tile_start, tile_end);
+    return;
+  }
+
+  //the sums for each pair of classes arrive in the same order as in
+  //decide(), so results are bit-for-bit the same
+  int nr_class = m_nr_class;
+  for (size_t b=0; b<n; ++b, kvalue+=rows, dec_values+=m_functions) {
+    int p = 0;
+    for (int i=0; i<nr_class; ++i) {
+      for (int j=i+1; j<nr_class; ++j, ++p) {
+        size_t si = m_start[i];
+        size_t sj = m_start[j];
+        const double* coef1 = &m_sv_coef[(j-1)*m_l];
+        const double* coef2 = &m_sv_coef[i*m_l];
+        double sum = partial_sum(dec_values[p], coef1, kvalue, si,
+            si + m_nSV[i], tile_start, tile_end);
+        dec_values[p] = partial_sum(sum, coef2, kvalue, sj, sj + m_nSV[j],
+            tile_start, tile_end);
+      }
+    }
+  }
+}
+
+template <typename T>
+void bob::learn::libsvm::DenseEngine::decidePrimal(const T* input,
+    const T* weights, double* dec_values) const {
+  gemm(input, 1, weights, m_functions, dec_values);
+  for (size_t p=0; p<m_functions; ++p) dec_values[p] -= m_rho[p];
+}
+
+double bob::learn::libsvm::DenseEngine::output(double* dec_values,
+    double* vote) const {
+
+  if (m_svm_type == ONE_CLASS) return (dec_values[0]>0)?1:-1;
+  if (m_svm_type == EPSILON_SVR || m_svm_type == NU_SVR) return dec_values[0];
+
+  int nr_class = m_nr_class;
+  int vote_max_idx = 0;
+  std::fill(vote, vote + nr_class, 0.);
+  int p = 0;
+  for (int i=0; i<nr_class; ++i) {
+    for (int j=i+1; j<nr_class; ++j, ++p) {
+      if (dec_values[p] > 0) ++vote[i];
+      else ++vote[j];
+    }
+  }
+  for (int i=1; i<nr_class; ++i)
+    if (vote[i] > vote[vote_max_idx]) vote_max_idx = i;
+  return m_label[vote_max_idx];
+}
+
+double bob::learn::libsvm::DenseEngine::predictValues(const double* input,
+    double* dec_values, double* work, PhaseTimes* times) const {
+
+  uint64_t start = times ? nanoseconds() : 0;
+
+  if (m_single) {
+    float* x = aligned_floats(work + workspaceSize() - roundedSize(1));
+    round(input, 1, x);
+    if (primal()) decidePrimal(x, m_weights32.data(), dec_values);
+    else {
+      kernel(x, m_sv32.data(), work);
+      decide(work, dec_values);
+    }
+  }
+  else if (primal()) decidePrimal(input, m_weights.data(), dec_values);
+  else {
+    kernel(input, m_sv.data(), work);
+    decide(work, dec_values);
+  }
+
+  if (!times) return output(dec_values, work + kernelSize());
+
+  uint64_t decided = nanoseconds();
+  double retval = output(dec_values, work + kernelSize());
+  times->kernel += decided - start;
+  times->voting += nanoseconds() - decided;
+  return retval;
+}
+
+double bob::learn::libsvm::DenseEngine::predict(const double* input,
+    double* work, PhaseTimes* times) const {
+  return predictValues(input, work + kernelSize() + m_nr_class, work, times);
+}
+
+double bob::learn::libsvm::DenseEngine::predictProbability
+(const double* input, double* prob_estimates, double* work,
+ PhaseTimes* times, coupling_t coupling) const {
+
+  if (!m_estimator.supported()) return predict(input, work, times);
+
+  size_t pairs = std::max(1, (m_nr_class*(m_nr_class-1))/2);
+  double* dec_values = work + kernelSize() + m_nr_class;
+
+  predictValues(input, dec_values, work, times);
+
+  uint64_t start = times ? nanoseconds() : 0;
+  double retval = m_estimator.estimate(dec_values, prob_estimates,
+      dec_values + pairs, coupling);
+  if (times) times->voting += nanoseconds() - start;
+  return retval;
+}
+
+void bob::learn::libsvm::DenseEngine::predictValues(const double* input,
+    size_t n, double* labels, double* dec_values, double* work,
+    PhaseTimes* times) const {
+
+  if (n > BATCH_SIZE) {
+    throw std::runtime_error("too many inputs for a batch of the dense engine");
+  }
+
+  if (m_single) {
+    float* x = aligned_floats(work + batchWorkspaceSize() -
+        roundedSize(BATCH_SIZE));
+    round(input, n, x);
+    predictBatch(x, primal() ? m_weights32.data() : m_sv32.data(), n,
+        labels, dec_values, work, times);
+    return;
+  }
+
+  predictBatch(input, primal() ? m_weights.data() : m_sv.data(), n, labels,
+      dec_values, work, times);
+}
+
+template <typename T>
+void bob::learn::libsvm::DenseEngine::predictBatch(const T* input,
+    const T* matrix, size_t n, double* labels, double* dec_values,
+    double* work, PhaseTimes* times) const {
+
+  double* vote = work + BATCH_SIZE*m_tile + BATCH_SIZE +
+    BATCH_SIZE*std::max<size_t>(1, m_functions);
+  uint64_t begin = times ? nanoseconds() : 0;
+
+  if (primal()) {
+    //one (small) matrix product with the primal weights
+    gemm(input, n, matrix, m_functions, dec_values);
+  }
+  else {
+    //processes support vectors one tile at a time, for all inputs
+    double* kvalue = work;
+    double* norm = kvalue + BATCH_SIZE*m_tile;
+    std::fill(dec_values, dec_values + n*m_functions, 0.);
+    std::fill(norm, norm + n, 0.);
+    if (m_kernel_type == RBF) {
+      for (size_t i=0; i<n; ++i) norm[i] = this->norm(input + i*m_padded_size);
+    }
+
+    for (size_t start=0; start<m_l; start+=m_tile) {
+      size_t end = std::min(m_l, start+m_tile);
+      size_t rows = end - start;
+      gemm(input, n, matrix + start*m_padded_size, rows, kvalue);
+      for (size_t i=0; i<n; ++i) {
+        transform(kvalue + i*rows, rows, norm[i],
+            m_sv_norm.empty() ? 0 : &m_sv_norm[start]);
+      }
+      decideTile(kvalue, n, start, end, dec_values);
+    }
+  }
+
+  for (size_t i=0; i<n; ++i) {
+    double* dec = dec_values + i*m_functions;
+    for (size_t p=0; p<m_functions; ++p) dec[p] -= m_rho[p];
+  }
+
+  uint64_t decided = times ? nanoseconds() : 0;
+  for (size_t i=0; i<n; ++i) labels[i] = output(dec_values + i*m_functions, vote);
+  if (times) {
+    times->kernel += decided - begin;
+    times->voting += nanoseconds() - decided;
+  }
+}
+
+void bob::learn::libsvm::DenseEngine::predictProbability(const double* input,
+    size_t n, double* labels, double* prob_estimates, double* work,
+    PhaseTimes* times, coupling_t coupling) const {
+
+  double* dec_values = work + BATCH_SIZE*m_tile + BATCH_SIZE;
+  double* scratch = dec_values + BATCH_SIZE*std::max<size_t>(1, m_functions)
+    + m_nr_class;
+
+  predictValues(input, n, labels, dec_values, work, times);
+  if (!m_estimator.supported()) return;
+
+  uint64_t start = times ? nanoseconds() : 0;
+  m_estimator.estimate(dec_values, n, labels, prob_estimates, scratch,
+      coupling);
+  if (times) times->voting += nanoseconds() - start;
+}
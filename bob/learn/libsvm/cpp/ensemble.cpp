@@ -0,0 +1,383 @@
+/**
+ * @date Thu 15 Oct 2026 19:12:37 CEST
+ *
+ * @brief Implementation of ensembles of machines
+ *
+ * Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+ */
+
+#include <bob.learn.libsvm/ensemble.h>
+#include <bob.learn.libsvm/parallel.h>
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <boost/format.hpp>
+#include <boost/functional/hash.hpp>
+#include <bob.core/check.h>
+
+/**
+ * Number of doubles rows are padded to, like in the dense engine
+ */
+static const size_t PADDING = 8;
+
+/**
+ * Same as libsvm's powi()
+ */
+static inline double powi(double base, int times) {
+  double tmp = base, ret = 1.0;
+  for (int t=times; t>0; t/=2) {
+    if (t%2==1) ret *= tmp;
+    tmp = tmp * tmp;
+  }
+  return ret;
+}
+
+/**
+ * Tells if two machines scale their inputs in the same way
+ */
+static bool same_scaling(const blitz::Array<double,1>& sub1,
+    const blitz::Array<double,1>& div1, const blitz::Array<double,1>& sub2,
+    const blitz::Array<double,1>& div2) {
+  for (int k=0; k<sub1.extent(0); ++k) {
+    if (sub1(k) != sub2(k) || div1(k) != div2(k)) return false;
+  }
+  return true;
+}
+
+bob::learn::libsvm::Ensemble::Ensemble
+(const std::vector<boost::shared_ptr<const Machine> >& machines):
+  m_input_size(0),
+  m_padded_size(0),
+  m_output_size(0),
+  m_support_vectors(0),
+  m_unique(0),
+  m_max_class(1)
+{
+
+  if (machines.empty()) {
+    throw std::runtime_error("ensembles require at least one machine");
+  }
+
+  m_input_size = machines[0]->m_input_size;
+  m_padded_size = ((m_input_size + PADDING - 1) / PADDING) * PADDING;
+  DenseEngine::kernels(m_dot, m_gemm);
+
+  //representative machine of each scaling, to compare others with
+  std::vector<const Machine*> scaled_by;
+
+  //support vectors of each kernel set, hashed, to find duplicates
+  std::vector<std::unordered_multimap<size_t, size_t> > hashes;
+
+  aligned_vector row(m_padded_size);
+
+  for (size_t i=0; i<machines.size(); ++i) {
+
+    const Machine& machine = *machines[i];
+    const svm_model* model = machine.m_model.get();
+
+    if (machine.m_input_size != m_input_size) {
+      boost::format m("all machines of an ensemble should have the same input size, but machine %d takes %d inputs instead of %d");
+      m % i % machine.m_input_size % m_input_size;
+      throw std::runtime_error(m.str());
+    }
+
+    if (model->param.kernel_type == PRECOMPUTED) {
+      boost::format m("machine %d of the ensemble uses a pre-computed kernel, which is not supported");
+      m % i;
+      throw std::runtime_error(m.str());
+    }
+
+    //finds (or adds) its scaling
+    size_t scaling = 0;
+    for (; scaling<scaled_by.size(); ++scaling) {
+      const Machine& other = *scaled_by[scaling];
+      if (same_scaling(machine.m_input_sub, machine.m_input_div,
+            other.m_input_sub, other.m_input_div)) break;
+    }
+    if (scaling == scaled_by.size()) {
+      scaled_by.push_back(&machine);
+      Scaling s;
+      s.sub.assign(machine.m_input_sub.begin(), machine.m_input_sub.end());
+      s.scale = machine.m_input_scale;
+      s.scaling = machine.m_scaling;
+      m_scalings.push_back(s);
+    }
+
+    //finds (or adds) its kernel set: parameters the kernel does not use
+    //are ignored
+    KernelSet key;
+    key.scaling = scaling;
+    key.kernel_type = model->param.kernel_type;
+    key.degree = (key.kernel_type == POLY) ? model->param.degree : 0;
+    key.gamma = (key.kernel_type == LINEAR) ? 0. : model->param.gamma;
+    key.coef0 = (key.kernel_type == POLY || key.kernel_type == SIGMOID) ?
+      model->param.coef0 : 0.;
+    key.rows = 0;
+    key.offset = 0;
+
+    size_t kernels = 0;
+    for (; kernels<m_kernels.size(); ++kernels) {
+      const KernelSet& k = m_kernels[kernels];
+      if (k.scaling == key.scaling && k.kernel_type == key.kernel_type &&
+          k.degree == key.degree && k.gamma == key.gamma &&
+          k.coef0 == key.coef0) break;
+    }
+    if (kernels == m_kernels.size()) {
+      m_kernels.push_back(key);
+      hashes.push_back(std::unordered_multimap<size_t, size_t>());
+    }
+    KernelSet& set = m_kernels[kernels];
+
+    Model m;
+    m.kernels = kernels;
+    m.svm_type = model->param.svm_type;
+    m.nr_class = model->nr_class;
+    m.l = model->l;
+    m.offset = m_output_size;
+
+    size_t pairs = (m.nr_class*(m.nr_class-1))/2;
+    if (m.svm_type == ONE_CLASS || m.svm_type == EPSILON_SVR ||
+        m.svm_type == NU_SVR) m.functions = 1;
+    else m.functions = pairs;
+
+    m.sv_coef.resize((m.nr_class-1) * m.l);
+    for (int k=0; k<m.nr_class-1; ++k)
+      std::copy(model->sv_coef[k], model->sv_coef[k] + m.l,
+          m.sv_coef.begin() + k*m.l);
+    m.rho.assign(model->rho, model->rho + m.functions);
+    if (model->label) m.label.assign(model->label, model->label + m.nr_class);
+    if (model->nSV) {
+      m.nSV.assign(model->nSV, model->nSV + m.nr_class);
+      m.start.resize(m.nr_class, 0);
+      for (int k=1; k<m.nr_class; ++k) m.start[k] = m.start[k-1] + m.nSV[k-1];
+    }
+
+    //stores its support vectors, unless the kernel set has them already
+    m.sv.resize(m.l);
+    for (size_t k=0; k<m.l; ++k) {
+      std::fill(row.begin(), row.end(), 0.);
+      for (const svm_node* p = model->SV[k]; p->index != -1; ++p) {
+        if (p->index >= 1 && (size_t)p->index <= m_input_size)
+          row[p->index-1] = p->value;
+      }
+      size_t hash = boost::hash_range(row.begin(), row.end());
+      auto range = hashes[kernels].equal_range(hash);
+      size_t found = set.rows;
+      for (auto it = range.first; it != range.second; ++it) {
+        if (std::equal(row.begin(), row.end(),
+              set.sv.begin() + it->second * m_padded_size)) {
+          found = it->second;
+          break;
+        }
+      }
+      if (found == set.rows) {
+        set.sv.insert(set.sv.end(), row.begin(), row.end());
+        hashes[kernels].insert(std::make_pair(hash, set.rows));
+        ++set.rows;
+      }
+      m.sv[k] = found;
+    }
+
+    m_output_size += m.functions;
+    m_support_vectors += m.l;
+    m_max_class = std::max(m_max_class, m.nr_class);
+    m_models.push_back(m);
+
+  }
+
+  for (size_t k=0; k<m_kernels.size(); ++k) {
+    KernelSet& set = m_kernels[k];
+    set.offset = m_unique;
+    m_unique += set.rows;
+    if (set.kernel_type == RBF) {
+      set.norm.resize(set.rows);
+      for (size_t i=0; i<set.rows; ++i) {
+        const double* sv = &set.sv[i * m_padded_size];
+        m_dot(sv, sv, 1, m_padded_size, &set.norm[i]);
+      }
+    }
+  }
+
+}
+
+bob::learn::libsvm::Ensemble::~Ensemble() {}
+
+/**
+ * The workspace holds, in order: the scaled inputs (BATCH_SIZE for each
+ * scaling) and the kernel values (BATCH_SIZE for each kernel set, one row
+ * of support vectors for each input), then votes
+ */
+size_t bob::learn::libsvm::Ensemble::workspaceSize() const {
+  size_t batch = DenseEngine::BATCH_SIZE;
+  return m_scalings.size() * batch * m_padded_size + batch * m_unique +
+    m_max_class;
+}
+
+double bob::learn::libsvm::Ensemble::decide(const Model& model,
+    const double* kvalue, double* dec_values, double* vote) const {
+
+  const std::vector<size_t>& sv = model.sv;
+
+  if (model.svm_type == ONE_CLASS || model.svm_type == EPSILON_SVR ||
+      model.svm_type == NU_SVR) {
+    const double* coef = model.sv_coef.data();
+    double sum = 0;
+    for (size_t i=0; i<model.l; ++i) sum += coef[i] * kvalue[sv[i]];
+    *dec_values = sum - model.rho[0];
+    if (model.svm_type == ONE_CLASS) return (*dec_values>0)?1:-1;
+    return *dec_values;
+  }
+
+  //classification: one-versus-one, in libsvm's order, then votes
+  int nr_class = model.nr_class;
+  std::fill(vote, vote + nr_class, 0.);
+  int p = 0;
+  for (int i=0; i<nr_class; ++i) {
+    for (int j=i+1; j<nr_class; ++j, ++p) {
+      double sum = 0;
+      int si = model.start[i];
+      int sj = model.start[j];
+      int ci = model.nSV[i];
+      int cj = model.nSV[j];
+      const double* coef1 = &model.sv_coef[(j-1)*model.l];
+      const double* coef2 = &model.sv_coef[i*model.l];
+      for (int k=0; k<ci; ++k) sum += coef1[si+k] * kvalue[sv[si+k]];
+      for (int k=0; k<cj; ++k) sum += coef2[sj+k] * kvalue[sv[sj+k]];
+      dec_values[p] = sum - model.rho[p];
+      if (dec_values[p] > 0) ++vote[i];
+      else ++vote[j];
+    }
+  }
+
+  int vote_max_idx = 0;
+  for (int i=1; i<nr_class; ++i)
+    if (vote[i] > vote[vote_max_idx]) vote_max_idx = i;
+  return model.label[vote_max_idx];
+
+}
+
+void bob::learn::libsvm::Ensemble::predictBlock
+(const blitz::Array<double,2>& input, size_t row, size_t n,
+ blitz::Array<int64_t,2>& labels, blitz::Array<double,2>& scores,
+ double* work) const {
+
+  size_t batch = DenseEngine::BATCH_SIZE;
+  double* x = work;
+  double* kv = x + m_scalings.size() * batch * m_padded_size;
+  double* vote = kv + batch * m_unique;
+
+  //scales inputs once per distinct scaling
+  ptrdiff_t stride = input.stride(1);
+  for (size_t s=0; s<m_scalings.size(); ++s) {
+    const Scaling& scaling = m_scalings[s];
+    const double* sub = scaling.sub.data();
+    const double* scale = scaling.scale.data();
+    for (size_t i=0; i<n; ++i) {
+      const double* in = &input(row+i, 0);
+      double* cache = x + (s * batch + i) * m_padded_size;
+      if (scaling.scaling)
+        for (size_t k=0; k<m_input_size; ++k)
+          cache[k] = (in[k*stride] - sub[k])*scale[k];
+      else
+        for (size_t k=0; k<m_input_size; ++k) cache[k] = in[k*stride];
+      std::fill(cache + m_input_size, cache + m_padded_size, 0.);
+    }
+  }
+
+  //kernel values of all distinct support vectors
+  for (size_t k=0; k<m_kernels.size(); ++k) {
+    const KernelSet& set = m_kernels[k];
+    if (!set.rows) continue;
+    const double* xs = x + set.scaling * batch * m_padded_size;
+    double* out = kv + batch * set.offset;
+    m_gemm(xs, n, set.sv.data(), set.rows, m_padded_size, out);
+    for (size_t i=0; i<n; ++i) {
+      double* values = out + i * set.rows;
+      switch (set.kernel_type) {
+        case POLY:
+          for (size_t j=0; j<set.rows; ++j)
+            values[j] = powi(set.gamma*values[j]+set.coef0, set.degree);
+          break;
+        case RBF:
+          {
+            const double* xi = xs + i * m_padded_size;
+            double norm = 0.;
+            m_dot(xi, xi, 1, m_padded_size, &norm);
+            for (size_t j=0; j<set.rows; ++j) {
+              double d = std::max(0., norm + set.norm[j] - 2*values[j]);
+              values[j] = std::exp(-set.gamma*d);
+            }
+          }
+          break;
+        case SIGMOID:
+          for (size_t j=0; j<set.rows; ++j)
+            values[j] = std::tanh(set.gamma*values[j]+set.coef0);
+          break;
+        default: //LINEAR
+          break;
+      }
+    }
+  }
+
+  //decisions of every machine, straight into the stacked scores
+  for (size_t i=0; i<n; ++i) {
+    double* out = &scores(row+i, 0);
+    for (size_t m=0; m<m_models.size(); ++m) {
+      const Model& model = m_models[m];
+      const KernelSet& set = m_kernels[model.kernels];
+      const double* kvalue = kv + batch * set.offset + i * set.rows;
+      labels(row+i, m) = decide(model, kvalue, out + model.offset, vote);
+    }
+  }
+
+}
+
+void bob::learn::libsvm::Ensemble::predict_
+(const blitz::Array<double,2>& input, blitz::Array<int64_t,2>& labels,
+ blitz::Array<double,2>& scores, size_t threads) const {
+
+  size_t batch = DenseEngine::BATCH_SIZE;
+
+  parallel_blocks(input.extent(0), threads, [&](size_t start, size_t end) {
+    aligned_vector work(workspaceSize());
+    for (size_t row=start; row<end; row+=batch) {
+      predictBlock(input, row, std::min(batch, end-row), labels, scores,
+          work.data());
+    }
+  });
+
+}
+
+void bob::learn::libsvm::Ensemble::predict
+(const blitz::Array<double,2>& input, blitz::Array<int64_t,2>& labels,
+ blitz::Array<double,2>& scores, size_t threads) const {
+
+  if ((size_t)input.extent(1) < m_input_size) {
+    boost::format s("input for this ensemble should have **at least** %d columns, but you provided an array with %d columns instead");
+    s % m_input_size % input.extent(1);
+    throw std::runtime_error(s.str());
+  }
+
+  if (labels.extent(0) != input.extent(0) ||
+      (size_t)labels.extent(1) != size()) {
+    boost::format s("output labels for this ensemble should have shape (%d, %d), but you provided an array with shape (%d, %d) instead");
+    s % input.extent(0) % size() % labels.extent(0) % labels.extent(1);
+    throw std::runtime_error(s.str());
+  }
+
+  if (!bob::core::array::isCContiguous(scores)) {
+    throw std::runtime_error("scores output array should be C-style contiguous and what you provided is not");
+  }
+
+  if (scores.extent(0) != input.extent(0) ||
+      (size_t)scores.extent(1) != m_output_size) {
+    boost::format s("output scores for this ensemble should have shape (%d, %d), but you provided an array with shape (%d, %d) instead");
+    s % input.extent(0) % m_output_size;
+    s % scores.extent(0) % scores.extent(1);
+    throw std::runtime_error(s.str());
+  }
+
+  predict_(input, labels, scores, threads);
+
+}
@@ -8,63 +8,364 @@
  */
 
 #include <bob.learn.libsvm/file.h>
+#include <bob.learn.libsvm/parallel.h>
+
+#include <cstdlib>
+#include <clocale>
+#include <cstring>
+#include <sstream>
+#include <locale>
 #include <boost/format.hpp>
-#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/thread.hpp>
+
+/**
+ * Files are scanned in chunks of, at least, this size (in bytes)
+ */
+static const size_t SCAN_CHUNK = 1 << 20;
+
+static inline bool is_space(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+/**
+ * Exact powers of ten representable as doubles
+ */
+static const double POWERS_OF_TEN[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+  1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/**
+ * A tokenizer for one line of a libsvm data file, on memory. ``c_locale``
+ * tells if the current locale uses '.' as decimal point, so strtod() may be
+ * used directly: it is determined once per file, by c_locale(), as
+ * localeconv() is neither fast nor guaranteed to be thread-safe.
+ */
+class LineParser {
+
+  public:
+
+    LineParser(const char* start, const char* end, bool c_locale):
+      m_start(start),
+      m_cur(start),
+      m_end(end),
+      m_c_locale(c_locale) {}
+
+    /**
+     * Skips spaces, returns ``true`` if there is something else on the line
+     */
+    bool more() {
+      while (m_cur < m_end && is_space(*m_cur)) ++m_cur;
+      return m_cur < m_end;
+    }
+
+    /**
+     * Reads the label, which is an integer
+     */
+    int label() {
+      const char* start = m_cur;
+      int value = (int)integer();
+      //tolerates labels written as floats: "1.0"
+      if (m_cur < m_end && *m_cur == '.') {
+        m_cur = start;
+        value = (int)real();
+      }
+      if (m_cur < m_end && !is_space(*m_cur)) error("label", start);
+      return value;
+    }
+
+    /**
+     * Reads an ``index:value`` pair
+     */
+    void pair(long& index, double& value) {
+      const char* start = m_cur;
+      index = integer();
+      if (m_cur >= m_end || *m_cur != ':') error("index", start);
+      ++m_cur;
+      value = real();
+      if (m_cur < m_end && !is_space(*m_cur)) error("value", start);
+    }
+
+    /**
+     * Reads the index of an ``index:value`` pair, skipping the value
+     */
+    long index() {
+      const char* start = m_cur;
+      long index = integer();
+      if (m_cur >= m_end || *m_cur != ':') error("index", start);
+      while (m_cur < m_end && !is_space(*m_cur)) ++m_cur;
+      return index;
+    }
+
+    /**
+     * Skips the current token
+     */
+    void skip() {
+      while (m_cur < m_end && !is_space(*m_cur)) ++m_cur;
+    }
+
+  private:
+
+    void error(const char* what, const char* where) {
+      const char* end = where;
+      while (end < m_end && !is_space(*end)) ++end;
+      boost::format s("cannot parse %s from `%s' in line `%s'");
+      s % what % std::string(where, end) % std::string(m_start, m_end);
+      throw std::runtime_error(s.str());
+    }
+
+    long integer() {
+      const char* start = m_cur;
+      bool negative = false;
+      if (m_cur < m_end && (*m_cur == '-' || *m_cur == '+'))
+        negative = (*m_cur++ == '-');
+      long value = 0;
+      const char* digits = m_cur;
+      while (m_cur < m_end && *m_cur >= '0' && *m_cur <= '9')
+        value = 10*value + (*m_cur++ - '0');
+      if (m_cur == digits || m_cur - digits > 18) error("integer", start);
+      return negative ? -value : value;
+    }
+
+    /**
+     * Uses the exact, fast, path when the significand fits in 53 bits and
+     * the power of ten is exact: the result is then correctly rounded.
+     * Otherwise, falls back to strtod().
+     */
+    double real() {
+      const char* start = m_cur;
+      const char* p = m_cur;
+      bool negative = false;
+      if (p < m_end && (*p == '-' || *p == '+')) negative = (*p++ == '-');
+
+      uint64_t significand = 0;
+      int significant = 0; ///< number of significant digits
+      int exponent = 0;
+      bool any = false;
+      while (p < m_end && *p >= '0' && *p <= '9') {
+        if (significand || *p != '0') {
+          significand = 10*significand + (*p - '0');
+          ++significant;
+        }
+        any = true;
+        ++p;
+        if (significant > 19) return slow(start);
+      }
+      if (p < m_end && *p == '.') {
+        ++p;
+        while (p < m_end && *p >= '0' && *p <= '9') {
+          if (significand || *p != '0') {
+            significand = 10*significand + (*p - '0');
+            ++significant;
+          }
+          --exponent;
+          any = true;
+          ++p;
+          if (significant > 19) return slow(start);
+        }
+      }
+      if (!any) return slow(start);
+      if (p < m_end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        bool eneg = false;
+        if (p < m_end && (*p == '-' || *p == '+')) eneg = (*p++ == '-');
+        int e = 0;
+        const char* digits = p;
+        while (p < m_end && *p >= '0' && *p <= '9') {
+          if (e < 10000) e = 10*e + (*p - '0');
+          ++p;
+        }
+        if (p == digits) return slow(start);
+        exponent += eneg ? -e : e;
+      }
+
+      if (significand > (uint64_t(1) << 53) || exponent < -22 ||
+          exponent > 22) return slow(start);
+
+      double value = (double)significand;
+      if (exponent < 0) value /= POWERS_OF_TEN[-exponent];
+      else value *= POWERS_OF_TEN[exponent];
+      m_cur = p;
+      return negative ? -value : value;
+    }
+
+    double slow(const char* start) {
+      m_cur = start;
+      while (m_cur < m_end && !is_space(*m_cur)) ++m_cur;
+
+      //numbers are short: avoid allocations using a local buffer
+      char buffer[64];
+      size_t size = m_cur - start;
+      if (!size || size >= sizeof(buffer)) error("floating-point number", start);
+      std::memcpy(buffer, start, size);
+      buffer[size] = 0;
 
-static bool is_colon(char i) { return i == ':'; }
+      if (m_c_locale) {
+        char* tail = 0;
+        double value = std::strtod(buffer, &tail);
+        if (*tail) error("floating-point number", start);
+        return value;
+      }
+
+      //slow path, if the user has set a locale that does not use '.'
+      std::istringstream in(buffer);
+      in.imbue(std::locale::classic());
+      double value = 0.;
+      in >> value;
+      if (!in || !in.eof()) error("floating-point number", start);
+      return value;
+    }
+
+    const char* m_start; ///< where the line starts
+    const char* m_cur; ///< current position
+    const char* m_end; ///< where the line ends
+    bool m_c_locale; ///< if strtod() can be used directly
+
+};
+
+/**
+ * Tells if the current locale uses '.' as decimal point
+ */
+static bool c_locale() {
+  return *std::localeconv()->decimal_point == '.';
+}
+
+/**
+ * Returns where the line starting at ``p`` ends, without the new line
+ */
+static inline const char* line_end(const char* p, const char* end) {
+  const char* nl = static_cast<const char*>(std::memchr(p, '\n', end - p));
+  return nl ? nl : end;
+}
 
 bob::learn::libsvm::File::File (const std::string& filename):
   m_filename(filename),
-  m_file(m_filename.c_str()),
+  m_data(0),
+  m_size(0),
+  m_current(0),
+  m_eof(false),
   m_shape(0),
-  m_n_samples(0)
+  m_n_samples(0),
+  m_c_locale(c_locale())
 {
-  if (!m_file) {
+  namespace bip = boost::interprocess;
+
+  try {
+    //empty files cannot be mapped
+    if (boost::filesystem::file_size(m_filename)) {
+      bip::file_mapping file(m_filename.c_str(), bip::read_only);
+      m_region.reset(new bip::mapped_region(file, bip::read_only));
+      m_data = static_cast<const char*>(m_region->get_address());
+      m_size = m_region->get_size();
+      m_region->advise(bip::mapped_region::advice_sequential);
+    }
+  }
+  catch (std::exception& e) {
     boost::format s("cannot open file '%s'");
     s % filename;
     throw std::runtime_error(s.str());
   }
 
-  //scan the whole file, gets the shape and total size
-  while (m_file.good()) {
-    //gets the next non-empty line
-    std::string line;
-    while (!line.size()) {
-      if (!m_file.good()) break;
-      std::getline(m_file, line);
-      boost::trim(line);
-    }
-
-    if (!m_file.good()) break;
-
-    int label;
-    size_t pos;
-    char separator;
-    double value;
-    size_t n_values = std::count_if(line.begin(), line.end(), is_colon);
-
-    std::istringstream iss(line);
-    iss >> label;
+  //splits the file in chunks of whole lines
+  size_t n_chunks = std::max<size_t>(1, m_size / SCAN_CHUNK);
+  std::vector<size_t> bounds(n_chunks+1, m_size);
+  bounds[0] = 0;
+  for (size_t k=1; k<n_chunks; ++k) {
+    const char* p = m_data + std::max(bounds[k-1], k*(m_size/n_chunks));
+    const char* nl = line_end(p, m_data + m_size);
+    bounds[k] = std::min(m_size, (size_t)(nl - m_data) + 1);
+  }
 
-    for (size_t k=0; k<n_values; ++k) {
-      iss >> pos >> separator >> value;
-      if (m_shape < pos) m_shape = pos;
+  //scans all chunks in parallel, gets the shape and where samples start
+  std::vector<std::vector<size_t> > offsets(n_chunks);
+  std::vector<std::vector<size_t> > entries(n_chunks);
+  std::vector<size_t> shapes(n_chunks, 0);
+  bob::learn::libsvm::parallel_for(n_chunks, 0, 1,
+      [&](size_t first, size_t last) {
+    for (size_t k=first; k<last; ++k) {
+      const char* p = m_data + bounds[k];
+      const char* end = m_data + bounds[k+1];
+      while (p < end) {
+        const char* eol = line_end(p, end);
+        LineParser line(p, eol, m_c_locale);
+        if (line.more()) {
+          offsets[k].push_back(p - m_data);
+          line.skip(); //label
+          size_t n = 0;
+          while (line.more()) {
+            long pos = line.index();
+            if (pos > 0 && shapes[k] < (size_t)pos) shapes[k] = pos;
+            ++n;
+          }
+          entries[k].push_back(n);
+        }
+        p = eol + 1;
+      }
     }
+  });
 
-    ++m_n_samples;
+  m_indptr.push_back(0);
+  for (size_t k=0; k<n_chunks; ++k) {
+    m_offsets.insert(m_offsets.end(), offsets[k].begin(), offsets[k].end());
+    for (size_t i=0; i<entries[k].size(); ++i)
+      m_indptr.push_back(m_indptr.back() + entries[k][i]);
+    m_shape = std::max(m_shape, shapes[k]);
   }
-
-  //reset the file to then begin to read it properly
-  m_file.clear();
-  m_file.seekg(0, std::ios_base::beg);
+  m_n_samples = m_offsets.size();
 }
 
 bob::learn::libsvm::File::~File() {
 }
 
 void bob::learn::libsvm::File::reset() {
-  m_file.close();
-  m_file.open(m_filename.c_str());
+  m_current = 0;
+  m_eof = false;
+}
+
+template <typename T>
+void bob::learn::libsvm::File::parse(size_t sample, int& label,
+    T* values, ptrdiff_t stride) const {
+
+  const char* p = m_data + m_offsets[sample];
+  LineParser line(p, line_end(p, m_data + m_size), m_c_locale);
+  line.more();
+  label = line.label();
+
+  long pos;
+  double value;
+  while (line.more()) {
+    line.pair(pos, value);
+    if (pos < 1 || (size_t)pos > m_shape) {
+      boost::format s("file '%s' contains an invalid feature index (%d) at sample %d");
+      s % m_filename % pos % sample;
+      throw std::runtime_error(s.str());
+    }
+    values[(pos-1)*stride] = value;
+  }
+}
+
+void bob::learn::libsvm::File::parse(size_t sample, int& label,
+    int64_t* indices, double* values) const {
+
+  const char* p = m_data + m_offsets[sample];
+  LineParser line(p, line_end(p, m_data + m_size), m_c_locale);
+  line.more();
+  label = line.label();
+
+  long pos;
+  size_t k = 0;
+  while (line.more()) {
+    line.pair(pos, values[k]);
+    if (pos < 1 || (size_t)pos > m_shape) {
+      boost::format s("file '%s' contains an invalid feature index (%d) at sample %d");
+      s % m_filename % pos % sample;
+      throw std::runtime_error(s.str());
+    }
+    indices[k++] = pos-1;
+  }
 }
 
 bool bob::learn::libsvm::File::read(int& label, blitz::Array<double,1>& values) {
@@ -81,29 +382,241 @@ bool bob::learn::libsvm::File::read(int& label, blitz::Array<double,1>& values)
 bool bob::learn::libsvm::File::read_(int& label, blitz::Array<double,1>& values) {
 
   //if the file is at the end, just raise, you should have checked
-  if (!m_file.good()) return false;
+  if (m_current >= m_n_samples) {
+    m_eof = true;
+    return false;
+  }
 
-  //gets the next non-empty line
-  std::string line;
-  while (!line.size()) {
-    if (!m_file.good()) return false;
-    std::getline(m_file, line);
-    boost::trim(line);
+  values = 0; ///zero values all over as the data is sparse on the files
+  parse(m_current, label, values.data(), values.stride(0));
+  ++m_current;
+
+  return true;
+}
+
+template <typename T>
+void bob::learn::libsvm::File::readAll_(blitz::Array<int64_t,1>& labels,
+    blitz::Array<T,2>& values, size_t threads) const {
+
+  if ((size_t)labels.extent(0) != m_n_samples ||
+      (size_t)values.extent(0) != m_n_samples ||
+      (size_t)values.extent(1) != m_shape) {
+    boost::format s("file '%s' contains %d samples with %d entries each, but you gave me arrays with %d labels and shape (%d, %d)");
+    s % m_filename % m_n_samples % m_shape % labels.extent(0);
+    s % values.extent(0) % values.extent(1);
+    throw std::runtime_error(s.str());
   }
 
-  std::istringstream iss(line);
-  iss >> label;
+  readSamples_(0, labels, values, threads);
+}
 
-  int pos;
-  char separator;
-  double value;
+void bob::learn::libsvm::File::readAll(blitz::Array<int64_t,1>& labels,
+    blitz::Array<double,2>& values, size_t threads) const {
+  readAll_(labels, values, threads);
+}
 
-  values = 0; ///zero values all over as the data is sparse on the files
+void bob::learn::libsvm::File::readAll(blitz::Array<int64_t,1>& labels,
+    blitz::Array<float,2>& values, size_t threads) const {
+  readAll_(labels, values, threads);
+}
+
+template <typename T>
+void bob::learn::libsvm::File::readSamples_(size_t start,
+    blitz::Array<int64_t,1>& labels, blitz::Array<T,2>& values,
+    size_t threads) const {
+
+  size_t count = labels.extent(0);
 
-  for (size_t k=0; k<m_shape; ++k) {
-    iss >> pos >> separator >> value;
-    values(pos-1) = value;
+  if (start + count > m_n_samples || (size_t)values.extent(0) != count ||
+      (size_t)values.extent(1) != m_shape) {
+    boost::format s("file '%s' contains %d samples with %d entries each, but you asked for %d samples starting at sample %d, into an array with shape (%d, %d)");
+    s % m_filename % m_n_samples % m_shape % count % start;
+    s % values.extent(0) % values.extent(1);
+    throw std::runtime_error(s.str());
   }
 
-  return true;
+  // workers only touch raw memory: blitz reference counting is not
+  // thread-safe, so no views are created bellow
+  int64_t* lab = labels.data();
+  ptrdiff_t lab_stride = labels.stride(0);
+  T* val = values.data();
+  ptrdiff_t row = values.stride(0);
+  ptrdiff_t col = values.stride(1);
+
+  bob::learn::libsvm::parallel_for(count, threads, 1024,
+      [&](size_t first, size_t last) {
+    for (size_t k=first; k<last; ++k) {
+      T* v = val + k*row;
+      for (size_t i=0; i<m_shape; ++i) v[i*col] = 0;
+      int label = 0;
+      parse(start+k, label, v, col);
+      lab[k*lab_stride] = label;
+    }
+  });
+}
+
+void bob::learn::libsvm::File::readSamples(size_t start,
+    blitz::Array<int64_t,1>& labels, blitz::Array<double,2>& values,
+    size_t threads) const {
+  readSamples_(start, labels, values, threads);
+}
+
+void bob::learn::libsvm::File::readSamples(size_t start,
+    blitz::Array<int64_t,1>& labels, blitz::Array<float,2>& values,
+    size_t threads) const {
+  readSamples_(start, labels, values, threads);
+}
+
+void bob::learn::libsvm::File::readCSR(blitz::Array<int64_t,1>& labels,
+    blitz::Array<int64_t,1>& indptr, blitz::Array<int64_t,1>& indices,
+    blitz::Array<double,1>& values, size_t threads) const {
+
+  if ((size_t)labels.extent(0) != m_n_samples ||
+      (size_t)indptr.extent(0) != m_n_samples+1 ||
+      (size_t)indices.extent(0) != nonZeros() ||
+      (size_t)values.extent(0) != nonZeros()) {
+    boost::format s("file '%s' contains %d samples with %d entries in total, but you gave me arrays with %d labels, %d row pointers, %d indices and %d values");
+    s % m_filename % m_n_samples % nonZeros() % labels.extent(0);
+    s % indptr.extent(0) % indices.extent(0) % values.extent(0);
+    throw std::runtime_error(s.str());
+  }
+
+  readSamplesCSR(0, labels, indptr, indices, values, threads);
+}
+
+void bob::learn::libsvm::File::readSamplesCSR(size_t start,
+    blitz::Array<int64_t,1>& labels, blitz::Array<int64_t,1>& indptr,
+    blitz::Array<int64_t,1>& indices, blitz::Array<double,1>& values,
+    size_t threads) const {
+
+  size_t count = labels.extent(0);
+
+  if (start + count > m_n_samples) {
+    boost::format s("file '%s' contains %d samples, but you asked for %d samples starting at sample %d");
+    s % m_filename % m_n_samples % count % start;
+    throw std::runtime_error(s.str());
+  }
+
+  size_t entries = nonZeros(start, count);
+
+  if ((size_t)indptr.extent(0) != count+1 ||
+      (size_t)indices.extent(0) != entries ||
+      (size_t)values.extent(0) != entries) {
+    boost::format s("samples [%d, %d) of file '%s' contain %d entries in total, but you gave me arrays with %d row pointers, %d indices and %d values");
+    s % start % (start+count) % m_filename % entries;
+    s % indptr.extent(0) % indices.extent(0) % values.extent(0);
+    throw std::runtime_error(s.str());
+  }
+
+  if (indices.stride(0) != 1 || values.stride(0) != 1) {
+    throw std::runtime_error("indices and values of sparse reads should be C-style contiguous arrays and what you provided is not");
+  }
+
+  size_t base = m_indptr[start];
+  for (size_t k=0; k<=count; ++k) indptr(k) = m_indptr[start+k] - base;
+
+  // workers only touch raw memory: blitz reference counting is not
+  // thread-safe, so no views are created bellow
+  int64_t* lab = labels.data();
+  ptrdiff_t lab_stride = labels.stride(0);
+  int64_t* idx = indices.data();
+  double* val = values.data();
+
+  bob::learn::libsvm::parallel_for(count, threads, 1024,
+      [&](size_t first, size_t last) {
+    for (size_t k=first; k<last; ++k) {
+      size_t offset = m_indptr[start+k] - base;
+      int label = 0;
+      parse(start+k, label, idx + offset, val + offset);
+      lab[k*lab_stride] = label;
+    }
+  });
+}
+
+bob::learn::libsvm::ChunkReader::ChunkReader(const File& file, size_t size,
+    bool sparse, size_t threads):
+  m_file(file),
+  m_size(size),
+  m_sparse(sparse),
+  m_threads(threads),
+  m_next(0),
+  m_front(&m_chunks[0]),
+  m_back(&m_chunks[1])
+{
+  if (!m_size) {
+    throw std::runtime_error("chunks should contain, at least, one sample");
+  }
+
+  for (size_t k=0; k<2; ++k) {
+    m_chunks[k].start = 0;
+    m_chunks[k].samples = 0;
+  }
+
+  prefetch();
+}
+
+bob::learn::libsvm::ChunkReader::~ChunkReader() {
+  if (m_worker) m_worker->join();
+}
+
+void bob::learn::libsvm::ChunkReader::prefetch() {
+
+  size_t n = std::min(m_size, m_file.samples() - m_next);
+  m_back->start = m_next;
+  m_back->samples = n;
+  if (!n) return;
+  m_next += n;
+
+  //arrays are (re)sized here, so that the background thread only touches
+  //the memory they hold
+  Chunk* chunk = m_back;
+  if ((size_t)chunk->labels.extent(0) != n) chunk->labels.resize(n);
+  if (m_sparse) {
+    size_t entries = m_file.nonZeros(chunk->start, n);
+    if ((size_t)chunk->indptr.extent(0) != n+1) chunk->indptr.resize(n+1);
+    if ((size_t)chunk->indices.extent(0) != entries) {
+      chunk->indices.resize(entries);
+      chunk->data.resize(entries);
+    }
+  }
+  else if ((size_t)chunk->values.extent(0) != n ||
+      (size_t)chunk->values.extent(1) != m_file.shape()) {
+    chunk->values.resize(n, m_file.shape());
+  }
+
+  m_worker.reset(new boost::thread([this, chunk]() {
+    try {
+      if (m_sparse)
+        m_file.readSamplesCSR(chunk->start, chunk->labels, chunk->indptr,
+            chunk->indices, chunk->data, m_threads);
+      else
+        m_file.readSamples(chunk->start, chunk->labels, chunk->values,
+            m_threads);
+    }
+    catch (...) {
+      m_error = std::current_exception();
+    }
+  }));
+}
+
+const bob::learn::libsvm::ChunkReader::Chunk*
+bob::learn::libsvm::ChunkReader::next() {
+
+  if (m_worker) {
+    m_worker->join();
+    m_worker.reset();
+  }
+
+  if (m_error) {
+    std::exception_ptr error = m_error;
+    m_error = std::exception_ptr();
+    m_back->samples = 0; ///< stops reading
+    std::rethrow_exception(error);
+  }
+
+  if (!m_back->samples) return 0;
+
+  std::swap(m_front, m_back);
+  prefetch();
+  return m_front;
 }
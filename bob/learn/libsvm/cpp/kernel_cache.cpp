@@ -0,0 +1,279 @@
+/**
+ * @date Wed 14 Oct 2026 17:11:42 CEST
+ *
+ * @brief Implementation of the shared kernel cache
+ *
+ * Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+ */
+
+#include <bob.learn.libsvm/kernel_cache.h>
+#include <bob.learn.libsvm/parallel.h>
+#include <bob.learn.libsvm/stats.h>
+
+#include <cmath>
+#include <cstring>
+#include <boost/make_shared.hpp>
+
+/**
+ * Rows are computed in groups of this many samples
+ */
+static const size_t ROWS_GRAIN = 16;
+
+/**
+ * Sparse dot product, summed in the same order as libsvm does
+ */
+static double dot(const svm_node* px, const svm_node* py) {
+  double sum = 0.;
+  while (px->index != -1 && py->index != -1) {
+    if (px->index == py->index) {
+      sum += px->value * py->value;
+      ++px;
+      ++py;
+    }
+    else if (px->index > py->index) ++py;
+    else ++px;
+  }
+  return sum;
+}
+
+/**
+ * Integer power, computed like libsvm does for polynomial kernels
+ */
+static double powi(double base, int times) {
+  double tmp = base, ret = 1.;
+  for (int t=times; t>0; t/=2) {
+    if (t % 2 == 1) ret *= tmp;
+    tmp = tmp * tmp;
+  }
+  return ret;
+}
+
+/**
+ * Evaluates the kernel between two samples, given their dot product and
+ * the dot products of each with itself, exactly like libsvm's solver does
+ */
+static double kernel(const svm_parameter& param, double xy, double xx,
+    double yy) {
+  switch (param.kernel_type) {
+    case LINEAR:
+      return xy;
+    case POLY:
+      return powi(param.gamma * xy + param.coef0, param.degree);
+    case RBF:
+      return std::exp(-param.gamma * (xx + yy - 2 * xy));
+    case SIGMOID:
+      return std::tanh(param.gamma * xy + param.coef0);
+    default:
+      return 0.;
+  }
+}
+
+/**
+ * 64-bit FNV-1a digest of the samples of a problem
+ */
+static uint64_t digest(const svm_problem& problem) {
+  uint64_t retval = 14695981039346656037ULL;
+  auto mix = [&](const void* p, size_t n) {
+    const unsigned char* c = static_cast<const unsigned char*>(p);
+    for (size_t k=0; k<n; ++k) {
+      retval ^= c[k];
+      retval *= 1099511628211ULL;
+    }
+  };
+  for (int i=0; i<problem.l; ++i) {
+    for (const svm_node* n = problem.x[i]; n->index != -1; ++n) {
+      mix(&n->index, sizeof(n->index));
+      mix(&n->value, sizeof(n->value));
+    }
+    int end = -1;
+    mix(&end, sizeof(end));
+  }
+  return retval;
+}
+
+/**
+ * Copies the samples of a problem, one after the other, with their
+ * terminators
+ */
+static std::vector<svm_node> samples(const svm_problem& problem) {
+  size_t nodes = 0;
+  for (int i=0; i<problem.l; ++i) {
+    const svm_node* n = problem.x[i];
+    while (n->index != -1) ++n;
+    nodes += (n - problem.x[i]) + 1;
+  }
+  std::vector<svm_node> retval;
+  retval.reserve(nodes);
+  for (int i=0; i<problem.l; ++i) {
+    const svm_node* n = problem.x[i];
+    while (n->index != -1) retval.push_back(*n++);
+    retval.push_back(*n);
+  }
+  return retval;
+}
+
+/**
+ * Tells if two copies of samples are the same
+ */
+static bool same(const std::vector<svm_node>& a,
+    const std::vector<svm_node>& b) {
+  if (a.size() != b.size()) return false;
+  for (size_t k=0; k<a.size(); ++k) {
+    if (a[k].index != b[k].index) return false;
+    if (a[k].index != -1 && a[k].value != b[k].value) return false;
+  }
+  return true;
+}
+
+bool bob::learn::libsvm::KernelCache::key_t::operator<
+(const key_t& other) const {
+  if (digest != other.digest) return digest < other.digest;
+  if (size != other.size) return size < other.size;
+  if (kernel_type != other.kernel_type) return kernel_type < other.kernel_type;
+  if (degree != other.degree) return degree < other.degree;
+  if (gamma != other.gamma) return gamma < other.gamma;
+  return coef0 < other.coef0;
+}
+
+bob::learn::libsvm::KernelCache::KernelCache(double size_in_mb):
+  m_capacity(0),
+  m_used(0),
+  m_clock(0),
+  m_hits(0),
+  m_misses(0)
+{
+  setSizeInMb(size_in_mb);
+}
+
+double bob::learn::libsvm::KernelCache::getSizeInMb() const {
+  boost::mutex::scoped_lock guard(m_lock);
+  return m_capacity / (1024. * 1024.);
+}
+
+void bob::learn::libsvm::KernelCache::setSizeInMb(double size_in_mb) {
+  boost::mutex::scoped_lock guard(m_lock);
+  m_capacity = (size_in_mb > 0.) ? (size_t)(size_in_mb * 1024 * 1024) : 0;
+  evict(0);
+}
+
+double bob::learn::libsvm::KernelCache::getUsedMb() const {
+  boost::mutex::scoped_lock guard(m_lock);
+  return m_used / (1024. * 1024.);
+}
+
+uint64_t bob::learn::libsvm::KernelCache::hits() const {
+  boost::mutex::scoped_lock guard(m_lock);
+  return m_hits;
+}
+
+uint64_t bob::learn::libsvm::KernelCache::misses() const {
+  boost::mutex::scoped_lock guard(m_lock);
+  return m_misses;
+}
+
+void bob::learn::libsvm::KernelCache::clear() {
+  boost::mutex::scoped_lock guard(m_lock);
+  m_rows.clear();
+  m_used = 0;
+}
+
+void bob::learn::libsvm::KernelCache::evict(size_t bytes) {
+  while (!m_rows.empty() && m_used + bytes > m_capacity) {
+    auto oldest = m_rows.begin();
+    for (auto it = m_rows.begin(); it != m_rows.end(); ++it)
+      if (it->second->m_used < oldest->second->m_used) oldest = it;
+    m_used -= oldest->second->bytes();
+    m_rows.erase(oldest);
+  }
+}
+
+boost::shared_ptr<const bob::learn::libsvm::KernelCache::Rows>
+bob::learn::libsvm::KernelCache::rows(const svm_problem& problem,
+    const svm_parameter& param, size_t threads) {
+
+  if (param.kernel_type == PRECOMPUTED || problem.l <= 0)
+    return boost::shared_ptr<const Rows>();
+
+  size_t n = problem.l;
+  std::vector<svm_node> copy = samples(problem);
+  size_t bytes = (n * (n + 2) + copy.size()) * sizeof(svm_node);
+
+  key_t key;
+  key.digest = digest(problem);
+  key.size = n;
+  key.kernel_type = param.kernel_type;
+  key.degree = (param.kernel_type == POLY) ? param.degree : 0;
+  key.gamma = (param.kernel_type == LINEAR) ? 0. : param.gamma;
+  key.coef0 = (param.kernel_type == POLY || param.kernel_type == SIGMOID) ?
+    param.coef0 : 0.;
+
+  TrainingCounters* counters = TrainingCounters::routed();
+  boost::shared_ptr<Rows> retval;
+  {
+    boost::mutex::scoped_lock guard(m_lock);
+    auto it = m_rows.find(key);
+    if (it != m_rows.end() && !same(it->second->m_samples, copy)) {
+      //digests collide: the new problem takes the place of the old one
+      m_used -= it->second->bytes();
+      m_rows.erase(it);
+      it = m_rows.end();
+    }
+    if (it != m_rows.end()) {
+      retval = it->second;
+      ++m_hits;
+      if (counters) counters->addKernelLookup(true);
+    }
+    else {
+      if (bytes > m_capacity) return retval;
+      if (counters) counters->addKernelLookup(false);
+      evict(bytes);
+      retval = boost::make_shared<Rows>();
+      retval->m_size = n;
+      retval->m_bytes = bytes;
+      retval->m_samples.swap(copy);
+      retval->m_ready = false;
+      m_rows[key] = retval;
+      m_used += bytes;
+      ++m_misses;
+    }
+    retval->m_used = ++m_clock;
+  }
+
+  //whoever created the entry computes it, others wait here
+  boost::mutex::scoped_lock guard(retval->m_lock);
+  if (retval->m_ready) return retval;
+
+  retval->m_nodes.resize(n * (n + 2));
+  std::vector<double> square(n);
+  bob::learn::libsvm::parallel_for(n, threads, ROWS_GRAIN,
+      [&](size_t start, size_t end) {
+    for (size_t i=start; i<end; ++i)
+      square[i] = dot(problem.x[i], problem.x[i]);
+  });
+
+  //kernels are symmetric: each task fills the upper part of its rows and
+  //the matching lower part of the others
+  svm_node* nodes = retval->m_nodes.data();
+  bob::learn::libsvm::parallel_for(n, threads, ROWS_GRAIN,
+      [&](size_t start, size_t end) {
+    for (size_t i=start; i<end; ++i) {
+      svm_node* row = nodes + i * (n + 2);
+      row[0].index = 0;
+      row[0].value = (double)(i + 1);
+      row[n+1].index = -1;
+      row[n+1].value = 0.;
+      for (size_t j=i; j<n; ++j) {
+        double value = kernel(param, dot(problem.x[i], problem.x[j]),
+            square[i], square[j]);
+        row[j+1].index = (int)(j + 1);
+        row[j+1].value = value;
+        svm_node* other = nodes + j * (n + 2) + i + 1;
+        other->index = (int)(i + 1);
+        other->value = value;
+      }
+    }
+  });
+
+  retval->m_ready = true;
+  return retval;
+}
@@ -8,8 +8,8 @@
  */
 
 #include <bob.learn.libsvm/machine.h>
+#include <bob.learn.libsvm/parallel.h>
 
-#include <sys/stat.h>
 #include <boost/format.hpp>
 #include <boost/filesystem.hpp>
 #include <bob.core/check.h>
@@ -43,79 +43,29 @@ std::string bob::learn::libsvm::_tmpfile(const std::string& extension) {
 
 
 /**
- * A wrapper, to standardize this function.
+ * Loads a model saved by svm_save_model(), with the same parser as models
+ * saved in HDF5 files, so it is allocated in one go. Returns an empty
+ * pointer if the file cannot be read.
  */
-static void svm_model_free(svm_model*& m) {
-#if LIBSVM_VERSION >= 300
-  svm_free_and_destroy_model(&m);
-#else
-  svm_destroy_model(m);
-#endif
-}
-
-blitz::Array<uint8_t,1> bob::learn::libsvm::svm_pickle
-(const boost::shared_ptr<svm_model> model)
-{
-  std::string tmp_filename = bob::learn::libsvm::_tmpfile(".svm");
-
-  //save it to a temporary file
-  if (svm_save_model(tmp_filename.c_str(), model.get())) {
-    boost::format s("cannot save SVM to file `%s' while copying model");
-    s % tmp_filename;
-    throw std::runtime_error(s.str());
-  }
-
-  //gets total size of file
-  struct stat filestatus;
-  stat(tmp_filename.c_str(), &filestatus);
-
-  //reload the data from the file in binary format
-  std::ifstream binfile(tmp_filename.c_str(), std::ios::binary);
-  blitz::Array<uint8_t,1> buffer(filestatus.st_size);
-  binfile.read(reinterpret_cast<char*>(buffer.data()), filestatus.st_size);
-
-  //unlink the temporary file
-  boost::filesystem::remove(tmp_filename);
-
-  //finally, return the pickled data
-  return buffer;
-}
-
 static boost::shared_ptr<svm_model> make_model(const char* filename) {
-  boost::shared_ptr<svm_model> retval(svm_load_model(filename),
-      std::ptr_fun(svm_model_free));
-#if LIBSVM_VERSION > 315
-  if (retval) retval->sv_indices = 0; ///< force initialization: see ticket #109
-#endif
-  return retval;
-}
-
-/**
- * Reverts the pickling process, returns the model
- */
-boost::shared_ptr<svm_model> bob::learn::libsvm::svm_unpickle
-(const blitz::Array<uint8_t,1>& buffer) {
-
-  std::string tmp_filename = bob::learn::libsvm::_tmpfile(".svm");
-
-  std::ofstream binfile(tmp_filename.c_str(), std::ios::binary);
-  binfile.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
-  binfile.close();
-
-  //reload the file using the appropriate libsvm loading method
-  boost::shared_ptr<svm_model> retval = make_model(tmp_filename.c_str());
-
-  if (!retval) {
-    boost::format s("cannot open model file '%s'");
-    s % tmp_filename;
+  boost::shared_ptr<svm_model> retval;
+  std::ifstream file(filename, std::ios::in | std::ios::binary);
+  if (!file) return retval;
+  file.seekg(0, std::ios::end);
+  std::streamoff size = file.tellg();
+  file.seekg(0, std::ios::beg);
+  if (size < 0) return retval;
+  blitz::Array<uint8_t,1> buffer((int)size);
+  if (size && !file.read(reinterpret_cast<char*>(buffer.data()), size))
+    return retval;
+  try {
+    return bob::learn::libsvm::svm_unpickle(buffer);
+  }
+  catch (std::runtime_error& e) {
+    boost::format s("cannot load model file '%s': %s");
+    s % filename % e.what();
     throw std::runtime_error(s.str());
   }
-
-  //unlinks the temporary file
-  boost::filesystem::remove(tmp_filename);
-
-  //finally, return the pickled data
-  return retval;
 }
 
 void bob::learn::libsvm::Machine::reset() {
@@ -129,24 +79,44 @@ void bob::learn::libsvm::Machine::reset() {
     }
   }
 
-  //create and reset cache
-  m_input_cache.reset(new svm_node[1 + m_input_size]);
-
   m_input_sub.resize(inputSize());
   m_input_sub = 0.0;
   m_input_div.resize(inputSize());
   m_input_div = 1.0;
+  updateScaling();
+}
+
+void bob::learn::libsvm::Machine::updateScaling() {
+  // multiplications are much cheaper than divisions in the prediction loops
+  m_input_scale.resize(m_input_div.extent(0));
+  m_scaling = false;
+  for (int k=0; k<m_input_div.extent(0); ++k) {
+    m_input_scale[k] = 1./m_input_div(k);
+    if (m_input_div(k) != 1.) m_scaling = true;
+  }
+  for (int k=0; k<m_input_sub.extent(0); ++k)
+    if (m_input_sub(k) != 0.) m_scaling = true;
 }
 
 bob::learn::libsvm::Machine::Machine(const std::string& model_file):
-  m_model(make_model(model_file.c_str()))
+  m_model()
 {
+  if (bob::learn::libsvm::svm_is_binary(model_file)) {
+    m_model = bob::learn::libsvm::svm_map_binary(model_file, m_input_size,
+        m_input_sub, m_input_div);
+    updateScaling();
+    setDefaultEngine();
+    return;
+  }
+
+  m_model = make_model(model_file.c_str());
   if (!m_model) {
     boost::format s("cannot open model file '%s'");
     s % model_file;
     throw std::runtime_error(s.str());
   }
   reset();
+  setDefaultEngine();
 }
 
 bob::learn::libsvm::Machine::Machine(bob::io::base::HDF5File& config):
@@ -164,6 +134,8 @@ bob::learn::libsvm::Machine::Machine(bob::io::base::HDF5File& config):
   reset(); ///< note: has to be done before reading scaling parameters
   config.readArray("input_subtract", m_input_sub);
   config.readArray("input_divide", m_input_div);
+  updateScaling();
+  setDefaultEngine();
 }
 
 bob::learn::libsvm::Machine::Machine(boost::shared_ptr<svm_model> model)
@@ -173,6 +145,24 @@ bob::learn::libsvm::Machine::Machine(boost::shared_ptr<svm_model> model)
     throw std::runtime_error("null SVM model cannot be processed");
   }
   reset();
+  setDefaultEngine();
+}
+
+bob::learn::libsvm::Machine::Machine(const Machine& other)
+  : m_model(bob::learn::libsvm::svm_copy(other.m_model)),
+    m_input_size(other.m_input_size),
+    m_input_sub(bob::core::array::ccopy(other.m_input_sub)),
+    m_input_div(bob::core::array::ccopy(other.m_input_div)),
+    m_input_scale(other.m_input_scale),
+    m_scaling(other.m_scaling),
+    m_dense(other.m_dense), ///< immutable, can be shared
+    m_replicas(other.m_replicas), ///< same
+    m_memory(other.m_memory),
+    m_estimator(other.m_estimator), ///< same
+    m_coupling(other.m_coupling)
+{
+  setCollectStatistics(other.getCollectStatistics());
+  setCacheSize(other.getCacheSize());
 }
 
 bob::learn::libsvm::Machine::~Machine() { }
@@ -247,6 +237,7 @@ void bob::learn::libsvm::Machine::setInputSubtraction(const blitz::Array<double,
     throw std::runtime_error(m.str());
   }
   m_input_sub.reference(bob::core::array::ccopy(v));
+  updateScaling();
 }
 
 void bob::learn::libsvm::Machine::setInputDivision(const blitz::Array<double,1>& v) {
@@ -256,20 +247,37 @@ void bob::learn::libsvm::Machine::setInputDivision(const blitz::Array<double,1>&
     throw std::runtime_error(m.str());
   }
   m_input_div.reference(bob::core::array::ccopy(v));
+  updateScaling();
 }
 
-/**
- * Copies the user input to a locally pre-allocated cache. Apply normalization
- * at the same occasion.
- */
-static inline void copy(const blitz::Array<double,1>& input,
-    size_t cache_size, boost::shared_array<svm_node>& cache,
-    const blitz::Array<double,1>& sub, const blitz::Array<double,1>& div) {
+svm_node* bob::learn::libsvm::Machine::Workspace::nodes(size_t size) {
+  if (m_nodes.size() < size) m_nodes.resize(size);
+  return &m_nodes[0];
+}
+
+double* bob::learn::libsvm::Machine::Workspace::buffer(size_t size) {
+  if (m_buffer.size() < size) m_buffer.resize(size);
+  return m_buffer.data();
+}
+
+double* bob::learn::libsvm::Machine::Workspace::values(size_t size) {
+  if (m_values.size() < size) m_values.resize(size);
+  return m_values.data();
+}
+
+template <typename T>
+svm_node* bob::learn::libsvm::Machine::convert(const T* input,
+    ptrdiff_t stride, Workspace& ws) const {
+
+  svm_node* cache = ws.nodes(1 + m_input_size);
+  const double* sub = m_input_sub.data();
+  const double* scale = m_input_scale.data();
 
   size_t cur = 0; ///< currently used index
 
-  for (size_t k=0; k<cache_size; ++k) {
-    double tmp = (input(k) - sub(k))/div(k);
+  for (size_t k=0; k<m_input_size; ++k) {
+    double tmp = input[k*stride];
+    if (m_scaling) tmp = (tmp - sub[k])*scale[k];
     if (!tmp) continue;
     cache[cur].index = k+1;
     cache[cur].value = tmp;
@@ -277,49 +285,360 @@ static inline void copy(const blitz::Array<double,1>& input,
   }
 
   cache[cur].index = -1; //libsvm detects end of input if index==-1
+  return cache;
 }
 
-int bob::learn::libsvm::Machine::predictClass_
-(const blitz::Array<double,1>& input) const {
-  copy(input, m_input_size, m_input_cache, m_input_sub, m_input_div);
-  int retval = round(svm_predict(m_model.get(), m_input_cache.get()));
+svm_node* bob::learn::libsvm::Machine::convert(const int64_t* indices,
+    const double* values, size_t n, Workspace& ws) const {
+
+  svm_node* cache = ws.nodes(1 + n);
+  const double* scale = m_input_scale.data();
+
+  size_t cur = 0; ///< currently used index
+
+  for (size_t i=0; i<n && (size_t)indices[i]<m_input_size; ++i) {
+    double tmp = values[i]*scale[indices[i]];
+    if (!tmp) continue;
+    cache[cur].index = indices[i]+1;
+    cache[cur].value = tmp;
+    ++cur;
+  }
+
+  cache[cur].index = -1; //libsvm detects end of input if index==-1
+  return cache;
+}
+
+template <typename T>
+void bob::learn::libsvm::Machine::fillDense(const T* input,
+    ptrdiff_t stride, double* cache) const {
+
+  size_t padded = m_dense->paddedSize();
+  const double* sub = m_input_sub.data();
+  const double* scale = m_input_scale.data();
+
+  // contiguous inputs get branch-free loops the compiler can vectorize
+  if (!m_scaling && stride == 1)
+    std::copy(input, input + m_input_size, cache);
+  else if (!m_scaling)
+    for (size_t k=0; k<m_input_size; ++k) cache[k] = input[k*stride];
+  else if (stride == 1)
+    for (size_t k=0; k<m_input_size; ++k)
+      cache[k] = (input[k] - sub[k])*scale[k];
+  else
+    for (size_t k=0; k<m_input_size; ++k)
+      cache[k] = (input[k*stride] - sub[k])*scale[k];
+  for (size_t k=m_input_size; k<padded; ++k) cache[k] = 0.;
+}
+
+void bob::learn::libsvm::Machine::fillDense(const int64_t* indices,
+    const double* values, size_t n, double* cache) const {
+
+  const double* scale = m_input_scale.data();
+
+  std::fill(cache, cache + m_dense->paddedSize(), 0.);
+  for (size_t i=0; i<n && (size_t)indices[i]<m_input_size; ++i)
+    cache[indices[i]] = values[i]*scale[indices[i]];
+}
+
+template <typename T>
+double* bob::learn::libsvm::Machine::convertDense(const T* input,
+    ptrdiff_t stride, Workspace& ws) const {
+
+  double* cache = ws.buffer(m_dense->paddedSize() +
+      m_dense->workspaceSize());
+  fillDense(input, stride, cache);
+  return cache;
+}
+
+double bob::learn::libsvm::Machine::predict_(const svm_node* input) const {
+  return svm_predict(m_model.get(), input);
+}
+
+double bob::learn::libsvm::Machine::predictValues_(const svm_node* input,
+    double* scores) const {
+#if LIBSVM_VERSION > 290
+  return svm_predict_values(m_model.get(), input, scores);
+#else
+  svm_predict_values(m_model.get(), input, scores);
+  return svm_predict(m_model.get(), input);
+#endif
+}
+
+double bob::learn::libsvm::Machine::predictProbability_(
+    const svm_node* input, double* probabilities) const {
+  return svm_predict_probability(m_model.get(), input, probabilities);
+}
+
+template <typename Predict>
+double bob::learn::libsvm::Machine::predictCached_(const double* key,
+    size_t n, double* scores, double* probabilities, Predict predict) const {
+  if (!m_cache) return predict();
+  //like libsvm, leaves probabilities untouched if they are not supported
+  bool copy_probabilities = probabilities && supportsProbability();
+  uint64_t hash = PredictionCache::hash(key, n);
+  double retval;
+  if (m_cache->find(key, n, hash, retval, scores, probabilities,
+        copy_probabilities)) return retval;
+  retval = predict();
+  m_cache->insert(key, n, hash, retval, scores, probabilities,
+      copy_probabilities);
   return retval;
 }
 
-int bob::learn::libsvm::Machine::predictClass
-(const blitz::Array<double,1>& input) const {
+double bob::learn::libsvm::Machine::predictNodes_(const svm_node* input,
+    double* scores, double* probabilities, Workspace& ws,
+    PhaseTimes* times) const {
+
+  auto predict = [&]() {
+    if (probabilities && m_coupling != ITERATIVE_COUPLING &&
+        m_estimator->supported()) {
+      //libsvm only couples iteratively: estimates from decision values
+      size_t pairs = m_estimator->pairs();
+      double* dec_values = ws.values(pairs + m_estimator->workspaceSize(1));
+      uint64_t start = times ? nanoseconds() : 0;
+      predictValues_(input, dec_values);
+      uint64_t decided = times ? nanoseconds() : 0;
+      double retval = m_estimator->estimate(dec_values, probabilities,
+          dec_values + pairs, m_coupling);
+      if (times) {
+        times->kernel += decided - start;
+        times->voting += nanoseconds() - decided;
+      }
+      return retval;
+    }
+    uint64_t start = times ? nanoseconds() : 0;
+    double retval;
+    if (probabilities) retval = predictProbability_(input, probabilities);
+    else if (scores) retval = predictValues_(input, scores);
+    else retval = predict_(input);
+    if (times) times->kernel += nanoseconds() - start;
+    return retval;
+  };
+  if (!m_cache) return predict();
+
+  //the key is the list of (index, value) pairs of the scaled input
+  size_t n = 0;
+  while (input[n].index != -1) ++n;
+  double* key = ws.buffer(2*n);
+  for (size_t i=0; i<n; ++i) {
+    key[2*i] = input[i].index;
+    key[2*i+1] = input[i].value;
+  }
+  return predictCached_(key, 2*n, scores, probabilities, predict);
+}
+
+template <typename T>
+double bob::learn::libsvm::Machine::predictRow_(const T* input,
+    ptrdiff_t stride, double* scores, double* probabilities, Workspace& ws,
+    PhaseTimes* times) const {
+
+  uint64_t start = times ? nanoseconds() : 0;
+
+  if (m_dense) {
+    double* x = convertDense(input, stride, ws);
+    double* work = x + m_dense->paddedSize();
+    if (times) times->conversion += nanoseconds() - start;
+    return predictCached_(x, m_input_size, scores, probabilities, [&]() {
+      const DenseEngine& engine = localEngine();
+      if (probabilities)
+        return engine.predictProbability(x, probabilities, work, times,
+            m_coupling);
+      if (scores) return engine.predictValues(x, scores, work, times);
+      return engine.predict(x, work, times);
+    });
+  }
+
+  svm_node* x = convert(input, stride, ws);
+  if (times) times->conversion += nanoseconds() - start;
+  return predictNodes_(x, scores, probabilities, ws, times);
+}
+
+template <typename T>
+double bob::learn::libsvm::Machine::predictOne_(const T* input,
+    ptrdiff_t stride, double* scores, double* probabilities,
+    Workspace& ws) const {
+
+  if (!m_counters) return predictRow_(input, stride, scores, probabilities,
+      ws, 0);
+
+  PhaseTimes times;
+  uint64_t start = nanoseconds();
+  double retval = predictRow_(input, stride, scores, probabilities, ws,
+      &times);
+  m_counters->add(1, kernelEvaluations(1), times);
+  m_counters->addCall(nanoseconds() - start);
+  return retval;
+}
+
+uint64_t bob::learn::libsvm::Machine::kernelEvaluations(size_t n) const {
+  if (m_dense && m_dense->primal()) return 0;
+  return n * m_model->l;
+}
+
+void bob::learn::libsvm::Machine::setEngine(engine_t engine) {
+  bool single = (engine == DENSE_SINGLE_ENGINE);
+  size_t nodes = m_memory.replicate ? numa_nodes().size() : 1;
+  m_replicas.clear();
+  m_dense.reset();
+  if ((engine == DENSE_ENGINE || single) &&
+      bob::learn::libsvm::DenseEngine::suitable(m_model.get(), m_input_size,
+        single)) {
+    if (nodes > 1) {
+      //each replica is built by a thread on its node: pages are placed
+      //where they are first touched
+      m_replicas.resize(nodes);
+      parallel_for(nodes, nodes, 1, [&](size_t node, size_t) {
+        pin_to_numa_node(node);
+        m_replicas[node].reset(new bob::learn::libsvm::DenseEngine
+            (m_model.get(), m_input_size, single, m_memory.pages));
+      });
+      m_dense = m_replicas[current_numa_node() % nodes];
+    }
+    else
+      m_dense.reset(new bob::learn::libsvm::DenseEngine(m_model.get(),
+            m_input_size, single, m_memory.pages));
+  }
+  //results may differ, by rounding, from the ones of the other engines
+  if (m_cache) m_cache->clear();
+}
+
+void bob::learn::libsvm::Machine::setDefaultEngine() {
+  m_estimator.reset(new ProbabilityEstimator(m_model.get()));
+  m_coupling = ITERATIVE_COUPLING;
+  //linear models collapse into primal weights: always worth it
+  setEngine(kernelType() == LINEAR ? DENSE_ENGINE : LIBSVM_ENGINE);
+}
+
+bob::learn::libsvm::engine_t bob::learn::libsvm::Machine::engine() const {
+  if (!m_dense) return LIBSVM_ENGINE;
+  return m_dense->single() ? DENSE_SINGLE_ENGINE : DENSE_ENGINE;
+}
+
+void bob::learn::libsvm::Machine::setMemoryPolicy(const MemoryPolicy& policy)
+{
+  m_memory = policy;
+  if (m_dense) setEngine(engine());
+}
+
+size_t bob::learn::libsvm::Machine::replicas() const {
+  if (!m_dense) return 0;
+  return m_replicas.empty() ? 1 : m_replicas.size();
+}
+
+const bob::learn::libsvm::DenseEngine&
+bob::learn::libsvm::Machine::localEngine() const {
+  if (m_replicas.empty()) return *m_dense;
+  return *m_replicas[current_numa_node() % m_replicas.size()];
+}
+
+const bob::learn::libsvm::DenseEngine&
+bob::learn::libsvm::Machine::blockEngine(size_t start, size_t rows,
+    bool worker) const {
+  if (m_replicas.empty()) return *m_dense;
+  if (!worker) return localEngine(); ///< do not pin the caller's thread
+  size_t node = (start * m_replicas.size()) / rows;
+  pin_to_numa_node(node);
+  return *m_replicas[node];
+}
 
-  if ((size_t)input.extent(0) < inputSize()) {
+void bob::learn::libsvm::Machine::setProbabilityCoupling(coupling_t coupling) {
+  m_coupling = coupling;
+  if (m_cache) m_cache->clear();
+}
+
+void bob::learn::libsvm::Machine::setCollectStatistics(bool v) {
+  if (!v) m_counters.reset();
+  else if (!m_counters) m_counters.reset(new PredictionCounters);
+}
+
+bob::learn::libsvm::PredictionStatistics
+bob::learn::libsvm::Machine::getStatistics() const {
+  if (m_counters) return m_counters->read();
+  return PredictionCounters().read();
+}
+
+void bob::learn::libsvm::Machine::resetStatistics() {
+  if (m_counters) m_counters->reset();
+}
+
+void bob::learn::libsvm::Machine::setCacheSize(double size_in_mb) {
+  if (size_in_mb <= 0.) {
+    m_cache.reset();
+    return;
+  }
+  size_t classes = numberOfClasses();
+  size_t scores = std::max<size_t>(1, classes * (classes - 1) / 2);
+  m_cache.reset(new PredictionCache(size_in_mb, scores, classes));
+}
+
+double bob::learn::libsvm::Machine::getCacheSize() const {
+  if (m_cache) return m_cache->getSizeInMb();
+  return 0.;
+}
+
+bob::learn::libsvm::CacheStatistics
+bob::learn::libsvm::Machine::getCacheStatistics() const {
+  if (m_cache) return m_cache->statistics();
+  return CacheStatistics(); ///< all zeroes
+}
+
+void bob::learn::libsvm::Machine::clearCache() {
+  if (m_cache) m_cache->clear();
+}
+
+/**
+ * Checks the input size before prediction
+ */
+static void check_input(const blitz::Array<double,1>& input, size_t size) {
+  if ((size_t)input.extent(0) < size) {
     boost::format s("input for this SVM should have **at least** %d components, but you provided an array with %d elements instead");
-    s % inputSize() % input.extent(0);
+    s % size % input.extent(0);
     throw std::runtime_error(s.str());
   }
+}
+
+int bob::learn::libsvm::Machine::predictClass_
+(const blitz::Array<double,1>& input, Workspace& ws) const {
+  return round(predictOne_(input.data(), input.stride(0), 0, 0, ws));
+}
+
+int bob::learn::libsvm::Machine::predictClass_
+(const blitz::Array<double,1>& input) const {
+  Workspace ws;
+  return predictClass_(input, ws);
+}
 
-  return predictClass_(input);
+int bob::learn::libsvm::Machine::predictClass
+(const blitz::Array<double,1>& input, Workspace& ws) const {
+  check_input(input, inputSize());
+  return predictClass_(input, ws);
+}
+
+int bob::learn::libsvm::Machine::predictClass
+(const blitz::Array<double,1>& input) const {
+  Workspace ws;
+  return predictClass(input, ws);
+}
+
+int bob::learn::libsvm::Machine::predictClassAndScores_
+(const blitz::Array<double,1>& input,
+ blitz::Array<double,1>& scores, Workspace& ws) const {
+  return round(predictOne_(input.data(), input.stride(0), scores.data(), 0,
+        ws));
 }
 
 int bob::learn::libsvm::Machine::predictClassAndScores_
 (const blitz::Array<double,1>& input,
  blitz::Array<double,1>& scores) const {
-  copy(input, m_input_size, m_input_cache, m_input_sub, m_input_div);
-#if LIBSVM_VERSION > 290
-  int retval = round(svm_predict_values(m_model.get(), m_input_cache.get(), scores.data()));
-#else
-  svm_predict_values(m_model.get(), m_input_cache.get(), scores.data());
-  int retval = round(svm_predict(m_model.get(), m_input_cache.get()));
-#endif
-  return retval;
+  Workspace ws;
+  return predictClassAndScores_(input, scores, ws);
 }
 
 int bob::learn::libsvm::Machine::predictClassAndScores
 (const blitz::Array<double,1>& input,
- blitz::Array<double,1>& scores) const {
+ blitz::Array<double,1>& scores, Workspace& ws) const {
 
-  if ((size_t)input.extent(0) < inputSize()) {
-    boost::format s("input for this SVM should have **at least** %d components, but you provided an array with %d elements instead");
-    s % inputSize() % input.extent(0);
-    throw std::runtime_error(s.str());
-  }
+  check_input(input, inputSize());
 
   if (!bob::core::array::isCContiguous(scores)) {
     throw std::runtime_error("scores output array should be C-style contiguous and what you provided is not");
@@ -333,26 +652,35 @@ int bob::learn::libsvm::Machine::predictClassAndScores
     throw std::runtime_error(s.str());
   }
 
-  return predictClassAndScores_(input, scores);
+  return predictClassAndScores_(input, scores, ws);
+}
+
+int bob::learn::libsvm::Machine::predictClassAndScores
+(const blitz::Array<double,1>& input,
+ blitz::Array<double,1>& scores) const {
+  Workspace ws;
+  return predictClassAndScores(input, scores, ws);
+}
+
+int bob::learn::libsvm::Machine::predictClassAndProbabilities_
+(const blitz::Array<double,1>& input,
+ blitz::Array<double,1>& probabilities, Workspace& ws) const {
+  return round(predictOne_(input.data(), input.stride(0), 0,
+        probabilities.data(), ws));
 }
 
 int bob::learn::libsvm::Machine::predictClassAndProbabilities_
 (const blitz::Array<double,1>& input,
  blitz::Array<double,1>& probabilities) const {
-  copy(input, m_input_size, m_input_cache, m_input_sub, m_input_div);
-  int retval = round(svm_predict_probability(m_model.get(), m_input_cache.get(), probabilities.data()));
-  return retval;
+  Workspace ws;
+  return predictClassAndProbabilities_(input, probabilities, ws);
 }
 
 int bob::learn::libsvm::Machine::predictClassAndProbabilities
 (const blitz::Array<double,1>& input,
- blitz::Array<double,1>& probabilities) const {
+ blitz::Array<double,1>& probabilities, Workspace& ws) const {
 
-  if ((size_t)input.extent(0) < inputSize()) {
-    boost::format s("input for this SVM should have **at least** %d components, but you provided an array with %d elements instead");
-    s % inputSize() % input.extent(0);
-    throw std::runtime_error(s.str());
-  }
+  check_input(input, inputSize());
 
   if (!supportsProbability()) {
     throw std::runtime_error("this SVM does not support probabilities");
@@ -362,13 +690,420 @@ int bob::learn::libsvm::Machine::predictClassAndProbabilities
     throw std::runtime_error("probabilities output array should be C-style contiguous and what you provided is not");
   }
 
-  if ((size_t)probabilities.extent(0) != outputSize()) {
+  if ((size_t)probabilities.extent(0) != numberOfClasses()) {
     boost::format s("output probabilities for this SVM should have %d components, but you provided an array with %d elements instead");
-    s % outputSize() % probabilities.extent(0);
+    s % numberOfClasses() % probabilities.extent(0);
+    throw std::runtime_error(s.str());
+  }
+
+  return predictClassAndProbabilities_(input, probabilities, ws);
+}
+
+int bob::learn::libsvm::Machine::predictClassAndProbabilities
+(const blitz::Array<double,1>& input,
+ blitz::Array<double,1>& probabilities) const {
+  Workspace ws;
+  return predictClassAndProbabilities(input, probabilities, ws);
+}
+
+int bob::learn::libsvm::Machine::predictClass_
+(const blitz::Array<float,1>& input) const {
+  Workspace ws;
+  return round(predictOne_(input.data(), input.stride(0), 0, 0, ws));
+}
+
+int bob::learn::libsvm::Machine::predictClassAndScores_
+(const blitz::Array<float,1>& input, blitz::Array<double,1>& scores) const {
+  Workspace ws;
+  return round(predictOne_(input.data(), input.stride(0), scores.data(), 0,
+        ws));
+}
+
+int bob::learn::libsvm::Machine::predictClassAndProbabilities_
+(const blitz::Array<float,1>& input,
+ blitz::Array<double,1>& probabilities) const {
+  Workspace ws;
+  return round(predictOne_(input.data(), input.stride(0), 0,
+        probabilities.data(), ws));
+}
+
+template <typename T>
+void bob::learn::libsvm::Machine::checkBatch
+(const blitz::Array<T,2>& input,
+ const blitz::Array<int64_t,1>& labels) const {
+
+  if ((size_t)input.extent(1) < inputSize()) {
+    boost::format s("input for this SVM should have **at least** %d columns, but you provided an array with %d columns instead");
+    s % inputSize() % input.extent(1);
+    throw std::runtime_error(s.str());
+  }
+
+  if (labels.extent(0) != input.extent(0)) {
+    boost::format s("output labels should have %d components (one per input row), but you provided an array with %d elements instead");
+    s % input.extent(0) % labels.extent(0);
+    throw std::runtime_error(s.str());
+  }
+
+}
+
+void bob::learn::libsvm::Machine::checkBatch
+(const SparseMatrix& input, const blitz::Array<int64_t,1>& labels) const {
+
+  //zeros are not stored, so they cannot be shifted
+  for (size_t k=0; k<m_input_size; ++k) {
+    if (m_input_sub(k)) {
+      boost::format s("sparse inputs can only be scaled by division, but this SVM subtracts %g from feature %d");
+      s % m_input_sub(k) % k;
+      throw std::runtime_error(s.str());
+    }
+  }
+
+  if ((size_t)labels.extent(0) != input.rows()) {
+    boost::format s("output labels should have %d components (one per input row), but you provided an array with %d elements instead");
+    s % input.rows() % labels.extent(0);
+    throw std::runtime_error(s.str());
+  }
+
+}
+
+/**
+ * Checks the shape of batch scores
+ */
+static void check_scores(const blitz::Array<double,2>& scores, size_t rows,
+    size_t classes) {
+
+  if (!bob::core::array::isCContiguous(scores)) {
+    throw std::runtime_error("scores output array should be C-style contiguous and what you provided is not");
+  }
+
+  size_t N = (classes == 2) ? 1 : classes;
+  size_t size = N < 2 ? 1 : (N*(N-1))/2;
+  if ((size_t)scores.extent(0) != rows || (size_t)scores.extent(1) != size) {
+    boost::format s("output scores for this SVM (%d classes) should have shape (%d, %d), but you provided an array with shape (%d, %d) instead");
+    s % classes % rows % size;
+    s % scores.extent(0) % scores.extent(1);
     throw std::runtime_error(s.str());
   }
 
-  return predictClassAndProbabilities_(input, probabilities);
+}
+
+/**
+ * Checks the shape of batch probabilities
+ */
+static void check_probabilities(const blitz::Array<double,2>& probabilities,
+    size_t rows, size_t classes) {
+
+  if (!bob::core::array::isCContiguous(probabilities)) {
+    throw std::runtime_error("probabilities output array should be C-style contiguous and what you provided is not");
+  }
+
+  if ((size_t)probabilities.extent(0) != rows ||
+      (size_t)probabilities.extent(1) != classes) {
+    boost::format s("output probabilities for this SVM should have shape (%d, %d), but you provided an array with shape (%d, %d) instead");
+    s % rows % classes;
+    s % probabilities.extent(0) % probabilities.extent(1);
+    throw std::runtime_error(s.str());
+  }
+
+}
+
+template <typename Fill>
+void bob::learn::libsvm::Machine::predictDense_(const DenseEngine& engine,
+    Fill fill, size_t start, size_t end, int64_t* labels, ptrdiff_t out_row, double* scores,
+    ptrdiff_t sc_row, double* probabilities, ptrdiff_t pr_row,
+    Workspace& ws, PhaseTimes* times) const {
+
+  const size_t B = DenseEngine::BATCH_SIZE;
+  size_t padded = engine.paddedSize();
+  size_t F = std::max<size_t>(1, engine.functions());
+  size_t C = numberOfClasses();
+
+  //layout: inputs, labels, scores, probabilities and the engine's space
+  double* x = ws.buffer(B*padded + B + B*F + B*C +
+      engine.batchWorkspaceSize());
+  double* lab = x + B*padded;
+  double* sc = lab + B;
+  double* pr = sc + B*F;
+  double* work = pr + B*C;
+
+  //like libsvm, leaves probabilities untouched if they are not supported
+  bool copy_probabilities = probabilities && supportsProbability();
+  size_t row[B]; ///< of the inputs to predict, in the batch
+  uint64_t hash[B]; ///< of their keys, if the cache is on
+
+  for (size_t first=start; first<end; first+=B) {
+
+    size_t n = std::min(B, end-first);
+    uint64_t begin = times ? nanoseconds() : 0;
+    size_t m = 0; ///< rows not found in the cache, packed at the start
+    for (size_t i=0; i<n; ++i) {
+      size_t k = first + i;
+      double* xm = x + m*padded;
+      fill(k, xm);
+      if (m_cache) {
+        hash[m] = PredictionCache::hash(xm, m_input_size);
+        double label;
+        if (m_cache->find(xm, m_input_size, hash[m], label,
+              scores ? scores + k*sc_row : 0,
+              probabilities ? probabilities + k*pr_row : 0,
+              copy_probabilities)) {
+          labels[k*out_row] = round(label);
+          continue;
+        }
+      }
+      row[m++] = k;
+    }
+    if (times) times->conversion += nanoseconds() - begin;
+    if (!m) continue;
+
+    if (probabilities)
+      engine.predictProbability(x, m, lab, pr, work, times, m_coupling);
+    else engine.predictValues(x, m, lab, sc, work, times);
+
+    for (size_t i=0; i<m; ++i) {
+      size_t k = row[i];
+      labels[k*out_row] = round(lab[i]);
+      if (scores) std::copy(sc + i*F, sc + (i+1)*F, scores + k*sc_row);
+      if (copy_probabilities)
+        std::copy(pr + i*C, pr + (i+1)*C, probabilities + k*pr_row);
+      //scores are computed anyway, when probabilities are not
+      if (m_cache) m_cache->insert(x + i*padded, m_input_size, hash[i],
+          lab[i], probabilities ? 0 : sc + i*F,
+          probabilities ? pr + i*C : 0, copy_probabilities);
+    }
+
+  }
+
+}
+
+template <typename T>
+void bob::learn::libsvm::Machine::predictBatch_
+(const blitz::Array<T,2>& input, blitz::Array<int64_t,1>& labels,
+ double* scores, ptrdiff_t sc_row, double* probabilities, ptrdiff_t pr_row,
+ size_t threads) const {
+
+  // workers only touch raw memory: blitz reference counting is not
+  // thread-safe, so no views are created bellow
+  const T* in = input.data();
+  ptrdiff_t in_row = input.stride(0);
+  ptrdiff_t in_col = input.stride(1);
+  int64_t* out = labels.data();
+  ptrdiff_t out_row = labels.stride(0);
+  auto fill = [&](size_t k, double* x) { fillDense(in + k*in_row, in_col, x); };
+  uint64_t begin = m_counters ? nanoseconds() : 0;
+  size_t rows = input.extent(0);
+  boost::thread::id caller = boost::this_thread::get_id();
+
+  parallel_blocks(rows, threads, [&](size_t start, size_t end) {
+    Workspace ws;
+    PhaseTimes times;
+    PhaseTimes* t = m_counters ? &times : 0;
+    if (m_dense) {
+      bool worker = boost::this_thread::get_id() != caller;
+      predictDense_(blockEngine(start, rows, worker), fill, start, end, out,
+          out_row, scores, sc_row, probabilities, pr_row, ws, t);
+    }
+    else {
+      for (size_t k=start; k<end; ++k) {
+        out[k*out_row] = round(predictRow_(in + k*in_row, in_col,
+              scores ? scores + k*sc_row : 0,
+              probabilities ? probabilities + k*pr_row : 0, ws, t));
+      }
+    }
+    if (t) m_counters->add(end-start, kernelEvaluations(end-start), times);
+  });
+
+  if (m_counters) m_counters->addCall(nanoseconds() - begin);
+}
+
+void bob::learn::libsvm::Machine::predictClass_
+(const blitz::Array<double,2>& input, blitz::Array<int64_t,1>& labels,
+ size_t threads) const {
+  predictBatch_(input, labels, 0, 0, 0, 0, threads);
+}
+
+void bob::learn::libsvm::Machine::predictClass
+(const blitz::Array<double,2>& input, blitz::Array<int64_t,1>& labels,
+ size_t threads) const {
+  checkBatch(input, labels);
+  predictClass_(input, labels, threads);
+}
+
+void bob::learn::libsvm::Machine::predictClassAndScores_
+(const blitz::Array<double,2>& input, blitz::Array<int64_t,1>& labels,
+ blitz::Array<double,2>& scores, size_t threads) const {
+  predictBatch_(input, labels, scores.data(), scores.stride(0), 0, 0,
+      threads);
+}
+
+void bob::learn::libsvm::Machine::predictClassAndScores
+(const blitz::Array<double,2>& input, blitz::Array<int64_t,1>& labels,
+ blitz::Array<double,2>& scores, size_t threads) const {
+  checkBatch(input, labels);
+  check_scores(scores, input.extent(0), numberOfClasses());
+  predictClassAndScores_(input, labels, scores, threads);
+}
+
+void bob::learn::libsvm::Machine::predictClassAndProbabilities_
+(const blitz::Array<double,2>& input, blitz::Array<int64_t,1>& labels,
+ blitz::Array<double,2>& probabilities, size_t threads) const {
+  predictBatch_(input, labels, 0, 0, probabilities.data(),
+      probabilities.stride(0), threads);
+}
+
+void bob::learn::libsvm::Machine::predictClassAndProbabilities
+(const blitz::Array<double,2>& input, blitz::Array<int64_t,1>& labels,
+ blitz::Array<double,2>& probabilities, size_t threads) const {
+
+  checkBatch(input, labels);
+
+  if (!supportsProbability()) {
+    throw std::runtime_error("this SVM does not support probabilities");
+  }
+
+  check_probabilities(probabilities, input.extent(0), numberOfClasses());
+  predictClassAndProbabilities_(input, labels, probabilities, threads);
+}
+
+void bob::learn::libsvm::Machine::predictClass_
+(const blitz::Array<float,2>& input, blitz::Array<int64_t,1>& labels,
+ size_t threads) const {
+  predictBatch_(input, labels, 0, 0, 0, 0, threads);
+}
+
+void bob::learn::libsvm::Machine::predictClass
+(const blitz::Array<float,2>& input, blitz::Array<int64_t,1>& labels,
+ size_t threads) const {
+  checkBatch(input, labels);
+  predictClass_(input, labels, threads);
+}
+
+void bob::learn::libsvm::Machine::predictClassAndScores_
+(const blitz::Array<float,2>& input, blitz::Array<int64_t,1>& labels,
+ blitz::Array<double,2>& scores, size_t threads) const {
+  predictBatch_(input, labels, scores.data(), scores.stride(0), 0, 0,
+      threads);
+}
+
+void bob::learn::libsvm::Machine::predictClassAndScores
+(const blitz::Array<float,2>& input, blitz::Array<int64_t,1>& labels,
+ blitz::Array<double,2>& scores, size_t threads) const {
+  checkBatch(input, labels);
+  check_scores(scores, input.extent(0), numberOfClasses());
+  predictClassAndScores_(input, labels, scores, threads);
+}
+
+void bob::learn::libsvm::Machine::predictClassAndProbabilities_
+(const blitz::Array<float,2>& input, blitz::Array<int64_t,1>& labels,
+ blitz::Array<double,2>& probabilities, size_t threads) const {
+  predictBatch_(input, labels, 0, 0, probabilities.data(),
+      probabilities.stride(0), threads);
+}
+
+void bob::learn::libsvm::Machine::predictClassAndProbabilities
+(const blitz::Array<float,2>& input, blitz::Array<int64_t,1>& labels,
+ blitz::Array<double,2>& probabilities, size_t threads) const {
+
+  checkBatch(input, labels);
+
+  if (!supportsProbability()) {
+    throw std::runtime_error("this SVM does not support probabilities");
+  }
+
+  check_probabilities(probabilities, input.extent(0), numberOfClasses());
+  predictClassAndProbabilities_(input, labels, probabilities, threads);
+}
+
+void bob::learn::libsvm::Machine::predictSparse_
+(const SparseMatrix& input, blitz::Array<int64_t,1>& labels,
+ double* scores, ptrdiff_t sc_row, double* probabilities, ptrdiff_t pr_row,
+ size_t threads) const {
+
+  const int64_t* ptr = input.indptr();
+  const int64_t* idx = input.indices();
+  const double* val = input.values();
+  int64_t* out = labels.data();
+  ptrdiff_t out_row = labels.stride(0);
+  auto fill = [&](size_t k, double* x) {
+    fillDense(idx + ptr[k], val + ptr[k], ptr[k+1] - ptr[k], x);
+  };
+  uint64_t begin = m_counters ? nanoseconds() : 0;
+  size_t rows = input.rows();
+  boost::thread::id caller = boost::this_thread::get_id();
+
+  parallel_blocks(rows, threads, [&](size_t start, size_t end) {
+    Workspace ws;
+    PhaseTimes times;
+    PhaseTimes* t = m_counters ? &times : 0;
+    if (m_dense) {
+      bool worker = boost::this_thread::get_id() != caller;
+      predictDense_(blockEngine(start, rows, worker), fill, start, end, out,
+          out_row, scores, sc_row, probabilities, pr_row, ws, t);
+    }
+    else {
+      for (size_t k=start; k<end; ++k) {
+        uint64_t now = t ? nanoseconds() : 0;
+        svm_node* x = convert(idx + ptr[k], val + ptr[k], ptr[k+1] - ptr[k],
+            ws);
+        if (t) t->conversion += nanoseconds() - now;
+        out[k*out_row] = round(predictNodes_(x,
+              scores ? scores + k*sc_row : 0,
+              probabilities ? probabilities + k*pr_row : 0, ws, t));
+      }
+    }
+    if (t) m_counters->add(end-start, kernelEvaluations(end-start), times);
+  });
+
+  if (m_counters) m_counters->addCall(nanoseconds() - begin);
+}
+
+void bob::learn::libsvm::Machine::predictClass_
+(const SparseMatrix& input, blitz::Array<int64_t,1>& labels,
+ size_t threads) const {
+  predictSparse_(input, labels, 0, 0, 0, 0, threads);
+}
+
+void bob::learn::libsvm::Machine::predictClass
+(const SparseMatrix& input, blitz::Array<int64_t,1>& labels,
+ size_t threads) const {
+  checkBatch(input, labels);
+  predictClass_(input, labels, threads);
+}
+
+void bob::learn::libsvm::Machine::predictClassAndScores_
+(const SparseMatrix& input, blitz::Array<int64_t,1>& labels,
+ blitz::Array<double,2>& scores, size_t threads) const {
+  predictSparse_(input, labels, scores.data(), scores.stride(0), 0, 0,
+      threads);
+}
+
+void bob::learn::libsvm::Machine::predictClassAndScores
+(const SparseMatrix& input, blitz::Array<int64_t,1>& labels,
+ blitz::Array<double,2>& scores, size_t threads) const {
+  checkBatch(input, labels);
+  check_scores(scores, input.rows(), numberOfClasses());
+  predictClassAndScores_(input, labels, scores, threads);
+}
+
+void bob::learn::libsvm::Machine::predictClassAndProbabilities_
+(const SparseMatrix& input, blitz::Array<int64_t,1>& labels,
+ blitz::Array<double,2>& probabilities, size_t threads) const {
+  predictSparse_(input, labels, 0, 0, probabilities.data(),
+      probabilities.stride(0), threads);
+}
+
+void bob::learn::libsvm::Machine::predictClassAndProbabilities
+(const SparseMatrix& input, blitz::Array<int64_t,1>& labels,
+ blitz::Array<double,2>& probabilities, size_t threads) const {
+
+  checkBatch(input, labels);
+
+  if (!supportsProbability()) {
+    throw std::runtime_error("this SVM does not support probabilities");
+  }
+
+  check_probabilities(probabilities, input.rows(), numberOfClasses());
+  predictClassAndProbabilities_(input, labels, probabilities, threads);
 }
 
 void bob::learn::libsvm::Machine::save(const std::string& filename) const {
@@ -379,6 +1114,11 @@ void bob::learn::libsvm::Machine::save(const std::string& filename) const {
   }
 }
 
+void bob::learn::libsvm::Machine::saveBinary(const std::string& filename) const {
+  bob::learn::libsvm::svm_save_binary(filename, m_model, m_input_size,
+      m_input_sub, m_input_div);
+}
+
 void bob::learn::libsvm::Machine::save(bob::io::base::HDF5File& config) const {
   config.setArray("svm_model", bob::learn::libsvm::svm_pickle(m_model));
   config.setArray("input_subtract", m_input_sub);
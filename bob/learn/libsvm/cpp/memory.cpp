@@ -0,0 +1,170 @@
+/**
+ * @date Fri 16 Oct 2026 09:26:11 CEST
+ *
+ * @brief Implementation of the placement of model arrays
+ *
+ * Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+ */
+
+#include <bob.learn.libsvm/memory.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#ifdef __linux__
+#  include <pthread.h>
+#  include <sched.h>
+#  include <sys/mman.h>
+#  define BOB_LEARN_LIBSVM_NUMA
+#endif
+
+/**
+ * Tells if an array is mapped directly from the system
+ */
+static bool mapped(size_t bytes, bob::learn::libsvm::pages_t pages) {
+#ifdef BOB_LEARN_LIBSVM_NUMA
+  return pages != bob::learn::libsvm::DEFAULT_PAGES &&
+    bytes >= bob::learn::libsvm::HUGE_PAGE_SIZE;
+#else
+  (void)bytes;
+  (void)pages;
+  return false;
+#endif
+}
+
+/**
+ * Rounds a mapped size up to whole huge pages
+ */
+static size_t mapped_size(size_t bytes) {
+  const size_t page = bob::learn::libsvm::HUGE_PAGE_SIZE;
+  return ((bytes + page - 1) / page) * page;
+}
+
+void* bob::learn::libsvm::allocate_model(size_t bytes, pages_t pages) {
+
+  if (!bytes) bytes = 1;
+
+#ifdef BOB_LEARN_LIBSVM_NUMA
+  if (mapped(bytes, pages)) {
+    size_t size = mapped_size(bytes);
+    void* p = MAP_FAILED;
+#   ifdef MAP_HUGETLB
+    if (pages == EXPLICIT_HUGE_PAGES)
+      p = mmap(0, size, PROT_READ | PROT_WRITE,
+          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#   endif
+    if (p == MAP_FAILED) {
+      p = mmap(0, size, PROT_READ | PROT_WRITE,
+          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (p == MAP_FAILED) throw std::bad_alloc();
+#     ifdef MADV_HUGEPAGE
+      madvise(p, size, MADV_HUGEPAGE); ///< only advice: failures are fine
+#     endif
+    }
+    return p;
+  }
+#endif
+
+  void* p = 0;
+  if (posix_memalign(&p, ENGINE_ALIGNMENT, bytes)) throw std::bad_alloc();
+  return p;
+}
+
+void bob::learn::libsvm::free_model(void* p, size_t bytes, pages_t pages) {
+  if (!p) return;
+  if (!bytes) bytes = 1;
+#ifdef BOB_LEARN_LIBSVM_NUMA
+  if (mapped(bytes, pages)) {
+    munmap(p, mapped_size(bytes));
+    return;
+  }
+#endif
+  std::free(p);
+}
+
+/**
+ * Parses a list of CPUs as printed by the kernel, like "0-3,8-11"
+ */
+static std::vector<int> parse_cpu_list(const std::string& list) {
+  std::vector<int> retval;
+  std::istringstream ranges(list);
+  std::string range;
+  while (std::getline(ranges, range, ',')) {
+    int first = 0, last = 0;
+    char dash = 0;
+    std::istringstream is(range);
+    if (!(is >> first)) continue;
+    last = first;
+    if (is >> dash && dash == '-') is >> last;
+    for (int cpu=first; cpu<=last; ++cpu) retval.push_back(cpu);
+  }
+  return retval;
+}
+
+/**
+ * Reads the CPUs of each NUMA node from sysfs
+ */
+static std::vector<std::vector<int> > read_numa_nodes() {
+  std::vector<std::vector<int> > retval;
+#ifdef BOB_LEARN_LIBSVM_NUMA
+  for (size_t node=0; ; ++node) {
+    std::ostringstream path;
+    path << "/sys/devices/system/node/node" << node << "/cpulist";
+    std::ifstream file(path.str().c_str());
+    std::string list;
+    if (!file || !std::getline(file, list)) break;
+    retval.push_back(parse_cpu_list(list));
+  }
+#endif
+  if (retval.empty()) retval.resize(1);
+  return retval;
+}
+
+const std::vector<std::vector<int> >& bob::learn::libsvm::numa_nodes() {
+  static const std::vector<std::vector<int> > nodes = read_numa_nodes();
+  return nodes;
+}
+
+#ifdef BOB_LEARN_LIBSVM_NUMA
+/**
+ * Maps each CPU to its NUMA node
+ */
+static std::vector<size_t> map_cpus() {
+  const std::vector<std::vector<int> >& nodes =
+    bob::learn::libsvm::numa_nodes();
+  std::vector<size_t> retval;
+  for (size_t node=0; node<nodes.size(); ++node) {
+    for (size_t k=0; k<nodes[node].size(); ++k) {
+      size_t cpu = nodes[node][k];
+      if (cpu >= retval.size()) retval.resize(cpu + 1, 0);
+      retval[cpu] = node;
+    }
+  }
+  return retval;
+}
+#endif
+
+size_t bob::learn::libsvm::current_numa_node() {
+#ifdef BOB_LEARN_LIBSVM_NUMA
+  static const std::vector<size_t> cpus = map_cpus();
+  int cpu = sched_getcpu();
+  if (cpu >= 0 && (size_t)cpu < cpus.size()) return cpus[cpu];
+#endif
+  return 0;
+}
+
+bool bob::learn::libsvm::pin_to_numa_node(size_t node) {
+  const std::vector<std::vector<int> >& nodes = numa_nodes();
+  if (node >= nodes.size() || nodes[node].empty()) return false;
+#ifdef BOB_LEARN_LIBSVM_NUMA
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (size_t k=0; k<nodes[node].size(); ++k)
+    if (nodes[node][k] < CPU_SETSIZE) CPU_SET(nodes[node][k], &set);
+  return !pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+  return false;
+#endif
+}
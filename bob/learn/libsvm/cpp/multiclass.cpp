@@ -0,0 +1,205 @@
+/**
+ * @date Wed 14 Oct 2026 16:02:18 CEST
+ *
+ * @brief Implementation of one-vs-rest multi-class machines
+ *
+ * Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+ */
+
+#include <bob.learn.libsvm/multiclass.h>
+
+#include <boost/format.hpp>
+#include <boost/make_shared.hpp>
+
+bob::learn::libsvm::OneVsRestMachine::OneVsRestMachine
+(const std::vector<boost::shared_ptr<bob::learn::libsvm::Machine> >& machines,
+ const std::vector<int>& labels):
+  m_machines(machines),
+  m_labels(labels)
+{
+  check();
+}
+
+bob::learn::libsvm::OneVsRestMachine::OneVsRestMachine
+(bob::io::base::HDF5File& config) {
+  blitz::Array<int64_t,1> labels = config.readArray<int64_t,1>("labels");
+  for (int k=0; k<labels.extent(0); ++k) {
+    boost::format group("machine_%d");
+    group % k;
+    config.cd(group.str());
+    m_machines.push_back(boost::make_shared<bob::learn::libsvm::Machine>(config));
+    config.cd("..");
+    m_labels.push_back((int)labels(k));
+  }
+  check();
+}
+
+bob::learn::libsvm::OneVsRestMachine::OneVsRestMachine
+(const bob::learn::libsvm::OneVsRestMachine& other):
+  m_labels(other.m_labels)
+{
+  for (size_t k=0; k<other.m_machines.size(); ++k)
+    m_machines.push_back(boost::make_shared<bob::learn::libsvm::Machine>(*other.m_machines[k]));
+}
+
+bob::learn::libsvm::OneVsRestMachine::~OneVsRestMachine() { }
+
+void bob::learn::libsvm::OneVsRestMachine::check() const {
+
+  if (m_machines.size() < 2 || m_machines.size() != m_labels.size()) {
+    boost::format s("one-vs-rest machines require one binary machine per class, for, at least, 2 classes, but there are %d machines for %d classes");
+    s % m_machines.size() % m_labels.size();
+    throw std::runtime_error(s.str());
+  }
+
+  for (size_t k=0; k<m_machines.size(); ++k) {
+    const bob::learn::libsvm::Machine& m = *m_machines[k];
+    if (m.numberOfClasses() != 2 || m.classLabel(0) != +1) {
+      boost::format s("the machine for class %d of a one-vs-rest machine should be a binary classifier whose first label is +1");
+      s % k;
+      throw std::runtime_error(s.str());
+    }
+    if (m.inputSize() != m_machines[0]->inputSize()) {
+      boost::format s("the machine for class %d of a one-vs-rest machine takes %d inputs, but the one for class 0 takes %d");
+      s % k % m.inputSize() % m_machines[0]->inputSize();
+      throw std::runtime_error(s.str());
+    }
+  }
+
+}
+
+size_t bob::learn::libsvm::OneVsRestMachine::inputSize() const {
+  return m_machines[0]->inputSize();
+}
+
+void bob::learn::libsvm::OneVsRestMachine::setInputSubtraction
+(const blitz::Array<double,1>& v) {
+  for (size_t k=0; k<m_machines.size(); ++k)
+    m_machines[k]->setInputSubtraction(v);
+}
+
+void bob::learn::libsvm::OneVsRestMachine::setInputDivision
+(const blitz::Array<double,1>& v) {
+  for (size_t k=0; k<m_machines.size(); ++k)
+    m_machines[k]->setInputDivision(v);
+}
+
+int bob::learn::libsvm::OneVsRestMachine::predictClass
+(const blitz::Array<double,1>& input) const {
+  blitz::Array<double,1> scores(m_labels.size());
+  return predictClassAndScores(input, scores);
+}
+
+int bob::learn::libsvm::OneVsRestMachine::predictClassAndScores
+(const blitz::Array<double,1>& input, blitz::Array<double,1>& scores) const {
+
+  if ((size_t)scores.extent(0) != m_labels.size()) {
+    boost::format s("output scores for this one-vs-rest machine (%d classes) should have %d components, but you provided an array with %d elements instead");
+    s % m_labels.size() % m_labels.size() % scores.extent(0);
+    throw std::runtime_error(s.str());
+  }
+
+  bob::learn::libsvm::Machine::Workspace ws;
+  blitz::Array<double,1> score(1);
+  size_t best = 0;
+  for (size_t k=0; k<m_machines.size(); ++k) {
+    m_machines[k]->predictClassAndScores(input, score, ws);
+    scores(k) = score(0);
+    if (scores(k) > scores(best)) best = k;
+  }
+  return m_labels[best];
+}
+
+template <typename Input>
+void bob::learn::libsvm::OneVsRestMachine::predict_
+(const Input& input, size_t rows, blitz::Array<int64_t,1>& labels,
+ blitz::Array<double,2>& scores, size_t threads) const {
+
+  blitz::Array<int64_t,1> decision(rows);
+  blitz::Array<double,2> score(rows, 1);
+  double* sc = scores.data();
+  ptrdiff_t sc_row = scores.stride(0);
+  ptrdiff_t sc_col = scores.stride(1);
+
+  for (size_t k=0; k<m_machines.size(); ++k) {
+    m_machines[k]->predictClassAndScores(input, decision, score, threads);
+    const double* s = score.data();
+    for (size_t i=0; i<rows; ++i) sc[i*sc_row + k*sc_col] = s[i];
+  }
+
+  int64_t* out = labels.data();
+  ptrdiff_t out_row = labels.stride(0);
+  for (size_t i=0; i<rows; ++i) {
+    const double* row = sc + i*sc_row;
+    size_t best = 0;
+    for (size_t k=1; k<m_labels.size(); ++k)
+      if (row[k*sc_col] > row[best*sc_col]) best = k;
+    out[i*out_row] = m_labels[best];
+  }
+
+}
+
+/**
+ * Checks the shape of batch outputs
+ */
+static void check_outputs(size_t rows, size_t classes,
+    const blitz::Array<int64_t,1>& labels,
+    const blitz::Array<double,2>& scores) {
+
+  if ((size_t)labels.extent(0) != rows) {
+    boost::format s("output labels should have %d components (one per input row), but you provided an array with %d elements instead");
+    s % rows % labels.extent(0);
+    throw std::runtime_error(s.str());
+  }
+
+  if ((size_t)scores.extent(0) != rows || (size_t)scores.extent(1) != classes) {
+    boost::format s("output scores for this one-vs-rest machine (%d classes) should have shape (%d, %d), but you provided an array with shape (%d, %d) instead");
+    s % classes % rows % classes % scores.extent(0) % scores.extent(1);
+    throw std::runtime_error(s.str());
+  }
+
+}
+
+void bob::learn::libsvm::OneVsRestMachine::predictClass
+(const blitz::Array<double,2>& input, blitz::Array<int64_t,1>& labels,
+ size_t threads) const {
+  blitz::Array<double,2> scores(input.extent(0), m_labels.size());
+  predictClassAndScores(input, labels, scores, threads);
+}
+
+void bob::learn::libsvm::OneVsRestMachine::predictClassAndScores
+(const blitz::Array<double,2>& input, blitz::Array<int64_t,1>& labels,
+ blitz::Array<double,2>& scores, size_t threads) const {
+  check_outputs(input.extent(0), m_labels.size(), labels, scores);
+  predict_(input, input.extent(0), labels, scores, threads);
+}
+
+void bob::learn::libsvm::OneVsRestMachine::predictClass
+(const bob::learn::libsvm::SparseMatrix& input,
+ blitz::Array<int64_t,1>& labels, size_t threads) const {
+  blitz::Array<double,2> scores(input.rows(), m_labels.size());
+  predictClassAndScores(input, labels, scores, threads);
+}
+
+void bob::learn::libsvm::OneVsRestMachine::predictClassAndScores
+(const bob::learn::libsvm::SparseMatrix& input,
+ blitz::Array<int64_t,1>& labels, blitz::Array<double,2>& scores,
+ size_t threads) const {
+  check_outputs(input.rows(), m_labels.size(), labels, scores);
+  predict_(input, input.rows(), labels, scores, threads);
+}
+
+void bob::learn::libsvm::OneVsRestMachine::save
+(bob::io::base::HDF5File& config) const {
+  blitz::Array<int64_t,1> labels(m_labels.size());
+  for (size_t k=0; k<m_labels.size(); ++k) labels(k) = m_labels[k];
+  config.setArray("labels", labels);
+  for (size_t k=0; k<m_machines.size(); ++k) {
+    boost::format group("machine_%d");
+    group % k;
+    config.createGroup(group.str());
+    config.cd(group.str());
+    m_machines[k]->save(config);
+    config.cd("..");
+  }
+}
@@ -0,0 +1,567 @@
+/**
+ * @date Tue 13 Oct 2026 10:21:07 CEST
+ *
+ * @brief In-memory (de-)serialization and copying of libsvm models
+ *
+ * Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+ */
+
+#include <bob.learn.libsvm/machine.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <clocale>
+#include <sstream>
+#include <locale>
+#include <new>
+#include <vector>
+#include <algorithm>
+#include <boost/format.hpp>
+#include <bob.core/check.h>
+
+/**
+ * Names used by libsvm to identify machine and kernel types in model files,
+ * in the same order as the enumerations in svm.h
+ */
+static const char* svm_type_table[] = {
+  "c_svc", "nu_svc", "one_class", "epsilon_svr", "nu_svr", 0
+};
+
+static const char* kernel_type_table[] = {
+  "linear", "polynomial", "rbf", "sigmoid", "precomputed", 0
+};
+
+/**
+ * Significant digits svm_save_model() writes floating-point numbers with.
+ * libsvm 3.25 raised the precision of everything but support vector values,
+ * which were already written with the precision of the training data files.
+ */
+#if LIBSVM_VERSION >= 325
+static const int PARAMETER_DIGITS = 17; ///< gamma, coef0, rho, probA, ...
+static const int COEFFICIENT_DIGITS = 17; ///< sv_coef
+#else
+static const int PARAMETER_DIGITS = 6;
+static const int COEFFICIENT_DIGITS = 16;
+#endif
+static const int VALUE_DIGITS = 8; ///< support vector values
+
+#if LIBSVM_VERSION >= 330
+/**
+ * Number of probability density marks of one-class models, fixed by libsvm
+ */
+static const int DENSITY_MARKS = 10;
+#endif
+
+/**
+ * Aligns offsets within a model arena to 16 bytes, which is good for any of
+ * the types it holds
+ */
+static size_t arena_align(size_t offset) {
+  return (offset + 15) & ~size_t(15);
+}
+
+/**
+ * Creates a model with ``l`` support vectors holding a total of ``elements``
+ * nodes (including terminators), with all its arrays on a single block of
+ * memory, right after the model itself, which is released at once with the
+ * last reference to the model. Pointers to optional arrays are only set if
+ * they are asked for, all others are zero (``marks`` is ignored before libsvm
+ * 3.3, which has no probability density marks). Such models must never be
+ * destroyed by libsvm: @c free_sv is not set.
+ */
+static boost::shared_ptr<svm_model> new_model(int nr_class, int l,
+    size_t elements, bool probA, bool probB, bool marks, bool label,
+    bool nSV) {
+
+  size_t m = nr_class - 1;
+  size_t pairs = (nr_class*(nr_class-1))/2;
+
+  size_t sv = arena_align(sizeof(svm_model));
+  size_t coef_rows = arena_align(sv + l*sizeof(svm_node*));
+  size_t coef = arena_align(coef_rows + m*sizeof(double*));
+  size_t rho = arena_align(coef + m*l*sizeof(double));
+  size_t prob_a = arena_align(rho + pairs*sizeof(double));
+  size_t prob_b = arena_align(prob_a + (probA ? pairs : 0)*sizeof(double));
+#if LIBSVM_VERSION >= 330
+  size_t density = arena_align(prob_b + (probB ? pairs : 0)*sizeof(double));
+  size_t labels = arena_align(density +
+      (marks ? DENSITY_MARKS : 0)*sizeof(double));
+#else
+  (void)marks;
+  size_t labels = arena_align(prob_b + (probB ? pairs : 0)*sizeof(double));
+#endif
+  size_t nsv = arena_align(labels + (label ? nr_class : 0)*sizeof(int));
+  size_t nodes = arena_align(nsv + (nSV ? nr_class : 0)*sizeof(int));
+  size_t size = nodes + elements*sizeof(svm_node);
+
+  char* base = static_cast<char*>(std::malloc(size));
+  if (!base) throw std::bad_alloc();
+  svm_model* model = new (base) svm_model(); ///< all zeros
+  boost::shared_ptr<svm_model> retval(model, [](svm_model* p) {
+      std::free(p); });
+
+  model->nr_class = nr_class;
+  model->l = l;
+  model->SV = reinterpret_cast<svm_node**>(base + sv);
+  model->sv_coef = reinterpret_cast<double**>(base + coef_rows);
+  for (size_t k=0; k<m; ++k)
+    model->sv_coef[k] = reinterpret_cast<double*>(base + coef) + k*l;
+  model->rho = reinterpret_cast<double*>(base + rho);
+  if (probA) model->probA = reinterpret_cast<double*>(base + prob_a);
+  if (probB) model->probB = reinterpret_cast<double*>(base + prob_b);
+#if LIBSVM_VERSION >= 330
+  if (marks)
+    model->prob_density_marks = reinterpret_cast<double*>(base + density);
+#endif
+  if (label) model->label = reinterpret_cast<int*>(base + labels);
+  if (nSV) model->nSV = reinterpret_cast<int*>(base + nsv);
+  if (l) model->SV[0] = reinterpret_cast<svm_node*>(base + nodes);
+  model->free_sv = 0;
+
+  return retval;
+}
+
+/**
+ * Copies ``from`` into a new model on a single block of memory. Values are
+ * copied exactly, but support vectors of precomputed kernels are reduced to
+ * their serial number, which is all libsvm uses (and saves) of them.
+ */
+boost::shared_ptr<svm_model> bob::learn::libsvm::svm_copy
+(const boost::shared_ptr<svm_model> model) {
+
+  const svm_model* from = model.get();
+  bool precomputed = (from->param.kernel_type == PRECOMPUTED);
+
+  //support vectors are copied to a single block of memory
+  size_t elements = 0;
+  for (int i=0; i<from->l; ++i) {
+    const svm_node* p = from->SV[i];
+    if (precomputed) { elements += 2; continue; }
+    while (p->index != -1) ++p;
+    elements += (p - from->SV[i]) + 1;
+  }
+
+#if LIBSVM_VERSION >= 330
+  bool marks = from->prob_density_marks;
+#else
+  bool marks = false;
+#endif
+  boost::shared_ptr<svm_model> retval = new_model(from->nr_class, from->l,
+      elements, from->probA, from->probB, marks, from->label, from->nSV);
+  svm_model* to = retval.get();
+
+  to->param = from->param;
+  to->param.nr_weight = 0; ///< training-only information, not owned
+  to->param.weight_label = 0;
+  to->param.weight = 0;
+
+  svm_node* x = to->l ? to->SV[0] : 0;
+  for (int i=0; i<from->l; ++i) {
+    const svm_node* p = from->SV[i];
+    to->SV[i] = x;
+    if (precomputed) *x++ = *p; ///< sample serial number
+    else while (p->index != -1) *x++ = *p++;
+    x->index = -1; ///< terminator
+    (x++)->value = 0.;
+  }
+
+  int nr_class = to->nr_class;
+  size_t pairs = (nr_class*(nr_class-1))/2;
+  for (int k=0; k<nr_class-1; ++k)
+    std::copy(from->sv_coef[k], from->sv_coef[k] + to->l, to->sv_coef[k]);
+  std::copy(from->rho, from->rho + pairs, to->rho);
+  if (to->probA) std::copy(from->probA, from->probA + pairs, to->probA);
+  if (to->probB) std::copy(from->probB, from->probB + pairs, to->probB);
+#if LIBSVM_VERSION >= 330
+  if (marks) std::copy(from->prob_density_marks,
+      from->prob_density_marks + DENSITY_MARKS, to->prob_density_marks);
+#endif
+  if (to->label) std::copy(from->label, from->label + nr_class, to->label);
+  if (to->nSV) std::copy(from->nSV, from->nSV + nr_class, to->nSV);
+
+  return retval;
+}
+
+/**
+ * Writes the model in the text format of svm_save_model() of the libsvm we
+ * are compiled against, that is also used within HDF5 files. The output is
+ * the same, byte by byte: C++ streams with a given precision format
+ * floating-point numbers like printf("%.<precision>g").
+ */
+static void write_model(std::ostream& out, const svm_model* model) {
+
+  out.imbue(std::locale::classic());
+  const svm_parameter& param = model->param;
+
+  out << "svm_type " << svm_type_table[param.svm_type] << "\n";
+  out << "kernel_type " << kernel_type_table[param.kernel_type] << "\n";
+
+  out.precision(PARAMETER_DIGITS);
+  if (param.kernel_type == POLY)
+    out << "degree " << param.degree << "\n";
+  if (param.kernel_type == POLY || param.kernel_type == RBF ||
+      param.kernel_type == SIGMOID)
+    out << "gamma " << param.gamma << "\n";
+  if (param.kernel_type == POLY || param.kernel_type == SIGMOID)
+    out << "coef0 " << param.coef0 << "\n";
+
+  int nr_class = model->nr_class;
+  int l = model->l;
+  int pairs = (nr_class*(nr_class-1))/2;
+  out << "nr_class " << nr_class << "\n";
+  out << "total_sv " << l << "\n";
+
+  out << "rho";
+  for (int i=0; i<pairs; ++i) out << " " << model->rho[i];
+  out << "\n";
+
+  if (model->label) {
+    out << "label";
+    for (int i=0; i<nr_class; ++i) out << " " << model->label[i];
+    out << "\n";
+  }
+
+  if (model->probA) {
+    out << "probA";
+    for (int i=0; i<pairs; ++i) out << " " << model->probA[i];
+    out << "\n";
+  }
+
+  if (model->probB) {
+    out << "probB";
+    for (int i=0; i<pairs; ++i) out << " " << model->probB[i];
+    out << "\n";
+  }
+
+#if LIBSVM_VERSION >= 330
+  if (model->prob_density_marks) {
+    out << "prob_density_marks";
+    for (int i=0; i<DENSITY_MARKS; ++i)
+      out << " " << model->prob_density_marks[i];
+    out << "\n";
+  }
+#endif
+
+  if (model->nSV) {
+    out << "nr_sv";
+    for (int i=0; i<nr_class; ++i) out << " " << model->nSV[i];
+    out << "\n";
+  }
+
+  out << "SV\n";
+  for (int i=0; i<l; ++i) {
+    out.precision(COEFFICIENT_DIGITS);
+    for (int j=0; j<nr_class-1; ++j) out << model->sv_coef[j][i] << " ";
+
+    const svm_node* p = model->SV[i];
+    if (param.kernel_type == PRECOMPUTED) {
+      out << "0:" << (int)(p->value) << " ";
+    }
+    else {
+      out.precision(VALUE_DIGITS);
+      for (; p->index != -1; ++p) out << p->index << ":" << p->value << " ";
+    }
+    out << "\n";
+  }
+
+}
+
+blitz::Array<uint8_t,1> bob::learn::libsvm::svm_pickle
+(const boost::shared_ptr<svm_model> model)
+{
+  std::ostringstream out;
+  write_model(out, model.get());
+
+  if (!out) {
+    throw std::runtime_error("cannot serialize SVM model to memory");
+  }
+
+  const std::string& s = out.str();
+  blitz::Array<uint8_t,1> buffer(s.size());
+  if (s.size()) std::memcpy(buffer.data(), s.data(), s.size());
+  return buffer;
+}
+
+/**
+ * A minimalistic scanner for libsvm model files kept in memory
+ */
+class ModelReader {
+
+  public:
+
+    ModelReader(const char* start, const char* end):
+      m_start(start), m_cur(start), m_end(end),
+      m_c_locale(*std::localeconv()->decimal_point == '.') {}
+
+    /**
+     * Skips blanks, but not line breaks if @c newlines is false
+     */
+    void skip(bool newlines=true) {
+      while (m_cur < m_end && (*m_cur == ' ' || *m_cur == '\t' ||
+            *m_cur == '\r' || (newlines && *m_cur == '\n'))) ++m_cur;
+    }
+
+    /**
+     * Tells if we are at the end of the current line (or of the buffer)
+     */
+    bool eol() {
+      skip(false);
+      return m_cur >= m_end || *m_cur == '\n';
+    }
+
+    /**
+     * Returns the next white-space separated word. Leaves the cursor after
+     * the word.
+     */
+    std::string word() {
+      skip();
+      const char* start = m_cur;
+      while (m_cur < m_end && !isblank()) ++m_cur;
+      return std::string(start, m_cur);
+    }
+
+    long integer() {
+      skip(false);
+      const char* start = m_cur;
+      bool negative = false;
+      if (m_cur < m_end && (*m_cur == '-' || *m_cur == '+')) {
+        negative = (*m_cur == '-');
+        ++m_cur;
+      }
+      long value = 0;
+      const char* digits = m_cur;
+      while (m_cur < m_end && *m_cur >= '0' && *m_cur <= '9')
+        value = 10*value + (*m_cur++ - '0');
+      if (m_cur == digits) error("integer", start);
+      return negative ? -value : value;
+    }
+
+    double real() {
+      skip(false);
+      const char* start = m_cur;
+      while (m_cur < m_end && !isblank() && *m_cur != ':') ++m_cur;
+      if (m_cur == start) error("floating-point number", start);
+
+      //numbers are short: avoid allocations using a local buffer
+      char buffer[64];
+      size_t size = m_cur - start;
+      if (size >= sizeof(buffer)) error("floating-point number", start);
+      std::memcpy(buffer, start, size);
+      buffer[size] = 0;
+
+      if (m_c_locale) {
+        char* tail = 0;
+        double value = std::strtod(buffer, &tail);
+        if (*tail) error("floating-point number", start);
+        return value;
+      }
+
+      //slow path, if the user has set a locale that does not use '.'
+      std::istringstream in(buffer);
+      in.imbue(std::locale::classic());
+      double value = 0.;
+      in >> value;
+      if (!in || !in.eof()) error("floating-point number", start);
+      return value;
+    }
+
+    void expect(char c) {
+      if (m_cur >= m_end || *m_cur != c) {
+        error((boost::format("`%c'") % c).str().c_str(), m_cur);
+      }
+      ++m_cur;
+    }
+
+    void next_line() {
+      while (m_cur < m_end && *m_cur != '\n') ++m_cur;
+      if (m_cur < m_end) ++m_cur;
+    }
+
+    bool end() { skip(); return m_cur >= m_end; }
+
+    const char* position() const { return m_cur; }
+
+    const char* limit() const { return m_end; }
+
+    void seek(const char* p) { m_cur = p; }
+
+    void error(const char* what, const char* where) const {
+      boost::format m("error parsing SVM model from memory: expected %s at position %d");
+      m % what % (where - m_start);
+      throw std::runtime_error(m.str());
+    }
+
+  private:
+
+    bool isblank() const {
+      return *m_cur == ' ' || *m_cur == '\t' || *m_cur == '\r' ||
+        *m_cur == '\n';
+    }
+
+    const char* m_start; ///< where the buffer starts
+    const char* m_cur; ///< current read position
+    const char* m_end; ///< one past the last valid position
+    bool m_c_locale; ///< if strtod() can be used directly
+
+};
+
+static int lookup(const char* table[], const std::string& name,
+    const char* what) {
+  for (int i=0; table[i]; ++i) if (name == table[i]) return i;
+  boost::format m("unknown %s `%s' while parsing SVM model from memory");
+  m % what % name;
+  throw std::runtime_error(m.str());
+}
+
+static std::vector<double> read_reals(ModelReader& r, size_t n) {
+  std::vector<double> retval(n);
+  for (size_t i=0; i<n; ++i) retval[i] = r.real();
+  return retval;
+}
+
+static std::vector<int> read_integers(ModelReader& r, size_t n) {
+  std::vector<int> retval(n);
+  for (size_t i=0; i<n; ++i) retval[i] = r.integer();
+  return retval;
+}
+
+boost::shared_ptr<svm_model> bob::learn::libsvm::svm_unpickle
+(const blitz::Array<uint8_t,1>& buffer) {
+
+  if (!bob::core::array::isCContiguous(buffer)) {
+    throw std::runtime_error("SVM model buffer should be C-style contiguous and what you provided is not");
+  }
+
+  const char* start = reinterpret_cast<const char*>(buffer.data());
+  ModelReader r(start, start + buffer.extent(0));
+
+  //header, kept aside until the model can be allocated in one go
+  svm_parameter param = svm_parameter();
+  int nr_class = 0;
+  int l = 0;
+  int pairs = 0;
+  std::vector<double> rho, probA, probB, marks;
+  std::vector<int> label, nSV;
+  bool has_probA = false, has_probB = false, has_marks = false;
+  bool has_label = false, has_nSV = false;
+
+  while (true) {
+    std::string cmd = r.word();
+    if (cmd.empty()) r.error("header entry", r.position());
+
+    if (cmd == "svm_type")
+      param.svm_type = lookup(svm_type_table, r.word(), "svm type");
+    else if (cmd == "kernel_type")
+      param.kernel_type = lookup(kernel_type_table, r.word(), "kernel type");
+    else if (cmd == "degree") param.degree = r.integer();
+    else if (cmd == "gamma") param.gamma = r.real();
+    else if (cmd == "coef0") param.coef0 = r.real();
+    else if (cmd == "nr_class") {
+      nr_class = r.integer();
+      pairs = (nr_class*(nr_class-1))/2;
+    }
+    else if (cmd == "total_sv") l = r.integer();
+    else if (cmd == "rho") rho = read_reals(r, pairs);
+    else if (cmd == "label") {
+      label = read_integers(r, nr_class);
+      has_label = true;
+    }
+    else if (cmd == "probA") {
+      probA = read_reals(r, pairs);
+      has_probA = true;
+    }
+    else if (cmd == "probB") {
+      probB = read_reals(r, pairs);
+      has_probB = true;
+    }
+#if LIBSVM_VERSION >= 330
+    else if (cmd == "prob_density_marks") {
+      marks = read_reals(r, DENSITY_MARKS);
+      has_marks = true;
+    }
+#endif
+    else if (cmd == "nr_sv") {
+      nSV = read_integers(r, nr_class);
+      has_nSV = true;
+    }
+    else if (cmd == "SV") {
+      r.next_line();
+      break;
+    }
+    else {
+      boost::format m("unknown entry `%s' in header of SVM model");
+      m % cmd;
+      throw std::runtime_error(m.str());
+    }
+  }
+
+  if (nr_class < 1 || l < 0) {
+    throw std::runtime_error("invalid number of classes or support vectors in the header of SVM model");
+  }
+
+  //entries may come before nr_class: they must have the right size anyway
+  size_t np = pairs;
+  size_t nc = nr_class;
+  if (rho.size() != np || (has_probA && probA.size() != np) ||
+      (has_probB && probB.size() != np) ||
+      (has_label && label.size() != nc) || (has_nSV && nSV.size() != nc)) {
+    throw std::runtime_error("entries of the header of SVM model do not match its number of classes");
+  }
+
+  if (has_nSV) {
+    long total = 0;
+    for (size_t k=0; k<nc; ++k) {
+      if (nSV[k] < 0) total = -1;
+      if (total < 0) break;
+      total += nSV[k];
+    }
+    if (total != l) {
+      throw std::runtime_error("the numbers of support vectors per class in the header of SVM model do not add up to its total number of support vectors");
+    }
+  }
+
+  //first pass: counts the number of nodes we need, so all support vectors
+  //are allocated with the model
+  const char* sv_start = r.position();
+  size_t elements = 0;
+  for (int i=0; i<l; ++i) {
+    if (r.end()) r.error("support vector", r.position());
+    const char* p = r.position();
+    while (p < r.limit() && *p != '\n')
+      if (*p++ == ':') ++elements;
+    ++elements; ///< terminator
+    r.next_line();
+  }
+  r.seek(sv_start);
+
+  boost::shared_ptr<svm_model> retval = new_model(nr_class, l, elements,
+      has_probA, has_probB, has_marks, has_label, has_nSV);
+  svm_model* model = retval.get();
+  model->param = param;
+  std::copy(rho.begin(), rho.end(), model->rho);
+  std::copy(probA.begin(), probA.end(), model->probA);
+  std::copy(probB.begin(), probB.end(), model->probB);
+#if LIBSVM_VERSION >= 330
+  std::copy(marks.begin(), marks.end(), model->prob_density_marks);
+#endif
+  std::copy(label.begin(), label.end(), model->label);
+  std::copy(nSV.begin(), nSV.end(), model->nSV);
+
+  svm_node* x = l ? model->SV[0] : 0;
+  int m = nr_class - 1;
+  for (int i=0; i<l; ++i) {
+    model->SV[i] = x;
+    for (int k=0; k<m; ++k) model->sv_coef[k][i] = r.real();
+    while (!r.eol()) {
+      x->index = r.integer();
+      r.expect(':');
+      x->value = r.real();
+      ++x;
+    }
+    (x++)->index = -1;
+    r.next_line();
+  }
+
+  return retval;
+}
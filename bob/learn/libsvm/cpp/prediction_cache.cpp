@@ -0,0 +1,195 @@
+/**
+ * @date Thu 15 Oct 2026 21:03:18 CEST
+ *
+ * @brief Implementation of the cache of predictions
+ *
+ * Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+ */
+
+#include <bob.learn.libsvm/prediction_cache.h>
+
+#include <algorithm>
+#include <cstring>
+
+/**
+ * Memory used by an entry with a key of ``n`` values and ``values`` stored
+ * results, counting the nodes of the list and of the index
+ */
+static size_t entry_bytes(size_t entry, size_t node, size_t n,
+    size_t values) {
+  return entry + node + 4 * sizeof(void*) + (n + values) * sizeof(double);
+}
+
+bob::learn::libsvm::PredictionCache::PredictionCache(double size_in_mb,
+    size_t scores, size_t classes):
+  m_capacity(std::max(0., size_in_mb) * 1024 * 1024 / SHARDS),
+  m_scores(scores),
+  m_classes(classes),
+  m_hits(0),
+  m_misses(0),
+  m_evictions(0)
+{
+}
+
+uint64_t bob::learn::libsvm::PredictionCache::hash(const double* key,
+    size_t n) {
+  uint64_t h = 0x9e3779b97f4a7c15ULL ^ n;
+  for (size_t i=0; i<n; ++i) {
+    double v = key[i] + 0.; ///< -0 and 0 compare equal: hash them alike
+    uint64_t w;
+    std::memcpy(&w, &v, sizeof(w));
+    h = (h ^ w) * 0xff51afd7ed558ccdULL;
+    h ^= h >> 32;
+  }
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+bob::learn::libsvm::PredictionCache::list_type::iterator
+bob::learn::libsvm::PredictionCache::lookup(Shard& shard, const double* key,
+    size_t n, uint64_t hash) {
+  auto range = shard.index.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    const std::vector<double>& k = it->second->key;
+    if (k.size() == n && std::equal(k.begin(), k.end(), key))
+      return it->second;
+  }
+  return shard.entries.end();
+}
+
+void bob::learn::libsvm::PredictionCache::evict(Shard& shard, size_t bytes) {
+  while (!shard.entries.empty() && shard.used + bytes > m_capacity) {
+    list_type::iterator oldest = --shard.entries.end();
+    auto range = shard.index.equal_range(oldest->hash);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (it->second == oldest) {
+        shard.index.erase(it);
+        break;
+      }
+    }
+    shard.used -= oldest->bytes;
+    shard.entries.erase(oldest);
+    ++m_evictions;
+  }
+}
+
+bool bob::learn::libsvm::PredictionCache::find(const double* key, size_t n,
+    uint64_t hash, double& label, double* scores, double* probabilities,
+    bool copy_probabilities) {
+
+  Shard& s = shard(hash);
+  boost::mutex::scoped_lock guard(s.lock);
+
+  list_type::iterator it = lookup(s, key, n, hash);
+  bool hit = it != s.entries.end() &&
+    (probabilities ? it->has_probabilities :
+     (scores ? it->has_scores : it->has_label));
+  if (!hit) {
+    ++m_misses;
+    return false;
+  }
+
+  s.entries.splice(s.entries.begin(), s.entries, it); ///< most recent
+  if (probabilities) {
+    label = it->probability_label;
+    if (copy_probabilities)
+      std::copy(it->values.begin() + m_scores, it->values.end(),
+          probabilities);
+  }
+  else {
+    label = it->label;
+    if (scores)
+      std::copy(it->values.begin(), it->values.begin() + m_scores, scores);
+  }
+  ++m_hits;
+  return true;
+}
+
+void bob::learn::libsvm::PredictionCache::insert(const double* key,
+    size_t n, uint64_t hash, double label, const double* scores,
+    const double* probabilities, bool copy_probabilities) {
+
+  size_t values = (scores || (probabilities && copy_probabilities)) ?
+    m_scores + m_classes : 0;
+  size_t bytes = entry_bytes(sizeof(Entry),
+      sizeof(index_type::value_type), n, values);
+  if (bytes > m_capacity) return; ///< would never fit
+
+  Shard& s = shard(hash);
+  boost::mutex::scoped_lock guard(s.lock);
+
+  list_type::iterator it = lookup(s, key, n, hash);
+  if (it == s.entries.end()) {
+    s.entries.push_front(Entry());
+    it = s.entries.begin();
+    it->hash = hash;
+    it->key.assign(key, key + n);
+    it->has_label = it->has_scores = it->has_probabilities = false;
+    it->label = it->probability_label = 0.;
+    it->bytes = 0;
+    s.index.insert(std::make_pair(hash, it));
+  }
+  else {
+    s.entries.splice(s.entries.begin(), s.entries, it);
+  }
+
+  if (values && it->values.empty()) it->values.resize(values);
+  if (probabilities) {
+    it->has_probabilities = true;
+    it->probability_label = label;
+    if (copy_probabilities)
+      std::copy(probabilities, probabilities + m_classes,
+          it->values.begin() + m_scores);
+  }
+  else {
+    it->has_label = true;
+    it->label = label;
+    if (scores) {
+      it->has_scores = true;
+      std::copy(scores, scores + m_scores, it->values.begin());
+    }
+  }
+
+  bytes = entry_bytes(sizeof(Entry), sizeof(index_type::value_type), n,
+      it->values.size());
+  s.used += bytes - it->bytes;
+  it->bytes = bytes;
+  evict(s, 0); ///< the entry is the most recent, and fits on its own
+}
+
+double bob::learn::libsvm::PredictionCache::getSizeInMb() const {
+  return (double)m_capacity * SHARDS / (1024. * 1024.);
+}
+
+bob::learn::libsvm::CacheStatistics
+bob::learn::libsvm::PredictionCache::statistics() const {
+  CacheStatistics retval;
+  retval.hits = m_hits;
+  retval.misses = m_misses;
+  retval.evictions = m_evictions;
+  retval.entries = 0;
+  size_t used = 0;
+  for (size_t i=0; i<SHARDS; ++i) {
+    const Shard& s = m_shards[i];
+    boost::mutex::scoped_lock guard(s.lock);
+    retval.entries += s.entries.size();
+    used += s.used;
+  }
+  retval.used = used / (1024. * 1024.);
+  retval.size = getSizeInMb();
+  return retval;
+}
+
+void bob::learn::libsvm::PredictionCache::clear() {
+  for (size_t i=0; i<SHARDS; ++i) {
+    boost::mutex::scoped_lock guard(m_shards[i].lock);
+    m_shards[i].entries.clear();
+    m_shards[i].index.clear();
+    m_shards[i].used = 0;
+  }
+  m_hits = 0;
+  m_misses = 0;
+  m_evictions = 0;
+}
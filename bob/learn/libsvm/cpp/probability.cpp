@@ -0,0 +1,175 @@
+/**
+ * @date Thu 15 Oct 2026 23:17:45 CEST
+ *
+ * @brief Implementation of probability estimates from decision values
+ *
+ * Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+ */
+
+#include <bob.learn.libsvm/probability.h>
+
+#include <cmath>
+#include <algorithm>
+
+/**
+ * Pairwise probabilities are clipped to [MIN_PROB, 1-MIN_PROB], like libsvm
+ */
+static const double MIN_PROB = 1e-7;
+
+/**
+ * Same as libsvm's multiclass_probability(): method 2 from the multiclass
+ * probability paper by Wu, Lin and Weng. ``r`` and ``Q`` are k x k
+ * matrices, ``Qp`` has k positions.
+ */
+static void multiclass_probability(int k, const double* r, double* p,
+    double* Q, double* Qp) {
+  int max_iter = std::max(100, k);
+  double eps = 0.005/k;
+
+  for (int t=0; t<k; ++t) {
+    p[t] = 1.0/k;  // Valid if k = 1
+    Q[t*k+t] = 0;
+    for (int j=0; j<t; ++j) {
+      Q[t*k+t] += r[j*k+t]*r[j*k+t];
+      Q[t*k+j] = Q[j*k+t];
+    }
+    for (int j=t+1; j<k; ++j) {
+      Q[t*k+t] += r[j*k+t]*r[j*k+t];
+      Q[t*k+j] = -r[j*k+t]*r[t*k+j];
+    }
+  }
+
+  for (int iter=0; iter<max_iter; ++iter) {
+    // stopping condition, recalculate QP,pQP for numerical accuracy
+    double pQp = 0;
+    for (int t=0; t<k; ++t) {
+      Qp[t] = 0;
+      for (int j=0; j<k; ++j) Qp[t] += Q[t*k+j]*p[j];
+      pQp += p[t]*Qp[t];
+    }
+    double max_error = 0;
+    for (int t=0; t<k; ++t) {
+      double error = std::fabs(Qp[t]-pQp);
+      if (error > max_error) max_error = error;
+    }
+    if (max_error < eps) break;
+
+    for (int t=0; t<k; ++t) {
+      double diff = (-Qp[t]+pQp)/Q[t*k+t];
+      p[t] += diff;
+      pQp = (pQp+diff*(diff*Q[t*k+t]+2*Qp[t]))/(1+diff)/(1+diff);
+      for (int j=0; j<k; ++j) {
+        Qp[j] = (Qp[j]+diff*Q[t*k+j])/(1+diff);
+        p[j] /= (1+diff);
+      }
+    }
+  }
+}
+
+/**
+ * Closed form coupling of Price, Knerr, Personnaz and Dreyfus, normalized
+ * so probabilities sum up to one. ``r`` is a k x k matrix.
+ */
+static void approximate_probability(int k, const double* r, double* p) {
+  double sum = 0.;
+  for (int i=0; i<k; ++i) {
+    double inv = 0.; ///< at least k-1, as pairwise probabilities are <= 1
+    for (int j=0; j<k; ++j) if (j != i) inv += 1./r[i*k+j];
+    p[i] = 1./(inv - (k-2));
+    sum += p[i];
+  }
+  for (int i=0; i<k; ++i) p[i] /= sum;
+}
+
+bob::learn::libsvm::ProbabilityEstimator::ProbabilityEstimator
+(const svm_model* model):
+  m_svm_type(model->param.svm_type),
+  m_nr_class(model->nr_class)
+{
+  size_t pairs = this->pairs();
+  if (model->probA) m_probA.assign(model->probA, model->probA + pairs);
+  if (model->probB) m_probB.assign(model->probB, model->probB + pairs);
+  if (model->label) m_label.assign(model->label, model->label + m_nr_class);
+}
+
+bool bob::learn::libsvm::ProbabilityEstimator::supported() const {
+  return (m_svm_type == C_SVC || m_svm_type == NU_SVC) && !m_probA.empty()
+    && !m_probB.empty();
+}
+
+/**
+ * The workspace holds the pairwise probabilities of all inputs (n x pairs)
+ * followed by the scratch space for coupling one of them (2 x nr_class x
+ * nr_class + nr_class)
+ */
+size_t bob::learn::libsvm::ProbabilityEstimator::workspaceSize(size_t n)
+  const {
+  return n*pairs() + 2*m_nr_class*m_nr_class + m_nr_class;
+}
+
+void bob::learn::libsvm::ProbabilityEstimator::pairwise
+(const double* dec_values, size_t n, double* r) const {
+
+  size_t pairs = this->pairs();
+  const double* A = m_probA.data();
+  const double* B = m_probB.data();
+
+  for (size_t i=0; i<n; ++i) {
+    const double* dec = dec_values + i*pairs;
+    double* out = r + i*pairs;
+    for (size_t k=0; k<pairs; ++k) {
+      //same as libsvm's sigmoid_predict(), with a single exponential
+      double fApB = dec[k]*A[k] + B[k];
+      double e = std::exp(-std::fabs(fApB));
+      double p = (fApB >= 0) ? e/(1.0+e) : 1.0/(1.0+e);
+      out[k] = std::min(std::max(p, MIN_PROB), 1-MIN_PROB);
+    }
+  }
+}
+
+double bob::learn::libsvm::ProbabilityEstimator::couple(const double* r,
+    double* prob_estimates, double* work, coupling_t coupling) const {
+
+  int nr_class = m_nr_class;
+  double* pairwise_prob = work;
+  double* Q = pairwise_prob + nr_class*nr_class;
+  double* Qp = Q + nr_class*nr_class;
+
+  int k = 0;
+  for (int i=0; i<nr_class; ++i) {
+    for (int j=i+1; j<nr_class; ++j) {
+      pairwise_prob[i*nr_class+j] = r[k];
+      pairwise_prob[j*nr_class+i] = 1-r[k];
+      ++k;
+    }
+  }
+  if (coupling == APPROXIMATE_COUPLING)
+    approximate_probability(nr_class, pairwise_prob, prob_estimates);
+  else
+    multiclass_probability(nr_class, pairwise_prob, prob_estimates, Q, Qp);
+
+  int prob_max_idx = 0;
+  for (int i=1; i<nr_class; ++i)
+    if (prob_estimates[i] > prob_estimates[prob_max_idx]) prob_max_idx = i;
+  return m_label[prob_max_idx];
+}
+
+double bob::learn::libsvm::ProbabilityEstimator::estimate
+(const double* dec_values, double* prob_estimates, double* work,
+ coupling_t coupling) const {
+  double* r = work;
+  pairwise(dec_values, 1, r);
+  return couple(r, prob_estimates, r + pairs(), coupling);
+}
+
+void bob::learn::libsvm::ProbabilityEstimator::estimate
+(const double* dec_values, size_t n, double* labels, double* prob_estimates,
+ double* work, coupling_t coupling) const {
+  double* r = work;
+  double* scratch = r + n*pairs();
+  pairwise(dec_values, n, r);
+  for (size_t i=0; i<n; ++i) {
+    labels[i] = couple(r + i*pairs(), prob_estimates + i*m_nr_class,
+        scratch, coupling);
+  }
+}
@@ -0,0 +1,132 @@
+/**
+ * @date Thu 15 Oct 2026 15:02:19 CEST
+ *
+ * @brief Implementation of progress reports and cancellation of trainings
+ *
+ * Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+ */
+
+#include <bob.learn.libsvm/progress.h>
+#include <bob.learn.libsvm/stats.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <boost/format.hpp>
+
+/**
+ * libsvm solvers print "." every so many iterations (less for problems with
+ * less samples)
+ */
+static const uint64_t ITERATIONS_PER_DOT = 1000;
+
+/**
+ * Monitor libsvm messages of each thread are routed to
+ */
+static thread_local bob::learn::libsvm::TrainingMonitor* routed_monitor = 0;
+
+/**
+ * Iterations of the problem being solved on each thread, estimated from
+ * the dots printed so far, until libsvm reports the exact number
+ */
+static thread_local uint64_t estimated_iterations = 0;
+
+bob::learn::libsvm::TrainingMonitor::TrainingMonitor
+(const ProgressCallback& callback, double time_limit, bool interrupt):
+  m_callback(callback),
+  m_start(nanoseconds()),
+  m_deadline(time_limit > 0. ? m_start + (uint64_t)(time_limit * 1e9) : 0),
+  m_time_limit(time_limit),
+  m_interrupt(interrupt),
+  m_cancelled(false)
+{
+  m_progress.problems = 0;
+  m_progress.iterations = 0;
+  m_progress.objective = std::numeric_limits<double>::quiet_NaN();
+  m_progress.elapsed = 0.;
+}
+
+void bob::learn::libsvm::TrainingMonitor::cancel(const std::string& reason) {
+  boost::mutex::scoped_lock guard(m_lock);
+  if (m_cancelled) return;
+  m_reason = reason;
+  m_cancelled = true;
+}
+
+bool bob::learn::libsvm::TrainingMonitor::cancelled() {
+  if (!m_cancelled && m_deadline && nanoseconds() > m_deadline) {
+    boost::format m("training was cancelled after exceeding its time limit of %g seconds");
+    m % m_time_limit;
+    cancel(m.str());
+  }
+  return m_cancelled;
+}
+
+void bob::learn::libsvm::TrainingMonitor::check() {
+  if (cancelled()) {
+    boost::mutex::scoped_lock guard(m_lock);
+    throw TrainingCancelled(m_reason);
+  }
+}
+
+void bob::learn::libsvm::TrainingMonitor::report() {
+  if (!m_callback || m_cancelled) return;
+  m_progress.elapsed = (nanoseconds() - m_start) * 1e-9;
+  if (!m_callback(m_progress)) {
+    m_reason = "training was cancelled by its progress callback";
+    m_cancelled = true;
+  }
+}
+
+void bob::learn::libsvm::TrainingMonitor::parse(const char* message) {
+
+  {
+    boost::mutex::scoped_lock guard(m_lock);
+
+    if (!std::strcmp(message, ".")) {
+      estimated_iterations += ITERATIONS_PER_DOT;
+      m_progress.iterations += ITERATIONS_PER_DOT;
+      report();
+    }
+    else if (const char* iter = std::strstr(message, "#iter = ")) {
+      //replaces the estimate by the exact number
+      uint64_t n = std::strtoull(iter + 8, 0, 10);
+      m_progress.iterations += n;
+      m_progress.iterations -= std::min(estimated_iterations,
+          m_progress.iterations);
+      estimated_iterations = 0;
+    }
+    else if (const char* obj = std::strstr(message, "obj = ")) {
+      ++m_progress.problems;
+      m_progress.objective = std::strtod(obj + 6, 0);
+      report();
+    }
+  }
+
+  //otherwise, the solver runs to its end: check() is called between
+  //problems
+  if (m_interrupt) check();
+}
+
+void bob::learn::libsvm::TrainingMonitor::solved(uint64_t iterations,
+    double objective) {
+  boost::mutex::scoped_lock guard(m_lock);
+  ++m_progress.problems;
+  m_progress.iterations += iterations;
+  m_progress.objective = objective;
+  report();
+}
+
+bob::learn::libsvm::TrainingMonitor*
+bob::learn::libsvm::TrainingMonitor::route(TrainingMonitor* monitor) {
+  TrainingMonitor* previous = routed_monitor;
+  routed_monitor = monitor;
+  estimated_iterations = 0;
+  return previous;
+}
+
+bob::learn::libsvm::TrainingMonitor*
+bob::learn::libsvm::TrainingMonitor::routed() {
+  return routed_monitor;
+}
@@ -0,0 +1,239 @@
+/**
+ * @date Thu 15 Oct 2026 17:41:52 CEST
+ *
+ * @brief Implementation of the prediction server
+ *
+ * Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+ */
+
+#include <bob.learn.libsvm/server.h>
+#include <bob.learn.libsvm/stats.h>
+
+#include <algorithm>
+#include <boost/format.hpp>
+#include <boost/make_shared.hpp>
+
+bob::learn::libsvm::PredictionServer::PredictionServer
+(boost::shared_ptr<const Machine> machine, output_t output, size_t workers,
+ size_t batch_size, double max_latency):
+  m_machine(machine),
+  m_output(output),
+  m_workers(workers ? workers : boost::thread::hardware_concurrency()),
+  m_batch_size(batch_size),
+  m_max_latency(max_latency),
+  m_max_wait((uint64_t)(max_latency * 1e9)),
+  m_values(0),
+  m_collecting(false),
+  m_closed(false)
+{
+
+  if (!m_machine) {
+    throw std::runtime_error("prediction servers require a machine");
+  }
+
+  if (!batch_size) {
+    throw std::runtime_error("prediction servers require a batch size of at least 1");
+  }
+
+  if (max_latency < 0.) {
+    boost::format m("the maximum latency of prediction servers should be non-negative, not %g");
+    m % max_latency;
+    throw std::runtime_error(m.str());
+  }
+
+  size_t classes = m_machine->numberOfClasses();
+  switch (output) {
+    case LABELS:
+      break;
+    case SCORES:
+      {
+        //as many decision values as with predictClassAndScores()
+        size_t n = (classes == 2) ? 1 : classes;
+        m_values = n < 2 ? 1 : (n*(n-1))/2;
+      }
+      break;
+    case PROBABILITIES:
+      if (!m_machine->supportsProbability()) {
+        throw std::runtime_error("this SVM does not support probabilities");
+      }
+      m_values = classes;
+      break;
+    default:
+      throw std::runtime_error("unsupported output for prediction servers");
+  }
+
+  if (!m_workers) m_workers = 1;
+  for (size_t k=0; k<m_workers; ++k) {
+    m_threads.create_thread([this]() { work(); });
+  }
+
+}
+
+bob::learn::libsvm::PredictionServer::~PredictionServer() {
+  close();
+}
+
+void bob::learn::libsvm::PredictionServer::submit(const double* input,
+    const Completion& done) {
+
+  Request request;
+  request.input.assign(input, input + inputSize());
+  request.done = done;
+
+  {
+    boost::mutex::scoped_lock guard(m_lock);
+    if (m_closed) {
+      throw std::runtime_error("cannot submit requests to a closed prediction server");
+    }
+    request.arrival = nanoseconds();
+    m_queue.push_back(std::move(request));
+  }
+
+  m_arrival.notify_one();
+
+}
+
+std::future<bob::learn::libsvm::PredictionResult>
+bob::learn::libsvm::PredictionServer::submit(const double* input) {
+  auto promise = boost::make_shared<std::promise<PredictionResult> >();
+  std::future<PredictionResult> retval = promise->get_future();
+  submit(input, [promise](const PredictionResult* result,
+        std::exception_ptr error) {
+      if (result) promise->set_value(*result);
+      else promise->set_exception(error);
+  });
+  return retval;
+}
+
+void bob::learn::libsvm::PredictionServer::close() {
+
+  boost::mutex::scoped_lock join(m_join);
+
+  {
+    boost::mutex::scoped_lock guard(m_lock);
+    m_closed = true;
+  }
+
+  m_arrival.notify_all();
+  m_collector.notify_all();
+  m_threads.join_all();
+
+}
+
+bool bob::learn::libsvm::PredictionServer::closed() const {
+  boost::mutex::scoped_lock guard(m_lock);
+  return m_closed;
+}
+
+size_t bob::learn::libsvm::PredictionServer::pending() const {
+  boost::mutex::scoped_lock guard(m_lock);
+  return m_queue.size();
+}
+
+bool bob::learn::libsvm::PredictionServer::collect
+(std::vector<Request>& batch) {
+
+  boost::mutex::scoped_lock guard(m_lock);
+
+  //a single worker gathers requests, so batches fill up before others start
+  while (m_collecting) m_collector.wait(guard);
+  m_collecting = true;
+
+  while (m_queue.empty() && !m_closed) m_arrival.wait(guard);
+
+  //waits for a full batch until the oldest request is due
+  while (m_queue.size() < m_batch_size && !m_closed) {
+    uint64_t due = m_queue.front().arrival + m_max_wait;
+    uint64_t now = nanoseconds();
+    if (now >= due) break;
+    m_arrival.wait_for(guard, boost::chrono::nanoseconds(due - now));
+  }
+
+  size_t n = std::min(m_queue.size(), m_batch_size);
+  for (size_t k=0; k<n; ++k) {
+    batch.push_back(std::move(m_queue.front()));
+    m_queue.pop_front();
+  }
+
+  m_collecting = false;
+  m_collector.notify_one();
+
+  return n > 0;
+
+}
+
+void bob::learn::libsvm::PredictionServer::predict
+(std::vector<Request>& batch, blitz::Array<double,2>& input,
+ blitz::Array<int64_t,1>& labels, blitz::Array<double,2>& values) const {
+
+  int rows = batch.size();
+  int columns = inputSize();
+  blitz::Range all = blitz::Range::all();
+
+  std::exception_ptr error;
+
+  try {
+
+    //workspaces grow to the largest batch seen
+    if (input.extent(0) < rows) {
+      input.resize(rows, columns);
+      labels.resize(rows);
+      if (m_values) values.resize(rows, m_values);
+    }
+
+    for (int k=0; k<rows; ++k) {
+      std::copy(batch[k].input.begin(), batch[k].input.end(),
+          &input(k, 0));
+    }
+
+    blitz::Array<double,2> in(input(blitz::Range(0, rows-1), all));
+    blitz::Array<int64_t,1> out(labels(blitz::Range(0, rows-1)));
+
+    if (m_output == LABELS) {
+      m_machine->predictClass_(in, out, 1);
+    }
+    else {
+      blitz::Array<double,2> val(values(blitz::Range(0, rows-1), all));
+      if (m_output == SCORES) m_machine->predictClassAndScores_(in, out, val, 1);
+      else m_machine->predictClassAndProbabilities_(in, out, val, 1);
+    }
+
+  }
+  catch (...) {
+    error = std::current_exception();
+  }
+
+  PredictionResult result;
+  for (int k=0; k<rows; ++k) {
+    try {
+      if (error) {
+        batch[k].done(0, error);
+        continue;
+      }
+      result.label = labels(k);
+      if (m_values) {
+        result.values.assign(&values(k, 0), &values(k, 0) + m_values);
+      }
+      batch[k].done(&result, std::exception_ptr());
+    }
+    catch (...) {
+      //completions should not throw: the worker must go on serving others
+    }
+  }
+
+}
+
+void bob::learn::libsvm::PredictionServer::work() {
+
+  std::vector<Request> batch;
+  batch.reserve(m_batch_size);
+  blitz::Array<double,2> input;
+  blitz::Array<int64_t,1> labels;
+  blitz::Array<double,2> values;
+
+  while (collect(batch)) {
+    predict(batch, input, labels, values);
+    batch.clear();
+  }
+
+}
@@ -0,0 +1,70 @@
+/**
+ * @date Wed 14 Oct 2026 15:21:07 CEST
+ *
+ * @brief Implementation of CSR matrices
+ *
+ * Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+ */
+
+#include <bob.learn.libsvm/sparse.h>
+
+#include <boost/format.hpp>
+#include <bob.core/array_copy.h>
+#include <bob.core/check.h>
+
+/**
+ * References ``src`` in ``dst`` if it is C-style contiguous, copies it
+ * otherwise
+ */
+template <typename T>
+static void attach(blitz::Array<T,1>& dst, const blitz::Array<T,1>& src) {
+  if (bob::core::array::isCContiguous(src)) dst.reference(src);
+  else dst.reference(bob::core::array::ccopy(src));
+}
+
+bob::learn::libsvm::SparseMatrix::SparseMatrix
+(const blitz::Array<int64_t,1>& indptr,
+ const blitz::Array<int64_t,1>& indices,
+ const blitz::Array<double,1>& values, size_t columns):
+  m_columns(columns)
+{
+  if (indptr.extent(0) < 1) {
+    throw std::runtime_error("the row pointers of a sparse matrix should have, at least, one entry");
+  }
+
+  if (indices.extent(0) != values.extent(0)) {
+    boost::format s("a sparse matrix should have as many indices as values, but you provided %d indices and %d values");
+    s % indices.extent(0) % values.extent(0);
+    throw std::runtime_error(s.str());
+  }
+
+  attach(m_indptr, indptr);
+  attach(m_indices, indices);
+  attach(m_values, values);
+
+  const int64_t* ptr = m_indptr.data();
+  const int64_t* idx = m_indices.data();
+  size_t n = rows();
+
+  if (ptr[0] != 0 || ptr[n] != (int64_t)nonZeros()) {
+    boost::format s("the row pointers of a sparse matrix should go from 0 to the number of stored entries (%d), but they go from %d to %d");
+    s % nonZeros() % ptr[0] % ptr[n];
+    throw std::runtime_error(s.str());
+  }
+
+  for (size_t i=0; i<n; ++i) {
+    if (ptr[i+1] < ptr[i]) {
+      boost::format s("the row pointers of a sparse matrix should not decrease, but they do at row %d");
+      s % i;
+      throw std::runtime_error(s.str());
+    }
+    for (int64_t k=ptr[i]; k<ptr[i+1]; ++k) {
+      if (idx[k] < 0 || idx[k] >= (int64_t)m_columns ||
+          (k > ptr[i] && idx[k] <= idx[k-1])) {
+        boost::format s("the column indices of row %d of a sparse matrix with %d columns should be strictly increasing and in range, but index %d is not");
+        s % i % m_columns % idx[k];
+        throw std::runtime_error(s.str());
+      }
+    }
+  }
+}
@@ -0,0 +1,149 @@
+/**
+ * @date Thu 15 Oct 2026 11:24:06 CEST
+ *
+ * @brief Implementation of counters on predictions and trainings
+ *
+ * Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+ */
+
+#include <bob.learn.libsvm/stats.h>
+
+#include <cstdlib>
+#include <cstring>
+
+const size_t bob::learn::libsvm::PredictionCounters::LATENCY_BUCKETS;
+
+bob::learn::libsvm::PredictionCounters::PredictionCounters() {
+  reset();
+}
+
+void bob::learn::libsvm::PredictionCounters::add(uint64_t predictions,
+    uint64_t kernel_evaluations, const PhaseTimes& times) {
+  m_predictions.fetch_add(predictions, std::memory_order_relaxed);
+  m_kernel_evaluations.fetch_add(kernel_evaluations,
+      std::memory_order_relaxed);
+  m_conversion.fetch_add(times.conversion, std::memory_order_relaxed);
+  m_kernel.fetch_add(times.kernel, std::memory_order_relaxed);
+  m_voting.fetch_add(times.voting, std::memory_order_relaxed);
+}
+
+void bob::learn::libsvm::PredictionCounters::addCall(uint64_t elapsed) {
+  size_t bucket = 0;
+  for (uint64_t us = elapsed / 1000; us && bucket < LATENCY_BUCKETS-1;
+      us >>= 1) ++bucket;
+  m_calls.fetch_add(1, std::memory_order_relaxed);
+  m_latency[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+bob::learn::libsvm::PredictionStatistics
+bob::learn::libsvm::PredictionCounters::read() const {
+  PredictionStatistics retval;
+  retval.calls = m_calls.load();
+  retval.predictions = m_predictions.load();
+  retval.kernel_evaluations = m_kernel_evaluations.load();
+  retval.conversion = m_conversion.load() * 1e-9;
+  retval.kernel = m_kernel.load() * 1e-9;
+  retval.voting = m_voting.load() * 1e-9;
+  retval.latency.resize(LATENCY_BUCKETS);
+  for (size_t k=0; k<LATENCY_BUCKETS; ++k) retval.latency[k] = m_latency[k];
+  return retval;
+}
+
+void bob::learn::libsvm::PredictionCounters::reset() {
+  m_calls = 0;
+  m_predictions = 0;
+  m_kernel_evaluations = 0;
+  m_conversion = 0;
+  m_kernel = 0;
+  m_voting = 0;
+  for (size_t k=0; k<LATENCY_BUCKETS; ++k) m_latency[k] = 0;
+}
+
+/**
+ * Counters libsvm messages of each thread are routed to
+ */
+static thread_local bob::learn::libsvm::TrainingCounters* routed_counters = 0;
+
+bob::learn::libsvm::TrainingCounters::TrainingCounters() {
+  reset();
+}
+
+void bob::learn::libsvm::TrainingCounters::addTraining() {
+  m_trainings.fetch_add(1, std::memory_order_relaxed);
+}
+
+void bob::learn::libsvm::TrainingCounters::addBuild(uint64_t elapsed) {
+  m_build.fetch_add(elapsed, std::memory_order_relaxed);
+}
+
+void bob::learn::libsvm::TrainingCounters::addSolve(uint64_t elapsed) {
+  m_problems.fetch_add(1, std::memory_order_relaxed);
+  m_solve.fetch_add(elapsed, std::memory_order_relaxed);
+}
+
+void bob::learn::libsvm::TrainingCounters::addIterations(uint64_t n) {
+  m_iterations.fetch_add(n, std::memory_order_relaxed);
+}
+
+void bob::learn::libsvm::TrainingCounters::addKernelLookup(bool hit) {
+  if (hit) m_kernel_hits.fetch_add(1, std::memory_order_relaxed);
+  else m_kernel_misses.fetch_add(1, std::memory_order_relaxed);
+}
+
+void bob::learn::libsvm::TrainingCounters::parse(const char* message) {
+  //the solver prints "." every min(l, 1000) iterations, whether it shrinks
+  //the problem or not, "*" when it reconstructs the gradient and the
+  //number of iterations once it is done
+  if (!std::strcmp(message, ".")) {
+    m_iteration_blocks.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  if (!std::strcmp(message, "*")) {
+    m_reconstructions.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  const char* iter = std::strstr(message, "#iter = ");
+  if (iter) {
+    uint64_t n = std::strtoull(iter + 8, 0, 10);
+    m_iterations.fetch_add(n, std::memory_order_relaxed);
+  }
+}
+
+bob::learn::libsvm::TrainingStatistics
+bob::learn::libsvm::TrainingCounters::read() const {
+  TrainingStatistics retval;
+  retval.trainings = m_trainings.load();
+  retval.problems = m_problems.load();
+  retval.iterations = m_iterations.load();
+  retval.iteration_blocks = m_iteration_blocks.load();
+  retval.reconstructions = m_reconstructions.load();
+  retval.kernel_hits = m_kernel_hits.load();
+  retval.kernel_misses = m_kernel_misses.load();
+  retval.build = m_build.load() * 1e-9;
+  retval.solve = m_solve.load() * 1e-9;
+  return retval;
+}
+
+void bob::learn::libsvm::TrainingCounters::reset() {
+  m_trainings = 0;
+  m_problems = 0;
+  m_iterations = 0;
+  m_iteration_blocks = 0;
+  m_reconstructions = 0;
+  m_kernel_hits = 0;
+  m_kernel_misses = 0;
+  m_build = 0;
+  m_solve = 0;
+}
+
+bob::learn::libsvm::TrainingCounters*
+bob::learn::libsvm::TrainingCounters::route(TrainingCounters* counters) {
+  TrainingCounters* previous = routed_counters;
+  routed_counters = counters;
+  return previous;
+}
+
+bob::learn::libsvm::TrainingCounters*
+bob::learn::libsvm::TrainingCounters::routed() {
+  return routed_counters;
+}
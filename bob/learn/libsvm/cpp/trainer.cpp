@@ -8,8 +8,16 @@
  */
 
 #include <bob.learn.libsvm/trainer.h>
+#include <bob.learn.libsvm/parallel.h>
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <map>
 #include <boost/format.hpp>
 #include <boost/make_shared.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
 #include <bob.core/logging.h>
 
 #ifdef BOB_DEBUG
@@ -24,8 +32,86 @@ static std::string strip(const char* s) {
 
 static void debug_libsvm(const char* s) {
   TDEBUG1("[libsvm-" << LIBSVM_VERSION << "] " << strip(s));
+  bob::learn::libsvm::TrainingCounters* counters =
+    bob::learn::libsvm::TrainingCounters::routed();
+  if (counters) counters->parse(s);
+  //may raise, to cancel the training, if the solver may be interrupted
+  bob::learn::libsvm::TrainingMonitor* monitor =
+    bob::learn::libsvm::TrainingMonitor::routed();
+  if (monitor) monitor->parse(s);
 }
 
+/**
+ * Where the statistics and the progress of a training go. Captures those of
+ * the calling thread by default: workers do not inherit them, so capture
+ * them before handing work out.
+ */
+struct observers {
+
+  bob::learn::libsvm::TrainingCounters* counters;
+  bob::learn::libsvm::TrainingMonitor* monitor;
+
+  observers():
+    counters(bob::learn::libsvm::TrainingCounters::routed()),
+    monitor(bob::learn::libsvm::TrainingMonitor::routed()) {}
+
+  observers(bob::learn::libsvm::TrainingCounters* c,
+      bob::learn::libsvm::TrainingMonitor* m): counters(c), monitor(m) {}
+
+};
+
+/**
+ * Routes libsvm messages, and statistics, of the calling thread to the
+ * given observers, while in scope
+ */
+class routing {
+
+  public:
+
+    routing(const observers& o):
+      m_counters(bob::learn::libsvm::TrainingCounters::route(o.counters)),
+      m_monitor(bob::learn::libsvm::TrainingMonitor::route(o.monitor)) {}
+
+    ~routing() {
+      bob::learn::libsvm::TrainingCounters::route(m_counters);
+      bob::learn::libsvm::TrainingMonitor::route(m_monitor);
+    }
+
+  private:
+
+    bob::learn::libsvm::TrainingCounters* m_counters;
+    bob::learn::libsvm::TrainingMonitor* m_monitor;
+
+};
+
+/**
+ * Observes a call to a training method: counts it, in ``counters`` (if
+ * set), and follows its progress if there is a ``callback`` or a
+ * ``time_limit``, interrupting solvers on cancellation if ``interrupt`` is
+ * set
+ */
+class training_scope {
+
+  public:
+
+    training_scope(bob::learn::libsvm::TrainingCounters* counters,
+        const bob::learn::libsvm::ProgressCallback& callback,
+        double time_limit, bool interrupt):
+      m_monitor((callback || time_limit > 0.) ?
+          new bob::learn::libsvm::TrainingMonitor(callback, time_limit,
+            interrupt) : 0),
+      m_routing(observers(counters, m_monitor.get()))
+    {
+      if (counters) counters->addTraining();
+    }
+
+  private:
+
+    boost::scoped_ptr<bob::learn::libsvm::TrainingMonitor> m_monitor;
+    routing m_routing;
+
+};
+
 bob::learn::libsvm::Trainer::Trainer(
     bob::learn::libsvm::machine_t machine_type,
     bob::learn::libsvm::kernel_t kernel_type,
@@ -52,12 +138,39 @@ bob::learn::libsvm::Trainer::Trainer(
   m_param.nr_weight = 0;
   m_param.weight_label = 0;
   m_param.weight = 0;
+
+  m_time_limit = 0.;
+  m_interrupt = false;
 }
 
 bob::learn::libsvm::Trainer::~Trainer() { }
 
+void bob::learn::libsvm::Trainer::setTimeLimit(double v) {
+  if (v < 0.) {
+    boost::format m("the time limit of trainings must be non-negative, not %g");
+    m % v;
+    throw std::runtime_error(m.str());
+  }
+  m_time_limit = v;
+}
+
+void bob::learn::libsvm::Trainer::setCollectStatistics(bool v) {
+  if (!v) m_counters.reset();
+  else if (!m_counters) m_counters.reset(new TrainingCounters);
+}
+
+bob::learn::libsvm::TrainingStatistics
+bob::learn::libsvm::Trainer::getStatistics() const {
+  if (m_counters) return m_counters->read();
+  return TrainingCounters().read();
+}
+
+void bob::learn::libsvm::Trainer::resetStatistics() {
+  if (m_counters) m_counters->reset();
+}
+
 /**
- * Erases an SVM problem:
+ * An SVM problem, together with the memory it points to:
  *
  * struct svm_problem {
  *   int l; //number of entries
@@ -65,145 +178,279 @@ bob::learn::libsvm::Trainer::~Trainer() { }
  *   svm_node** x; //each set terminated with a -1 index entry
  * };
  *
- * At svm-train the nodes for each entry are allocated globally, what is
- * probably more efficient from the allocation perspective. It still requires
- * libsvm to scan the data twice to understand how many nodes need to be
- * allocated globally.
+ * At svm-train the nodes for all entries are allocated globally, which
+ * requires scanning the data twice to understand how many nodes are needed.
+ * libsvm does not require that, though: here, nodes are allocated for blocks
+ * of consecutive samples, which can be filled in a single pass and in
+ * parallel.
  */
-static void delete_problem(svm_problem* p) {
-  delete[] p->y; //all labels
-  delete[] p->x[0]; //all entries
-  delete[] p->x; //entry pointers
-  delete p;
+struct problem_storage {
+  svm_problem problem;
+  std::vector<double> y; ///< all labels
+  std::vector<svm_node*> x; ///< entry pointers
+  std::vector<std::vector<svm_node> > nodes; ///< entries, one per block
+};
+
+/**
+ * Number of samples in each block of nodes. Large enough to amortize
+ * thread dispatching, small enough to balance work and keep the temporary
+ * over-allocation of each block bounded.
+ */
+static const size_t PROBLEM_BLOCK = 4096;
+
+/**
+ * Sets up the base pointers of ``n`` consecutive samples in ``nodes``, once
+ * they will not move anymore
+ */
+static void set_pointers(std::vector<svm_node>& nodes, size_t n,
+    svm_node** x) {
+  svm_node* current = nodes.data();
+  for (size_t i=0; i<n; ++i) {
+    x[i] = current;
+    while (current->index != -1) ++current;
+    ++current;
+  }
 }
 
 /**
- * Allocates an svm_problem matrix
+ * Fills the nodes for samples [start, end) of a 2D array with ``features``
+ * columns, scaling them on the fly. Space is reserved for all features of
+ * every sample, so that dense data is written exactly once with no counting
+ * pass. If the data turns out to be sparse, the block is shrunk to fit.
+ * Returns the highest feature index set.
  */
-static svm_problem* new_problem(size_t entries) {
-  svm_problem* retval = new svm_problem;
-  retval->l = (int)entries;
-  retval->y = new double[entries];
-  typedef svm_node* svm_node_ptr;
-  retval->x = new svm_node_ptr[entries];
-  for (size_t k=0; k<entries; ++k) retval->x[k] = 0;
-  return retval;
+static int fill_block(const double* data, ptrdiff_t row, ptrdiff_t col,
+    int features, size_t start, size_t end, const double* sub,
+    const double* div, std::vector<svm_node>& nodes, svm_node** x) {
+
+  nodes.resize((end-start)*(features+1));
+  int max_index = 0;
+  size_t node = 0;
+
+  for (size_t i=start; i<end; ++i) {
+    const double* sample = data + i*row;
+    for (int p=0; p<features; ++p) {
+      double d = (sample[p*col] - sub[p])/div[p];
+      if (d) {
+        int index = p+1; //starts indexing at 1
+        nodes[node].index = index;
+        nodes[node].value = d;
+        if ( index > max_index ) max_index = index;
+        ++node;
+      }
+    }
+    //marks end of sequence
+    nodes[node].index = -1;
+    nodes[node].value = 0;
+    ++node;
+  }
+
+  //gives back memory if more than a quarter of the block is unused
+  if (node < nodes.size() - nodes.size()/4)
+    std::vector<svm_node>(nodes.begin(), nodes.begin()+node).swap(nodes);
+  else
+    nodes.resize(node);
+
+  set_pointers(nodes, end-start, x);
+  return max_index;
 }
 
 /**
- * Converts the input arrayset data into an svm_problem matrix, used by libsvm
- * training routines. Updates "gamma" at the svm_parameter's.
+ * Same as above, for rows [start, end) of a sparse matrix. The number of
+ * entries is known, so the block is allocated exactly, up to entries that
+ * become zero after scaling.
  */
-static boost::shared_ptr<svm_problem> data2problem
-(const std::vector<blitz::Array<double, 2> >& data,
- const blitz::Array<double,1>& sub, const blitz::Array<double,1>& div,
- svm_parameter& param) {
+static int fill_sparse_block(const bob::learn::libsvm::SparseMatrix& data,
+    size_t start, size_t end, const double* div,
+    std::vector<svm_node>& nodes, svm_node** x) {
 
-  //counts the number of samples required
-  size_t entries = 0;
-  for (size_t k=0; k<data.size(); ++k)
-    entries += data[k].extent(blitz::firstDim);
+  const int64_t* ptr = data.indptr();
+  const int64_t* idx = data.indices();
+  const double* val = data.values();
+
+  nodes.resize((ptr[end] - ptr[start]) + (end-start));
+  int max_index = 0;
+  size_t node = 0;
+
+  for (size_t i=start; i<end; ++i) {
+    for (int64_t k=ptr[i]; k<ptr[i+1]; ++k) {
+      double d = val[k]/div[idx[k]];
+      if (d) {
+        int index = idx[k]+1; //starts indexing at 1
+        nodes[node].index = index;
+        nodes[node].value = d;
+        if ( index > max_index ) max_index = index;
+        ++node;
+      }
+    }
+    //marks end of sequence
+    nodes[node].index = -1;
+    nodes[node].value = 0;
+    ++node;
+  }
+
+  nodes.resize(node);
+  set_pointers(nodes, end-start, x);
+  return max_index;
+}
 
-  //allocates the container that will represent the problem; at this stage, we
-  //allocate entries for each vector, but not the space in which feature will
-  //be put at. This will come next.
-  boost::shared_ptr<svm_problem> problem(new_problem(entries),
-      std::ptr_fun(delete_problem));
+/**
+ * Checks the number of classes and the kernel, returns the labels libsvm
+ * should use for each class
+ */
+static std::vector<double> choose_labels(size_t classes,
+    const svm_parameter& param) {
 
-  //choose labels.
   if(param.svm_type==ONE_CLASS)
   {
-    if ((data.size() != 1)) {
+    if ((classes != 1)) {
       boost::format m("Only support a singular entry for one class. Your are training ONE_CLASS svm classifier. You passed me a list of %d arraysets.");
-      m % data.size();
+      m % classes;
       throw std::runtime_error(m.str());
     }
   }
   else {
-    if ((data.size() <= 1) | (data.size() > 16)) {
-      boost::format m("Only supports SVMs for binary or multi-class classification problems (up to 16 classes). You passed me a list of %d arraysets.");
-      m % data.size();
+    if (classes <= 1) {
+      boost::format m("Only supports SVMs for binary or multi-class classification problems (at least 2 classes). You passed me a list of %d arraysets.");
+      m % classes;
       throw std::runtime_error(m.str());
     }
   }
 
+  //do not support pre-computed kernels...
+  if (param.kernel_type == PRECOMPUTED) {
+    throw std::runtime_error("We currently dod not support PRECOMPUTED kernels in these bindings to libsvm");
+  }
+
   std::vector<double> labels;
-  labels.reserve(data.size());
-  if (data.size() == 1) {
+  labels.reserve(classes);
+  if (classes == 1) {
     //oc-svm only support one class. 
     labels.push_back(+1.);
   }
-  else if (data.size() == 2) {
+  else if (classes == 2) {
     //keep libsvm ordering
     labels.push_back(+1.);
     labels.push_back(-1.);
   }
-  else { //data.size() == 3, 4, ..., 16
-    for (size_t k=0; k<data.size(); ++k) labels.push_back(k+1);
+  else { //classes == 3, 4, ...
+    for (size_t k=0; k<classes; ++k) labels.push_back(k+1);
   }
 
-  //just count how many nodes we need; unfortunately we have no other choice
-  //than doing a 2-pass instantiation here as libsvm has a very weird way to
-  //optimize data access in which it requires all nodes to be allocated in a
-  //single shot.
-  size_t nodes = 0; //total number of nodes to be allocated
-  blitz::Range all=blitz::Range::all();
-  int n_features = data[0].extent(blitz::secondDim);
-  blitz::Array<double,1> d(n_features); //for temporary feature manipulation
+  return labels;
+}
 
-  for (size_t k=0; k<data.size(); ++k) {
-    for (int i=0; i<data[k].extent(blitz::firstDim); ++i) {
-      d = (data[k](i,all)-sub)/div; //eval and copy in 1 instruction
-      for (int p=0; p<d.extent(blitz::firstDim); ++p) {
-        if (d(p)) {
-          ++nodes;
-        }
-      }
-      ++nodes; //one extra for the termination node "index == -1"
+/**
+ * Builds an svm_problem for classes with the given number of ``rows``
+ * each. ``fill(cls, start, end, nodes, x)`` should fill the nodes for
+ * samples [start, end) of class ``cls`` and return the highest feature
+ * index set: it is called in parallel, for different blocks. Updates
+ * "gamma" at the svm_parameter's.
+ */
+template <typename Fill>
+static boost::shared_ptr<problem_storage> make_problem
+(const std::vector<size_t>& rows, svm_parameter& param, Fill fill) {
+
+  std::vector<double> labels = choose_labels(rows.size(), param);
+
+  //splits all samples in blocks, which never cross class boundaries
+  struct block { size_t cls, start, end, sample; };
+  std::vector<block> blocks;
+  size_t entries = 0;
+  for (size_t k=0; k<rows.size(); ++k) {
+    for (size_t start=0; start<rows[k]; start+=PROBLEM_BLOCK) {
+      block b = {k, start, std::min(rows[k], start+PROBLEM_BLOCK), entries};
+      blocks.push_back(b);
+      entries += b.end - b.start;
     }
   }
 
-  //allocates all the nodes, set first entry, a la libsvm
-  svm_node* all_nodes = new svm_node[nodes];
+  boost::shared_ptr<problem_storage> retval =
+    boost::make_shared<problem_storage>();
+  retval->y.resize(entries);
+  retval->x.resize(entries);
+  retval->nodes.resize(blocks.size());
+  retval->problem.l = (int)entries;
+  retval->problem.y = retval->y.data();
+  retval->problem.x = retval->x.data();
 
-  //iterates over each class data and fills the svm_node's
-  int max_index = 0; //data width
-  size_t sample = 0; //sample counter
-  size_t node = 0; //node counter
+  std::vector<int> max_index(blocks.size(), 0);
 
-  for (size_t k=0; k<data.size(); ++k) {
-    for (int i=0; i<data[k].extent(blitz::firstDim); ++i) {
-      problem->x[sample] = &all_nodes[node]; //setup current sample base pointer
-      d = (data[k](i,all)-sub)/div; //eval and copy in 1 instruction
-      for (blitz::sizeType p=0; p<d.size(); ++p) {
-        if (d(p)) {
-          int index = p+1; //starts indexing at 1
-          all_nodes[node].index = index;
-          all_nodes[node].value = d(p);
-          if ( index > max_index ) max_index = index;
-          ++node; //index within the current sample
-        }
-      }
-      //marks end of sequence
-      all_nodes[node].index = -1;
-      all_nodes[node].value = 0;
-      problem->y[sample] = labels[k];
-      ++node;
-      ++sample;
+  bob::learn::libsvm::TrainingCounters* counters =
+    bob::learn::libsvm::TrainingCounters::routed();
+  uint64_t begin = counters ? bob::learn::libsvm::nanoseconds() : 0;
+
+  bob::learn::libsvm::parallel_for(blocks.size(), 0, 1,
+      [&](size_t first, size_t last) {
+    for (size_t b=first; b<last; ++b) {
+      const block& bl = blocks[b];
+      max_index[b] = fill(bl.cls, bl.start, bl.end, retval->nodes[b],
+          &retval->x[bl.sample]);
+      std::fill(retval->y.begin() + bl.sample,
+          retval->y.begin() + bl.sample + (bl.end - bl.start),
+          labels[bl.cls]);
     }
-  }
+  });
 
   //extracted from svm-train.c
-  if (param.gamma == 0. && max_index > 0) {
-    param.gamma = 1.0/max_index;
+  int data_width = 0;
+  for (size_t b=0; b<blocks.size(); ++b)
+    data_width = std::max(data_width, max_index[b]);
+  if (param.gamma == 0. && data_width > 0) {
+    param.gamma = 1.0/data_width;
   }
 
-  //do not support pre-computed kernels...
-  if (param.kernel_type == PRECOMPUTED) {
-    throw std::runtime_error("We currently dod not support PRECOMPUTED kernels in these bindings to libsvm");
+  if (counters) counters->addBuild(bob::learn::libsvm::nanoseconds() - begin);
+
+  return retval;
+}
+
+/**
+ * Converts the input arrayset data into an svm_problem matrix, used by libsvm
+ * training routines. Updates "gamma" at the svm_parameter's.
+ */
+static boost::shared_ptr<problem_storage> data2problem
+(const std::vector<blitz::Array<double, 2> >& data,
+ const blitz::Array<double,1>& sub, const blitz::Array<double,1>& div,
+ svm_parameter& param) {
+
+  //workers only touch raw memory: blitz reference counting is not
+  //thread-safe, so no views are created bellow
+  int n_features = data.empty() ? 0 : data[0].extent(blitz::secondDim);
+  std::vector<size_t> rows(data.size());
+  std::vector<const double*> base(data.size());
+  std::vector<ptrdiff_t> row(data.size()), col(data.size());
+  for (size_t k=0; k<data.size(); ++k) {
+    rows[k] = data[k].extent(blitz::firstDim);
+    base[k] = data[k].data();
+    row[k] = data[k].stride(blitz::firstDim);
+    col[k] = data[k].stride(blitz::secondDim);
   }
+  const double* sub_ = sub.data();
+  const double* div_ = div.data();
 
-  return problem;
+  return make_problem(rows, param, [&](size_t cls, size_t start, size_t end,
+        std::vector<svm_node>& nodes, svm_node** x) {
+      return fill_block(base[cls], row[cls], col[cls], n_features, start,
+        end, sub_, div_, nodes, x);
+  });
+}
+
+/**
+ * Same as above, for sparse data, which is only scaled by division
+ */
+static boost::shared_ptr<problem_storage> data2problem
+(const std::vector<bob::learn::libsvm::SparseMatrix>& data,
+ const blitz::Array<double,1>& div, svm_parameter& param) {
+
+  std::vector<size_t> rows(data.size());
+  for (size_t k=0; k<data.size(); ++k) rows[k] = data[k].rows();
+  const double* div_ = div.data();
+
+  return make_problem(rows, param, [&](size_t cls, size_t start, size_t end,
+        std::vector<svm_node>& nodes, svm_node** x) {
+      return fill_sparse_block(data[cls], start, end, div_, nodes, x);
+  });
 }
 
 /**
@@ -217,12 +464,10 @@ static void svm_model_free(svm_model*& m) {
 #endif
 }
 
-bob::learn::libsvm::Machine* bob::learn::libsvm::Trainer::train
-(const std::vector<blitz::Array<double, 2> >& data,
- const blitz::Array<double,1>& input_subtraction,
- const blitz::Array<double,1>& input_division) const {
-
-  //sanity check of input arraysets
+/**
+ * Sanity check of input arraysets
+ */
+static void check_data(const std::vector<blitz::Array<double,2> >& data) {
   int n_features = data[0].extent(blitz::secondDim);
 
   for (size_t cl=0; cl<data.size(); ++cl) {
@@ -232,25 +477,61 @@ bob::learn::libsvm::Machine* bob::learn::libsvm::Trainer::train
       throw std::runtime_error(m.str());
     }
   }
+}
 
-  //converts the input arraysets into something libsvm can digest
-  double save_gamma = m_param.gamma; ///< the next method may update it!
-  boost::shared_ptr<svm_problem> problem =
-    data2problem(data, input_subtraction, input_division,
-        const_cast<svm_parameter&>(m_param) ///< temporary cast
-        );
+/**
+ * Sanity check of input matrices and of their scaling parameters
+ */
+static void check_data
+(const std::vector<bob::learn::libsvm::SparseMatrix>& data,
+ const blitz::Array<double,1>& input_subtraction,
+ const blitz::Array<double,1>& input_division) {
 
-  //checks parametrization to make sure all is alright.
-  const char* error_msg = svm_check_parameter(problem.get(), &m_param);
+  size_t n_features = data[0].columns();
+
+  for (size_t cl=0; cl<data.size(); ++cl) {
+    if (data[cl].columns() != n_features) {
+      boost::format m("number of features (columns) of sparse matrix for class %u (%d) does not match that of sparse matrix for class 0 (%d)");
+      m % cl % data[cl].columns() % n_features;
+      throw std::runtime_error(m.str());
+    }
+  }
+
+  if ((size_t)input_subtraction.extent(0) < n_features ||
+      (size_t)input_division.extent(0) < n_features) {
+    boost::format m("scaling parameters should have, at least, %d positions (one per feature), but you provided %d values to subtract and %d to divide by");
+    m % n_features % input_subtraction.extent(0) % input_division.extent(0);
+    throw std::runtime_error(m.str());
+  }
+
+  //zeros are not stored, so they cannot be shifted
+  for (size_t k=0; k<n_features; ++k) {
+    if (input_subtraction(k)) {
+      boost::format m("sparse data can only be scaled by division, but you asked to subtract %g from feature %d");
+      m % input_subtraction(k) % k;
+      throw std::runtime_error(m.str());
+    }
+  }
+}
+
+/**
+ * Checks parametrization to make sure all is alright
+ */
+static void check_parameter(const svm_problem& problem,
+    const svm_parameter& param) {
+  const char* error_msg = svm_check_parameter(&problem, &param);
 
   if (error_msg) {
-    const_cast<double&>(m_param.gamma) = save_gamma;
     boost::format m("libsvm-%d reports: %s");
     m % libsvm_version % error_msg;
-    std::runtime_error(m.str());
+    throw std::runtime_error(m.str());
   }
+}
 
-  //do the training, returns the new machine
+/**
+ * Routes libsvm messages to our debugging stream
+ */
+static void set_print_function() {
 #if LIBSVM_VERSION >= 291
   svm_set_print_string_function(debug_libsvm);
 #else
@@ -258,17 +539,268 @@ bob::learn::libsvm::Machine* bob::learn::libsvm::Trainer::train
   m % libsvm_version;
   debug_libsvm(m.str().c_str());
 #endif
-  boost::shared_ptr<svm_model> model(svm_train(problem.get(), &m_param),
-      std::ptr_fun(svm_model_free));
+}
+
+/**
+ * Calls svm_train(), unless the training was cancelled, routing libsvm
+ * messages of the calling thread to ``obs`` meanwhile, and adds the problem
+ * to its counters (if set). Raises TrainingCancelled if the training was
+ * cancelled meanwhile, after releasing the model.
+ */
+static svm_model* train_svm(const svm_problem* problem,
+    const svm_parameter* param, const observers& obs) {
 
-  const_cast<double&>(m_param.gamma) = save_gamma;
+  if (obs.monitor) obs.monitor->check();
+  if (!obs.counters && !obs.monitor) return svm_train(problem, param);
+
+  routing route(obs);
+  uint64_t start = bob::learn::libsvm::nanoseconds();
+  svm_model* retval = svm_train(problem, param);
+  if (obs.counters)
+    obs.counters->addSolve(bob::learn::libsvm::nanoseconds() - start);
+  if (obs.monitor && obs.monitor->cancelled()) {
+    svm_model_free(retval);
+    obs.monitor->check();
+  }
+  return retval;
+}
+
+/**
+ * Returns a copy of a model returned by svm_train(), which does not depend
+ * on the training problem anymore
+ */
+static boost::shared_ptr<svm_model> detach
+(const boost::shared_ptr<svm_model> model) {
+  //copies support vectors out of the problem, without rounding anything
+  return bob::learn::libsvm::svm_copy(model);
+}
+
+/**
+ * The kernel matrix of a problem, taken from a KernelCache, with what is
+ * required to train on it instead of on the samples of the problem
+ */
+struct precomputed {
+  boost::shared_ptr<const bob::learn::libsvm::KernelCache::Rows> rows;
+  const svm_problem* problem; ///< the samples the matrix was computed for
+  std::map<const svm_node*, size_t> index; ///< position of each sample
+  svm_parameter param; ///< kernel the matrix was computed with
+};
+
+/**
+ * Looks the kernel matrix of ``problem`` up in ``cache``, computing it with
+ * up to ``threads`` threads if required. Returns an empty pointer if there
+ * is no cache or if the matrix does not fit in it.
+ */
+static boost::shared_ptr<precomputed> precompute
+(bob::learn::libsvm::KernelCache* cache, const svm_problem& problem,
+ const svm_parameter& param, size_t threads) {
+
+  boost::shared_ptr<precomputed> retval;
+  if (!cache) return retval;
+  auto rows = cache->rows(problem, param, threads);
+  if (!rows) return retval;
+
+  retval = boost::make_shared<precomputed>();
+  retval->rows = rows;
+  retval->problem = &problem;
+  for (size_t i=0; i<(size_t)problem.l; ++i) retval->index[problem.x[i]] = i;
+  retval->param = param;
+  return retval;
+}
+
+/**
+ * Trains ``problem``, whose samples must be samples of the problem ``pre``
+ * was computed for (if set), on the precomputed kernel matrix. Support
+ * vectors of the returned model point to the samples of ``problem`` and
+ * its parameters are ``param``, like if svm_train() was called on it.
+ * Statistics and progress go to ``obs``.
+ */
+static svm_model* train_model(const svm_problem& problem,
+    const svm_parameter& param, const precomputed* pre,
+    const observers& obs) {
+
+  if (!pre || pre->param.kernel_type != param.kernel_type ||
+      pre->param.degree != param.degree ||
+      pre->param.gamma != param.gamma || pre->param.coef0 != param.coef0)
+    return train_svm(&problem, &param, obs);
+
+  std::vector<svm_node*> x(problem.l);
+  for (size_t i=0; i<(size_t)problem.l; ++i)
+    x[i] = pre->rows->row(pre->index.find(problem.x[i])->second);
+  svm_problem view = problem;
+  view.x = x.data();
+  svm_parameter kernel = param;
+  kernel.kernel_type = PRECOMPUTED;
+
+  svm_model* model = train_svm(&view, &kernel, obs);
+
+  //rows start with the (1-based) index of their sample
+  for (int k=0; k<model->l; ++k)
+    model->SV[k] = pre->problem->x[(int)model->SV[k][0].value - 1];
+  model->param = param;
+  return model;
+}
+
+/**
+ * Solves each of the one-vs-one binary sub-problems of a multi-class
+ * problem on a separate task, with an even share of the kernel cache, and
+ * merges them into a single model, laid out exactly like those of
+ * svm_train(), which solves them one after the other. Returns a model that
+ * does not depend on the problem anymore.
+ */
+static boost::shared_ptr<svm_model> solve_pairs(problem_storage& problem,
+    const svm_parameter& param, size_t threads, const precomputed* pre) {
+
+  //classes are consecutive in problems built by make_problem()
+  const svm_problem& full = problem.problem;
+  std::vector<int> label;
+  std::vector<size_t> start;
+  for (size_t i=0; i<(size_t)full.l; ++i) {
+    if (i && full.y[i] == full.y[i-1]) continue;
+    label.push_back((int)full.y[i]);
+    start.push_back(i);
+  }
+  start.push_back(full.l);
+  size_t classes = label.size();
+
+  std::vector<std::pair<size_t,size_t> > pairs;
+  for (size_t i=0; i<classes; ++i)
+    for (size_t j=i+1; j<classes; ++j) pairs.push_back(std::make_pair(i, j));
+
+  size_t workers = bob::learn::libsvm::number_of_workers(pairs.size(),
+      threads);
+  svm_parameter pair_param = param;
+  pair_param.cache_size = param.cache_size / workers;
+
+  observers obs;
+
+  std::vector<boost::shared_ptr<svm_model> > models(pairs.size());
+  bob::learn::libsvm::parallel_for(pairs.size(), workers, 1,
+      [&](size_t first, size_t last) {
+    for (size_t p=first; p<last; ++p) {
+      size_t i = pairs[p].first, j = pairs[p].second;
+      std::vector<double> y(full.y + start[i], full.y + start[i+1]);
+      y.insert(y.end(), full.y + start[j], full.y + start[j+1]);
+      std::vector<svm_node*> x(full.x + start[i], full.x + start[i+1]);
+      x.insert(x.end(), full.x + start[j], full.x + start[j+1]);
+      svm_problem pair_problem;
+      pair_problem.l = (int)y.size();
+      pair_problem.y = y.data();
+      pair_problem.x = x.data();
+      models[p].reset(train_model(pair_problem, pair_param, pre, obs),
+          std::ptr_fun(svm_model_free));
+    }
+  });
 
-  //save newly created machine to file, reload from there to get rid of memory
-  //dependencies due to the poorly implemented memory model in libsvm
-  boost::shared_ptr<svm_model> new_model =
-    bob::learn::libsvm::svm_unpickle(bob::learn::libsvm::svm_pickle(model));
+  //support vectors of binary models point to the nodes of the problem,
+  //which tell where they come from
+  std::map<const svm_node*, size_t> sample;
+  for (size_t i=0; i<(size_t)full.l; ++i) sample[full.x[i]] = i;
 
-  auto retval = new bob::learn::libsvm::Machine(new_model);
+  std::vector<std::vector<double> > coef(classes-1,
+      std::vector<double>(full.l, 0.));
+  std::vector<char> is_sv(full.l, 0);
+  std::vector<double> rho(pairs.size());
+  std::vector<double> probA, probB;
+
+  for (size_t p=0; p<pairs.size(); ++p) {
+    size_t i = pairs[p].first, j = pairs[p].second;
+    const svm_model* model = models[p].get();
+    //positive decisions should be for class i, whatever libsvm chose
+    double sign = (model->label[0] == label[i]) ? 1. : -1.;
+    rho[p] = sign * model->rho[0];
+    if (model->probA && model->probB) {
+      probA.push_back(model->probA[0]);
+      probB.push_back(sign * model->probB[0]);
+    }
+    for (int k=0; k<model->l; ++k) {
+      size_t s = sample[model->SV[k]];
+      //coefficients for class i are stored with those of class j and the
+      //other way around, like libsvm does
+      coef[s < start[i+1] ? j-1 : i][s] = sign * model->sv_coef[0][k];
+      is_sv[s] = 1;
+    }
+  }
+
+  std::vector<svm_node*> SV;
+  std::vector<int> nSV(classes, 0);
+  std::vector<std::vector<double> > sv_coef(classes-1);
+  for (size_t c=0; c<classes; ++c) {
+    for (size_t s=start[c]; s<start[c+1]; ++s) {
+      if (!is_sv[s]) continue;
+      SV.push_back(full.x[s]);
+      ++nSV[c];
+      for (size_t k=0; k<classes-1; ++k) sv_coef[k].push_back(coef[k][s]);
+    }
+  }
+  std::vector<double*> sv_coef_ptr(classes-1);
+  for (size_t k=0; k<classes-1; ++k) sv_coef_ptr[k] = sv_coef[k].data();
+
+  svm_model merged = svm_model();
+  merged.param = param;
+  merged.nr_class = (int)classes;
+  merged.l = (int)SV.size();
+  merged.SV = SV.data();
+  merged.sv_coef = sv_coef_ptr.data();
+  merged.rho = rho.data();
+  if (probA.size() == pairs.size()) {
+    merged.probA = probA.data();
+    merged.probB = probB.data();
+  }
+  merged.label = label.data();
+  merged.nSV = nSV.data();
+  merged.free_sv = 0;
+
+  return detach(boost::shared_ptr<svm_model>(&merged, [](svm_model*) {}));
+}
+
+/**
+ * Trains on the given problem and returns a model that does not depend on
+ * it anymore. Multi-class classification sub-problems are solved with up to
+ * ``threads`` threads. Kernels are looked up in ``cache``, if set.
+ */
+static boost::shared_ptr<svm_model> solve(problem_storage& problem,
+    const svm_parameter& param, size_t threads,
+    bob::learn::libsvm::KernelCache* cache) {
+
+  check_parameter(problem.problem, param);
+
+  //do the training, returns the new machine
+  set_print_function();
+
+  boost::shared_ptr<precomputed> pre = precompute(cache, problem.problem,
+      param, threads);
+
+  bool classifier = (param.svm_type == C_SVC || param.svm_type == NU_SVC);
+  size_t classes = 0;
+  for (size_t i=0; i<(size_t)problem.problem.l; ++i)
+    if (!i || problem.problem.y[i] != problem.problem.y[i-1]) ++classes;
+  if (classifier && classes > 2 && threads != 1)
+    return solve_pairs(problem, param, threads, pre.get());
+
+  boost::shared_ptr<svm_model> model(train_model(problem.problem, param,
+        pre.get(), observers()), std::ptr_fun(svm_model_free));
+
+  return detach(model);
+}
+
+bob::learn::libsvm::Machine* bob::learn::libsvm::Trainer::train
+(const std::vector<blitz::Array<double, 2> >& data,
+ const blitz::Array<double,1>& input_subtraction,
+ const blitz::Array<double,1>& input_division, size_t threads) const {
+
+  check_data(data);
+  training_scope scope(m_counters.get(), m_progress, m_time_limit,
+      m_interrupt);
+
+  //converts the input arraysets into something libsvm can digest; works on
+  //a copy of the parameters so concurrent calls to train() are safe
+  svm_parameter param = m_param;
+  boost::shared_ptr<problem_storage> problem =
+    data2problem(data, input_subtraction, input_division, param);
+
+  auto retval = new bob::learn::libsvm::Machine(solve(*problem, param,
+        threads, m_cache.get()));
 
   //sets up the scaling parameters given as input
   retval->setInputSubtraction(input_subtraction);
@@ -278,13 +810,865 @@ bob::learn::libsvm::Machine* bob::learn::libsvm::Trainer::train
 }
 
 bob::learn::libsvm::Machine* bob::learn::libsvm::Trainer::train
-(const std::vector<blitz::Array<double,2> >& data) const {
+(const std::vector<blitz::Array<double,2> >& data, size_t threads) const {
+  int n_features = data[0].extent(blitz::secondDim);
+
+  blitz::Array<double,1> sub(n_features);
+  sub = 0.;
+  blitz::Array<double,1> div(n_features);
+  div = 1.;
+  return train(data, sub, div, threads);
+}
+
+bob::learn::libsvm::Machine* bob::learn::libsvm::Trainer::train
+(const std::vector<bob::learn::libsvm::SparseMatrix>& data,
+ const blitz::Array<double,1>& input_subtraction,
+ const blitz::Array<double,1>& input_division, size_t threads) const {
+
+  check_data(data, input_subtraction, input_division);
+  training_scope scope(m_counters.get(), m_progress, m_time_limit,
+      m_interrupt);
+
+  svm_parameter param = m_param;
+  boost::shared_ptr<problem_storage> problem =
+    data2problem(data, input_division, param);
+
+  auto retval = new bob::learn::libsvm::Machine(solve(*problem, param,
+        threads, m_cache.get()));
+
+  //sets up the scaling parameters given as input
+  retval->setInputSubtraction(input_subtraction);
+  retval->setInputDivision(input_division);
+
+  return retval;
+}
+
+bob::learn::libsvm::Machine* bob::learn::libsvm::Trainer::train
+(const std::vector<bob::learn::libsvm::SparseMatrix>& data,
+ size_t threads) const {
+  size_t n_features = data[0].columns();
+
+  blitz::Array<double,1> sub(n_features);
+  sub = 0.;
+  blitz::Array<double,1> div(n_features);
+  div = 1.;
+  return train(data, sub, div, threads);
+}
+
+/**
+ * Samples whose margin, for the previous solution, is above one plus this
+ * band are left out of the first working set of a warm start. Wider bands
+ * lead to larger working sets, but to less rounds until the solution
+ * settles.
+ */
+static const double WARM_START_BAND = 0.1;
+
+/**
+ * Returns the margin of a sample of class ``label``, given the decision
+ * values of a model with the given ``labels``: the smallest of the decision
+ * values of all pairs of classes involving ``label``, oriented so that
+ * they are positive when the pair is decided for ``label``
+ */
+static double oriented_margin(const std::vector<int>& labels,
+    const double* dec_values, double label) {
+  double retval = std::numeric_limits<double>::infinity();
+  size_t p = 0;
+  for (size_t i=0; i<labels.size(); ++i) {
+    for (size_t j=i+1; j<labels.size(); ++j, ++p) {
+      if (labels[i] == label) retval = std::min(retval, dec_values[p]);
+      else if (labels[j] == label) retval = std::min(retval, -dec_values[p]);
+    }
+  }
+  return retval;
+}
+
+static size_t rows(const blitz::Array<double,2>& data) {
+  return data.extent(0);
+}
+
+static size_t rows(const bob::learn::libsvm::SparseMatrix& data) {
+  return data.rows();
+}
+
+/**
+ * Computes the margins of all samples of a problem (built from ``data``)
+ * for the ``previous`` machine. Checks ``previous`` is a classifier for the
+ * same classes.
+ */
+template <typename Data>
+static std::vector<double> previous_margins
+(const std::vector<Data>& data, const problem_storage& problem,
+ const bob::learn::libsvm::Machine& previous, size_t threads) {
+
+  std::vector<int> labels(previous.numberOfClasses());
+  for (size_t i=0; i<labels.size(); ++i) labels[i] = previous.classLabel(i);
+
+  if (labels.size() != data.size()) {
+    boost::format m("cannot retrain a machine for %d classes with data for %d classes");
+    m % labels.size() % data.size();
+    throw std::runtime_error(m.str());
+  }
+
+  std::vector<double> retval(problem.problem.l);
+  size_t offset = 0;
+  for (size_t k=0; k<data.size(); ++k) {
+    size_t n = rows(data[k]);
+    if (!n) continue;
+    double label = problem.problem.y[offset];
+    if (std::find(labels.begin(), labels.end(), label) == labels.end()) {
+      boost::format m("cannot retrain a machine that does not know about label %g, assigned to class %d");
+      m % label % k;
+      throw std::runtime_error(m.str());
+    }
+    blitz::Array<int64_t,1> predicted(n);
+    blitz::Array<double,2> scores(n, previous.outputSize());
+    previous.predictClassAndScores(data[k], predicted, scores, threads);
+    for (size_t r=0; r<n; ++r) {
+      retval[offset+r] = oriented_margin(labels, &scores(r,0), label);
+    }
+    offset += n;
+  }
+
+  return retval;
+}
+
+/**
+ * Trains on a problem, given the margins of its samples for a previous
+ * solution, by solving increasingly large working sets until all samples
+ * left out satisfy the optimality conditions. Returns a model that does not
+ * depend on the problem anymore.
+ */
+static boost::shared_ptr<svm_model> solve_warm(problem_storage& problem,
+    const svm_parameter& param, const std::vector<double>& margins,
+    size_t threads) {
+
+  check_parameter(problem.problem, param);
+  set_print_function();
+
+  const svm_problem& full = problem.problem;
+  std::vector<char> selected(full.l);
+  for (size_t i=0; i<(size_t)full.l; ++i)
+    selected[i] = margins[i] < 1. + WARM_START_BAND;
+
+  //every class must be part of the working set
+  for (size_t start=0, end; start<(size_t)full.l; start=end) {
+    bool any = false;
+    for (end=start; end<(size_t)full.l && full.y[end]==full.y[start]; ++end)
+      any = any || selected[end];
+    if (!any) std::fill(selected.begin()+start, selected.begin()+end, 1);
+  }
+
+  std::vector<char> violates(full.l);
+
+  while (true) {
+
+    std::vector<double> y;
+    std::vector<svm_node*> x;
+    for (size_t i=0; i<(size_t)full.l; ++i) {
+      if (!selected[i]) continue;
+      y.push_back(full.y[i]);
+      x.push_back(full.x[i]);
+    }
+    svm_problem working;
+    working.l = (int)y.size();
+    working.y = y.data();
+    working.x = x.data();
+
+    boost::shared_ptr<svm_model> model(train_svm(&working, &param,
+          observers()), std::ptr_fun(svm_model_free));
+
+    //checks the samples left out, with alpha = 0, should be on the right
+    //side of the margin
+    std::vector<int> labels(model->label, model->label + model->nr_class);
+    size_t pairs = labels.size() * (labels.size()-1) / 2;
+    std::fill(violates.begin(), violates.end(), 0);
+    bob::learn::libsvm::parallel_for(full.l, threads, 1024,
+        [&](size_t first, size_t last) {
+      std::vector<double> dec_values(std::max(pairs, (size_t)1));
+      for (size_t i=first; i<last; ++i) {
+        if (selected[i]) continue;
+        svm_predict_values(model.get(), full.x[i], dec_values.data());
+        violates[i] = oriented_margin(labels, dec_values.data(),
+            full.y[i]) < 1. - param.eps;
+      }
+    });
+
+    size_t added = 0;
+    for (size_t i=0; i<(size_t)full.l; ++i) {
+      if (violates[i]) {
+        selected[i] = 1;
+        ++added;
+      }
+    }
+
+    if (!added) return detach(model);
+  }
+}
+
+bob::learn::libsvm::Machine* bob::learn::libsvm::Trainer::train
+(const std::vector<blitz::Array<double,2> >& data,
+ const bob::learn::libsvm::Machine& previous, size_t threads) const {
+
+  const blitz::Array<double,1>& sub = previous.getInputSubtraction();
+  const blitz::Array<double,1>& div = previous.getInputDivision();
+
+  //probabilities must be fitted on all samples, not on a working set
+  if (m_param.svm_type != C_SVC || m_param.probability)
+    return train(data, sub, div, threads);
+
+  check_data(data);
+
+  if ((size_t)data[0].extent(blitz::secondDim) != previous.inputSize()) {
+    boost::format m("cannot retrain a machine for %d features with data that has %d features");
+    m % previous.inputSize() % data[0].extent(blitz::secondDim);
+    throw std::runtime_error(m.str());
+  }
+
+  training_scope scope(m_counters.get(), m_progress, m_time_limit,
+      m_interrupt);
+  svm_parameter param = m_param;
+  boost::shared_ptr<problem_storage> problem =
+    data2problem(data, sub, div, param);
+  std::vector<double> margins =
+    previous_margins(data, *problem, previous, threads);
+
+  auto retval = new bob::learn::libsvm::Machine(solve_warm(*problem, param,
+        margins, threads));
+
+  retval->setInputSubtraction(sub);
+  retval->setInputDivision(div);
+
+  return retval;
+}
+
+bob::learn::libsvm::Machine* bob::learn::libsvm::Trainer::train
+(const std::vector<bob::learn::libsvm::SparseMatrix>& data,
+ const bob::learn::libsvm::Machine& previous, size_t threads) const {
+
+  const blitz::Array<double,1>& sub = previous.getInputSubtraction();
+  const blitz::Array<double,1>& div = previous.getInputDivision();
+
+  //probabilities must be fitted on all samples, not on a working set
+  if (m_param.svm_type != C_SVC || m_param.probability)
+    return train(data, sub, div, threads);
+
+  check_data(data, sub, div);
+  training_scope scope(m_counters.get(), m_progress, m_time_limit,
+      m_interrupt);
+
+  svm_parameter param = m_param;
+  boost::shared_ptr<problem_storage> problem =
+    data2problem(data, div, param);
+  std::vector<double> margins =
+    previous_margins(data, *problem, previous, threads);
+
+  auto retval = new bob::learn::libsvm::Machine(solve_warm(*problem, param,
+        margins, threads));
+
+  retval->setInputSubtraction(sub);
+  retval->setInputDivision(div);
+
+  return retval;
+}
+
+/**
+ * The training set of a cross-validation fold, which points to the nodes
+ * of the full problem, together with the samples it holds out
+ */
+struct fold_storage {
+  svm_problem problem;
+  std::vector<double> y; ///< labels of the training samples
+  std::vector<svm_node*> x; ///< training samples
+  std::vector<size_t> test; ///< held-out samples of the full problem
+};
+
+/**
+ * Splits a problem in ``folds`` folds. Samples of each class are
+ * consecutive in problems built by make_problem(), so handing out all
+ * samples in a round-robin fashion stratifies folds by class.
+ */
+static std::vector<fold_storage> make_folds(const svm_problem& problem,
+    size_t folds) {
+
+  if (folds < 2 || folds > (size_t)problem.l) {
+    boost::format m("cross-validation requires between 2 and as many folds as samples (%d), but you asked for %d folds");
+    m % problem.l % folds;
+    throw std::runtime_error(m.str());
+  }
+
+  std::vector<fold_storage> retval(folds);
+  for (size_t f=0; f<folds; ++f) {
+    fold_storage& fold = retval[f];
+    size_t tests = (problem.l - f + folds - 1) / folds;
+    fold.test.reserve(tests);
+    fold.y.reserve(problem.l - tests);
+    fold.x.reserve(problem.l - tests);
+    for (size_t i=0; i<(size_t)problem.l; ++i) {
+      if (i % folds == f) {
+        fold.test.push_back(i);
+      }
+      else {
+        fold.y.push_back(problem.y[i]);
+        fold.x.push_back(problem.x[i]);
+      }
+    }
+    fold.problem.l = (int)fold.y.size();
+    fold.problem.y = fold.y.data();
+    fold.problem.x = fold.x.data();
+  }
+
+  return retval;
+}
+
+/**
+ * Checks the grid of a search has, at least, one cell
+ */
+static void check_grid(const std::vector<double>& costs,
+    const std::vector<double>& gammas) {
+
+  if (costs.empty() || gammas.empty()) {
+    boost::format m("grid searches require, at least, one cost and one gamma value, but you passed %d cost(s) and %d gamma value(s)");
+    m % costs.size() % gammas.size();
+    throw std::runtime_error(m.str());
+  }
+
+}
+
+/**
+ * Runs the grid search on a problem built with ``param``, whose gamma
+ * (if not zero) is the default for cells asking for a gamma of zero. With
+ * a kernel ``cache``, cells are evaluated one gamma value after the other,
+ * so that their tasks share the kernel matrix of the problem.
+ */
+static bob::learn::libsvm::GridSearchResults grid_search
+(const problem_storage& problem, const svm_parameter& param, size_t folds,
+ const std::vector<double>& costs, const std::vector<double>& gammas,
+ size_t threads, bob::learn::libsvm::KernelCache* cache) {
+
+  check_grid(costs, gammas);
+
+  std::vector<svm_parameter> cells;
+  cells.reserve(costs.size() * gammas.size());
+  for (size_t c=0; c<costs.size(); ++c) {
+    for (size_t g=0; g<gammas.size(); ++g) {
+      svm_parameter cell = param;
+      cell.C = costs[c];
+      if (gammas[g]) cell.gamma = gammas[g];
+      check_parameter(problem.problem, cell);
+      cells.push_back(cell);
+    }
+  }
+
+  std::vector<fold_storage> fold = make_folds(problem.problem, folds);
+
+  //one task per cell and fold, which never share anything but the
+  //(read-only) nodes of the problem and kernel matrices
+  size_t tasks = cells.size() * folds;
+  std::vector<size_t> correct(tasks, 0);
+  std::vector<double> squared_error(tasks, 0.);
+  std::vector<double> seconds(tasks, 0.);
+
+  std::vector<std::vector<size_t> > passes(cache ? gammas.size() : 1);
+  for (size_t t=0; t<tasks; ++t)
+    passes[cache ? (t / folds) % gammas.size() : 0].push_back(t);
+
+  set_print_function();
+  observers obs;
+  for (size_t p=0; p<passes.size(); ++p) {
+    const std::vector<size_t>& pass = passes[p];
+    boost::shared_ptr<precomputed> pre;
+    if (cache) pre = precompute(cache, problem.problem,
+        cells[pass[0] / folds], threads);
+    bob::learn::libsvm::parallel_for(pass.size(), threads, 1,
+        [&](size_t first, size_t last) {
+      for (size_t k=first; k<last; ++k) {
+        size_t t = pass[k];
+        auto start = std::chrono::steady_clock::now();
+        const fold_storage& f = fold[t % folds];
+        svm_model* model = train_model(f.problem, cells[t / folds],
+            pre.get(), obs);
+        for (size_t j=0; j<f.test.size(); ++j) {
+          size_t i = f.test[j];
+          double prediction = svm_predict(model, problem.problem.x[i]);
+          double error = prediction - problem.problem.y[i];
+          if (prediction == problem.problem.y[i]) ++correct[t];
+          squared_error[t] += error * error;
+        }
+        svm_model_free(model);
+        seconds[t] = std::chrono::duration<double>
+          (std::chrono::steady_clock::now() - start).count();
+      }
+    });
+  }
+
+  bob::learn::libsvm::GridSearchResults retval;
+  retval.accuracy.resize(costs.size(), gammas.size());
+  retval.mse.resize(costs.size(), gammas.size());
+  retval.seconds.resize(costs.size(), gammas.size());
+  for (size_t c=0; c<costs.size(); ++c) {
+    for (size_t g=0; g<gammas.size(); ++g) {
+      size_t hits = 0;
+      double error = 0., time = 0.;
+      for (size_t t=(c*gammas.size()+g)*folds, f=0; f<folds; ++t, ++f) {
+        hits += correct[t];
+        error += squared_error[t];
+        time += seconds[t];
+      }
+      retval.accuracy(c, g) = (double)hits / problem.problem.l;
+      retval.mse(c, g) = error / problem.problem.l;
+      retval.seconds(c, g) = time;
+    }
+  }
+
+  return retval;
+}
+
+bob::learn::libsvm::GridSearchResults
+bob::learn::libsvm::Trainer::gridSearch
+(const std::vector<blitz::Array<double,2> >& data,
+ const blitz::Array<double,1>& input_subtraction,
+ const blitz::Array<double,1>& input_division, size_t folds,
+ const std::vector<double>& costs, const std::vector<double>& gammas,
+ size_t threads) const {
+
+  check_grid(costs, gammas);
+  check_data(data);
+  training_scope scope(m_counters.get(), m_progress, m_time_limit,
+      m_interrupt);
+
+  //builds the problem a single time for all cells, with the default gamma
+  svm_parameter param = m_param;
+  param.gamma = 0.;
+  boost::shared_ptr<problem_storage> problem =
+    data2problem(data, input_subtraction, input_division, param);
+
+  return grid_search(*problem, param, folds, costs, gammas, threads,
+      m_cache.get());
+}
+
+bob::learn::libsvm::GridSearchResults
+bob::learn::libsvm::Trainer::gridSearch
+(const std::vector<bob::learn::libsvm::SparseMatrix>& data,
+ const blitz::Array<double,1>& input_subtraction,
+ const blitz::Array<double,1>& input_division, size_t folds,
+ const std::vector<double>& costs, const std::vector<double>& gammas,
+ size_t threads) const {
+
+  check_grid(costs, gammas);
+  check_data(data, input_subtraction, input_division);
+  training_scope scope(m_counters.get(), m_progress, m_time_limit,
+      m_interrupt);
+
+  svm_parameter param = m_param;
+  param.gamma = 0.;
+  boost::shared_ptr<problem_storage> problem =
+    data2problem(data, input_division, param);
+
+  return grid_search(*problem, param, folds, costs, gammas, threads,
+      m_cache.get());
+}
+
+/**
+ * Trains one binary model per class of the problem, separating it (as +1)
+ * from all others (as -1), on a separate task each, with an even share of
+ * the kernel cache. Returns models that do not depend on the problem
+ * anymore, along with the label of each class.
+ */
+static std::vector<boost::shared_ptr<svm_model> > solve_one_vs_rest
+(problem_storage& problem, const svm_parameter& param, size_t threads,
+ bob::learn::libsvm::KernelCache* cache, std::vector<int>& label) {
+
+  if (param.svm_type != C_SVC && param.svm_type != NU_SVC) {
+    throw std::runtime_error("one-vs-rest machines can only be trained for classification (C_SVC or NU_SVC)");
+  }
+
+  //classes are consecutive in problems built by make_problem()
+  const svm_problem& full = problem.problem;
+  std::vector<size_t> start;
+  label.clear();
+  for (size_t i=0; i<(size_t)full.l; ++i) {
+    if (i && full.y[i] == full.y[i-1]) continue;
+    label.push_back((int)full.y[i]);
+    start.push_back(i);
+  }
+  start.push_back(full.l);
+  size_t classes = label.size();
+
+  set_print_function();
+
+  //all binary problems hold the same samples, in different orders
+  boost::shared_ptr<precomputed> pre = precompute(cache, full, param,
+      threads);
+
+  size_t workers = bob::learn::libsvm::number_of_workers(classes, threads);
+  svm_parameter binary_param = param;
+  binary_param.cache_size = param.cache_size / workers;
+
+  observers obs;
+
+  std::vector<boost::shared_ptr<svm_model> > retval(classes);
+  bob::learn::libsvm::parallel_for(classes, workers, 1,
+      [&](size_t first, size_t last) {
+    for (size_t c=first; c<last; ++c) {
+      //samples of the class go first, so libsvm labels it first
+      std::vector<double> y(start[c+1] - start[c], +1.);
+      y.resize(full.l, -1.);
+      std::vector<svm_node*> x(full.x + start[c], full.x + start[c+1]);
+      x.insert(x.end(), full.x, full.x + start[c]);
+      x.insert(x.end(), full.x + start[c+1], full.x + full.l);
+      svm_problem binary;
+      binary.l = full.l;
+      binary.y = y.data();
+      binary.x = x.data();
+      check_parameter(binary, binary_param);
+      boost::shared_ptr<svm_model> model(train_model(binary, binary_param,
+            pre.get(), obs), std::ptr_fun(svm_model_free));
+      retval[c] = detach(model);
+    }
+  });
+
+  return retval;
+}
+
+/**
+ * Wraps the binary models of a one-vs-rest problem in machines, with the
+ * given scaling
+ */
+static bob::learn::libsvm::OneVsRestMachine* one_vs_rest
+(const std::vector<boost::shared_ptr<svm_model> >& models,
+ const std::vector<int>& labels, const blitz::Array<double,1>& sub,
+ const blitz::Array<double,1>& div) {
+
+  std::vector<boost::shared_ptr<bob::learn::libsvm::Machine> > machines;
+  for (size_t c=0; c<models.size(); ++c) {
+    machines.push_back(boost::make_shared<bob::learn::libsvm::Machine>(models[c]));
+    machines.back()->setInputSubtraction(sub);
+    machines.back()->setInputDivision(div);
+  }
+  return new bob::learn::libsvm::OneVsRestMachine(machines, labels);
+}
+
+bob::learn::libsvm::OneVsRestMachine*
+bob::learn::libsvm::Trainer::trainOneVsRest
+(const std::vector<blitz::Array<double,2> >& data,
+ const blitz::Array<double,1>& input_subtraction,
+ const blitz::Array<double,1>& input_division, size_t threads) const {
+
+  check_data(data);
+  training_scope scope(m_counters.get(), m_progress, m_time_limit,
+      m_interrupt);
+
+  svm_parameter param = m_param;
+  boost::shared_ptr<problem_storage> problem =
+    data2problem(data, input_subtraction, input_division, param);
+
+  std::vector<int> labels;
+  std::vector<boost::shared_ptr<svm_model> > models =
+    solve_one_vs_rest(*problem, param, threads, m_cache.get(), labels);
+  return one_vs_rest(models, labels, input_subtraction, input_division);
+}
+
+bob::learn::libsvm::OneVsRestMachine*
+bob::learn::libsvm::Trainer::trainOneVsRest
+(const std::vector<blitz::Array<double,2> >& data, size_t threads) const {
   int n_features = data[0].extent(blitz::secondDim);
 
   blitz::Array<double,1> sub(n_features);
   sub = 0.;
   blitz::Array<double,1> div(n_features);
   div = 1.;
-  return train(data, sub, div);
+  return trainOneVsRest(data, sub, div, threads);
+}
+
+bob::learn::libsvm::OneVsRestMachine*
+bob::learn::libsvm::Trainer::trainOneVsRest
+(const std::vector<bob::learn::libsvm::SparseMatrix>& data,
+ const blitz::Array<double,1>& input_subtraction,
+ const blitz::Array<double,1>& input_division, size_t threads) const {
+
+  check_data(data, input_subtraction, input_division);
+  training_scope scope(m_counters.get(), m_progress, m_time_limit,
+      m_interrupt);
+
+  svm_parameter param = m_param;
+  boost::shared_ptr<problem_storage> problem =
+    data2problem(data, input_division, param);
+
+  std::vector<int> labels;
+  std::vector<boost::shared_ptr<svm_model> > models =
+    solve_one_vs_rest(*problem, param, threads, m_cache.get(), labels);
+  return one_vs_rest(models, labels, input_subtraction, input_division);
 }
 
+bob::learn::libsvm::OneVsRestMachine*
+bob::learn::libsvm::Trainer::trainOneVsRest
+(const std::vector<bob::learn::libsvm::SparseMatrix>& data,
+ size_t threads) const {
+  size_t n_features = data[0].columns();
+
+  blitz::Array<double,1> sub(n_features);
+  sub = 0.;
+  blitz::Array<double,1> div(n_features);
+  div = 1.;
+  return trainOneVsRest(data, sub, div, threads);
+}
+
+/**
+ * Number of samples mapped at once, while mapping training data
+ */
+static const size_t MAP_BLOCK = 256;
+
+/**
+ * Maximum number of passes over the samples of each linear problem
+ */
+static const size_t LINEAR_MAX_PASSES = 1000;
+
+/**
+ * Smallest stopping tolerance of linear problems: the default of liblinear
+ * for dual solvers, as libsvm's own default takes too many passes
+ */
+static const double LINEAR_EPSILON = 0.1;
+
+/**
+ * Solves the dual of a linear, L1-loss, SVM, with a bias term, by
+ * coordinate descent (Hsieh et al., ICML 2008): samples are visited in a
+ * random order at every pass, until the projected gradients are within
+ * ``eps`` of each other. ``features`` holds ``l`` padded rows of ``size``
+ * values each and ``w``, ``size`` aligned values, set to the solution, of
+ * which the dual ``objective`` is given back. Returns the number of
+ * coordinate descent steps taken. Raises TrainingCancelled between passes
+ * if the training followed by ``monitor`` (if set) is cancelled: unlike
+ * libsvm's, this solver owns all its memory.
+ */
+static uint64_t solve_linear(const double* features, size_t l, size_t size,
+    const std::vector<double>& y, double C, double eps, uint32_t seed,
+    bob::learn::libsvm::DenseEngine::block_function dot, double* w,
+    double& b, double& objective,
+    bob::learn::libsvm::TrainingMonitor* monitor) {
+
+  std::vector<double> alpha(l, 0.);
+  std::vector<double> diagonal(l);
+  std::vector<size_t> order(l);
+  for (size_t i=0; i<l; ++i) {
+    const double* x = features + i*size;
+    dot(x, x, 1, size, &diagonal[i]);
+    diagonal[i] += 1.; //the bias is an extra feature, always 1
+    order[i] = i;
+  }
+  std::fill(w, w + size, 0.);
+  b = 0.;
+
+  boost::random::mt19937 generator(seed);
+  size_t pass = 0;
+  for (; pass<LINEAR_MAX_PASSES; ++pass) {
+    if (monitor) monitor->check();
+    for (size_t i=l-1; i>0; --i) {
+      boost::random::uniform_int_distribution<size_t> pick(0, i);
+      std::swap(order[i], order[pick(generator)]);
+    }
+
+    double pg_max = -std::numeric_limits<double>::infinity();
+    double pg_min = std::numeric_limits<double>::infinity();
+    for (size_t k=0; k<l; ++k) {
+      size_t i = order[k];
+      const double* x = features + i*size;
+      double decision;
+      dot(w, x, 1, size, &decision);
+      double gradient = y[i] * (decision + b) - 1.;
+
+      double projected = gradient;
+      if (alpha[i] == 0.) projected = std::min(gradient, 0.);
+      else if (alpha[i] == C) projected = std::max(gradient, 0.);
+      pg_max = std::max(pg_max, projected);
+      pg_min = std::min(pg_min, projected);
+      if (projected == 0.) continue;
+
+      double previous = alpha[i];
+      alpha[i] = std::min(std::max(alpha[i] - gradient / diagonal[i], 0.), C);
+      double step = (alpha[i] - previous) * y[i];
+      for (size_t j=0; j<size; ++j) w[j] += step * x[j];
+      b += step;
+    }
+
+    if (pg_max - pg_min <= eps) break;
+  }
+
+  if (pass == LINEAR_MAX_PASSES) {
+    bob::core::warn << "linear solver reached the maximum number of passes over the samples (" << LINEAR_MAX_PASSES << "); consider a larger stopping epsilon or a smaller cost" << std::endl;
+  }
+  else ++pass; ///< the last one, which converged, counts as well
+
+  //like libsvm's: 1/2 (||w||^2 + b^2) - sum(alpha)
+  double norm;
+  dot(w, w, 1, size, &norm);
+  objective = 0.5 * (norm + b*b);
+  for (size_t i=0; i<l; ++i) objective -= alpha[i];
+
+  return pass * l;
+}
+
+bob::learn::libsvm::ApproximateMachine*
+bob::learn::libsvm::Trainer::trainApproximate
+(const std::vector<blitz::Array<double,2> >& data,
+ const blitz::Array<double,1>& input_subtraction,
+ const blitz::Array<double,1>& input_division,
+ bob::learn::libsvm::approximation_t approximation, size_t components,
+ uint32_t seed, size_t threads) const {
+
+  if (m_param.svm_type != C_SVC || m_param.kernel_type != RBF) {
+    throw std::runtime_error("approximate machines can only be trained for classification (C_SVC), with RBF kernels");
+  }
+
+  std::vector<double> labels = choose_labels(data.size(), m_param);
+  check_data(data);
+  training_scope scope(m_counters.get(), m_progress, m_time_limit,
+      m_interrupt);
+  observers obs; ///< for the workers, which do not inherit them
+
+  size_t n_features = data[0].extent(blitz::secondDim);
+  if ((size_t)input_subtraction.extent(0) < n_features ||
+      (size_t)input_division.extent(0) < n_features) {
+    boost::format m("scaling parameters should have, at least, %d positions (one per feature), but you provided %d values to subtract and %d to divide by");
+    m % n_features % input_subtraction.extent(0) % input_division.extent(0);
+    throw std::runtime_error(m.str());
+  }
+
+  //workers only touch raw memory, like for data2problem()
+  size_t classes = data.size();
+  std::vector<size_t> start(classes + 1, 0);
+  std::vector<const double*> base(classes);
+  std::vector<ptrdiff_t> row(classes), col(classes);
+  for (size_t k=0; k<classes; ++k) {
+    start[k+1] = start[k] + data[k].extent(blitz::firstDim);
+    base[k] = data[k].data();
+    row[k] = data[k].stride(blitz::firstDim);
+    col[k] = data[k].stride(blitz::secondDim);
+  }
+  size_t l = start[classes];
+  if (!l) {
+    throw std::runtime_error("approximate machines cannot be trained without samples");
+  }
+  const double* sub = input_subtraction.data();
+  const double* div = input_division.data();
+  auto sample = [&](size_t i, double* output) {
+    size_t k = std::upper_bound(start.begin(), start.end(), i) -
+      start.begin() - 1;
+    const double* input = base[k] + (i - start[k]) * row[k];
+    for (size_t j=0; j<n_features; ++j)
+      output[j] = (input[j*col[k]] - sub[j]) / div[j];
+  };
+
+  //same default as train() (see make_problem()): one over the highest
+  //feature index that is not zero, after scaling, for some sample
+  double gamma = m_param.gamma;
+  if (gamma == 0.) {
+    auto used = [&](size_t j) {
+      for (size_t k=0; k<classes; ++k) {
+        const double* input = base[k] + j*col[k];
+        for (size_t i=start[k]; i<start[k+1]; ++i, input+=row[k])
+          if ((*input - sub[j]) / div[j]) return true;
+      }
+      return false;
+    };
+    size_t width = n_features;
+    while (width && !used(width-1)) --width;
+    //all samples are zero then: any gamma gives the same kernel
+    gamma = 1. / (width ? width : n_features);
+  }
+
+  boost::shared_ptr<bob::learn::libsvm::KernelMap> map;
+  if (approximation == bob::learn::libsvm::NYSTROM) {
+    //landmarks are distinct samples, picked at random, kept in order
+    size_t landmarks = std::min(components, l);
+    std::vector<size_t> index(l);
+    for (size_t i=0; i<l; ++i) index[i] = i;
+    boost::random::mt19937 generator(seed);
+    for (size_t i=0; i<landmarks; ++i) {
+      boost::random::uniform_int_distribution<size_t> pick(i, l-1);
+      std::swap(index[i], index[pick(generator)]);
+    }
+    std::sort(index.begin(), index.begin() + landmarks);
+    blitz::Array<double,2> basis(landmarks, n_features);
+    for (size_t i=0; i<landmarks; ++i) sample(index[i], &basis(i,0));
+    map = bob::learn::libsvm::KernelMap::nystrom(basis, gamma);
+  }
+  else {
+    map = bob::learn::libsvm::KernelMap::fourier(n_features, components,
+        gamma, seed);
+  }
+
+  //all samples are mapped once, which is what building the problem means
+  //for these trainings
+  uint64_t begin = obs.counters ? bob::learn::libsvm::nanoseconds() : 0;
+  size_t p = map->paddedInputSize();
+  size_t q = map->paddedOutputSize();
+  bob::learn::libsvm::aligned_vector features(l * q);
+  bob::learn::libsvm::parallel_for(l, threads, MAP_BLOCK,
+      [&](size_t first, size_t last) {
+    bob::learn::libsvm::aligned_vector scaled(MAP_BLOCK * p, 0.);
+    bob::learn::libsvm::aligned_vector work(map->workspaceSize(MAP_BLOCK));
+    for (size_t i=first; i<last; i+=MAP_BLOCK) {
+      size_t n = std::min(MAP_BLOCK, last - i);
+      for (size_t k=0; k<n; ++k) sample(i + k, &scaled[k*p]);
+      map->map(&scaled[0], n, &features[i*q], &work[0]);
+    }
+  });
+  if (obs.counters)
+    obs.counters->addBuild(bob::learn::libsvm::nanoseconds() - begin);
+
+  //a single function separates 2 classes, otherwise one per class
+  size_t functions = (classes == 2) ? 1 : classes;
+  bob::learn::libsvm::aligned_vector weights(functions * q);
+  std::vector<double> bias(functions);
+  bob::learn::libsvm::parallel_for(functions, threads, 1,
+      [&](size_t first, size_t last) {
+    std::vector<double> y(l);
+    for (size_t f=first; f<last; ++f) {
+      for (size_t k=0; k<classes; ++k)
+        std::fill(y.begin() + start[k], y.begin() + start[k+1],
+            (k == f) ? +1. : -1.);
+      uint64_t solving = obs.counters ? bob::learn::libsvm::nanoseconds() : 0;
+      double objective;
+      uint64_t steps = solve_linear(&features[0], l, q, y, m_param.C,
+          std::max(m_param.eps, LINEAR_EPSILON), seed + 1 + f, map->dot(),
+          &weights[f*q], bias[f], objective, obs.monitor);
+      if (obs.counters) {
+        obs.counters->addSolve(bob::learn::libsvm::nanoseconds() - solving);
+        obs.counters->addIterations(steps);
+      }
+      if (obs.monitor) {
+        obs.monitor->solved(steps, objective);
+        obs.monitor->check();
+      }
+    }
+  });
+
+  blitz::Array<double,2> w(functions, map->outputSize());
+  blitz::Array<double,1> b(functions);
+  for (size_t f=0; f<functions; ++f) {
+    for (size_t j=0; j<map->outputSize(); ++j) w(f,j) = weights[f*q + j];
+    b(f) = bias[f];
+  }
+  std::vector<int> label(labels.begin(), labels.end());
+
+  bob::learn::libsvm::ApproximateMachine* retval =
+    new bob::learn::libsvm::ApproximateMachine(map, w, b, label);
+  retval->setInputSubtraction(input_subtraction);
+  retval->setInputDivision(input_division);
+  return retval;
+}
+
+bob::learn::libsvm::ApproximateMachine*
+bob::learn::libsvm::Trainer::trainApproximate
+(const std::vector<blitz::Array<double,2> >& data,
+ bob::learn::libsvm::approximation_t approximation, size_t components,
+ uint32_t seed, size_t threads) const {
+  int n_features = data[0].extent(blitz::secondDim);
+
+  blitz::Array<double,1> sub(n_features);
+  sub = 0.;
+  blitz::Array<double,1> div(n_features);
+  div = 1.;
+  return trainApproximate(data, sub, div, approximation, components, seed,
+      threads);
+}
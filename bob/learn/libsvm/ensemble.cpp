@@ -0,0 +1,378 @@
+/**
+ * @date Thu 15 Oct 2026 19:12:37 CEST
+ *
+ * @brief Bindings for ensembles of machines
+ *
+ * Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+ */
+
+#define BOB_LEARN_LIBSVM_MODULE
+#include <bob.blitz/cppapi.h>
+#include <bob.blitz/cleanup.h>
+#include <bob.learn.libsvm/api.h>
+
+/************************************************
+ * Implementation of bob.learn.libsvm.Ensemble *
+ ************************************************/
+
+PyDoc_STRVAR(s_ensemble_str, BOB_EXT_MODULE_PREFIX ".Ensemble");
+
+PyDoc_STRVAR(s_ensemble_doc,
+"Ensemble(machines)\n\
+\n\
+Many :py:class:`Machine` objects, with the same input size, that\n\
+score the same inputs together.\n\
+\n\
+Inputs are scaled once per distinct set of scaling parameters,\n\
+and support vectors shared by several machines (with the same\n\
+scaling and kernel) are stored once, so that their kernel values\n\
+are only computed once per input. Scores are stacked in a single\n\
+matrix, with the scores of each machine starting at the column\n\
+given by :py:attr:`offsets`. They are the same as the ones of\n\
+:py:meth:`Machine.predict_class_and_scores`, up to rounding.\n\
+\n\
+The ensemble keeps copies of everything it needs from\n\
+``machines``, an iterable of :py:class:`Machine` objects, which\n\
+may be modified afterwards. Machines with pre-computed kernels are\n\
+not supported.\n\
+\n\
+");
+
+static int PyBobLearnLibsvmEnsemble_init
+(PyBobLearnLibsvmEnsembleObject* self, PyObject* args, PyObject* kwds) {
+
+  /* Parses input arguments in a single shot */
+  static const char* const_kwlist[] = {"machines", 0};
+  static char** kwlist = const_cast<char**>(const_kwlist);
+
+  PyObject* machines = 0;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O", kwlist,
+        &machines)) return -1;
+
+  PyObject* seq = PySequence_Fast(machines, "`machines' should be an iterable of bob.learn.libsvm.Machine objects");
+  if (!seq) return -1;
+  auto seq_ = make_safe(seq);
+
+  //the ensemble copies what it needs: machines are not owned
+  std::vector<boost::shared_ptr<const bob::learn::libsvm::Machine> > cxx;
+  for (Py_ssize_t k=0; k<PySequence_Fast_GET_SIZE(seq); ++k) {
+    PyObject* o = PySequence_Fast_GET_ITEM(seq, k);
+    if (!PyBobLearnLibsvmMachine_Check(o)) {
+      PyErr_Format(PyExc_TypeError, "`%s' requires bob.learn.libsvm.Machine objects, but object %" PY_FORMAT_SIZE_T "d is of type `%s'", Py_TYPE(self)->tp_name, k, Py_TYPE(o)->tp_name);
+      return -1;
+    }
+    auto m = reinterpret_cast<PyBobLearnLibsvmMachineObject*>(o);
+    cxx.push_back(boost::shared_ptr<const bob::learn::libsvm::Machine>(m->cxx,
+          [](const bob::learn::libsvm::Machine*) {}));
+  }
+
+  try {
+    self->cxx = new bob::learn::libsvm::Ensemble(cxx);
+  }
+  catch (std::exception& ex) {
+    PyErr_SetString(PyExc_RuntimeError, ex.what());
+    return -1;
+  }
+  catch (...) {
+    PyErr_Format(PyExc_RuntimeError, "cannot create new object of type `%s' - unknown exception thrown", Py_TYPE(self)->tp_name);
+    return -1;
+  }
+
+  return 0;
+
+}
+
+static void PyBobLearnLibsvmEnsemble_delete
+(PyBobLearnLibsvmEnsembleObject* self) {
+
+  delete self->cxx;
+  Py_TYPE(self)->tp_free((PyObject*)self);
+
+}
+
+PyDoc_STRVAR(s_shape_str, "shape");
+PyDoc_STRVAR(s_shape_doc,
+"A tuple with the size of the input vector, followed by the\n\
+total number of scores, over all machines, in the format\n\
+``(input, output)``.\n\
+");
+
+static PyObject* PyBobLearnLibsvmEnsemble_getShape
+(PyBobLearnLibsvmEnsembleObject* self, void* /*closure*/) {
+  return Py_BuildValue("(nn)", self->cxx->inputSize(),
+      self->cxx->outputSize());
+}
+
+PyDoc_STRVAR(s_offsets_str, "offsets");
+PyDoc_STRVAR(s_offsets_doc,
+"The column of the first score of each machine, in the stacked\n\
+scores, followed by the total number of scores: the scores of\n\
+machine ``i`` are in columns ``offsets[i]:offsets[i+1]``.\n\
+");
+
+static PyObject* PyBobLearnLibsvmEnsemble_getOffsets
+(PyBobLearnLibsvmEnsembleObject* self, void* /*closure*/) {
+  size_t n = self->cxx->size();
+  PyObject* retval = PyList_New(n + 1);
+  if (!retval) return 0;
+  for (size_t k=0; k<n; ++k) {
+    PyList_SET_ITEM(retval, k, Py_BuildValue("n", self->cxx->scoreOffset(k)));
+  }
+  PyList_SET_ITEM(retval, n, Py_BuildValue("n", self->cxx->outputSize()));
+  return retval;
+}
+
+PyDoc_STRVAR(s_support_vectors_str, "support_vectors");
+PyDoc_STRVAR(s_support_vectors_doc,
+"A tuple with the number of support vectors of all machines, and\n\
+the number of distinct ones, whose kernel values are computed for\n\
+each input, in the format ``(total, unique)``.\n\
+");
+
+static PyObject* PyBobLearnLibsvmEnsemble_getSupportVectors
+(PyBobLearnLibsvmEnsembleObject* self, void* /*closure*/) {
+  return Py_BuildValue("(nn)", self->cxx->supportVectors(),
+      self->cxx->uniqueSupportVectors());
+}
+
+PyDoc_STRVAR(s_scalings_str, "scalings");
+PyDoc_STRVAR(s_scalings_doc,
+"The number of distinct sets of scaling parameters, inputs are\n\
+scaled once for each\n\
+");
+
+static PyObject* PyBobLearnLibsvmEnsemble_getScalings
+(PyBobLearnLibsvmEnsembleObject* self, void* /*closure*/) {
+  return Py_BuildValue("n", self->cxx->scalings());
+}
+
+static PyGetSetDef PyBobLearnLibsvmEnsemble_getseters[] = {
+    {
+      s_shape_str,
+      (getter)PyBobLearnLibsvmEnsemble_getShape,
+      0,
+      s_shape_doc,
+      0
+    },
+    {
+      s_offsets_str,
+      (getter)PyBobLearnLibsvmEnsemble_getOffsets,
+      0,
+      s_offsets_doc,
+      0
+    },
+    {
+      s_support_vectors_str,
+      (getter)PyBobLearnLibsvmEnsemble_getSupportVectors,
+      0,
+      s_support_vectors_doc,
+      0
+    },
+    {
+      s_scalings_str,
+      (getter)PyBobLearnLibsvmEnsemble_getScalings,
+      0,
+      s_scalings_doc,
+      0
+    },
+    {0}  /* Sentinel */
+};
+
+static Py_ssize_t PyBobLearnLibsvmEnsemble_len
+(PyBobLearnLibsvmEnsembleObject* self) {
+  return self->cxx->size();
+}
+
+static PySequenceMethods PyBobLearnLibsvmEnsemble_sequence = {
+    (lenfunc)PyBobLearnLibsvmEnsemble_len,            /* sq_length */
+    0,                                                /* sq_concat */
+    0,                                                /* sq_repeat */
+    0,                                                /* sq_item */
+    0,                                                /* sq_slice */
+    0,                                                /* sq_ass_item */
+    0,                                                /* sq_ass_slice */
+    0,                                                /* sq_contains */
+    0,                                                /* sq_inplace_concat */
+    0,                                                /* sq_inplace_repeat */
+};
+
+PyDoc_STRVAR(s_predict_str, "predict_class_and_scores");
+PyDoc_STRVAR(s_predict_doc,
+"o.predict_class_and_scores(input, [threads=1]) -> (array, array)\n\
+\n\
+o(input, [threads=1]) -> (array, array)\n\
+\n\
+Calculates the **predicted classes** and the scores of all\n\
+machines, given one single feature vector or multiple ones, in a\n\
+1D or 2D 64-bit float array. Returns a tuple with the predicted\n\
+classes, in an ``int64`` array with one column per machine, and\n\
+the stacked scores, in a ``float64`` array with as many columns as\n\
+all machines have scores (see :py:attr:`offsets`). Outputs are 1D\n\
+if ``input`` is 1D.\n\
+\n\
+Rows are split between ``threads`` workers (zero means one per\n\
+core). The Python global interpreter lock is released during the\n\
+computation.\n\
+\n\
+");
+
+static PyObject* PyBobLearnLibsvmEnsemble_predict
+(PyBobLearnLibsvmEnsembleObject* self, PyObject* args, PyObject* kwds) {
+
+  static const char* const_kwlist[] = {"input", "threads", 0};
+  static char** kwlist = const_cast<char**>(const_kwlist);
+
+  PyBlitzArrayObject* input = 0;
+  Py_ssize_t threads = 1;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&|n", kwlist,
+        &PyBlitzArray_Converter, &input, &threads)) return 0;
+
+  auto input_ = make_safe(input);
+
+  if (threads < 0) {
+    PyErr_Format(PyExc_ValueError, "`%s' requires a non-negative number of `threads' (or zero, to use all available cores), not %" PY_FORMAT_SIZE_T "d", Py_TYPE(self)->tp_name, threads);
+    return 0;
+  }
+
+  if (input->type_num != NPY_FLOAT64) {
+    PyErr_Format(PyExc_TypeError, "`%s' only supports 64-bit float arrays for input array `input'", Py_TYPE(self)->tp_name);
+    return 0;
+  }
+
+  if (input->ndim < 1 || input->ndim > 2) {
+    PyErr_Format(PyExc_TypeError, "`%s' only accepts 1 or 2-dimensional arrays (not %" PY_FORMAT_SIZE_T "dD arrays)", Py_TYPE(self)->tp_name, input->ndim);
+    return 0;
+  }
+
+  Py_ssize_t ndim = input->ndim;
+  Py_ssize_t columns = input->shape[ndim-1];
+  if (columns != (Py_ssize_t)self->cxx->inputSize()) {
+    PyErr_Format(PyExc_RuntimeError, "`input' array should have %" PY_FORMAT_SIZE_T "d columns, matching `%s' input size, not %" PY_FORMAT_SIZE_T "d", self->cxx->inputSize(), Py_TYPE(self)->tp_name, columns);
+    return 0;
+  }
+  Py_ssize_t rows = (ndim == 1) ? 1 : input->shape[0];
+
+  Py_ssize_t csize[2] = {rows, (Py_ssize_t)self->cxx->size()};
+  PyObject* cls = PyBlitzArray_SimpleNew(NPY_INT64, 2, csize);
+  if (!cls) return 0;
+  auto cls_ = make_safe(cls);
+
+  Py_ssize_t osize[2] = {rows, (Py_ssize_t)self->cxx->outputSize()};
+  PyObject* score = PyBlitzArray_SimpleNew(NPY_FLOAT64, 2, osize);
+  if (!score) return 0;
+  auto score_ = make_safe(score);
+
+  try {
+    auto bzcls = PyBlitzArrayCxx_AsBlitz<int64_t,2>(reinterpret_cast<PyBlitzArrayObject*>(cls));
+    auto bzscore = PyBlitzArrayCxx_AsBlitz<double,2>(reinterpret_cast<PyBlitzArrayObject*>(score));
+    if (ndim == 1) {
+      blitz::Array<double,2> bzin(1, columns);
+      bzin(0, blitz::Range::all()) = *PyBlitzArrayCxx_AsBlitz<double,1>(input);
+      self->cxx->predict_(bzin, *bzcls, *bzscore);
+    }
+    else {
+      auto bzin = PyBlitzArrayCxx_AsBlitz<double,2>(input);
+      PyBobLearnLibsvmNoGIL nogil;
+      self->cxx->predict_(*bzin, *bzcls, *bzscore, threads);
+    }
+  }
+  catch (std::exception& e) {
+    PyErr_SetString(PyExc_RuntimeError, e.what());
+    return 0;
+  }
+  catch (...) {
+    PyErr_Format(PyExc_RuntimeError, "%s cannot forward data: unknown exception caught", Py_TYPE(self)->tp_name);
+    return 0;
+  }
+
+  //1D inputs produce 1D outputs
+  if (ndim == 1) {
+    Py_ssize_t n = self->cxx->size();
+    PyObject* flat_cls = PyBlitzArray_SimpleNew(NPY_INT64, 1, &n);
+    if (!flat_cls) return 0;
+    *PyBlitzArrayCxx_AsBlitz<int64_t,1>(reinterpret_cast<PyBlitzArrayObject*>(flat_cls)) = (*PyBlitzArrayCxx_AsBlitz<int64_t,2>(reinterpret_cast<PyBlitzArrayObject*>(cls)))(0, blitz::Range::all());
+    cls_ = make_safe(flat_cls);
+    cls = flat_cls;
+
+    Py_ssize_t k = self->cxx->outputSize();
+    PyObject* flat = PyBlitzArray_SimpleNew(NPY_FLOAT64, 1, &k);
+    if (!flat) return 0;
+    *PyBlitzArrayCxx_AsBlitz<double,1>(reinterpret_cast<PyBlitzArrayObject*>(flat)) = (*PyBlitzArrayCxx_AsBlitz<double,2>(reinterpret_cast<PyBlitzArrayObject*>(score)))(0, blitz::Range::all());
+    score_ = make_safe(flat);
+    score = flat;
+  }
+
+  Py_INCREF(cls);
+  Py_INCREF(score);
+  return Py_BuildValue("OO",
+      PyBlitzArray_NUMPY_WRAP(cls),
+      PyBlitzArray_NUMPY_WRAP(score)
+      );
+
+}
+
+static PyMethodDef PyBobLearnLibsvmEnsemble_methods[] = {
+  {
+    s_predict_str,
+    (PyCFunction)PyBobLearnLibsvmEnsemble_predict,
+    METH_VARARGS|METH_KEYWORDS,
+    s_predict_doc
+  },
+  {0} /* Sentinel */
+};
+
+static PyObject* PyBobLearnLibsvmEnsemble_new
+(PyTypeObject* type, PyObject*, PyObject*) {
+
+  /* Allocates the python object itself */
+  PyBobLearnLibsvmEnsembleObject* self =
+    (PyBobLearnLibsvmEnsembleObject*)type->tp_alloc(type, 0);
+
+  self->cxx = 0;
+
+  return reinterpret_cast<PyObject*>(self);
+
+}
+
+PyTypeObject PyBobLearnLibsvmEnsemble_Type = {
+    PyVarObject_HEAD_INIT(0, 0)
+    s_ensemble_str,                                   /* tp_name */
+    sizeof(PyBobLearnLibsvmEnsembleObject),           /* tp_basicsize */
+    0,                                                /* tp_itemsize */
+    (destructor)PyBobLearnLibsvmEnsemble_delete,      /* tp_dealloc */
+    0,                                                /* tp_print */
+    0,                                                /* tp_getattr */
+    0,                                                /* tp_setattr */
+    0,                                                /* tp_compare */
+    0,                                                /* tp_repr */
+    0,                                                /* tp_as_number */
+    &PyBobLearnLibsvmEnsemble_sequence,               /* tp_as_sequence */
+    0,                                                /* tp_as_mapping */
+    0,                                                /* tp_hash */
+    (ternaryfunc)PyBobLearnLibsvmEnsemble_predict,    /* tp_call */
+    0,                                                /* tp_str */
+    0,                                                /* tp_getattro */
+    0,                                                /* tp_setattro */
+    0,                                                /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,         /* tp_flags */
+    s_ensemble_doc,                                   /* tp_doc */
+    0,                                                /* tp_traverse */
+    0,                                                /* tp_clear */
+    0,                                                /* tp_richcompare */
+    0,                                                /* tp_weaklistoffset */
+    0,                                                /* tp_iter */
+    0,                                                /* tp_iternext */
+    PyBobLearnLibsvmEnsemble_methods,                 /* tp_methods */
+    0,                                                /* tp_members */
+    PyBobLearnLibsvmEnsemble_getseters,               /* tp_getset */
+    0,                                                /* tp_base */
+    0,                                                /* tp_dict */
+    0,                                                /* tp_descr_get */
+    0,                                                /* tp_descr_set */
+    0,                                                /* tp_dictoffset */
+    (initproc)PyBobLearnLibsvmEnsemble_init,          /* tp_init */
+    0,                                                /* tp_alloc */
+    PyBobLearnLibsvmEnsemble_new,                     /* tp_new */
+};
@@ -71,6 +71,7 @@ static int PyBobLearnLibsvmFile_init
 #endif
 
   try {
+    PyBobLearnLibsvmNoGIL nogil; ///< the file is scanned once, on opening
     self->cxx = new bob::learn::libsvm::File(c_filename);
   }
   catch (std::exception& ex) {
@@ -407,6 +408,10 @@ provided, they will be allocated internally and returned.\n\
    reset as by calling :py:meth:`reset` before the\n\
    readout starts.\n\
 \n\
+The Python global interpreter lock is released while the file\n\
+is parsed, so that different files may be read concurrently.\n\
+Do not share the same object between threads, though.\n\
+\n\
 ");
 
 static PyObject* PyBobLearnLibsvmFile_read_all
@@ -435,8 +440,9 @@ static PyObject* PyBobLearnLibsvmFile_read_all
     return 0;
   }
 
-  if (values && values->type_num != NPY_FLOAT64) {
-    PyErr_Format(PyExc_TypeError, "`%s' only supports 64-bit float arrays for output array `values'", Py_TYPE(self)->tp_name);
+  if (values && values->type_num != NPY_FLOAT64 &&
+      values->type_num != NPY_FLOAT32) {
+    PyErr_Format(PyExc_TypeError, "`%s' only supports 32 or 64-bit float arrays for output array `values'", Py_TYPE(self)->tp_name);
     return 0;
   }
 
@@ -483,19 +489,16 @@ static PyObject* PyBobLearnLibsvmFile_read_all
 
   /** all basic checks are done, can call the machine now **/
   try {
+    PyBobLearnLibsvmNoGIL nogil; ///< only touches C++ objects bellow
     self->cxx->reset();
     auto bzlab = PyBlitzArrayCxx_AsBlitz<int64_t,1>(labels);
-    auto bzval = PyBlitzArrayCxx_AsBlitz<double,2>(values);
-    blitz::Range all = blitz::Range::all();
-    int k = 0;
-    
-    while ((self->cxx->good()) && ((size_t)k < self->cxx->samples())) {
-      blitz::Array<double,1> v_ = (*bzval)(k, all);
-      
-      int label = 0;
-      bool ok = self->cxx->read_(label, v_);
-      if (ok) (*bzlab)(k) = label;
-      ++k;
+    if (values->type_num == NPY_FLOAT32) {
+      auto bzval = PyBlitzArrayCxx_AsBlitz<float,2>(values);
+      self->cxx->readAll(*bzlab, *bzval);
+    }
+    else {
+      auto bzval = PyBlitzArrayCxx_AsBlitz<double,2>(values);
+      self->cxx->readAll(*bzlab, *bzval);
     }
   }
   catch (std::exception& e) {
@@ -516,6 +519,161 @@ static PyObject* PyBobLearnLibsvmFile_read_all
 
 }
 
+PyDoc_STRVAR(s_read_csr_str, "read_csr");
+PyDoc_STRVAR(s_read_csr_doc,
+"o.read_csr() -> (array, array, array, array)\n\
+\n\
+Reads all contents of the file in compressed sparse row (CSR)\n\
+format, without allocating space for the zeros that are not\n\
+stored in the file. Returns a tuple ``(labels, indptr, indices,\n\
+values)``, where ``labels`` contains each entry's label (as with\n\
+:py:meth:`read_all`) and the features of entry ``i`` are the\n\
+``values[indptr[i]:indptr[i+1]]``, at the (zero-based) columns\n\
+``indices[indptr[i]:indptr[i+1]]``. The last three arrays can be\n\
+used to build a :py:class:`scipy.sparse.csr_matrix` of shape\n\
+``(o.samples, o.shape)``, which can be directly fed to\n\
+:py:class:`Machine` and :py:class:`Trainer` objects. ``labels``,\n\
+``indptr`` and ``indices`` have data type ``int64``, while\n\
+``values`` are ``float64``.\n\
+\n\
+.. note::\n\
+\n\
+   Like :py:meth:`read_all`, this method resets the file\n\
+   before the readout starts.\n\
+\n\
+The Python global interpreter lock is released while the file\n\
+is parsed, so that different files may be read concurrently.\n\
+Do not share the same object between threads, though.\n\
+\n\
+");
+
+static PyObject* PyBobLearnLibsvmFile_read_csr
+(PyBobLearnLibsvmFileObject* self) {
+
+  // before doing anything, check file status and returns if that is the case
+  if (!self->cxx->good()) Py_RETURN_NONE;
+
+  Py_ssize_t samples = self->cxx->samples();
+  Py_ssize_t rows = samples + 1;
+  Py_ssize_t entries = self->cxx->nonZeros();
+
+  PyBlitzArrayObject* labels = (PyBlitzArrayObject*)PyBlitzArray_SimpleNew(NPY_INT64, 1, &samples);
+  if (!labels) return 0;
+  auto labels_ = make_safe(labels);
+  PyBlitzArrayObject* indptr = (PyBlitzArrayObject*)PyBlitzArray_SimpleNew(NPY_INT64, 1, &rows);
+  if (!indptr) return 0;
+  auto indptr_ = make_safe(indptr);
+  PyBlitzArrayObject* indices = (PyBlitzArrayObject*)PyBlitzArray_SimpleNew(NPY_INT64, 1, &entries);
+  if (!indices) return 0;
+  auto indices_ = make_safe(indices);
+  PyBlitzArrayObject* values = (PyBlitzArrayObject*)PyBlitzArray_SimpleNew(NPY_FLOAT64, 1, &entries);
+  if (!values) return 0;
+  auto values_ = make_safe(values);
+
+  try {
+    PyBobLearnLibsvmNoGIL nogil; ///< only touches C++ objects bellow
+    self->cxx->reset();
+    auto bzlab = PyBlitzArrayCxx_AsBlitz<int64_t,1>(labels);
+    auto bzptr = PyBlitzArrayCxx_AsBlitz<int64_t,1>(indptr);
+    auto bzidx = PyBlitzArrayCxx_AsBlitz<int64_t,1>(indices);
+    auto bzval = PyBlitzArrayCxx_AsBlitz<double,1>(values);
+    self->cxx->readCSR(*bzlab, *bzptr, *bzidx, *bzval);
+  }
+  catch (std::exception& e) {
+    PyErr_SetString(PyExc_RuntimeError, e.what());
+    return 0;
+  }
+  catch (...) {
+    PyErr_Format(PyExc_RuntimeError, "%s cannot read data: unknown exception caught", Py_TYPE(self)->tp_name);
+    return 0;
+  }
+
+  Py_INCREF(labels);
+  Py_INCREF(indptr);
+  Py_INCREF(indices);
+  Py_INCREF(values);
+  return Py_BuildValue("OOOO",
+      PyBlitzArray_NUMPY_WRAP(reinterpret_cast<PyObject*>(labels)),
+      PyBlitzArray_NUMPY_WRAP(reinterpret_cast<PyObject*>(indptr)),
+      PyBlitzArray_NUMPY_WRAP(reinterpret_cast<PyObject*>(indices)),
+      PyBlitzArray_NUMPY_WRAP(reinterpret_cast<PyObject*>(values))
+      );
+
+}
+
+PyDoc_STRVAR(s_read_chunks_str, "read_chunks");
+PyDoc_STRVAR(s_read_chunks_doc,
+"o.read_chunks(size, [sparse=False, [threads=1]]) -> iterator\n\
+\n\
+Returns an iterator over the contents of the file, in chunks of\n\
+(at most) ``size`` consecutive entries, so that large files can\n\
+be processed with bounded memory. Each chunk is a tuple\n\
+``(labels, values)``, like the output of :py:meth:`read_all`, or,\n\
+if ``sparse`` is set, a tuple ``(labels, indptr, indices,\n\
+values)`` as returned by :py:meth:`read_csr`, with row pointers\n\
+relative to the start of the chunk. Every chunk is returned\n\
+in new arrays.\n\
+\n\
+While a chunk is being processed by the caller, the next one is\n\
+parsed in the background, with (up to) ``threads`` threads (zero\n\
+means one per hardware thread). Iteration does not interfere with\n\
+:py:meth:`read`, :py:meth:`reset` and the other methods of this\n\
+object.\n\
+\n\
+");
+
+static PyObject* PyBobLearnLibsvmFile_read_chunks
+(PyBobLearnLibsvmFileObject* self, PyObject* args, PyObject* kwds) {
+
+  /* Parses input arguments in a single shot */
+  static const char* const_kwlist[] = {"size", "sparse", "threads", 0};
+  static char** kwlist = const_cast<char**>(const_kwlist);
+
+  Py_ssize_t size = 0;
+  PyObject* sparse = Py_False;
+  Py_ssize_t threads = 1;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "n|On", kwlist,
+        &size, &sparse, &threads)) return 0;
+
+  if (size <= 0) {
+    PyErr_Format(PyExc_ValueError, "`%s' chunks should contain, at least, one entry - you asked for %" PY_FORMAT_SIZE_T "d", Py_TYPE(self)->tp_name, size);
+    return 0;
+  }
+
+  if (threads < 0) {
+    PyErr_Format(PyExc_ValueError, "`%s' cannot read chunks with a negative number of threads (%" PY_FORMAT_SIZE_T "d)", Py_TYPE(self)->tp_name, threads);
+    return 0;
+  }
+
+  int is_sparse = PyObject_IsTrue(sparse);
+  if (is_sparse < 0) return 0;
+
+  PyBobLearnLibsvmFileChunksObject* retval = (PyBobLearnLibsvmFileChunksObject*)PyBobLearnLibsvmFileChunks_Type.tp_alloc(&PyBobLearnLibsvmFileChunks_Type, 0);
+  if (!retval) return 0;
+  retval->cxx = 0;
+  Py_INCREF(self);
+  retval->file = reinterpret_cast<PyObject*>(self);
+  auto retval_ = make_safe(retval);
+
+  try {
+    retval->cxx = new bob::learn::libsvm::ChunkReader(*self->cxx, size,
+        is_sparse, threads);
+  }
+  catch (std::exception& e) {
+    PyErr_SetString(PyExc_RuntimeError, e.what());
+    return 0;
+  }
+  catch (...) {
+    PyErr_Format(PyExc_RuntimeError, "%s cannot read chunks: unknown exception caught", Py_TYPE(self)->tp_name);
+    return 0;
+  }
+
+  Py_INCREF(retval);
+  return reinterpret_cast<PyObject*>(retval);
+
+}
+
 static PyMethodDef PyBobLearnLibsvmFile_methods[] = {
   {
     s_reset_str,
@@ -553,6 +711,18 @@ static PyMethodDef PyBobLearnLibsvmFile_methods[] = {
     METH_VARARGS|METH_KEYWORDS,
     s_read_all_doc
   },
+  {
+    s_read_csr_str,
+    (PyCFunction)PyBobLearnLibsvmFile_read_csr,
+    METH_NOARGS,
+    s_read_csr_doc
+  },
+  {
+    s_read_chunks_str,
+    (PyCFunction)PyBobLearnLibsvmFile_read_chunks,
+    METH_VARARGS|METH_KEYWORDS,
+    s_read_chunks_doc
+  },
   {0} /* Sentinel */
 };
 
@@ -609,3 +779,125 @@ PyTypeObject PyBobLearnLibsvmFile_Type = {
     0,                                             /* tp_alloc */
     PyBobLearnLibsvmFile_new,                      /* tp_new */
 };
+
+/************************************************
+ * Iterator over chunks of Support Vector Files *
+ ************************************************/
+
+PyDoc_STRVAR(s_file_chunks_str, BOB_EXT_MODULE_PREFIX ".FileChunks");
+
+static void PyBobLearnLibsvmFileChunks_delete
+(PyBobLearnLibsvmFileChunksObject* self) {
+
+  if (self->cxx) {
+    PyBobLearnLibsvmNoGIL nogil; ///< waits for the background thread
+    delete self->cxx;
+  }
+  Py_XDECREF(self->file);
+  Py_TYPE(self)->tp_free((PyObject*)self);
+
+}
+
+/**
+ * Returns a new array with a copy of ``a``, or 0 with a Python exception set
+ */
+template <typename T, int N>
+static PyObject* copy_array(const blitz::Array<T,N>& a) {
+  Py_ssize_t shape[N];
+  for (int i=0; i<N; ++i) shape[i] = a.extent(i);
+  PyObject* retval = PyBlitzArray_SimpleNew(PyBlitzArrayCxx_CToTypenum<T>(), N, shape);
+  if (!retval) return 0;
+  *PyBlitzArrayCxx_AsBlitz<T,N>(reinterpret_cast<PyBlitzArrayObject*>(retval)) = a;
+  return retval;
+}
+
+static PyObject* PyBobLearnLibsvmFileChunks_next
+(PyBobLearnLibsvmFileChunksObject* self) {
+
+  const bob::learn::libsvm::ChunkReader::Chunk* chunk = 0;
+
+  try {
+    PyBobLearnLibsvmNoGIL nogil; ///< only touches C++ objects bellow
+    chunk = self->cxx->next();
+  }
+  catch (std::exception& e) {
+    PyErr_SetString(PyExc_RuntimeError, e.what());
+    return 0;
+  }
+  catch (...) {
+    PyErr_Format(PyExc_RuntimeError, "%s cannot read data: unknown exception caught", Py_TYPE(self)->tp_name);
+    return 0;
+  }
+
+  if (!chunk) return 0; ///< stops the iteration
+
+  // the chunk is re-used by the reader: outputs are copies
+  if (!self->cxx->sparse()) {
+    PyObject* labels = copy_array(chunk->labels);
+    if (!labels) return 0;
+    auto labels_ = make_safe(labels);
+    PyObject* values = copy_array(chunk->values);
+    if (!values) return 0;
+    auto values_ = make_safe(values);
+    Py_INCREF(labels);
+    Py_INCREF(values);
+    return Py_BuildValue("OO",
+        PyBlitzArray_NUMPY_WRAP(labels),
+        PyBlitzArray_NUMPY_WRAP(values)
+        );
+  }
+
+  PyObject* labels = copy_array(chunk->labels);
+  if (!labels) return 0;
+  auto labels_ = make_safe(labels);
+  PyObject* indptr = copy_array(chunk->indptr);
+  if (!indptr) return 0;
+  auto indptr_ = make_safe(indptr);
+  PyObject* indices = copy_array(chunk->indices);
+  if (!indices) return 0;
+  auto indices_ = make_safe(indices);
+  PyObject* values = copy_array(chunk->data);
+  if (!values) return 0;
+  auto values_ = make_safe(values);
+  Py_INCREF(labels);
+  Py_INCREF(indptr);
+  Py_INCREF(indices);
+  Py_INCREF(values);
+  return Py_BuildValue("OOOO",
+      PyBlitzArray_NUMPY_WRAP(labels),
+      PyBlitzArray_NUMPY_WRAP(indptr),
+      PyBlitzArray_NUMPY_WRAP(indices),
+      PyBlitzArray_NUMPY_WRAP(values)
+      );
+
+}
+
+PyTypeObject PyBobLearnLibsvmFileChunks_Type = {
+    PyVarObject_HEAD_INIT(0, 0)
+    s_file_chunks_str,                             /* tp_name */
+    sizeof(PyBobLearnLibsvmFileChunksObject),      /* tp_basicsize */
+    0,                                             /* tp_itemsize */
+    (destructor)PyBobLearnLibsvmFileChunks_delete, /* tp_dealloc */
+    0,                                             /* tp_print */
+    0,                                             /* tp_getattr */
+    0,                                             /* tp_setattr */
+    0,                                             /* tp_compare */
+    0,                                             /* tp_repr */
+    0,                                             /* tp_as_number */
+    0,                                             /* tp_as_sequence */
+    0,                                             /* tp_as_mapping */
+    0,                                             /* tp_hash */
+    0,                                             /* tp_call */
+    0,                                             /* tp_str */
+    0,                                             /* tp_getattro */
+    0,                                             /* tp_setattro */
+    0,                                             /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                            /* tp_flags */
+    s_read_chunks_doc,                             /* tp_doc */
+    0,                                             /* tp_traverse */
+    0,                                             /* tp_clear */
+    0,                                             /* tp_richcompare */
+    0,                                             /* tp_weaklistoffset */
+    PyObject_SelfIter,                             /* tp_iter */
+    (iternextfunc)PyBobLearnLibsvmFileChunks_next, /* tp_iternext */
+};
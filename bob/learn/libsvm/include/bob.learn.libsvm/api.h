@@ -12,7 +12,11 @@
 #include <bob.learn.libsvm/config.h>
 #include <bob.learn.libsvm/file.h>
 #include <bob.learn.libsvm/machine.h>
+#include <bob.learn.libsvm/multiclass.h>
+#include <bob.learn.libsvm/approximate.h>
+#include <bob.learn.libsvm/ensemble.h>
 #include <bob.learn.libsvm/trainer.h>
+#include <bob.learn.libsvm/server.h>
 
 #define BOB_LEARN_LIBSVM_MODULE_PREFIX bob.learn.libsvm
 #define BOB_LEARN_LIBSVM_MODULE_NAME _library
@@ -137,6 +141,18 @@ typedef struct {
 
   PyBobLearnLibsvmFile_Check_RET PyBobLearnLibsvmFile_Check PyBobLearnLibsvmFile_Check_PROTO;
 
+  /**
+   * Iterators returned by File.read_chunks(), that own the C++ reader and
+   * keep a reference to the file being read
+   */
+  typedef struct {
+    PyObject_HEAD
+    PyObject* file;
+    bob::learn::libsvm::ChunkReader* cxx;
+  } PyBobLearnLibsvmFileChunksObject;
+
+  extern PyTypeObject PyBobLearnLibsvmFileChunks_Type;
+
   /******************************************
    * Bindings for bob.learn.libsvm.Machine *
    ******************************************/
@@ -147,6 +163,62 @@ typedef struct {
 
   PyBobLearnLibsvmMachine_NewFromMachine_RET PyBobLearnLibsvmMachine_NewFromMachine PyBobLearnLibsvmMachine_NewFromMachine_PROTO;
 
+  /***************************************************
+   * Bindings for bob.learn.libsvm.OneVsRestMachine *
+   ***************************************************/
+
+  typedef struct {
+    PyObject_HEAD
+    bob::learn::libsvm::OneVsRestMachine* cxx;
+  } PyBobLearnLibsvmOneVsRestMachineObject;
+
+  extern PyTypeObject PyBobLearnLibsvmOneVsRestMachine_Type;
+
+  /**
+   * Wraps ``m`` in a new Python object, that takes ownership of it
+   */
+  PyObject* PyBobLearnLibsvmOneVsRestMachine_NewFromMachine
+    (bob::learn::libsvm::OneVsRestMachine* m);
+
+  /*****************************************************
+   * Bindings for bob.learn.libsvm.ApproximateMachine *
+   *****************************************************/
+
+  typedef struct {
+    PyObject_HEAD
+    bob::learn::libsvm::ApproximateMachine* cxx;
+  } PyBobLearnLibsvmApproximateMachineObject;
+
+  extern PyTypeObject PyBobLearnLibsvmApproximateMachine_Type;
+
+  /**
+   * Wraps ``m`` in a new Python object, that takes ownership of it
+   */
+  PyObject* PyBobLearnLibsvmApproximateMachine_NewFromMachine
+    (bob::learn::libsvm::ApproximateMachine* m);
+
+  /*********************************************
+   * Bindings for bob.learn.libsvm.Ensemble *
+   *********************************************/
+
+  typedef struct {
+    PyObject_HEAD
+    bob::learn::libsvm::Ensemble* cxx;
+  } PyBobLearnLibsvmEnsembleObject;
+
+  extern PyTypeObject PyBobLearnLibsvmEnsemble_Type;
+
+  /*****************************************************
+   * Bindings for bob.learn.libsvm.PredictionServer *
+   *****************************************************/
+
+  typedef struct {
+    PyObject_HEAD
+    bob::learn::libsvm::PredictionServer* cxx;
+  } PyBobLearnLibsvmPredictionServerObject;
+
+  extern PyTypeObject PyBobLearnLibsvmPredictionServer_Type;
+
   /******************************************
    * Bindings for bob.learn.libsvm.Trainer *
    ******************************************/
@@ -171,6 +243,51 @@ typedef struct {
 
   PyBobLearnLibsvm_CStringAsKernelType_RET PyBobLearnLibsvm_CStringAsKernelType PyBobLearnLibsvm_CStringAsKernelType_PROTO;
 
+  /**
+   * Converts kernel approximations to and from their names, ``'FOURIER'``
+   * and ``'NYSTROM'``. Conversions from names return -1, with a Python
+   * exception set, on errors.
+   */
+  PyObject* PyBobLearnLibsvm_ApproximationAsString
+    (bob::learn::libsvm::approximation_t s);
+
+  bob::learn::libsvm::approximation_t PyBobLearnLibsvm_CStringAsApproximation
+    (const char* s);
+
+  /**
+   * Tells if ``o`` looks like a sparse matrix in CSR format, such as a
+   * ``scipy.sparse.csr_matrix``: an object with ``indptr``, ``indices``,
+   * ``data`` and ``shape`` attributes
+   */
+  int PyBobLearnLibsvm_IsSparse(PyObject* o);
+
+  /**
+   * Converts an object that passes PyBobLearnLibsvm_IsSparse() into a sparse
+   * matrix. Indices are converted to 64-bit integers and values to 64-bit
+   * floats, if required. Arrays are otherwise referenced, and kept alive
+   * for the lifetime of the returned object, which must be released with
+   * the GIL held. Returns an empty pointer, with a Python exception set, on
+   * errors.
+   */
+  boost::shared_ptr<bob::learn::libsvm::SparseMatrix>
+    PyBobLearnLibsvm_AsSparse(PyObject* o);
+
+  /**
+   * Releases the GIL for the lifetime of this object. Only use it around
+   * calls that do not touch any Python object. Because the GIL is
+   * re-acquired on destruction, exceptions may be translated into Python
+   * errors as usual, in the enclosing catch handlers.
+   */
+  class PyBobLearnLibsvmNoGIL {
+    public:
+      PyBobLearnLibsvmNoGIL(): m_state(PyEval_SaveThread()) {}
+      ~PyBobLearnLibsvmNoGIL() { PyEval_RestoreThread(m_state); }
+    private:
+      PyBobLearnLibsvmNoGIL(const PyBobLearnLibsvmNoGIL&);
+      PyBobLearnLibsvmNoGIL& operator=(const PyBobLearnLibsvmNoGIL&);
+      PyThreadState* m_state;
+  };
+
 #else
 
   /* This section is used in modules that use `bob.learn.libsvm's' C-API */
@@ -0,0 +1,311 @@
+/**
+ * @date Wed 14 Oct 2026 18:24:07 CEST
+ *
+ * @brief Linear machines working on explicit, approximate, RBF kernel
+ * feature maps
+ *
+ * Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+ */
+
+#ifndef BOB_LEARN_LIBSVM_APPROXIMATE_H
+#define BOB_LEARN_LIBSVM_APPROXIMATE_H
+
+#include <vector>
+#include <stdint.h>
+#include <boost/shared_ptr.hpp>
+#include <blitz/array.h>
+#include <bob.io.base/HDF5File.h>
+#include <bob.learn.libsvm/engine.h>
+
+namespace bob { namespace learn { namespace libsvm {
+
+  /**
+   * Explicit feature maps approximating an RBF kernel
+   */
+  typedef enum approximation_t {
+    FOURIER = 0, ///< random Fourier features
+    NYSTROM ///< Nyström method, on a random subset of the training samples
+  } approximation_t;
+
+  /**
+   * Maps inputs into a space of ``outputSize()`` components, where dot
+   * products approximate the RBF kernel exp(-gamma * ||x-y||^2) between the
+   * original inputs.
+   *
+   * Random Fourier features are sqrt(2/D) * cos(<w_i,x> + b_i), where the
+   * D projections w_i are drawn from a normal distribution of variance
+   * 2*gamma and the offsets b_i uniformly from [0, 2*pi). The Nyström map
+   * evaluates the kernel between the input and D landmarks, which are then
+   * multiplied by the inverse of the Cholesky factor of the kernel matrix of
+   * the landmarks, so that dot products in the mapped space are the Nyström
+   * approximation of the kernel.
+   *
+   * Maps work on batches of inputs, as matrix products, with the SIMD block
+   * functions of DenseEngine. Objects of this class are immutable after
+   * construction and may be shared between threads and machines.
+   */
+  class KernelMap {
+
+    public: //api
+
+      /**
+       * Draws a new random Fourier map for inputs with ``input_size``
+       * features, from a generator initialized with ``seed``
+       */
+      static boost::shared_ptr<KernelMap> fourier(size_t input_size,
+          size_t components, double gamma, uint32_t seed);
+
+      /**
+       * Builds a new Nyström map with the given ``landmarks``, one per row,
+       * already scaled like the inputs will be
+       */
+      static boost::shared_ptr<KernelMap> nystrom
+        (const blitz::Array<double,2>& landmarks, double gamma);
+
+      /**
+       * Loads a map saved with save()
+       */
+      KernelMap(bob::io::base::HDF5File& config);
+
+      /**
+       * The kind of map
+       */
+      approximation_t approximation() const { return m_approximation; }
+
+      /**
+       * The gamma of the approximated RBF kernel
+       */
+      double gamma() const { return m_gamma; }
+
+      /**
+       * Number of input features and of mapped components
+       */
+      size_t inputSize() const { return m_input_size; }
+      size_t outputSize() const { return m_output_size; }
+
+      /**
+       * Size of inputs and of outputs, after padding. Inputs and outputs of
+       * map() are rows of this size, aligned to ENGINE_ALIGNMENT, with
+       * padding elements set to zero.
+       */
+      size_t paddedInputSize() const { return m_padded_input; }
+      size_t paddedOutputSize() const { return m_padded_output; }
+
+      /**
+       * Name of the instruction set used by the block functions bellow
+       */
+      const char* instructionSet() const { return m_isa; }
+
+      /**
+       * The block functions chosen for the running CPU, that may be used
+       * on the mapped features
+       */
+      DenseEngine::block_function dot() const { return m_dot; }
+      DenseEngine::gemm_function gemm() const { return m_gemm; }
+
+      /**
+       * The number of doubles required as scratch space to map ``n`` inputs
+       */
+      size_t workspaceSize(size_t n) const;
+
+      /**
+       * Maps ``n`` consecutive padded inputs into ``n`` consecutive padded
+       * outputs
+       */
+      void map(const double* input, size_t n, double* output,
+          double* work) const;
+
+      /**
+       * Saves the map into the current group of a configuration file
+       */
+      void save(bob::io::base::HDF5File& config) const;
+
+    private: //methods
+
+      /**
+       * Builds an empty map, filled by the factory methods
+       */
+      KernelMap(approximation_t approximation, size_t input_size,
+          size_t components, double gamma);
+
+      /**
+       * Copies ``basis`` (one row per component) into the padded rows of
+       * m_basis
+       */
+      void setBasis(const blitz::Array<double,2>& basis);
+
+      /**
+       * Computes the transform of Nyström maps from the landmarks
+       */
+      void factorize();
+
+    private: //not implemented
+
+      KernelMap(const KernelMap& other);
+      KernelMap& operator= (const KernelMap& other);
+
+    private: //representation
+
+      approximation_t m_approximation;
+      double m_gamma;
+      size_t m_input_size; ///< number of features
+      size_t m_output_size; ///< number of components
+      size_t m_padded_input; ///< number of features, with padding
+      size_t m_padded_output; ///< number of components, with padding
+      aligned_vector m_basis; ///< projections or landmarks, row-major
+      std::vector<double> m_offset; ///< phases of Fourier features
+      std::vector<double> m_basis_norm; ///< squared norms of landmarks
+      aligned_vector m_transform; ///< inverse Cholesky factor of landmarks
+      DenseEngine::block_function m_dot;
+      DenseEngine::gemm_function m_gemm;
+      const char* m_isa; ///< name of the instruction set chosen
+
+  };
+
+  /**
+   * A linear classifier working on the features of a KernelMap, which makes
+   * it an approximation of an RBF machine whose prediction costs depend on
+   * the number of components of the map, instead of the number of support
+   * vectors. Binary machines (labels +1 and -1, in that order) produce a
+   * single score per input, positive for the first label, and multi-class
+   * machines one score per class, one-vs-rest.
+   *
+   * Like Machine, inputs are scaled before being mapped and prediction
+   * methods do not modify the object, which may be shared by many threads.
+   */
+  class ApproximateMachine {
+
+    public: //api
+
+      /**
+       * Builds a new machine from a feature ``map`` and the ``weights`` (one
+       * row of map->outputSize() values per score) and ``bias`` of each
+       * score. There is a single score for 2 ``labels`` and one per label
+       * otherwise. Scaling parameters are set to identities.
+       */
+      ApproximateMachine(boost::shared_ptr<const KernelMap> map,
+          const blitz::Array<double,2>& weights,
+          const blitz::Array<double,1>& bias, const std::vector<int>& labels);
+
+      /**
+       * Builds a new machine from an HDF5 file containing a machine saved
+       * with save(), including the map and the scaling parameters
+       */
+      ApproximateMachine(bob::io::base::HDF5File& config);
+
+      /**
+       * Copies the weights and scaling parameters of ``other``, sharing its
+       * (immutable) feature map
+       */
+      ApproximateMachine(const ApproximateMachine& other);
+
+      /**
+       * Virtual d'tor
+       */
+      virtual ~ApproximateMachine();
+
+      /**
+       * Tells the input size this machine expects
+       */
+      size_t inputSize() const { return m_map->inputSize(); }
+
+      /**
+       * Tells the number of scores produced for each input
+       */
+      size_t outputSize() const { return m_bias.size(); }
+
+      /**
+       * Tells the number of classes and the label of class ``i``
+       */
+      size_t numberOfClasses() const { return m_labels.size(); }
+      int classLabel(size_t i) const { return m_labels[i]; }
+
+      /**
+       * The feature map used by this machine
+       */
+      const KernelMap& map() const { return *m_map; }
+
+      /**
+       * Returns the weights (one row per score) and biases
+       */
+      blitz::Array<double,2> getWeights() const;
+      blitz::Array<double,1> getBias() const;
+
+      /**
+       * Input scaling parameters, applied before mapping: x' = (x-sub)/div
+       */
+      const blitz::Array<double,1>& getInputSubtraction() const
+      { return m_input_sub; }
+      void setInputSubtraction(const blitz::Array<double,1>& v);
+      const blitz::Array<double,1>& getInputDivision() const
+      { return m_input_div; }
+      void setInputDivision(const blitz::Array<double,1>& v);
+
+      /**
+       * Predicts the class of a single input
+       */
+      int predictClass(const blitz::Array<double,1>& input) const;
+
+      /**
+       * Predicts the class and the scores of a single input. ``scores``
+       * should have outputSize() positions.
+       */
+      int predictClassAndScores(const blitz::Array<double,1>& input,
+          blitz::Array<double,1>& scores) const;
+
+      /**
+       * Predicts the classes of all rows in ``input``, which are mapped and
+       * scored in batches, with up to ``threads`` workers (zero means one
+       * per hardware thread).
+       */
+      void predictClass(const blitz::Array<double,2>& input,
+          blitz::Array<int64_t,1>& labels, size_t threads=1) const;
+
+      /**
+       * Predicts the classes and scores of all rows in ``input``.
+       * ``scores`` should have as many rows as ``input`` and outputSize()
+       * columns.
+       */
+      void predictClassAndScores(const blitz::Array<double,2>& input,
+          blitz::Array<int64_t,1>& labels, blitz::Array<double,2>& scores,
+          size_t threads=1) const;
+
+      /**
+       * Saves the whole machine into a configuration file: weights, labels
+       * and scaling parameters go to the current group and the map to a
+       * sub-group called "map"
+       */
+      void save(bob::io::base::HDF5File& config) const;
+
+    private: //not implemented
+
+      ApproximateMachine& operator= (const ApproximateMachine& other);
+
+    private: //methods
+
+      /**
+       * Checks weights, biases and labels are consistent with the map
+       */
+      void check() const;
+
+      /**
+       * Scales, maps and scores rows [start, end) of ``input``, in batches
+       */
+      void predict_(const blitz::Array<double,2>& input, size_t start,
+          size_t end, blitz::Array<int64_t,1>& labels,
+          blitz::Array<double,2>& scores) const;
+
+    private: //representation
+
+      boost::shared_ptr<const KernelMap> m_map;
+      aligned_vector m_weights; ///< one padded row per score
+      std::vector<double> m_bias; ///< one per score
+      std::vector<int> m_labels; ///< class labels
+      blitz::Array<double,1> m_input_sub; ///< scaling: subtraction
+      blitz::Array<double,1> m_input_div; ///< scaling: division
+
+  };
+
+}}}
+
+#endif /* BOB_LEARN_LIBSVM_APPROXIMATE_H */
@@ -0,0 +1,356 @@
+/**
+ * @date Wed 14 Oct 2026 09:03:18 CEST
+ *
+ * @brief Dense, vectorized, evaluation of libsvm models
+ *
+ * Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+ */
+
+#ifndef BOB_LEARN_LIBSVM_ENGINE_H
+#define BOB_LEARN_LIBSVM_ENGINE_H
+
+#include <vector>
+#include <string>
+#include <boost/align/aligned_allocator.hpp>
+#include <svm.h>
+#include <bob.learn.libsvm/memory.h>
+#include <bob.learn.libsvm/probability.h>
+#include <bob.learn.libsvm/stats.h>
+
+namespace bob { namespace learn { namespace libsvm {
+
+  /**
+   * A vector of doubles that is aligned for SIMD use
+   */
+  typedef std::vector<double,
+          boost::alignment::aligned_allocator<double, ENGINE_ALIGNMENT> >
+            aligned_vector;
+
+  /**
+   * A vector of floats that is aligned for SIMD use
+   */
+  typedef std::vector<float,
+          boost::alignment::aligned_allocator<float, ENGINE_ALIGNMENT> >
+            aligned_float_vector;
+
+  /**
+   * Evaluates a libsvm model using a dense representation of its support
+   * vectors, stored row-major in an aligned matrix, with rows padded with
+   * zeros to a multiple of the SIMD width. Kernels are evaluated for blocks
+   * of support vectors at once, using the best instruction set available on
+   * the running CPU (AVX-512, AVX2 + FMA or plain C++), chosen at run time.
+   *
+   * Linear models are collapsed at construction time: each decision
+   * function is then a single, primal, weight vector (the sum of its
+   * support vectors, weighted by their coefficients), so prediction costs
+   * one dot product per pair of classes, whatever the number of support
+   * vectors.
+   *
+   * Inputs may also be evaluated in batches of up to BATCH_SIZE. Support
+   * vectors are then processed in tiles that fit in the cache, using the
+   * expansion ||x - sv||^2 = ||x||^2 + ||sv||^2 - 2<x,sv> for RBF kernels
+   * (with cached norms for the support vectors), so that most of the work
+   * is a matrix product between the inputs and each tile. The same
+   * expansion is used for single inputs, so that batch results are exactly
+   * the same as those obtained one input at a time.
+   *
+   * Results are the same as with libsvm's svm_predict_values() and
+   * svm_predict_probability(), up to rounding: decision values are
+   * accumulated in the same order, but dot products are not.
+   *
+   * In single precision, support vectors (or primal weights) are stored as
+   * floats, which halves their size and doubles the number of SIMD lanes
+   * for dot products. Inputs are rounded to floats in the workspace and
+   * products are summed in floats, lane by lane, but lanes are added up in
+   * double precision. Squared norms (for RBF kernels), kernel values and
+   * decision values are always computed in double precision.
+   *
+   * Support vectors (or primal weights) may be backed by huge pages, which
+   * spares TLB misses when they take hundreds of megabytes. They live on the
+   * NUMA node of the thread that builds the engine, as pages are placed
+   * where they are first touched.
+   *
+   * Objects of this class are immutable after construction and hold copies
+   * of everything they need from the model: they can be shared between
+   * threads and between machines.
+   */
+  class DenseEngine {
+
+    public: //api
+
+      /**
+       * Maximum number of inputs evaluated at once, in batch mode
+       */
+      static const size_t BATCH_SIZE = 8;
+
+      /**
+       * Builds a dense engine for the given model, that works on inputs with
+       * ``input_size`` features. If ``single`` is set, support vectors are
+       * stored (and dot products computed) in single precision. Support
+       * vectors (or primal weights) are allocated with ``pages``.
+       */
+      DenseEngine(const svm_model* model, size_t input_size,
+          bool single=false, pages_t pages=DEFAULT_PAGES);
+
+      /**
+       * Tells if a model is worth being evaluated with a dense engine: the
+       * kernel must not be pre-computed and the dense representation of the
+       * support vectors (or of the primal weights, for linear models), in
+       * single or double precision, should not be much larger than the
+       * sparse one.
+       */
+      static bool suitable(const svm_model* model, size_t input_size,
+          bool single=false);
+
+      /**
+       * Name of the instruction set used for evaluating kernels
+       */
+      const char* instructionSet() const { return m_isa; }
+
+      /**
+       * Tells if support vectors are stored in single precision
+       */
+      bool single() const { return m_single; }
+
+      /**
+       * Tells if decision functions are evaluated using primal weights,
+       * which is the case for all linear models
+       */
+      bool primal() const { return !m_weights.empty() || !m_weights32.empty(); }
+
+      /**
+       * The size of dense inputs, after padding. Inputs given to the
+       * methods bellow must be aligned to ENGINE_ALIGNMENT and have this
+       * size, with padding elements set to zero.
+       */
+      size_t paddedSize() const { return m_padded_size; }
+
+      /**
+       * The number of decision values for each input: one per pair of
+       * classes for classification, a single one otherwise
+       */
+      size_t functions() const { return m_functions; }
+
+      /**
+       * The number of doubles required as scratch space by the methods
+       * bellow
+       */
+      size_t workspaceSize() const;
+
+      /**
+       * Same as svm_predict_values(): fills ``dec_values`` and returns the
+       * predicted label (or regression value). If ``times`` is set, the
+       * time spent on kernels and on voting is added to it, as for all
+       * methods bellow.
+       */
+      double predictValues(const double* input, double* dec_values,
+          double* work, PhaseTimes* times=0) const;
+
+      /**
+       * Same as svm_predict()
+       */
+      double predict(const double* input, double* work,
+          PhaseTimes* times=0) const;
+
+      /**
+       * Same as svm_predict_probability(): fills ``prob_estimates`` (one per
+       * class) if the model supports probabilities and returns the predicted
+       * label. Pairwise probabilities are coupled as set by ``coupling``
+       * (see ProbabilityEstimator).
+       */
+      double predictProbability(const double* input, double* prob_estimates,
+          double* work, PhaseTimes* times=0,
+          coupling_t coupling=ITERATIVE_COUPLING) const;
+
+      /**
+       * The number of doubles required as scratch space by the batch
+       * methods bellow
+       */
+      size_t batchWorkspaceSize() const;
+
+      /**
+       * Batch variant of predictValues(), for ``n`` (up to BATCH_SIZE)
+       * consecutive padded inputs. Fills ``n`` labels and ``n`` x
+       * functions() decision values.
+       */
+      void predictValues(const double* input, size_t n, double* labels,
+          double* dec_values, double* work, PhaseTimes* times=0) const;
+
+      /**
+       * Batch variant of predictProbability(), for ``n`` (up to BATCH_SIZE)
+       * consecutive padded inputs. Fills ``n`` labels and, if the model
+       * supports probabilities, ``n`` x nr_class probabilities.
+       */
+      void predictProbability(const double* input, size_t n, double* labels,
+          double* prob_estimates, double* work, PhaseTimes* times=0,
+          coupling_t coupling=ITERATIVE_COUPLING) const;
+
+    private: //methods
+
+      /**
+       * Adds ``coef`` times a sparse support vector to a dense row
+       */
+      void accumulate(const svm_node* sv, double coef, double* row) const;
+
+      /**
+       * Number of kernel values in the workspace (none in primal mode)
+       */
+      size_t kernelSize() const;
+
+      /**
+       * Number of doubles, at the end of the workspaces, that hold the
+       * inputs rounded to single precision (none in double precision)
+       */
+      size_t roundedSize(size_t n) const;
+
+      /**
+       * Rounds ``n`` padded inputs to single precision, into ``rounded``
+       */
+      void round(const double* input, size_t n, float* rounded) const;
+
+      /**
+       * Squared norm of a padded input, for RBF kernels
+       */
+      double norm(const double* input) const;
+      double norm(const float* input) const;
+
+      /**
+       * Dot products of ``n`` padded inputs with the ``rows`` rows of
+       * ``matrix``, in the precision of the inputs
+       */
+      void gemm(const double* input, size_t n, const double* matrix,
+          size_t rows, double* out) const;
+      void gemm(const float* input, size_t n, const float* matrix,
+          size_t rows, double* out) const;
+
+      /**
+       * Evaluates the kernel between the input and every support vector
+       */
+      template <typename T>
+      void kernel(const T* input, const T* sv, double* kvalue) const;
+
+      /**
+       * Batch evaluation of decision values, for inputs and support vectors
+       * (or weights) in the same precision
+       */
+      template <typename T>
+      void predictBatch(const T* input, const T* matrix, size_t n,
+          double* labels, double* dec_values, double* work,
+          PhaseTimes* times) const;
+
+      /**
+       * Turns ``n`` dot products into kernel values. For RBF kernels, the
+       * squared norms of the input and of the support vectors are used.
+       */
+      void transform(double* values, size_t n, double input_norm,
+          const double* sv_norm) const;
+
+      /**
+       * Accumulates into the decision values of ``n`` inputs the
+       * contributions of the support vectors in [tile_start, tile_end),
+       * whose kernel values are stored one row per input
+       */
+      void decideTile(const double* kvalue, size_t n, size_t tile_start,
+          size_t tile_end, double* dec_values) const;
+
+      /**
+       * Computes the decision values from the kernel values, like libsvm
+       */
+      void decide(const double* kvalue, double* dec_values) const;
+
+      /**
+       * Computes the decision values of a linear model directly from the
+       * input, using the primal weights
+       */
+      template <typename T>
+      void decidePrimal(const T* input, const T* weights,
+          double* dec_values) const;
+
+      /**
+       * Turns decision values into a prediction, like libsvm. ``vote`` is
+       * scratch space for one vote counter per class.
+       */
+      double output(double* dec_values, double* vote) const;
+
+    public: //types
+
+      /**
+       * Functions that compute, for ``rows`` consecutive rows of ``matrix``
+       * (``size`` columns each), the dot product with ``x``. ``size`` is a
+       * multiple of 8.
+       */
+      typedef void (*block_function)(const double* x, const double* matrix,
+          size_t rows, size_t size, double* out);
+
+      /**
+       * Functions that compute the dot products of ``nx`` consecutive inputs
+       * ``x`` with ``rows`` consecutive rows of ``matrix``, storing them in
+       * ``out`` (one row of ``rows`` values per input). Results are the
+       * same as with the matching block_function.
+       */
+      typedef void (*gemm_function)(const double* x, size_t nx,
+          const double* matrix, size_t rows, size_t size, double* out);
+
+      /**
+       * Chooses the fastest block functions for the running CPU, that may
+       * also be used for other dense computations, and returns the name of
+       * their instruction set. Inputs must then be aligned and padded like
+       * for the engines.
+       */
+      static const char* kernels(block_function& dot, gemm_function& gemm);
+
+      /**
+       * Single precision variants of the functions above. Products are
+       * summed in floats, lane by lane, and lanes in double precision.
+       * ``size`` is a multiple of 16.
+       */
+      typedef void (*float_block_function)(const float* x,
+          const float* matrix, size_t rows, size_t size, double* out);
+      typedef void (*float_gemm_function)(const float* x, size_t nx,
+          const float* matrix, size_t rows, size_t size, double* out);
+
+      /**
+       * Chooses the fastest single precision block functions for the
+       * running CPU, and returns the name of their instruction set
+       */
+      static const char* kernels(float_block_function& dot,
+          float_gemm_function& gemm);
+
+    private: //representation
+
+      int m_svm_type;
+      int m_kernel_type;
+      int m_degree;
+      double m_gamma;
+      double m_coef0;
+      int m_nr_class;
+      size_t m_l; ///< number of support vectors
+      size_t m_input_size; ///< number of features
+      size_t m_padded_size; ///< number of features, with padding
+      size_t m_functions; ///< number of decision functions
+      size_t m_tile; ///< number of support vectors per tile, in batch mode
+      bool m_single; ///< if support vectors are stored in single precision
+      ProbabilityEstimator m_estimator; ///< from decision values
+
+      model_vector m_sv; ///< support vectors, dense, row-major
+      model_vector m_weights; ///< primal weights, one row per function
+      model_float_vector m_sv32; ///< same as m_sv, in single precision
+      model_float_vector m_weights32; ///< same as m_weights, in single precision
+      std::vector<double> m_sv_norm; ///< squared norms of SVs, for RBF
+      std::vector<double> m_sv_coef; ///< (nr_class-1) x l coefficients
+      std::vector<double> m_rho;
+      std::vector<int> m_label;
+      std::vector<int> m_start; ///< index of 1st SV of each class
+      std::vector<int> m_nSV;
+
+      block_function m_dot;
+      gemm_function m_gemm;
+      float_block_function m_dot32;
+      float_gemm_function m_gemm32;
+      const char* m_isa; ///< name of the instruction set chosen
+
+  };
+
+}}}
+
+#endif /* BOB_LEARN_LIBSVM_ENGINE_H */
@@ -0,0 +1,191 @@
+/**
+ * @date Thu 15 Oct 2026 19:12:37 CEST
+ *
+ * @brief Ensembles of machines, evaluated together on the same inputs
+ *
+ * Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+ */
+
+#ifndef BOB_LEARN_LIBSVM_ENSEMBLE_H
+#define BOB_LEARN_LIBSVM_ENSEMBLE_H
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <blitz/array.h>
+#include <bob.learn.libsvm/engine.h>
+#include <bob.learn.libsvm/machine.h>
+
+namespace bob { namespace learn { namespace libsvm {
+
+  /**
+   * Many machines, with the same input size, that score the same inputs.
+   * Compared to calling each machine in turn, inputs are scaled once per
+   * distinct set of scaling parameters, and support vectors shared by
+   * several machines (with the same scaling and kernel) are stored once,
+   * so their kernel values are computed once per input. Kernels are
+   * evaluated with the dense engine's SIMD routines, on blocks of inputs.
+   *
+   * Machines are not referenced after construction: the ensemble holds
+   * copies of everything it needs and is immutable, so it may be shared by
+   * many threads. Scores are the same as with the dense engine (see
+   * DenseEngine), up to rounding.
+   */
+  class Ensemble {
+
+    public: //api
+
+      /**
+       * Builds an ensemble of ``machines``, which must all have the same
+       * input size and must not use pre-computed kernels
+       */
+      Ensemble(const std::vector<boost::shared_ptr<const Machine> >& machines);
+
+      /**
+       * Virtual d'tor
+       */
+      virtual ~Ensemble();
+
+      /**
+       * Tells the input size of all machines
+       */
+      size_t inputSize() const { return m_input_size; }
+
+      /**
+       * Tells the number of machines in the ensemble
+       */
+      size_t size() const { return m_models.size(); }
+
+      /**
+       * Tells the total number of scores, over all machines
+       */
+      size_t outputSize() const { return m_output_size; }
+
+      /**
+       * Returns the column of the first score of machine ``i``, in the
+       * stacked scores, and its number of scores (as many as with
+       * Machine::predictClassAndScores())
+       */
+      size_t scoreOffset(size_t i) const { return m_models[i].offset; }
+      size_t numberOfScores(size_t i) const { return m_models[i].functions; }
+
+      /**
+       * Tells the number of support vectors of all machines, and the number
+       * of distinct ones, whose kernel values are computed for each input
+       */
+      size_t supportVectors() const { return m_support_vectors; }
+      size_t uniqueSupportVectors() const { return m_unique; }
+
+      /**
+       * Tells the number of distinct sets of scaling parameters
+       */
+      size_t scalings() const { return m_scalings.size(); }
+
+      /**
+       * Predicts the classes and the scores of all machines for all rows of
+       * ``input``. ``labels`` should have as many rows as ``input`` and one
+       * column per machine; ``scores`` as many rows as ``input`` and
+       * outputSize() (C-contiguous) columns, the scores of each machine
+       * starting at scoreOffset(). Rows are split in contiguous blocks that
+       * are processed by up to ``threads`` workers (zero means one per
+       * hardware thread).
+       */
+      void predict(const blitz::Array<double,2>& input,
+          blitz::Array<int64_t,2>& labels, blitz::Array<double,2>& scores,
+          size_t threads=1) const;
+
+      /**
+       * Same as above, but does not check the input or output arrays
+       */
+      void predict_(const blitz::Array<double,2>& input,
+          blitz::Array<int64_t,2>& labels, blitz::Array<double,2>& scores,
+          size_t threads=1) const;
+
+    private: //types
+
+      /**
+       * Scaling parameters shared by some of the machines
+       */
+      struct Scaling {
+        std::vector<double> sub;
+        std::vector<double> scale; ///< reciprocals of the divisions
+        bool scaling; ///< false if inputs need no scaling at all
+      };
+
+      /**
+       * Distinct support vectors of machines with the same scaling and
+       * kernel, whose kernel values are computed together
+       */
+      struct KernelSet {
+        size_t scaling; ///< index of the scaling of inputs
+        int kernel_type;
+        int degree;
+        double gamma;
+        double coef0;
+        size_t rows; ///< number of support vectors
+        size_t offset; ///< of the first one, over all kernel sets
+        aligned_vector sv; ///< dense and padded, row-major
+        std::vector<double> norm; ///< squared norms, for RBF kernels
+      };
+
+      /**
+       * The decision functions of one machine, on the kernel values of a
+       * kernel set
+       */
+      struct Model {
+        size_t kernels; ///< index of the kernel set
+        int svm_type;
+        int nr_class;
+        size_t l; ///< number of support vectors
+        std::vector<size_t> sv; ///< their rows in the kernel set
+        std::vector<double> sv_coef; ///< (nr_class-1) x l coefficients
+        std::vector<double> rho;
+        std::vector<int> label;
+        std::vector<int> start; ///< index of 1st SV of each class
+        std::vector<int> nSV;
+        size_t offset; ///< of the first score, in the stacked scores
+        size_t functions; ///< number of scores
+      };
+
+    private: //methods
+
+      /**
+       * Scores ``n`` (up to DenseEngine::BATCH_SIZE) consecutive rows of
+       * the input, starting at ``row``, using ``work`` as scratch space
+       */
+      void predictBlock(const blitz::Array<double,2>& input, size_t row,
+          size_t n, blitz::Array<int64_t,2>& labels,
+          blitz::Array<double,2>& scores, double* work) const;
+
+      /**
+       * Computes the decision values of a model, from the kernel values of
+       * one input with the support vectors of its kernel set, and returns
+       * its prediction, like libsvm
+       */
+      double decide(const Model& model, const double* kvalue,
+          double* dec_values, double* vote) const;
+
+      /**
+       * Number of doubles of scratch space used by predictBlock()
+       */
+      size_t workspaceSize() const;
+
+    private: //representation
+
+      size_t m_input_size;
+      size_t m_padded_size; ///< of dense inputs and support vectors
+      size_t m_output_size;
+      size_t m_support_vectors;
+      size_t m_unique; ///< distinct support vectors, over all kernel sets
+      int m_max_class; ///< largest number of classes, for votes
+      std::vector<Scaling> m_scalings;
+      std::vector<KernelSet> m_kernels;
+      std::vector<Model> m_models;
+
+      DenseEngine::block_function m_dot;
+      DenseEngine::gemm_function m_gemm;
+
+  };
+
+}}}
+
+#endif /* BOB_LEARN_LIBSVM_ENSEMBLE_H */
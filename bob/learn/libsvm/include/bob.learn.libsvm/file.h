@@ -10,8 +10,13 @@
 #ifndef BOB_LEARN_LIBSVM_FILE_H
 #define BOB_LEARN_LIBSVM_FILE_H
 
+#include <vector>
+#include <exception>
 #include <blitz/array.h>
-#include <fstream>
+#include <boost/shared_ptr.hpp>
+
+namespace boost { class thread; }
+namespace boost { namespace interprocess { class mapped_region; } }
 
 namespace bob { namespace learn { namespace libsvm {
 
@@ -26,6 +31,11 @@ namespace bob { namespace learn { namespace libsvm {
    * point.
    *
    * Zero values are suppressed - this is a sparse format.
+   *
+   * The file is memory-mapped and scanned once, in parallel, on opening:
+   * that gives its shape and an index of where each sample starts, so that
+   * samples can then be parsed in any order, without re-scanning. Numbers
+   * are parsed by hand, without iostreams.
    */
   class File {
 
@@ -69,24 +79,208 @@ namespace bob { namespace learn { namespace libsvm {
        */
       bool read_(int& label, blitz::Array<double,1>& values);
 
+      /**
+       * Reads all samples in the file, in parallel, using up to ``threads``
+       * threads (zero means one per hardware thread). ``labels`` should have
+       * as many entries as samples() and ``values`` as many rows as
+       * samples() and as many columns as shape(). This does not change the
+       * current read position.
+       */
+      void readAll(blitz::Array<int64_t,1>& labels,
+          blitz::Array<double,2>& values, size_t threads=0) const;
+
+      /**
+       * Same as above, but only reads as many consecutive samples as there
+       * are entries in ``labels``, starting at sample ``start``
+       */
+      void readSamples(size_t start, blitz::Array<int64_t,1>& labels,
+          blitz::Array<double,2>& values, size_t threads=0) const;
+
+      /**
+       * Same as the two methods above, but stores values in single
+       * precision. Values are parsed in double precision, then rounded.
+       */
+      void readAll(blitz::Array<int64_t,1>& labels,
+          blitz::Array<float,2>& values, size_t threads=0) const;
+      void readSamples(size_t start, blitz::Array<int64_t,1>& labels,
+          blitz::Array<float,2>& values, size_t threads=0) const;
+
+      /**
+       * Returns the total number of ``index:value`` entries in the file
+       */
+      inline size_t nonZeros() const { return m_indptr.back(); }
+
+      /**
+       * Returns the number of ``index:value`` entries in the ``count``
+       * samples starting at sample ``start``
+       */
+      inline size_t nonZeros(size_t start, size_t count) const
+      { return m_indptr[start+count] - m_indptr[start]; }
+
+      /**
+       * Reads all samples in the file, in parallel, in compressed sparse row
+       * (CSR) format, like scipy.sparse.csr_matrix: the zero-based feature
+       * indices and the values of sample ``i`` are stored at positions
+       * [indptr(i), indptr(i+1)) of ``indices`` and ``values``, in the same
+       * order as in the file. ``labels`` should have samples() entries,
+       * ``indptr`` samples()+1 and both ``indices`` and ``values``
+       * nonZeros(). This does not change the current read position.
+       */
+      void readCSR(blitz::Array<int64_t,1>& labels,
+          blitz::Array<int64_t,1>& indptr, blitz::Array<int64_t,1>& indices,
+          blitz::Array<double,1>& values, size_t threads=0) const;
+
+      /**
+       * Same as above, but only reads as many consecutive samples as there
+       * are entries in ``labels``, starting at sample ``start``. ``indptr``
+       * starts at zero and ``indices`` and ``values`` should have
+       * nonZeros(start, labels.extent(0)) entries.
+       */
+      void readSamplesCSR(size_t start, blitz::Array<int64_t,1>& labels,
+          blitz::Array<int64_t,1>& indptr, blitz::Array<int64_t,1>& indices,
+          blitz::Array<double,1>& values, size_t threads=0) const;
+
       /**
        * Returns the name of the file being read.
        */
       inline const std::string& filename() const { return m_filename; }
 
       /**
-       * Tests if the file is still good to go.
+       * Tests if the file is still good to go. Like with a stream, trying to
+       * read past the last sample sets both the ``eof`` and ``fail``
+       * conditions, until reset() is called.
+       */
+      inline bool good() const { return !m_eof; }
+      inline bool eof() const { return m_eof; }
+      inline bool fail() const { return m_eof; }
+
+    private: //methods
+
+      /**
+       * Implement readAll() and readSamples(), in either precision
        */
-      inline bool good() const { return m_file.good(); }
-      inline bool eof() const { return m_file.eof(); }
-      inline bool fail() const { return m_file.fail(); }
+      template <typename T>
+      void readAll_(blitz::Array<int64_t,1>& labels,
+          blitz::Array<T,2>& values, size_t threads) const;
+      template <typename T>
+      void readSamples_(size_t start, blitz::Array<int64_t,1>& labels,
+          blitz::Array<T,2>& values, size_t threads) const;
+
+      /**
+       * Parses a sample, storing its values at ``values``, with consecutive
+       * elements ``stride`` positions apart. Values must be zeroed before.
+       */
+      template <typename T>
+      void parse(size_t sample, int& label, T* values,
+          ptrdiff_t stride) const;
+
+      /**
+       * Parses a sample, storing its zero-based feature indices and values
+       * consecutively
+       */
+      void parse(size_t sample, int& label, int64_t* indices,
+          double* values) const;
 
     private: //representation
 
       std::string m_filename; ///< The path to the file being read
-      std::ifstream m_file; ///< The file I'm reading.
+      boost::shared_ptr<boost::interprocess::mapped_region> m_region;
+      const char* m_data; ///< The contents of the file
+      size_t m_size; ///< The size of the file, in bytes
+      std::vector<size_t> m_offsets; ///< where each sample starts
+      std::vector<size_t> m_indptr; ///< where each sample's entries start
+      size_t m_current; ///< next sample to be read
+      bool m_eof; ///< set if a read was attempted past the last sample
       size_t m_shape; ///< Number of floats in samples
       size_t m_n_samples; ///< total number of samples at input file
+      bool m_c_locale; ///< if numbers can be parsed with strtod() directly
+
+  };
+
+  /**
+   * Reads a File in chunks of, at most, a fixed number of consecutive
+   * samples, so that files can be processed with bounded memory. Chunks are
+   * double-buffered: while the caller works on one chunk, the next one is
+   * parsed by a background thread. Samples can be read densely or in
+   * compressed sparse row (CSR) format, like with File::readCSR().
+   *
+   * The file must outlive the reader. Readers are not thread-safe.
+   */
+  class ChunkReader {
+
+    public: //types
+
+      /**
+       * A chunk of consecutive samples
+       */
+      struct Chunk {
+        size_t start; ///< index of the first sample in the file
+        size_t samples; ///< number of samples in this chunk
+        blitz::Array<int64_t,1> labels; ///< one label per sample
+        blitz::Array<double,2> values; ///< dense: samples x File::shape()
+        blitz::Array<int64_t,1> indptr; ///< sparse: samples+1 row pointers
+        blitz::Array<int64_t,1> indices; ///< sparse: zero-based features
+        blitz::Array<double,1> data; ///< sparse: values of the entries
+      };
+
+    public: //api
+
+      /**
+       * Starts reading ``file`` in chunks of ``size`` samples. If
+       * ``sparse`` is set, chunks are stored in CSR format. Each chunk is
+       * parsed with up to ``threads`` threads (zero means one per hardware
+       * thread).
+       */
+      ChunkReader(const File& file, size_t size, bool sparse=false,
+          size_t threads=1);
+
+      /**
+       * Waits for the background thread to finish
+       */
+      virtual ~ChunkReader();
+
+      /**
+       * Returns the next chunk, or a null pointer if the file is over. The
+       * chunk (and its arrays) are only valid until the next call: then,
+       * its memory is re-used for parsing the chunk that follows. Errors
+       * found while parsing the chunk are raised here.
+       */
+      const Chunk* next();
+
+      /**
+       * The maximum number of samples in each chunk
+       */
+      size_t size() const { return m_size; }
+
+      /**
+       * Tells if chunks are read in CSR format
+       */
+      bool sparse() const { return m_sparse; }
+
+    private: //not implemented
+
+      ChunkReader(const ChunkReader& other);
+      ChunkReader& operator= (const ChunkReader& other);
+
+    private: //methods
+
+      /**
+       * Starts parsing the next chunk of the file into the back buffer
+       */
+      void prefetch();
+
+    private: //representation
+
+      const File& m_file; ///< the file being read
+      size_t m_size; ///< number of samples per chunk
+      bool m_sparse; ///< if chunks are read in CSR format
+      size_t m_threads; ///< threads used to parse each chunk
+      size_t m_next; ///< first sample not yet handed to the background
+      Chunk m_chunks[2]; ///< the double buffer
+      Chunk* m_front; ///< chunk the caller works on
+      Chunk* m_back; ///< chunk being parsed
+      boost::shared_ptr<boost::thread> m_worker; ///< parses the back chunk
+      std::exception_ptr m_error; ///< error raised by the background thread
 
   };
 
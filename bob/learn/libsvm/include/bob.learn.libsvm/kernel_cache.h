@@ -0,0 +1,177 @@
+/**
+ * @date Wed 14 Oct 2026 17:11:42 CEST
+ *
+ * @brief Kernel rows shared by trainings on the same data
+ *
+ * Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+ */
+
+#ifndef BOB_LEARN_LIBSVM_KERNEL_CACHE_H
+#define BOB_LEARN_LIBSVM_KERNEL_CACHE_H
+
+#include <map>
+#include <vector>
+#include <stdint.h>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <svm.h>
+
+namespace bob { namespace learn { namespace libsvm {
+
+  /**
+   * A size-bounded store of kernel matrices, shared by all trainings that
+   * use the same samples and kernel parameters (kernel type, degree, gamma
+   * and coefficient 0), e.g. to try several costs or one-class machines with
+   * several values of nu on the same data. Each matrix is computed once and
+   * laid out in the format libsvm expects for PRECOMPUTED kernels, so the
+   * solver only looks kernel values up.
+   *
+   * Problems are identified by their contents, not by their address, so
+   * problems rebuilt from the same data find the matrices computed before.
+   * Matrices are looked up by a digest of the samples, and each keeps a
+   * copy of its samples, which are compared on lookup: problems whose
+   * digests collide replace each other, but never share a matrix.
+   * When the cache is full, the matrices used the longest time ago are
+   * evicted. Matrices that do not fit at all are not computed. All methods
+   * may be called concurrently.
+   */
+  class KernelCache {
+
+    public: //types
+
+      /**
+       * The kernel matrix of a problem with ``size()`` samples. Row ``i``
+       * starts with a node holding ``i+1`` (libsvm's sample serial number),
+       * followed by the kernel values between sample ``i`` and all samples,
+       * in order.
+       */
+      class Rows {
+
+        public: //api
+
+          /**
+           * Number of samples
+           */
+          size_t size() const { return m_size; }
+
+          /**
+           * Memory used by this matrix (and the copy of its samples), in
+           * bytes
+           */
+          size_t bytes() const { return m_bytes; }
+
+          /**
+           * The kernel row of sample ``i``, as libsvm nodes. libsvm never
+           * writes to the samples of a problem.
+           */
+          svm_node* row(size_t i) const {
+            return const_cast<svm_node*>(&m_nodes[i * (m_size + 2)]);
+          }
+
+        private: //representation
+
+          friend class KernelCache;
+
+          size_t m_size; ///< number of samples
+          size_t m_bytes; ///< memory used, counted from the start
+          std::vector<svm_node> m_samples; ///< of the problem, terminated
+          std::vector<svm_node> m_nodes; ///< all rows, one after the other
+          boost::mutex m_lock; ///< held while the rows are computed
+          bool m_ready; ///< set once the rows are computed
+          uint64_t m_used; ///< last time the rows were asked for
+
+      };
+
+    public: //api
+
+      /**
+       * Builds a new, empty, cache that may hold up to ``size_in_mb``
+       * megabytes of kernel matrices
+       */
+      KernelCache(double size_in_mb);
+
+      /**
+       * Returns the kernel matrix of ``problem`` for the kernel set in
+       * ``param``, computing it with up to ``threads`` threads (zero means
+       * one per hardware thread) if it is not stored yet. Callers asking for
+       * a matrix that is being computed wait for it to be ready. Returns an
+       * empty pointer if the matrix does not fit in the cache or if the
+       * kernel is PRECOMPUTED already.
+       *
+       * Matrices are kept alive by the returned pointers, even if they are
+       * evicted meanwhile.
+       */
+      boost::shared_ptr<const Rows> rows(const svm_problem& problem,
+          const svm_parameter& param, size_t threads=1);
+
+      /**
+       * Maximum amount of memory used by this cache
+       */
+      double getSizeInMb() const;
+
+      /**
+       * Changes the maximum amount of memory this cache may use, evicting
+       * matrices if required
+       */
+      void setSizeInMb(double size_in_mb);
+
+      /**
+       * Memory used by the matrices currently stored
+       */
+      double getUsedMb() const;
+
+      /**
+       * Number of matrices found in (respectively, added to) the cache
+       */
+      uint64_t hits() const;
+      uint64_t misses() const;
+
+      /**
+       * Removes all matrices from the cache
+       */
+      void clear();
+
+    private: //types
+
+      /**
+       * Identifies a kernel matrix: a digest of the samples of the problem,
+       * their number and the kernel parameters
+       */
+      struct key_t {
+        uint64_t digest;
+        size_t size;
+        int kernel_type;
+        int degree;
+        double gamma;
+        double coef0;
+        bool operator< (const key_t& other) const;
+      };
+
+    private: //methods
+
+      /**
+       * Evicts the least recently used matrices until ``bytes`` more fit in
+       * the cache. Must be called with the lock held.
+       */
+      void evict(size_t bytes);
+
+    private: //not implemented
+
+      KernelCache(const KernelCache& other);
+      KernelCache& operator= (const KernelCache& other);
+
+    private: //representation
+
+      mutable boost::mutex m_lock; ///< protects everything bellow
+      size_t m_capacity; ///< maximum size, in bytes
+      size_t m_used; ///< current size, in bytes
+      uint64_t m_clock; ///< increased at every request
+      uint64_t m_hits; ///< number of requests satisfied from the cache
+      uint64_t m_misses; ///< number of matrices computed
+      std::map<key_t, boost::shared_ptr<Rows> > m_rows; ///< stored matrices
+
+  };
+
+}}}
+
+#endif /* BOB_LEARN_LIBSVM_KERNEL_CACHE_H */
@@ -15,8 +15,13 @@
 #include <boost/shared_array.hpp>
 #include <blitz/array.h>
 #include <fstream>
+#include <vector>
 #include <svm.h>
 #include <bob.io.base/HDF5File.h>
+#include <bob.learn.libsvm/engine.h>
+#include <bob.learn.libsvm/prediction_cache.h>
+#include <bob.learn.libsvm/sparse.h>
+#include <bob.learn.libsvm/stats.h>
 
 // @cond SKIPDOXYGEN
 // We need to declare the svm_model type for libsvm < 3.0.0. The next bit of
@@ -62,6 +67,12 @@ namespace bob { namespace learn { namespace libsvm {
     PRECOMPUTED
   }; /* kernel type used on the machine */
 
+  enum engine_t {
+    LIBSVM_ENGINE, ///< libsvm's own (sparse) prediction routines
+    DENSE_ENGINE, ///< dense, vectorized kernel evaluation
+    DENSE_SINGLE_ENGINE ///< same as DENSE_ENGINE, in single precision
+  }; /* how predictions are computed */
+
     /**
      * @brief Chooses the correct temporary directory to use, like this:
      *
@@ -83,9 +94,10 @@ namespace bob { namespace learn { namespace libsvm {
    * Here is the problem: libsvm does not provide a simple way to extract the
    * information from the SVM structure. There are lots of cases and allocation
    * and re-allocation is not exactly trivial. To overcome these problems and
-   * still be able to save data in HDF5 format, we let libsvm pickle the data
-   * into a text file and then re-read it in binary. We save the outcome of
-   * this readout in a binary blob inside the HDF5 file.
+   * still be able to save data in HDF5 format, we pickle the model into
+   * libsvm's text format, in memory. The outcome is the same as what
+   * svm_save_model() would write to a file and is saved as a binary blob
+   * inside the HDF5 file.
    */
   blitz::Array<uint8_t,1> svm_pickle(const boost::shared_ptr<svm_model> model);
 
@@ -94,11 +106,108 @@ namespace bob { namespace learn { namespace libsvm {
    */
   boost::shared_ptr<svm_model> svm_unpickle(const blitz::Array<uint8_t,1>& buffer);
 
+  /**
+   * Returns a deep copy of the model, that does not depend on any memory
+   * held by the original (e.g. the training data of an svm_model returned by
+   * svm_train()). Values are copied exactly, with no rounding. Support
+   * vectors of precomputed kernels only keep their serial number.
+   *
+   * Models created by this function and svm_unpickle() hold all their arrays
+   * on a single block of memory, allocated with the model itself, and are
+   * released by their own deleter: they must never be handed to libsvm's
+   * model destruction routines.
+   */
+  boost::shared_ptr<svm_model> svm_copy(const boost::shared_ptr<svm_model> model);
+
+  /**
+   * Tells if the given file contains a model in our binary format, saved by
+   * svm_save_binary()
+   */
+  bool svm_is_binary(const std::string& filename);
+
+  /**
+   * Saves the model and scaling parameters in a compact binary format: a
+   * header, followed by contiguous arrays for the nodes of all support
+   * vectors, the coefficients and the remaining model parameters. The file
+   * is only valid for machines with the same byte order and layout of
+   * svm_node as the one writing it.
+   */
+  void svm_save_binary(const std::string& filename,
+      const boost::shared_ptr<svm_model> model, size_t input_size,
+      const blitz::Array<double,1>& input_subtract,
+      const blitz::Array<double,1>& input_divide);
+
+  /**
+   * Maps a file saved with svm_save_binary() in memory (read-only) and
+   * returns a model pointing directly at the mapped arrays: nothing is
+   * parsed or copied, so loading is almost instantaneous and pages are only
+   * read from disk when first used. The mapping is released together with
+   * the model. The input size and scaling parameters are returned via the
+   * other arguments.
+   */
+  boost::shared_ptr<svm_model> svm_map_binary(const std::string& filename,
+      size_t& input_size, blitz::Array<double,1>& input_subtract,
+      blitz::Array<double,1>& input_divide);
+
+  /**
+   * How closely a machine follows another one (typically, the machine it was
+   * compressed from) on a set of validation samples. See Machine::fidelity().
+   */
+  struct Fidelity {
+    size_t samples; ///< number of validation samples
+    double agreement; ///< fraction of samples predicted in the same class
+    double max_error; ///< largest absolute difference between scores
+    double mean_error; ///< mean absolute difference between scores
+  };
+
   /**
    * Interface to svm_model, from libsvm. Incorporates prediction.
+   *
+   * The prediction methods do not modify the machine. All scratch memory
+   * required to convert inputs into libsvm's format lives in a Workspace,
+   * either supplied by the caller or allocated for the duration of the call.
+   * A single machine can, therefore, be shared by many threads, as long as
+   * each of them uses its own Workspace and the scaling parameters are not
+   * changed while predictions are ongoing.
    */
   class Machine {
 
+    public: //types
+
+      /**
+       * Per-thread scratch memory for the re-entrant prediction methods.
+       * Buffers grow on demand, so the same workspace can be re-used with
+       * different machines. Workspaces are not thread-safe: use one for each
+       * thread calling into the machine.
+       */
+      class Workspace {
+
+        public: //api
+
+          /**
+           * Returns a buffer of, at least, ``size`` libsvm nodes
+           */
+          svm_node* nodes(size_t size);
+
+          /**
+           * Returns aligned scratch memory for, at least, ``size`` doubles
+           */
+          double* buffer(size_t size);
+
+          /**
+           * Returns memory for, at least, ``size`` doubles, separate from
+           * buffer()
+           */
+          double* values(size_t size);
+
+        private: //representation
+
+          std::vector<svm_node> m_nodes; ///< sparse input in libsvm format
+          aligned_vector m_buffer; ///< dense input and engine scratch space
+          std::vector<double> m_values; ///< decision values and probabilities
+
+      };
+
     public: //api
 
       /**
@@ -108,6 +217,9 @@ namespace bob { namespace learn { namespace libsvm {
        * parameters will be set to defaults (subtraction of 0.0 and division by
        * 1.0). If you need scaling to be applied, set it individually using the
        * appropriate methods bellow.
+       *
+       * If the file was saved with saveBinary(), it is memory-mapped instead
+       * and scaling parameters are loaded from it.
        */
       Machine(const std::string& model_file);
 
@@ -130,6 +242,15 @@ namespace bob { namespace learn { namespace libsvm {
        */
       Machine(boost::shared_ptr<svm_model> model);
 
+      /**
+       * Copies ``other``: the svm_model and the scaling parameters are deep
+       * copied, and the new machine gets its own, empty, prediction cache
+       * and statistics, with the same settings. The dense engine, its NUMA
+       * replicas and the probability estimator are immutable, so they are
+       * shared read-only with ``other``.
+       */
+      Machine(const Machine& other);
+
       /**
        * Virtual d'tor
        */
@@ -215,7 +336,8 @@ namespace bob { namespace learn { namespace libsvm {
       /**
        * Sets all input subtraction values to a specific value.
        */
-      inline void setInputSubtraction(double v) { m_input_sub = v; }
+      inline void setInputSubtraction(double v)
+      { m_input_sub = v; updateScaling(); }
 
       /**
        * Returns the input division factor
@@ -233,7 +355,8 @@ namespace bob { namespace learn { namespace libsvm {
       /**
        * Sets all input division values to a specific value.
        */
-      inline void setInputDivision(double v) { m_input_div = v; }
+      inline void setInputDivision(double v)
+      { m_input_div = v; updateScaling(); }
 
       /**
        * Predict, output classes only. Note that the number of labels in the
@@ -241,6 +364,13 @@ namespace bob { namespace learn { namespace libsvm {
        */
       int predictClass(const blitz::Array<double,1>& input) const;
 
+      /**
+       * Same as above, but uses the memory in the given workspace instead of
+       * allocating scratch space at every call.
+       */
+      int predictClass(const blitz::Array<double,1>& input,
+          Workspace& ws) const;
+
       /**
        * Predict, output classes only. Note that the number of labels in the
        * output "labels" array should be the same as the number of input.
@@ -249,6 +379,13 @@ namespace bob { namespace learn { namespace libsvm {
        */
       int predictClass_(const blitz::Array<double,1>& input) const;
 
+      /**
+       * Predict, output classes only, using the given workspace. Does not
+       * check the input.
+       */
+      int predictClass_(const blitz::Array<double,1>& input,
+          Workspace& ws) const;
+
       /**
        * Predicts class and scores output for each class on this SVM,
        *
@@ -259,6 +396,13 @@ namespace bob { namespace learn { namespace libsvm {
         (const blitz::Array<double,1>& input,
          blitz::Array<double,1>& scores) const;
 
+      /**
+       * Same as above, but uses the memory in the given workspace
+       */
+      int predictClassAndScores
+        (const blitz::Array<double,1>& input,
+         blitz::Array<double,1>& scores, Workspace& ws) const;
+
       /**
        * Predicts output class and scores. Same as above, but does not check
        */
@@ -266,6 +410,14 @@ namespace bob { namespace learn { namespace libsvm {
         (const blitz::Array<double,1>& input,
          blitz::Array<double,1>& scores) const;
 
+      /**
+       * Predicts output class and scores using the given workspace. Does not
+       * check the input.
+       */
+      int predictClassAndScores_
+        (const blitz::Array<double,1>& input,
+         blitz::Array<double,1>& scores, Workspace& ws) const;
+
       /**
        * Predict, output class and probabilities for each class on this SVM,
        * but only if the model supports it. Otherwise, throws a run-time
@@ -278,6 +430,13 @@ namespace bob { namespace learn { namespace libsvm {
         (const blitz::Array<double,1>& input,
          blitz::Array<double,1>& probabilities) const;
 
+      /**
+       * Same as above, but uses the memory in the given workspace
+       */
+      int predictClassAndProbabilities
+        (const blitz::Array<double,1>& input,
+         blitz::Array<double,1>& probabilities, Workspace& ws) const;
+
       /**
        * Predict, output class and probability, but only if the model supports
        * it. Same as above, but does not check
@@ -286,6 +445,141 @@ namespace bob { namespace learn { namespace libsvm {
         (const blitz::Array<double,1>& input,
          blitz::Array<double,1>& probabilities) const;
 
+      /**
+       * Predict, output class and probability using the given workspace. Does
+       * not check the input.
+       */
+      int predictClassAndProbabilities_
+        (const blitz::Array<double,1>& input,
+         blitz::Array<double,1>& probabilities, Workspace& ws) const;
+
+      /**
+       * Same as the unchecked methods above, for single precision inputs
+       */
+      int predictClass_(const blitz::Array<float,1>& input) const;
+      int predictClassAndScores_(const blitz::Array<float,1>& input,
+          blitz::Array<double,1>& scores) const;
+      int predictClassAndProbabilities_(const blitz::Array<float,1>& input,
+          blitz::Array<double,1>& probabilities) const;
+
+      /**
+       * Predicts the classes of all rows in ``input``, placing the results
+       * in ``labels``, that must have as many positions as there are rows in
+       * ``input``. Rows are split in contiguous blocks that are processed by
+       * up to ``threads`` workers, each with its own workspace. If
+       * ``threads`` is zero, use one worker per hardware thread.
+       */
+      void predictClass(const blitz::Array<double,2>& input,
+          blitz::Array<int64_t,1>& labels, size_t threads=1) const;
+
+      /**
+       * Same as above, but does not check the input or output arrays
+       */
+      void predictClass_(const blitz::Array<double,2>& input,
+          blitz::Array<int64_t,1>& labels, size_t threads=1) const;
+
+      /**
+       * Predicts the classes and scores of all rows in ``input``, in
+       * parallel. The array ``scores`` must have as many rows as ``input``
+       * and as many (C-contiguous) columns as scores produced for a single
+       * input.
+       */
+      void predictClassAndScores(const blitz::Array<double,2>& input,
+          blitz::Array<int64_t,1>& labels, blitz::Array<double,2>& scores,
+          size_t threads=1) const;
+
+      /**
+       * Same as above, but does not check the input or output arrays
+       */
+      void predictClassAndScores_(const blitz::Array<double,2>& input,
+          blitz::Array<int64_t,1>& labels, blitz::Array<double,2>& scores,
+          size_t threads=1) const;
+
+      /**
+       * Predicts the classes and probabilities of all rows in ``input``, in
+       * parallel. The array ``probabilities`` must have as many rows as
+       * ``input`` and as many (C-contiguous) columns as outputs.
+       */
+      void predictClassAndProbabilities(const blitz::Array<double,2>& input,
+          blitz::Array<int64_t,1>& labels,
+          blitz::Array<double,2>& probabilities, size_t threads=1) const;
+
+      /**
+       * Same as above, but does not check the input or output arrays
+       */
+      void predictClassAndProbabilities_(const blitz::Array<double,2>& input,
+          blitz::Array<int64_t,1>& labels,
+          blitz::Array<double,2>& probabilities, size_t threads=1) const;
+
+      /**
+       * Same as the batch methods above, for single precision inputs. Rows
+       * are scaled (in double precision) as they are predicted, so inputs
+       * are never copied as a whole.
+       */
+      void predictClass(const blitz::Array<float,2>& input,
+          blitz::Array<int64_t,1>& labels, size_t threads=1) const;
+      void predictClass_(const blitz::Array<float,2>& input,
+          blitz::Array<int64_t,1>& labels, size_t threads=1) const;
+      void predictClassAndScores(const blitz::Array<float,2>& input,
+          blitz::Array<int64_t,1>& labels, blitz::Array<double,2>& scores,
+          size_t threads=1) const;
+      void predictClassAndScores_(const blitz::Array<float,2>& input,
+          blitz::Array<int64_t,1>& labels, blitz::Array<double,2>& scores,
+          size_t threads=1) const;
+      void predictClassAndProbabilities(const blitz::Array<float,2>& input,
+          blitz::Array<int64_t,1>& labels,
+          blitz::Array<double,2>& probabilities, size_t threads=1) const;
+      void predictClassAndProbabilities_(const blitz::Array<float,2>& input,
+          blitz::Array<int64_t,1>& labels,
+          blitz::Array<double,2>& probabilities, size_t threads=1) const;
+
+      /**
+       * Predicts the classes of all rows of a sparse matrix, in parallel,
+       * without ever densifying it: rows are converted straight into
+       * libsvm's format (or scattered into the dense engine's buffers).
+       * Columns beyond inputSize() are ignored, like with dense inputs.
+       * Because zeros are not stored, the machine may only scale inputs by
+       * division: an exception is raised if the input subtraction is set.
+       */
+      void predictClass(const SparseMatrix& input,
+          blitz::Array<int64_t,1>& labels, size_t threads=1) const;
+
+      /**
+       * Same as above, but does not check the input or output arrays
+       */
+      void predictClass_(const SparseMatrix& input,
+          blitz::Array<int64_t,1>& labels, size_t threads=1) const;
+
+      /**
+       * Predicts the classes and scores of all rows of a sparse matrix, in
+       * parallel. Outputs are like for dense inputs.
+       */
+      void predictClassAndScores(const SparseMatrix& input,
+          blitz::Array<int64_t,1>& labels, blitz::Array<double,2>& scores,
+          size_t threads=1) const;
+
+      /**
+       * Same as above, but does not check the input or output arrays
+       */
+      void predictClassAndScores_(const SparseMatrix& input,
+          blitz::Array<int64_t,1>& labels, blitz::Array<double,2>& scores,
+          size_t threads=1) const;
+
+      /**
+       * Predicts the classes and probabilities of all rows of a sparse
+       * matrix, in parallel. Outputs are like for dense inputs.
+       */
+      void predictClassAndProbabilities(const SparseMatrix& input,
+          blitz::Array<int64_t,1>& labels,
+          blitz::Array<double,2>& probabilities, size_t threads=1) const;
+
+      /**
+       * Same as above, but does not check the input or output arrays
+       */
+      void predictClassAndProbabilities_(const SparseMatrix& input,
+          blitz::Array<int64_t,1>& labels,
+          blitz::Array<double,2>& probabilities, size_t threads=1) const;
+
       /**
        * Saves the current model state to a file. With this variant, the model
        * is saved on simpler libsvm model file that does not include the
@@ -300,26 +594,332 @@ namespace bob { namespace learn { namespace libsvm {
        */
       void save(bob::io::base::HDF5File& config) const;
 
-    private: //not implemented
+      /**
+       * Saves the whole machine, including scaling parameters, in a binary
+       * format that can be memory-mapped when reloaded, through the
+       * constructor taking a path.
+       */
+      void saveBinary(const std::string& filename) const;
 
-      Machine(const Machine& other);
+      /**
+       * Chooses how predictions are computed. With DENSE_ENGINE, support
+       * vectors are re-packed into a dense matrix and kernels are evaluated
+       * with SIMD instructions. Models that are too sparse for that (or that
+       * use pre-computed kernels) keep on using libsvm. Do not call this
+       * while other threads are using this machine.
+       *
+       * Linear models use DENSE_ENGINE by default: their support vectors are
+       * collapsed into one weight vector per decision function, so that
+       * prediction cost does not depend on the number of support vectors.
+       * All other models use LIBSVM_ENGINE by default.
+       *
+       * DENSE_SINGLE_ENGINE stores the dense support vectors in single
+       * precision, which halves their size and doubles the SIMD width, at
+       * the cost of about 7 significant digits on dot products (see
+       * DenseEngine).
+       */
+      void setEngine(engine_t engine);
+
+      /**
+       * Tells which engine is being used for predictions
+       */
+      engine_t engine() const;
+
+      /**
+       * Chooses how pairwise probabilities are coupled into class
+       * probabilities (see ProbabilityEstimator). ITERATIVE_COUPLING, the
+       * default, gives the same probabilities as libsvm.
+       * APPROXIMATE_COUPLING uses a closed form, which costs one division
+       * per pair of classes instead of libsvm's iterative solver: with it,
+       * probabilities cost about as much as scores, on all engines, but
+       * they differ from libsvm's for more than two classes. Drops all
+       * cached predictions. Do not call this while other threads are using
+       * this machine.
+       */
+      void setProbabilityCoupling(coupling_t coupling);
+      coupling_t getProbabilityCoupling() const { return m_coupling; }
+
+      /**
+       * Chooses how the arrays of the dense engines (support vectors or
+       * primal weights) are placed in memory: on huge pages, and replicated
+       * on each NUMA node of the host. With replicas, the workers of batch
+       * predictions are pinned to the nodes in turn and each reads the copy
+       * of its node, while single predictions read the copy of the node
+       * they run on. Replicas are only built on hosts with more than one
+       * NUMA node. LIBSVM_ENGINE keeps on using libsvm's own model. Rebuilds
+       * the dense engine, if set. Do not call this while other threads are
+       * using this machine.
+       */
+      void setMemoryPolicy(const MemoryPolicy& policy);
+      const MemoryPolicy& getMemoryPolicy() const { return m_memory; }
+
+      /**
+       * Tells how many copies of the dense engine this machine keeps: one
+       * per NUMA node if they are replicated, one if not, and none if
+       * predictions use libsvm
+       */
+      size_t replicas() const;
+
+      /**
+       * Starts (or stops) collecting statistics on predictions. They are
+       * not collected by default; when they are, each call reads the clock
+       * a few times and adds to the counters with atomic operations, once
+       * per call or, in batch calls, once per block of rows. Time spent in
+       * libsvm's own routines (LIBSVM_ENGINE) is accounted as kernel time,
+       * as they vote internally. Copies collect their own statistics.
+       */
+      void setCollectStatistics(bool v);
+      bool getCollectStatistics() const { return (bool)m_counters; }
+
+      /**
+       * Returns the statistics collected so far, all zeroes if they are not
+       * collected
+       */
+      PredictionStatistics getStatistics() const;
+
+      /**
+       * Sets all statistics back to zero
+       */
+      void resetStatistics();
+
+      /**
+       * Keeps the predictions of recent inputs, up to ``size_in_mb``
+       * megabytes, in a PredictionCache keyed by the scaled inputs, so that
+       * inputs seen again are not predicted again. Zero, the default, turns
+       * the cache off. Setting the size, or the engine, drops all cached
+       * predictions. Copies start with their own, empty, cache of the same
+       * size. Cached predictions are counted in the statistics as if they
+       * were computed, but they are much faster.
+       */
+      void setCacheSize(double size_in_mb);
+      double getCacheSize() const;
+
+      /**
+       * Returns the counters of the cache, all zeroes if it is off
+       */
+      CacheStatistics getCacheStatistics() const;
+
+      /**
+       * Drops all cached predictions and sets the cache counters to zero
+       */
+      void clearCache();
+
+      /**
+       * Returns a new machine, with less support vectors than this one, whose
+       * scores never differ by more than ``max_error`` from the scores of
+       * this machine, whatever the input. Scaling parameters and the engine
+       * are the same as for this machine.
+       *
+       * Support vectors of each class are repeatedly merged with their
+       * nearest neighbour (into their mean, weighted by the magnitude of
+       * their coefficients), or pruned if their coefficients are small, in
+       * the order that costs less. The new coefficients are the projection
+       * of the two terms they replace in the kernel's feature space, and the
+       * norm of what is left out bounds the change of every decision value,
+       * since RBF feature vectors have unit norm. Operations are applied
+       * while the sum of these bounds respects ``max_error``, for all
+       * decision functions, or until there are only ``size`` support vectors
+       * left, if ``size`` is not zero. Each class keeps, at least, one
+       * support vector.
+       *
+       * Only models with RBF kernels can be compressed. Neighbours are
+       * searched for with up to ``threads`` threads (zero means one per
+       * hardware thread). Probability estimates, if any, are kept as they
+       * are. Use fidelity() to measure the effects on validation data.
+       */
+      Machine* compress(double max_error, size_t size=0,
+          size_t threads=1) const;
+
+      /**
+       * Compares the predictions of ``other`` with the ones of this
+       * machine, on all rows of ``validation``, using up to ``threads``
+       * threads. Both machines must have the same input size and classes.
+       */
+      Fidelity fidelity(const Machine& other,
+          const blitz::Array<double,2>& validation, size_t threads=1) const;
+
+    private: //not implemented
 
       Machine& operator= (const Machine& other);
 
+    private: //friends
+
+      friend class Ensemble; ///< reads models and scaling parameters
+
     private: //methods
 
+      /**
+       * Chooses the engine, and sets probability estimates up, when a model
+       * is loaded
+       */
+      void setDefaultEngine();
+
       /**
        * Resets the internal state of this machine. Normally called
        */
       void reset();
 
+      /**
+       * Recomputes the reciprocals of the input division factors. Must be
+       * called each time the input subtraction or division factors change.
+       */
+      void updateScaling();
+
+      /**
+       * Converts (and scales) the input vector starting at ``input``, with
+       * consecutive elements ``stride`` positions apart, into libsvm's
+       * sparse format, using the memory in the workspace. Inputs may be in
+       * single or double precision.
+       */
+      template <typename T>
+      svm_node* convert(const T* input, ptrdiff_t stride,
+          Workspace& ws) const;
+
+      /**
+       * Converts (and scales) the ``n`` entries of a sparse row, with
+       * increasing, zero-based, column ``indices``, into libsvm's format
+       */
+      svm_node* convert(const int64_t* indices, const double* values,
+          size_t n, Workspace& ws) const;
+
+      /**
+       * Same as above, but for the dense engine: returns an aligned and
+       * padded dense vector, followed by the engine's scratch space.
+       */
+      template <typename T>
+      double* convertDense(const T* input, ptrdiff_t stride,
+          Workspace& ws) const;
+
+      /**
+       * Scales the input vector into ``cache``, which has
+       * DenseEngine::paddedSize() positions
+       */
+      template <typename T>
+      void fillDense(const T* input, ptrdiff_t stride, double* cache) const;
+
+      /**
+       * Scales a sparse row into ``cache``, zeroing all other positions
+       */
+      void fillDense(const int64_t* indices, const double* values, size_t n,
+          double* cache) const;
+
+      /**
+       * Predicts a single input, on raw memory, using the current engine.
+       * Scores are computed if ``scores`` is set and probabilities if
+       * ``probabilities`` is set. If ``times`` is set, the time spent in
+       * each phase is added to it.
+       */
+      template <typename T>
+      double predictRow_(const T* input, ptrdiff_t stride, double* scores,
+          double* probabilities, Workspace& ws, PhaseTimes* times) const;
+
+      /**
+       * Same as above, for a call predicting a single input: updates the
+       * counters, if statistics are collected
+       */
+      template <typename T>
+      double predictOne_(const T* input, ptrdiff_t stride, double* scores,
+          double* probabilities, Workspace& ws) const;
+
+      /**
+       * Same as predictRow_(), for inputs already in libsvm's format. Only
+       * the time spent in libsvm is added to ``times``.
+       */
+      double predictNodes_(const svm_node* input, double* scores,
+          double* probabilities, Workspace& ws, PhaseTimes* times) const;
+
+      /**
+       * Returns the prediction of the scaled input ``key``, of ``n`` values,
+       * from the cache or, if it is not there (or the cache is off), by
+       * calling ``predict()``, storing the result. Only used (and
+       * instantiated) in the implementation.
+       */
+      template <typename Predict>
+      double predictCached_(const double* key, size_t n, double* scores,
+          double* probabilities, Predict predict) const;
+
+      /**
+       * Predictors working on inputs already in libsvm's format
+       */
+      double predict_(const svm_node* input) const;
+      double predictValues_(const svm_node* input, double* scores) const;
+      double predictProbability_(const svm_node* input,
+          double* probabilities) const;
+
+      /**
+       * Predicts rows [start, end) of a batch with ``engine``, in
+       * groups of DenseEngine::BATCH_SIZE inputs. ``fill(row, cache)`` should
+       * write the scaled and padded input for row ``row`` at ``cache``.
+       * ``scores`` and ``probabilities`` may be null if they are not
+       * required. Only used (and instantiated) in the implementation.
+       */
+      template <typename Fill>
+      void predictDense_(const DenseEngine& engine, Fill fill, size_t start,
+          size_t end, int64_t* labels, ptrdiff_t out_row, double* scores,
+          ptrdiff_t sc_row, double* probabilities, ptrdiff_t pr_row,
+          Workspace& ws, PhaseTimes* times) const;
+
+      /**
+       * Returns the dense engine of the NUMA node the calling thread runs
+       * on
+       */
+      const DenseEngine& localEngine() const;
+
+      /**
+       * Returns the dense engine for the block of a batch of ``rows``
+       * starting at row ``start``. With replicas, blocks go to the NUMA
+       * nodes in order, and ``worker`` threads (not the caller's) are first
+       * pinned to the node of their block.
+       */
+      const DenseEngine& blockEngine(size_t start, size_t rows,
+          bool worker) const;
+
+      /**
+       * Predicts all rows of a dense batch, in parallel. Scores are only
+       * computed if ``scores`` is set and probabilities if ``probabilities``
+       * is set. Only used (and instantiated) in the implementation.
+       */
+      template <typename T>
+      void predictBatch_(const blitz::Array<T,2>& input,
+          blitz::Array<int64_t,1>& labels, double* scores, ptrdiff_t sc_row,
+          double* probabilities, ptrdiff_t pr_row, size_t threads) const;
+
+      /**
+       * Same as above, for sparse batches
+       */
+      void predictSparse_(const SparseMatrix& input,
+          blitz::Array<int64_t,1>& labels, double* scores, ptrdiff_t sc_row,
+          double* probabilities, ptrdiff_t pr_row, size_t threads) const;
+
+      /**
+       * Number of kernel values computed to predict ``n`` inputs
+       */
+      uint64_t kernelEvaluations(size_t n) const;
+
+      /**
+       * Checks the dimensions of batch inputs and outputs
+       */
+      template <typename T>
+      void checkBatch(const blitz::Array<T,2>& input,
+          const blitz::Array<int64_t,1>& labels) const;
+      void checkBatch(const SparseMatrix& input,
+          const blitz::Array<int64_t,1>& labels) const;
+
     private: //representation
 
       boost::shared_ptr<svm_model> m_model; ///< libsvm model pointer
-      mutable boost::shared_array<svm_node> m_input_cache; ///< cache
       size_t m_input_size; ///< vector size expected as input for the SVM's
       blitz::Array<double,1> m_input_sub; ///< scaling: subtraction
       blitz::Array<double,1> m_input_div; ///< scaling: division
+      std::vector<double> m_input_scale; ///< scaling: 1/m_input_div
+      bool m_scaling; ///< false if inputs need no scaling at all
+      boost::shared_ptr<const DenseEngine> m_dense; ///< dense engine, if set
+      std::vector<boost::shared_ptr<const DenseEngine> > m_replicas; ///< node
+      MemoryPolicy m_memory; ///< of dense engines
+      boost::shared_ptr<const ProbabilityEstimator> m_estimator; ///< shared
+      coupling_t m_coupling; ///< of pairwise probabilities
+      boost::shared_ptr<PredictionCounters> m_counters; ///< statistics, if on
+      boost::shared_ptr<PredictionCache> m_cache; ///< recent predictions, if on
 
   };
 
@@ -0,0 +1,143 @@
+/**
+ * @date Fri 16 Oct 2026 09:26:11 CEST
+ *
+ * @brief Placement of large, read-only, model arrays in memory
+ *
+ * Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+ */
+
+#ifndef BOB_LEARN_LIBSVM_MEMORY_H
+#define BOB_LEARN_LIBSVM_MEMORY_H
+
+#include <vector>
+#include <cstddef>
+#include <new>
+
+namespace bob { namespace learn { namespace libsvm {
+
+  /**
+   * Memory alignment (in bytes) of all buffers used by the engines, which
+   * is good for any SIMD instruction set we use, up to AVX-512
+   */
+  const size_t ENGINE_ALIGNMENT = 64;
+
+  /**
+   * Size of the huge pages model arrays may be backed with
+   */
+  const size_t HUGE_PAGE_SIZE = 2 << 20;
+
+  /**
+   * Pages backing large model arrays
+   */
+  enum pages_t {
+    DEFAULT_PAGES, ///< whatever the system allocator gives
+    TRANSPARENT_HUGE_PAGES, ///< advises the kernel to use huge pages
+    EXPLICIT_HUGE_PAGES ///< from the pool of reserved huge pages, if any
+  };
+
+  /**
+   * How a Machine places the arrays its dense engines work on (support
+   * vectors or primal weights), which dominate memory traffic once models
+   * are large
+   */
+  struct MemoryPolicy {
+    pages_t pages;
+    bool replicate; ///< keeps one copy of the arrays per NUMA node
+
+    MemoryPolicy(pages_t pages=DEFAULT_PAGES, bool replicate=false):
+      pages(pages), replicate(replicate) {}
+  };
+
+  /**
+   * Allocates ``bytes`` of memory, aligned to ENGINE_ALIGNMENT. Arrays of
+   * at least HUGE_PAGE_SIZE bytes are mapped directly from the system if
+   * ``pages`` asks for huge pages, rounded up to whole huge pages. Explicit
+   * huge pages fall back to transparent ones if none are reserved. On
+   * systems other than Linux, ``pages`` is ignored. Throws std::bad_alloc
+   * on failure.
+   */
+  void* allocate_model(size_t bytes, pages_t pages);
+
+  /**
+   * Releases memory returned by allocate_model(), with the same ``bytes``
+   * and ``pages``
+   */
+  void free_model(void* p, size_t bytes, pages_t pages);
+
+  /**
+   * A standard allocator on top of allocate_model(), so that vectors of
+   * model arrays carry their placement along
+   */
+  template <typename T>
+  class model_allocator {
+
+    public: //types
+
+      typedef T value_type;
+
+      template <typename U> struct rebind {
+        typedef model_allocator<U> other;
+      };
+
+    public: //api
+
+      model_allocator(pages_t pages=DEFAULT_PAGES): m_pages(pages) {}
+
+      template <typename U>
+      model_allocator(const model_allocator<U>& other):
+        m_pages(other.pages()) {}
+
+      T* allocate(size_t n) {
+        return static_cast<T*>(allocate_model(n * sizeof(T), m_pages));
+      }
+
+      void deallocate(T* p, size_t n) {
+        free_model(p, n * sizeof(T), m_pages);
+      }
+
+      pages_t pages() const { return m_pages; }
+
+      template <typename U>
+      bool operator== (const model_allocator<U>& other) const {
+        return m_pages == other.pages();
+      }
+
+      template <typename U>
+      bool operator!= (const model_allocator<U>& other) const {
+        return m_pages != other.pages();
+      }
+
+    private: //representation
+
+      pages_t m_pages;
+
+  };
+
+  /**
+   * Vectors of model arrays, aligned to ENGINE_ALIGNMENT
+   */
+  typedef std::vector<double, model_allocator<double> > model_vector;
+  typedef std::vector<float, model_allocator<float> > model_float_vector;
+
+  /**
+   * Returns the CPUs of each NUMA node of this host, as listed by the
+   * kernel, or a single node with no CPUs if the topology is unknown
+   */
+  const std::vector<std::vector<int> >& numa_nodes();
+
+  /**
+   * Returns the NUMA node of the CPU the calling thread runs on, or zero if
+   * it is unknown
+   */
+  size_t current_numa_node();
+
+  /**
+   * Restricts the calling thread to the CPUs of NUMA node ``node``. Memory
+   * it touches first is then allocated on that node. Returns false if the
+   * thread could not be pinned.
+   */
+  bool pin_to_numa_node(size_t node);
+
+}}}
+
+#endif /* BOB_LEARN_LIBSVM_MEMORY_H */
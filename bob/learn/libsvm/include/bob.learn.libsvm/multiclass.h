@@ -0,0 +1,174 @@
+/**
+ * @date Wed 14 Oct 2026 16:02:18 CEST
+ *
+ * @brief One-vs-rest multi-class machines, made of binary libsvm machines
+ *
+ * Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+ */
+
+#ifndef BOB_LEARN_LIBSVM_MULTICLASS_H
+#define BOB_LEARN_LIBSVM_MULTICLASS_H
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <blitz/array.h>
+#include <bob.io.base/HDF5File.h>
+#include <bob.learn.libsvm/machine.h>
+#include <bob.learn.libsvm/sparse.h>
+
+namespace bob { namespace learn { namespace libsvm {
+
+  /**
+   * A multi-class classifier made of one binary machine per class, that
+   * separates that class (labelled +1) from all others (labelled -1). The
+   * predicted class is the one whose machine gives the highest decision
+   * value. Contrary to libsvm's own one-vs-one decomposition, that evaluates
+   * N(N-1)/2 decision functions for N classes, prediction only requires N
+   * of them, and there is no limit on the number of classes.
+   *
+   * Like Machine, prediction methods do not modify the object, which may be
+   * shared by many threads.
+   */
+  class OneVsRestMachine {
+
+    public: //api
+
+      /**
+       * Builds a new machine from binary ``machines``, one per class, with
+       * the given class ``labels``. All machines should be binary
+       * classifiers, with the same input size, that output +1 for their
+       * class. They are not copied.
+       */
+      OneVsRestMachine
+        (const std::vector<boost::shared_ptr<Machine> >& machines,
+         const std::vector<int>& labels);
+
+      /**
+       * Builds a new machine from an HDF5 file containing a machine saved
+       * with save(), including the scaling parameters
+       */
+      OneVsRestMachine(bob::io::base::HDF5File& config);
+
+      /**
+       * Deep copy: the new machine shares no memory with ``other``
+       */
+      OneVsRestMachine(const OneVsRestMachine& other);
+
+      /**
+       * Virtual d'tor
+       */
+      virtual ~OneVsRestMachine();
+
+      /**
+       * Tells the input size this machine expects
+       */
+      size_t inputSize() const;
+
+      /**
+       * Tells the number of classes, which is also the number of scores
+       * produced for each input
+       */
+      size_t numberOfClasses() const { return m_labels.size(); }
+
+      /**
+       * Returns the label of class ``i``
+       */
+      int classLabel(size_t i) const { return m_labels[i]; }
+
+      /**
+       * Returns the binary machine for class ``i``
+       */
+      const Machine& machine(size_t i) const { return *m_machines[i]; }
+
+      /**
+       * Sets the scaling parameters of all binary machines
+       */
+      void setInputSubtraction(const blitz::Array<double,1>& v);
+      void setInputDivision(const blitz::Array<double,1>& v);
+
+      /**
+       * Returns the scaling parameters, common to all binary machines
+       */
+      const blitz::Array<double,1>& getInputSubtraction() const
+      { return m_machines[0]->getInputSubtraction(); }
+      const blitz::Array<double,1>& getInputDivision() const
+      { return m_machines[0]->getInputDivision(); }
+
+      /**
+       * Predicts the class of a single input
+       */
+      int predictClass(const blitz::Array<double,1>& input) const;
+
+      /**
+       * Predicts the class and the decision values of all binary machines
+       * for a single input. ``scores`` should have numberOfClasses()
+       * positions.
+       */
+      int predictClassAndScores(const blitz::Array<double,1>& input,
+          blitz::Array<double,1>& scores) const;
+
+      /**
+       * Predicts the classes of all rows in ``input``, with up to
+       * ``threads`` workers (zero means one per hardware thread). Each
+       * binary machine goes through all rows with its batch prediction
+       * methods, in turn.
+       */
+      void predictClass(const blitz::Array<double,2>& input,
+          blitz::Array<int64_t,1>& labels, size_t threads=1) const;
+
+      /**
+       * Predicts the classes and decision values of all rows in ``input``.
+       * ``scores`` should have as many rows as ``input`` and
+       * numberOfClasses() columns.
+       */
+      void predictClassAndScores(const blitz::Array<double,2>& input,
+          blitz::Array<int64_t,1>& labels, blitz::Array<double,2>& scores,
+          size_t threads=1) const;
+
+      /**
+       * Same as above, for sparse inputs, which are never densified
+       */
+      void predictClass(const SparseMatrix& input,
+          blitz::Array<int64_t,1>& labels, size_t threads=1) const;
+      void predictClassAndScores(const SparseMatrix& input,
+          blitz::Array<int64_t,1>& labels, blitz::Array<double,2>& scores,
+          size_t threads=1) const;
+
+      /**
+       * Saves the whole machine into a configuration file: class labels go
+       * to the current group and each binary machine to a sub-group of its
+       * own
+       */
+      void save(bob::io::base::HDF5File& config) const;
+
+    private: //not implemented
+
+      OneVsRestMachine& operator= (const OneVsRestMachine& other);
+
+    private: //methods
+
+      /**
+       * Checks binary machines and labels are consistent
+       */
+      void check() const;
+
+      /**
+       * Runs all binary machines through ``input`` (dense or sparse) and
+       * chooses the best class for each row. ``scores`` must be
+       * C-contiguous.
+       */
+      template <typename Input>
+      void predict_(const Input& input, size_t rows,
+          blitz::Array<int64_t,1>& labels, blitz::Array<double,2>& scores,
+          size_t threads) const;
+
+    private: //representation
+
+      std::vector<boost::shared_ptr<Machine> > m_machines; ///< one per class
+      std::vector<int> m_labels; ///< class labels
+
+  };
+
+}}}
+
+#endif /* BOB_LEARN_LIBSVM_MULTICLASS_H */
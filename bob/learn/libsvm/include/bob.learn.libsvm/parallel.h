@@ -0,0 +1,99 @@
+/**
+ * @date Mon 12 Oct 2026 09:12:41 CEST
+ *
+ * @brief Minimal thread pooling support for bob.learn.libsvm
+ *
+ * Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+ */
+
+#ifndef BOB_LEARN_LIBSVM_PARALLEL_H
+#define BOB_LEARN_LIBSVM_PARALLEL_H
+
+#include <algorithm>
+#include <vector>
+#include <exception>
+#include <boost/thread.hpp>
+
+namespace bob { namespace learn { namespace libsvm {
+
+  /**
+   * Returns the number of workers to use if the user asks for ``threads``
+   * workers to process ``n`` work items. If ``threads`` is zero, use as many
+   * workers as there are hardware threads on the machine. The result is
+   * never larger than ``n`` and never smaller than 1.
+   */
+  inline size_t number_of_workers(size_t n, size_t threads) {
+    if (!threads) threads = boost::thread::hardware_concurrency();
+    if (threads > n) threads = n;
+    if (!threads) threads = 1;
+    return threads;
+  }
+
+  /**
+   * Calls ``f(start, end)`` over consecutive ranges of, at most, ``grain``
+   * items, covering [0, n). Ranges are handed out dynamically to up to
+   * ``threads`` workers (zero means one worker per hardware thread). If only
+   * one worker is required, ``f`` is called on the current thread.
+   *
+   * Exceptions raised by ``f`` stop the distribution of further ranges and
+   * the first one caught is re-thrown on the calling thread, after all
+   * workers have finished.
+   */
+  template <typename F>
+  void parallel_for(size_t n, size_t threads, size_t grain, F f) {
+
+    if (!n) return;
+    if (!grain) grain = 1;
+
+    size_t workers = number_of_workers((n + grain - 1) / grain, threads);
+
+    if (workers == 1) {
+      for (size_t start=0; start<n; start+=grain) {
+        f(start, std::min(n, start+grain));
+      }
+      return;
+    }
+
+    boost::mutex lock; ///< protects the variables bellow
+    size_t next = 0; ///< next item to be handed out
+    std::exception_ptr error; ///< first exception caught
+
+    boost::thread_group group;
+    for (size_t k=0; k<workers; ++k) group.create_thread([&]() {
+      while (true) {
+        size_t start;
+        {
+          boost::mutex::scoped_lock guard(lock);
+          if (next >= n || error) return;
+          start = next;
+          next += grain;
+        }
+        try {
+          f(start, std::min(n, start+grain));
+        }
+        catch (...) {
+          boost::mutex::scoped_lock guard(lock);
+          if (!error) error = std::current_exception();
+          return;
+        }
+      }
+    });
+    group.join_all();
+
+    if (error) std::rethrow_exception(error);
+
+  }
+
+  /**
+   * Shortcut to split [0, n) into one contiguous block per worker, which is
+   * the best choice when all items cost roughly the same
+   */
+  template <typename F>
+  void parallel_blocks(size_t n, size_t threads, F f) {
+    size_t workers = number_of_workers(n, threads);
+    parallel_for(n, workers, (n + workers - 1) / workers, f);
+  }
+
+}}}
+
+#endif /* BOB_LEARN_LIBSVM_PARALLEL_H */
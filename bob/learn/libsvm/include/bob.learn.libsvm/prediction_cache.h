@@ -0,0 +1,158 @@
+/**
+ * @date Thu 15 Oct 2026 21:03:18 CEST
+ *
+ * @brief Predictions of recently seen inputs
+ *
+ * Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+ */
+
+#ifndef BOB_LEARN_LIBSVM_PREDICTION_CACHE_H
+#define BOB_LEARN_LIBSVM_PREDICTION_CACHE_H
+
+#include <atomic>
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+#include <boost/thread/mutex.hpp>
+
+namespace bob { namespace learn { namespace libsvm {
+
+  /**
+   * A snapshot of the counters of a PredictionCache
+   */
+  struct CacheStatistics {
+    uint64_t hits; ///< predictions found in the cache
+    uint64_t misses; ///< predictions computed (and added to the cache)
+    uint64_t evictions; ///< entries removed to make room for new ones
+    uint64_t entries; ///< entries currently stored
+    double used; ///< megabytes currently used
+    double size; ///< maximum number of megabytes
+  };
+
+  /**
+   * A size-bounded store of the predictions of a Machine, keyed by the
+   * scaled inputs, so inputs seen recently are not predicted again. Keys
+   * are compared exactly, after a 64-bit hash is matched, so cached results
+   * are the ones the machine would compute. Each entry keeps the class and,
+   * if they were asked for, the scores; or the class and the probabilities,
+   * which are computed (and stored) separately, as the class predicted
+   * along with probabilities may differ.
+   *
+   * Entries are spread over a few shards, by hash, each with its own lock
+   * and its own share of the memory, in which the entries used the longest
+   * time ago are evicted first. All methods may be called concurrently.
+   */
+  class PredictionCache {
+
+    public: //api
+
+      /**
+       * Builds a new, empty, cache that may hold up to ``size_in_mb``
+       * megabytes of predictions of ``scores`` decision values or
+       * ``classes`` probabilities
+       */
+      PredictionCache(double size_in_mb, size_t scores, size_t classes);
+
+      /**
+       * Hashes the ``n`` values of a key
+       */
+      static uint64_t hash(const double* key, size_t n);
+
+      /**
+       * Looks up the key of ``n`` values, with the given ``hash``. If
+       * ``probabilities`` is set, the entry must hold them (they are copied
+       * only if ``copy_probabilities`` is set); otherwise, it must hold the
+       * class or, if ``scores`` is set, the scores. Returns true and sets
+       * ``label`` on a hit.
+       */
+      bool find(const double* key, size_t n, uint64_t hash, double& label,
+          double* scores, double* probabilities, bool copy_probabilities);
+
+      /**
+       * Stores the prediction of a key, with the same arguments as find().
+       * Keys already stored are updated with what they did not hold yet.
+       */
+      void insert(const double* key, size_t n, uint64_t hash, double label,
+          const double* scores, const double* probabilities,
+          bool copy_probabilities);
+
+      /**
+       * Maximum amount of memory used by this cache
+       */
+      double getSizeInMb() const;
+
+      /**
+       * Returns the current values of all counters
+       */
+      CacheStatistics statistics() const;
+
+      /**
+       * Removes all entries and sets all counters back to zero
+       */
+      void clear();
+
+    private: //types
+
+      struct Entry {
+        uint64_t hash;
+        std::vector<double> key;
+        bool has_label; ///< the class, without probabilities
+        bool has_scores;
+        bool has_probabilities; ///< the class along with probabilities
+        double label;
+        double probability_label;
+        std::vector<double> values; ///< scores, then probabilities
+        size_t bytes; ///< memory accounted for this entry
+      };
+
+      typedef std::list<Entry> list_type; ///< most recently used first
+      typedef std::unordered_multimap<uint64_t, list_type::iterator>
+        index_type;
+
+      struct Shard {
+        mutable boost::mutex lock; ///< protects everything bellow
+        list_type entries;
+        index_type index;
+        size_t used; ///< in bytes
+        Shard(): used(0) {}
+      };
+
+      static const size_t SHARDS = 16;
+
+    private: //methods
+
+      /**
+       * Returns the entry for a key in a shard, or the end of its list
+       */
+      list_type::iterator lookup(Shard& shard, const double* key, size_t n,
+          uint64_t hash);
+
+      /**
+       * Evicts the least recently used entries of a shard until ``bytes``
+       * more fit in it. Must be called with the shard lock held.
+       */
+      void evict(Shard& shard, size_t bytes);
+
+      Shard& shard(uint64_t hash) { return m_shards[hash >> 60]; }
+
+    private: //not implemented
+
+      PredictionCache(const PredictionCache& other);
+      PredictionCache& operator= (const PredictionCache& other);
+
+    private: //representation
+
+      size_t m_capacity; ///< maximum size of each shard, in bytes
+      size_t m_scores;
+      size_t m_classes;
+      Shard m_shards[SHARDS];
+      std::atomic<uint64_t> m_hits;
+      std::atomic<uint64_t> m_misses;
+      std::atomic<uint64_t> m_evictions;
+
+  };
+
+}}}
+
+#endif /* BOB_LEARN_LIBSVM_PREDICTION_CACHE_H */
@@ -0,0 +1,119 @@
+/**
+ * @date Thu 15 Oct 2026 23:17:45 CEST
+ *
+ * @brief Probability estimates from decision values
+ *
+ * Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+ */
+
+#ifndef BOB_LEARN_LIBSVM_PROBABILITY_H
+#define BOB_LEARN_LIBSVM_PROBABILITY_H
+
+#include <vector>
+#include <cstddef>
+#include <svm.h>
+
+namespace bob { namespace learn { namespace libsvm {
+
+  /**
+   * How pairwise probabilities are coupled into class probabilities
+   */
+  enum coupling_t {
+    ITERATIVE_COUPLING, ///< libsvm's solver (method 2 of Wu, Lin and Weng)
+    APPROXIMATE_COUPLING ///< closed form of Price et al., normalized
+  };
+
+  /**
+   * Estimates class probabilities from the decision values of a model
+   * trained with probability estimates, like svm_predict_probability():
+   * each decision value goes through the sigmoid fitted at training time
+   * (with the model's probA and probB), which gives the probability of the
+   * first class of its pair against the second one, and these pairwise
+   * probabilities are then coupled into one probability per class.
+   *
+   * libsvm couples them with an iterative solver, that takes up to
+   * max(100, nr_class) passes over an nr_class x nr_class system for each
+   * input. The approximate coupling of Price, Knerr, Personnaz and Dreyfus
+   * (1995) has a closed form instead: the probability of class ``i`` is
+   * proportional to ``1 / (sum_j 1/r_ij - (nr_class - 2))``, where ``r_ij``
+   * is the probability of ``i`` against ``j``. It costs one division per
+   * pair of classes and gives the same probabilities as libsvm for two
+   * classes. With more classes, it usually picks the same class as libsvm,
+   * but probabilities differ from libsvm's.
+   *
+   * Objects of this class are immutable after construction and hold copies
+   * of everything they need from the model.
+   */
+  class ProbabilityEstimator {
+
+    public: //api
+
+      /**
+       * Copies the probability parameters of ``model``
+       */
+      ProbabilityEstimator(const svm_model* model);
+
+      /**
+       * Tells if probabilities can be estimated for the model: it must be a
+       * classifier trained with probability estimates
+       */
+      bool supported() const;
+
+      /**
+       * Number of classes, and of decision values (one per pair of classes)
+       */
+      size_t classes() const { return m_nr_class; }
+      size_t pairs() const { return (m_nr_class*(m_nr_class-1))/2; }
+
+      /**
+       * The number of doubles required as scratch space to estimate the
+       * probabilities of ``n`` inputs at once
+       */
+      size_t workspaceSize(size_t n) const;
+
+      /**
+       * Fills ``prob_estimates`` (one per class) from the decision values
+       * of one input and returns the most probable label
+       */
+      double estimate(const double* dec_values, double* prob_estimates,
+          double* work, coupling_t coupling=ITERATIVE_COUPLING) const;
+
+      /**
+       * Batch variant of the above, for ``n`` inputs whose decision values
+       * are stored one after the other. Fills ``n`` labels and ``n`` x
+       * classes() probabilities. The sigmoids of all inputs are computed
+       * first, in a single pass without branches.
+       */
+      void estimate(const double* dec_values, size_t n, double* labels,
+          double* prob_estimates, double* work,
+          coupling_t coupling=ITERATIVE_COUPLING) const;
+
+    private: //methods
+
+      /**
+       * Computes the pairwise probabilities for ``n`` inputs, clipped to
+       * [1e-7, 1-1e-7] like libsvm
+       */
+      void pairwise(const double* dec_values, size_t n, double* r) const;
+
+      /**
+       * Couples the pairwise probabilities of one input and returns the most
+       * probable label. ``work`` should have space for 2 x nr_class x
+       * nr_class + nr_class doubles.
+       */
+      double couple(const double* r, double* prob_estimates, double* work,
+          coupling_t coupling) const;
+
+    private: //representation
+
+      int m_svm_type;
+      int m_nr_class;
+      std::vector<double> m_probA;
+      std::vector<double> m_probB;
+      std::vector<int> m_label;
+
+  };
+
+}}}
+
+#endif /* BOB_LEARN_LIBSVM_PROBABILITY_H */
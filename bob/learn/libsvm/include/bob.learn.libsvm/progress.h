@@ -0,0 +1,139 @@
+/**
+ * @date Thu 15 Oct 2026 15:02:19 CEST
+ *
+ * @brief Progress reports and cancellation of trainings
+ *
+ * Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+ */
+
+#ifndef BOB_LEARN_LIBSVM_PROGRESS_H
+#define BOB_LEARN_LIBSVM_PROGRESS_H
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <stdint.h>
+#include <boost/function.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace bob { namespace learn { namespace libsvm {
+
+  /**
+   * The progress of a training, so far
+   */
+  struct TrainingProgress {
+    uint64_t problems; ///< optimization problems solved by libsvm
+    /**
+     * SMO iterations over all problems. Problems being solved report every
+     * 1000 iterations, so the count is exact only between problems.
+     */
+    uint64_t iterations;
+    double objective; ///< of the last problem solved (NaN before the first)
+    double elapsed; ///< seconds since the training started
+  };
+
+  /**
+   * Called with the progress of a training, whenever it changes. Returning
+   * false cancels the training. Calls are serialized, but may come from
+   * any of the threads of the training.
+   */
+  typedef boost::function<bool (const TrainingProgress&)> ProgressCallback;
+
+  /**
+   * Raised by training methods that were cancelled, by their progress
+   * callback or because they ran out of time
+   */
+  class TrainingCancelled: public std::runtime_error {
+    public:
+      TrainingCancelled(const std::string& what): std::runtime_error(what) {}
+  };
+
+  /**
+   * Follows the progress of a training, from the messages libsvm prints,
+   * reports it to a callback and cancels the training if the callback asks
+   * for it or if it runs out of time. libsvm cannot be asked to stop, so
+   * cancelled trainings stop before the next problem is solved, by calling
+   * check() between problems. Optionally, they may also stop in the middle
+   * of a problem: TrainingCancelled is then raised from the messages libsvm
+   * prints, which unwinds its solver without freeing the memory it holds
+   * (mostly its kernel cache, up to ``cache_size`` megabytes per solver).
+   */
+  class TrainingMonitor {
+
+    public: //api
+
+      /**
+       * Reports to ``callback`` (if set) and cancels the training after
+       * ``time_limit`` seconds (if positive). If ``interrupt`` is set,
+       * cancellation also stops problems being solved, leaking the memory
+       * of their solvers.
+       */
+      TrainingMonitor(const ProgressCallback& callback, double time_limit,
+          bool interrupt=false);
+
+      /**
+       * Tells if the training was cancelled or if it ran out of time
+       */
+      bool cancelled();
+
+      /**
+       * Raises TrainingCancelled if the training was cancelled or if it ran
+       * out of time
+       */
+      void check();
+
+      /**
+       * Updates the progress from a message printed by libsvm, on the
+       * calling thread, and reports it. Checks for cancellation, only if
+       * problems may be interrupted.
+       */
+      void parse(const char* message);
+
+      /**
+       * Adds a problem solved in ``iterations`` iterations, to an
+       * ``objective`` value, by a solver other than libsvm's, and reports
+       * it
+       */
+      void solved(uint64_t iterations, double objective);
+
+      /**
+       * Sets the monitor libsvm messages printed by the calling thread are
+       * routed to, returning the previous one. Use null to stop routing.
+       */
+      static TrainingMonitor* route(TrainingMonitor* monitor);
+
+      /**
+       * Returns the monitor messages of the calling thread are routed to
+       */
+      static TrainingMonitor* routed();
+
+    private: //methods
+
+      /**
+       * Cancels the training, which will raise TrainingCancelled with the
+       * given reason from all threads
+       */
+      void cancel(const std::string& reason);
+
+      /**
+       * Calls the callback, with m_lock held
+       */
+      void report();
+
+    private: //representation
+
+      ProgressCallback m_callback;
+      uint64_t m_start; ///< in nanoseconds
+      uint64_t m_deadline; ///< in nanoseconds, zero if there is none
+      double m_time_limit; ///< in seconds
+      bool m_interrupt; ///< raises from libsvm's messages if cancelled
+      boost::mutex m_lock; ///< serializes callbacks, protects the below
+      TrainingProgress m_progress;
+      std::string m_reason; ///< why the training was cancelled
+      std::atomic<bool> m_cancelled;
+
+  };
+
+}}}
+
+#endif /* BOB_LEARN_LIBSVM_PROGRESS_H */
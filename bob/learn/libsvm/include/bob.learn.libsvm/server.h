@@ -0,0 +1,172 @@
+/**
+ * @date Thu 15 Oct 2026 17:41:52 CEST
+ *
+ * @brief A prediction server, that batches single requests
+ *
+ * Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+ */
+
+#ifndef BOB_LEARN_LIBSVM_SERVER_H
+#define BOB_LEARN_LIBSVM_SERVER_H
+
+#include <deque>
+#include <exception>
+#include <future>
+#include <vector>
+#include <stdint.h>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <bob.learn.libsvm/machine.h>
+
+namespace bob { namespace learn { namespace libsvm {
+
+  /**
+   * What a PredictionServer computes for each input, besides its class
+   */
+  enum output_t {
+    LABELS, ///< only the predicted class
+    SCORES, ///< the decision values, as with predictClassAndScores()
+    PROBABILITIES ///< the class probabilities
+  };
+
+  /**
+   * The prediction for a single input
+   */
+  struct PredictionResult {
+    int64_t label; ///< the predicted class
+    std::vector<double> values; ///< scores or probabilities, if requested
+  };
+
+  /**
+   * Serves predictions of a Machine to many threads, each submitting single
+   * inputs. Requests are queued and picked up by a pool of workers, that
+   * predict them in micro-batches with the batch methods of the Machine, so
+   * kernel evaluations are vectorized over requests. A worker starts a batch
+   * once ``batch_size`` requests are queued, or once the oldest of them has
+   * waited ``max_latency`` seconds. Only one worker gathers requests at a
+   * time, while the others predict the batches gathered before.
+   *
+   * Requests are completed on the worker threads, by calling their
+   * Completion or by setting their future.
+   */
+  class PredictionServer {
+
+    public: //api
+
+      /**
+       * Called once a request is predicted, with its result, or with the
+       * exception that prevented its prediction (and a null result)
+       */
+      typedef boost::function<void (const PredictionResult*,
+          std::exception_ptr)> Completion;
+
+      /**
+       * Serves predictions of ``output`` kind from ``machine``, with
+       * ``workers`` threads (zero means one per hardware thread). The
+       * machine must not be modified while it is being served.
+       */
+      PredictionServer(boost::shared_ptr<const Machine> machine,
+          output_t output=LABELS, size_t workers=1, size_t batch_size=64,
+          double max_latency=1e-3);
+
+      /**
+       * Closes the server, waiting for all queued requests to complete
+       */
+      virtual ~PredictionServer();
+
+      /**
+       * Queues ``input``, with ``inputSize()`` values, which is copied. Its
+       * prediction is passed to ``done``, on a worker thread, which should
+       * not throw (exceptions are ignored). Raises a std::runtime_error if
+       * the server is closed.
+       */
+      void submit(const double* input, const Completion& done);
+
+      /**
+       * Same as above, returning a future for the prediction
+       */
+      std::future<PredictionResult> submit(const double* input);
+
+      /**
+       * Stops accepting requests and waits for the ones queued to complete.
+       * Must not be called from a Completion.
+       */
+      void close();
+
+      /**
+       * Tells if the server was closed
+       */
+      bool closed() const;
+
+      /**
+       * Returns the number of requests queued and not picked by a worker yet
+       */
+      size_t pending() const;
+
+      const Machine& getMachine() const { return *m_machine; }
+      output_t getOutput() const { return m_output; }
+      size_t getWorkers() const { return m_workers; }
+      size_t getBatchSize() const { return m_batch_size; }
+      double getMaxLatency() const { return m_max_latency; }
+
+      /**
+       * Tells the size of inputs and the number of values computed for each
+       */
+      size_t inputSize() const { return m_machine->inputSize(); }
+      size_t outputSize() const { return m_values; }
+
+    private: //types
+
+      struct Request {
+        std::vector<double> input;
+        Completion done;
+        uint64_t arrival; ///< in nanoseconds
+      };
+
+    private: //methods
+
+      /**
+       * The loop of each worker
+       */
+      void work();
+
+      /**
+       * Waits for a batch of requests and moves it to ``batch``. Returns
+       * false once the server is closed and there are no more requests.
+       */
+      bool collect(std::vector<Request>& batch);
+
+      /**
+       * Predicts and completes a batch of requests
+       */
+      void predict(std::vector<Request>& batch,
+          blitz::Array<double,2>& input, blitz::Array<int64_t,1>& labels,
+          blitz::Array<double,2>& values) const;
+
+    private: //representation
+
+      boost::shared_ptr<const Machine> m_machine;
+      output_t m_output;
+      size_t m_workers;
+      size_t m_batch_size;
+      double m_max_latency; ///< in seconds
+      uint64_t m_max_wait; ///< in nanoseconds
+      size_t m_values; ///< computed for each input
+
+      mutable boost::mutex m_lock; ///< protects the below
+      boost::condition_variable m_arrival; ///< requests arrived (or closed)
+      boost::condition_variable m_collector; ///< no worker is collecting
+      std::deque<Request> m_queue;
+      bool m_collecting; ///< a worker is gathering a batch
+      bool m_closed;
+
+      boost::mutex m_join; ///< serializes calls to close()
+      boost::thread_group m_threads;
+
+  };
+
+}}}
+
+#endif /* BOB_LEARN_LIBSVM_SERVER_H */
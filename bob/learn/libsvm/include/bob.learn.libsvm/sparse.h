@@ -0,0 +1,74 @@
+/**
+ * @date Wed 14 Oct 2026 15:21:07 CEST
+ *
+ * @brief Sparse (CSR) matrices, for data that should not be densified
+ *
+ * Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+ */
+
+#ifndef BOB_LEARN_LIBSVM_SPARSE_H
+#define BOB_LEARN_LIBSVM_SPARSE_H
+
+#include <blitz/array.h>
+
+namespace bob { namespace learn { namespace libsvm {
+
+  /**
+   * A matrix in compressed sparse row (CSR) format, like the ones of
+   * scipy.sparse: the column indices (starting from zero) and the values of
+   * the non-zero entries of row ``i`` are stored at positions [indptr(i),
+   * indptr(i+1)) of ``indices`` and ``values``. Column indices must be
+   * strictly increasing within each row, as libsvm requires.
+   *
+   * The matrix references the given arrays if they are C-style contiguous
+   * and copies them otherwise: it is only valid as long as referenced data
+   * is. Objects are immutable after construction and may be read from many
+   * threads.
+   */
+  class SparseMatrix {
+
+    public: //api
+
+      /**
+       * Builds a new sparse matrix with ``columns`` columns and as many rows
+       * as there are entries in ``indptr``, minus one. Throws if the arrays
+       * are not consistent.
+       */
+      SparseMatrix(const blitz::Array<int64_t,1>& indptr,
+          const blitz::Array<int64_t,1>& indices,
+          const blitz::Array<double,1>& values, size_t columns);
+
+      /**
+       * Number of rows (samples)
+       */
+      size_t rows() const { return m_indptr.extent(0) - 1; }
+
+      /**
+       * Number of columns (features)
+       */
+      size_t columns() const { return m_columns; }
+
+      /**
+       * Number of stored entries
+       */
+      size_t nonZeros() const { return m_values.extent(0); }
+
+      /**
+       * Raw, contiguous, access to the arrays
+       */
+      const int64_t* indptr() const { return m_indptr.data(); }
+      const int64_t* indices() const { return m_indices.data(); }
+      const double* values() const { return m_values.data(); }
+
+    private: //representation
+
+      blitz::Array<int64_t,1> m_indptr; ///< where each row starts
+      blitz::Array<int64_t,1> m_indices; ///< column of each entry
+      blitz::Array<double,1> m_values; ///< value of each entry
+      size_t m_columns; ///< number of columns
+
+  };
+
+}}}
+
+#endif /* BOB_LEARN_LIBSVM_SPARSE_H */
@@ -0,0 +1,209 @@
+/**
+ * @date Thu 15 Oct 2026 11:24:06 CEST
+ *
+ * @brief Counters on predictions and trainings
+ *
+ * Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+ */
+
+#ifndef BOB_LEARN_LIBSVM_STATS_H
+#define BOB_LEARN_LIBSVM_STATS_H
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <stdint.h>
+
+namespace bob { namespace learn { namespace libsvm {
+
+  /**
+   * Returns the time of a monotonic clock, in nanoseconds
+   */
+  inline uint64_t nanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  /**
+   * Time spent in each phase of predictions, in nanoseconds. Accumulated by
+   * a single thread, then added to PredictionCounters.
+   */
+  struct PhaseTimes {
+    uint64_t conversion; ///< scaling and converting inputs
+    uint64_t kernel; ///< computing kernel values and decision functions
+    uint64_t voting; ///< voting and coupling probabilities
+
+    PhaseTimes(): conversion(0), kernel(0), voting(0) {}
+  };
+
+  /**
+   * A snapshot of PredictionCounters
+   */
+  struct PredictionStatistics {
+    uint64_t calls; ///< calls to prediction methods
+    uint64_t predictions; ///< inputs predicted
+    uint64_t kernel_evaluations; ///< kernel values computed
+    double conversion; ///< seconds spent scaling and converting inputs
+    double kernel; ///< seconds spent on kernels and decision functions
+    double voting; ///< seconds spent voting and coupling probabilities
+    /**
+     * Latencies of calls: position 0 counts calls that took less than a
+     * microsecond and position ``k`` those that took between ``2^(k-1)``
+     * and ``2^k`` microseconds. The last position also counts all slower
+     * calls.
+     */
+    std::vector<uint64_t> latency;
+  };
+
+  /**
+   * Counters on the predictions of a Machine. Threads accumulate their own
+   * PhaseTimes and add them, with atomic operations, once per call (or per
+   * block of rows, in batch calls), so updates are cheap and never block.
+   */
+  class PredictionCounters {
+
+    public: //api
+
+      static const size_t LATENCY_BUCKETS = 32;
+
+      PredictionCounters();
+
+      /**
+       * Adds ``predictions`` inputs, that required ``kernel_evaluations``
+       * kernel values, and the time spent on them
+       */
+      void add(uint64_t predictions, uint64_t kernel_evaluations,
+          const PhaseTimes& times);
+
+      /**
+       * Adds a call, that took ``elapsed`` nanoseconds
+       */
+      void addCall(uint64_t elapsed);
+
+      /**
+       * Returns the current values of all counters
+       */
+      PredictionStatistics read() const;
+
+      /**
+       * Sets all counters back to zero
+       */
+      void reset();
+
+    private: //representation
+
+      std::atomic<uint64_t> m_calls;
+      std::atomic<uint64_t> m_predictions;
+      std::atomic<uint64_t> m_kernel_evaluations;
+      std::atomic<uint64_t> m_conversion; ///< in nanoseconds
+      std::atomic<uint64_t> m_kernel; ///< in nanoseconds
+      std::atomic<uint64_t> m_voting; ///< in nanoseconds
+      std::atomic<uint64_t> m_latency[LATENCY_BUCKETS];
+
+  };
+
+  /**
+   * A snapshot of TrainingCounters
+   */
+  struct TrainingStatistics {
+    uint64_t trainings; ///< calls to training methods
+    uint64_t problems; ///< optimization problems solved
+    /**
+     * Solver iterations, over all problems: SMO iterations for libsvm,
+     * coordinate descent steps for approximate trainings
+     */
+    uint64_t iterations;
+    /**
+     * Blocks of SMO iterations, as reported by libsvm: one every
+     * min(samples, 1000) iterations of each problem, with or without
+     * shrinking
+     */
+    uint64_t iteration_blocks;
+    uint64_t reconstructions; ///< gradient reconstructions (unshrinking)
+    uint64_t kernel_hits; ///< kernel matrices found in the shared cache
+    uint64_t kernel_misses; ///< kernel matrices computed for the cache
+    double build; ///< seconds spent building problems from the data
+    double solve; ///< seconds spent solving problems, over all threads
+  };
+
+  /**
+   * Counters on the trainings of a Trainer, which may be updated by several
+   * threads concurrently. libsvm does not expose its solver state, so
+   * iterations, blocks of iterations and gradient reconstructions are taken
+   * from the messages it prints, which are routed to the counters of the
+   * training running on the same thread.
+   */
+  class TrainingCounters {
+
+    public: //api
+
+      TrainingCounters();
+
+      /**
+       * Adds a call to a training method
+       */
+      void addTraining();
+
+      /**
+       * Adds ``elapsed`` nanoseconds spent building a problem
+       */
+      void addBuild(uint64_t elapsed);
+
+      /**
+       * Adds a problem solved in ``elapsed`` nanoseconds
+       */
+      void addSolve(uint64_t elapsed);
+
+      /**
+       * Adds ``n`` iterations of a solver other than libsvm's
+       */
+      void addIterations(uint64_t n);
+
+      /**
+       * Adds a lookup of the shared kernel cache
+       */
+      void addKernelLookup(bool hit);
+
+      /**
+       * Updates the solver counters from a message printed by libsvm
+       */
+      void parse(const char* message);
+
+      /**
+       * Returns the current values of all counters
+       */
+      TrainingStatistics read() const;
+
+      /**
+       * Sets all counters back to zero
+       */
+      void reset();
+
+      /**
+       * Sets the counters libsvm messages printed by the calling thread are
+       * routed to, returning the previous ones. Use null to stop routing.
+       */
+      static TrainingCounters* route(TrainingCounters* counters);
+
+      /**
+       * Returns the counters messages of the calling thread are routed to
+       */
+      static TrainingCounters* routed();
+
+    private: //representation
+
+      std::atomic<uint64_t> m_trainings;
+      std::atomic<uint64_t> m_problems;
+      std::atomic<uint64_t> m_iterations;
+      std::atomic<uint64_t> m_iteration_blocks;
+      std::atomic<uint64_t> m_reconstructions;
+      std::atomic<uint64_t> m_kernel_hits;
+      std::atomic<uint64_t> m_kernel_misses;
+      std::atomic<uint64_t> m_build; ///< in nanoseconds
+      std::atomic<uint64_t> m_solve; ///< in nanoseconds
+
+  };
+
+}}}
+
+#endif /* BOB_LEARN_LIBSVM_STATS_H */
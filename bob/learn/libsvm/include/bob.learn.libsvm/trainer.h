@@ -12,9 +12,24 @@
 
 #include <vector>
 #include <bob.learn.libsvm/machine.h>
+#include <bob.learn.libsvm/multiclass.h>
+#include <bob.learn.libsvm/approximate.h>
+#include <bob.learn.libsvm/kernel_cache.h>
+#include <bob.learn.libsvm/stats.h>
+#include <bob.learn.libsvm/progress.h>
 
 namespace bob { namespace learn { namespace libsvm {
 
+  /**
+   * Results of a cross-validated grid search: one row per cost value and
+   * one column per gamma value tried
+   */
+  struct GridSearchResults {
+    blitz::Array<double,2> accuracy; ///< fraction of held-out samples predicted right
+    blitz::Array<double,2> mse; ///< mean squared error of held-out predictions
+    blitz::Array<double,2> seconds; ///< time spent on all folds, in seconds
+  };
+
   /**
    * This class emulates the behavior of the command line utility called
    * svm-train, from libsvm. These bindings do not support:
@@ -56,9 +71,22 @@ namespace bob { namespace learn { namespace libsvm {
        * size of the input data array should be 1.
        *
        * Returns a new object you must deallocate yourself.
+       *
+       * This method does not modify the trainer and may be called
+       * concurrently from several threads, as long as the parameters are not
+       * changed while training is going on.
+       *
+       * With more than 2 classes (and C_SVC or NU_SVC machines), the
+       * one-vs-one binary sub-problems may be solved concurrently, on up to
+       * ``threads`` threads (zero means one per hardware thread), instead
+       * of one after the other by libsvm's svm_train(). The kernel cache
+       * (getCacheSizeInMb()) is then split evenly between the threads. The
+       * resulting model is the same, up to probability estimates, which
+       * libsvm fits on random folds.
        */
       bob::learn::libsvm::Machine* train
-        (const std::vector<blitz::Array<double,2> >& data) const;
+        (const std::vector<blitz::Array<double,2> >& data,
+         size_t threads=1) const;
 
       /**
        * This version accepts scaling parameters that will be applied
@@ -67,7 +95,175 @@ namespace bob { namespace learn { namespace libsvm {
       bob::learn::libsvm::Machine* train
         (const std::vector<blitz::Array<double,2> >& data,
          const blitz::Array<double,1>& input_subtract,
-         const blitz::Array<double,1>& input_division) const;
+         const blitz::Array<double,1>& input_division,
+         size_t threads=1) const;
+
+      /**
+       * Trains a new machine from sparse data, one matrix per class, like
+       * above. Nodes for libsvm are built straight from the non-zero
+       * entries, so the data is never densified. All matrices should have
+       * the same number of columns.
+       */
+      bob::learn::libsvm::Machine* train
+        (const std::vector<SparseMatrix>& data, size_t threads=1) const;
+
+      /**
+       * This version accepts scaling parameters, as above. Because zeros are
+       * not stored, sparse data can only be scaled by division: an exception
+       * is raised if ``input_subtract`` is not zero everywhere.
+       */
+      bob::learn::libsvm::Machine* train
+        (const std::vector<SparseMatrix>& data,
+         const blitz::Array<double,1>& input_subtract,
+         const blitz::Array<double,1>& input_division,
+         size_t threads=1) const;
+
+      /**
+       * Retrains a machine, starting from a ``previous`` solution: ``data``
+       * is the complete training set (typically, the data ``previous`` was
+       * trained on, plus some new samples), with classes in the same order,
+       * and is scaled with the parameters of ``previous``.
+       *
+       * libsvm cannot be given initial multipliers, so the previous solution
+       * is used to choose a working set instead: samples that ``previous``
+       * classifies with a margin above one (plus a safety band) cannot be
+       * support vectors and, most likely, will not become ones. The solver
+       * only runs on the remaining samples. Then, samples left out that
+       * violate the optimality conditions of the new solution (i.e. they
+       * have a margin bellow one) are added to the working set, which is
+       * solved again, until there are none. The result is the same as if
+       * all data was used, at a fraction of the cost when the support
+       * vectors barely change.
+       *
+       * Only C_SVC machines are retrained this way: the constraints of the
+       * other formulations depend on the number of samples, so they are
+       * trained from scratch. So are machines with probability estimates:
+       * libsvm fits them by cross-validation on the samples it is given,
+       * and a working set of samples close to the margin would bias them.
+       *
+       * Works with up to ``threads`` threads (zero means one per hardware
+       * thread) for evaluating margins and, for models trained from
+       * scratch, for solving sub-problems as above.
+       */
+      bob::learn::libsvm::Machine* train
+        (const std::vector<blitz::Array<double,2> >& data,
+         const Machine& previous, size_t threads=1) const;
+
+      /**
+       * Same as above, for sparse data. The scaling parameters of
+       * ``previous`` must not subtract anything, like for sparse train()
+       */
+      bob::learn::libsvm::Machine* train
+        (const std::vector<SparseMatrix>& data, const Machine& previous,
+         size_t threads=1) const;
+
+      /**
+       * Trains a one-vs-rest machine for classification: one binary machine
+       * per class in ``data``, that separates it from all other classes,
+       * instead of libsvm's one binary machine per pair of classes. There is
+       * no limit to the number of classes and prediction costs grow
+       * linearly with it. Labels are assigned like for train().
+       *
+       * Binary machines are trained on a single problem, built once, on up
+       * to ``threads`` threads (zero means one per hardware thread), that
+       * split the kernel cache evenly. Only C_SVC and NU_SVC machines may be
+       * trained this way.
+       */
+      bob::learn::libsvm::OneVsRestMachine* trainOneVsRest
+        (const std::vector<blitz::Array<double,2> >& data,
+         size_t threads=1) const;
+
+      /**
+       * This version accepts scaling parameters, that are set on all binary
+       * machines
+       */
+      bob::learn::libsvm::OneVsRestMachine* trainOneVsRest
+        (const std::vector<blitz::Array<double,2> >& data,
+         const blitz::Array<double,1>& input_subtract,
+         const blitz::Array<double,1>& input_division,
+         size_t threads=1) const;
+
+      /**
+       * Same as above, for sparse data, which may only be scaled by division
+       */
+      bob::learn::libsvm::OneVsRestMachine* trainOneVsRest
+        (const std::vector<SparseMatrix>& data, size_t threads=1) const;
+
+      bob::learn::libsvm::OneVsRestMachine* trainOneVsRest
+        (const std::vector<SparseMatrix>& data,
+         const blitz::Array<double,1>& input_subtract,
+         const blitz::Array<double,1>& input_division,
+         size_t threads=1) const;
+
+      /**
+       * Trains a linear machine on an explicit map of the samples that
+       * approximates this trainer's RBF kernel (see KernelMap): either
+       * ``components`` random Fourier features, or the Nyström method, with
+       * ``components`` landmarks picked among the training samples. Both are
+       * drawn from a generator initialized with ``seed``. Training costs
+       * then grow linearly with the number of samples, instead of
+       * quadratically, and prediction costs depend on the number of
+       * components, instead of support vectors.
+       *
+       * Only C_SVC machines with RBF kernels may be trained this way. The
+       * cost and gamma are those of this trainer (a gamma of zero gets the
+       * same default as for train()), as is the stopping criterion, but
+       * never under 0.1 (liblinear's default for this kind of solver). The
+       * kernel cache is not used. Labels are assigned like for train(): 2
+       * classes are separated by a single linear function, more classes get
+       * one function per class, one-vs-rest. Samples are mapped on up to
+       * ``threads`` threads (zero means one per hardware thread), which then
+       * solve the linear functions concurrently, by dual coordinate descent.
+       * Each one counts as a problem, for statistics and progress reports.
+       * Cancelled trainings stop after the current pass over the samples,
+       * whether libsvm's solvers may be interrupted or not.
+       */
+      bob::learn::libsvm::ApproximateMachine* trainApproximate
+        (const std::vector<blitz::Array<double,2> >& data,
+         const blitz::Array<double,1>& input_subtract,
+         const blitz::Array<double,1>& input_division,
+         approximation_t approximation, size_t components, uint32_t seed=0,
+         size_t threads=1) const;
+
+      bob::learn::libsvm::ApproximateMachine* trainApproximate
+        (const std::vector<blitz::Array<double,2> >& data,
+         approximation_t approximation, size_t components, uint32_t seed=0,
+         size_t threads=1) const;
+
+      /**
+       * Evaluates, by ``folds``-fold cross-validation, machines trained with
+       * every combination of the given ``costs`` and ``gammas`` (a gamma of
+       * zero stands for the default, one over the number of features). All
+       * other parameters are taken from this trainer.
+       *
+       * The training problem is built once and shared read-only by all
+       * folds: held-out sets are stratified, assigning the samples of each
+       * class to folds in a round-robin fashion. Every pair of grid cell and
+       * fold is a separate task, run on up to ``threads`` threads (zero
+       * means one per hardware thread). Note each task allocates its own
+       * kernel cache, of getCacheSizeInMb() megabytes.
+       *
+       * Accuracy is the relevant figure for classification and mean squared
+       * error for regression. Times are summed over folds, so they do not
+       * depend on the number of threads used.
+       */
+      GridSearchResults gridSearch
+        (const std::vector<blitz::Array<double,2> >& data,
+         const blitz::Array<double,1>& input_subtract,
+         const blitz::Array<double,1>& input_division, size_t folds,
+         const std::vector<double>& costs, const std::vector<double>& gammas,
+         size_t threads=1) const;
+
+      /**
+       * Same as above, for sparse data: ``input_subtract`` should be zero
+       * everywhere, like for train()
+       */
+      GridSearchResults gridSearch
+        (const std::vector<SparseMatrix>& data,
+         const blitz::Array<double,1>& input_subtract,
+         const blitz::Array<double,1>& input_division, size_t folds,
+         const std::vector<double>& costs, const std::vector<double>& gammas,
+         size_t threads=1) const;
 
       /**
        * Getters and setters for all parameters
@@ -110,9 +306,77 @@ namespace bob { namespace learn { namespace libsvm {
       void setProbabilityEstimates(bool v)
       { m_param.probability = v; }
 
+      /**
+       * A kernel cache shared by the trainings of this trainer (and of all
+       * other trainers it is set on). When set, train(), trainOneVsRest()
+       * and gridSearch() look the kernel matrix of their problem up in the
+       * cache, computing it there if required, and libsvm only looks kernel
+       * values up: trainings on the same samples with the same kernel
+       * parameters, but different costs or nu's, evaluate kernels a single
+       * time. Problems whose matrix does not fit in the cache (and warm
+       * starts, which only look at part of the kernel matrix) are trained
+       * as usual. Resulting machines are the same either way. Not set by
+       * default.
+       */
+      boost::shared_ptr<KernelCache> getKernelCache() const
+      { return m_cache; }
+      void setKernelCache(boost::shared_ptr<KernelCache> v) { m_cache = v; }
+
+      /**
+       * Turns counters on the trainings of this trainer (trainings, SMO
+       * iterations, shrinking passes, gradient reconstructions, lookups of
+       * the kernel cache and time spent building and solving problems) on
+       * or off. Switching them on starts from zero. Off by default.
+       */
+      void setCollectStatistics(bool v);
+      bool getCollectStatistics() const { return (bool)m_counters; }
+
+      /**
+       * Returns the counters, which are all zero if they are off
+       */
+      TrainingStatistics getStatistics() const;
+
+      /**
+       * Sets all counters back to zero
+       */
+      void resetStatistics();
+
+      /**
+       * A callback the progress of trainings (by train(), trainOneVsRest(),
+       * trainApproximate() and gridSearch()) is reported to, about every
+       * thousand SMO iterations and whenever a problem is solved. Returning
+       * false cancels the training, which then raises TrainingCancelled.
+       * Not set by default.
+       */
+      ProgressCallback getProgressCallback() const { return m_progress; }
+      void setProgressCallback(const ProgressCallback& v) { m_progress = v; }
+
+      /**
+       * Trainings running for longer than this many seconds are cancelled
+       * and raise TrainingCancelled. Zero (the default) means no limit.
+       */
+      double getTimeLimit() const { return m_time_limit; }
+      void setTimeLimit(double v);
+
+      /**
+       * Cancelled trainings stop before libsvm solves their next problem,
+       * and, if this is set, in the middle of the problems being solved,
+       * about every thousand SMO iterations. libsvm cannot free the memory
+       * of interrupted solvers: each one leaks its kernel cache (up to
+       * getCacheSizeInMb() megabytes) and working arrays, so keep this off
+       * in processes cancelling many trainings. Off by default.
+       */
+      bool getInterruptSolver() const { return m_interrupt; }
+      void setInterruptSolver(bool v) { m_interrupt = v; }
+
     private: //representation
 
       svm_parameter m_param; ///< training parametrization for libsvm
+      boost::shared_ptr<KernelCache> m_cache; ///< shared kernel matrices
+      boost::shared_ptr<TrainingCounters> m_counters; ///< statistics, if on
+      ProgressCallback m_progress; ///< progress reports, if set
+      double m_time_limit; ///< in seconds, zero if there is none
+      bool m_interrupt; ///< if cancellation stops problems being solved
 
   };
 
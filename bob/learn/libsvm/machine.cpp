@@ -49,7 +49,9 @@ libsvm model file. When you load using the libsvm model loader,\n\
 note that the scaling parameters will be set to defaults\n\
 (subtraction of 0.0 and division by 1.0). If you need scaling\n\
 to be applied, set it individually using the appropriate methods\n\
-on the returned object.\n\
+on the returned object. If ``path`` points to a file written\n\
+with :py:meth:`save_binary`, the model is memory-mapped instead\n\
+of parsed, and scaling factors are loaded from the file.\n\
 \n\
 Using the second constructor, we build a new machine from an\n\
 HDF5 file containing not only the machine support vectors, but\n\
@@ -347,6 +349,339 @@ static PyObject* PyBobLearnLibsvmMachine_getSupportsProbability
   Py_RETURN_FALSE;
 }
 
+PyDoc_STRVAR(s_engine_str, "engine");
+PyDoc_STRVAR(s_engine_doc,
+"How predictions are computed: ``'libsvm'`` uses libsvm's own\n\
+routines, while ``'dense'`` re-packs the support vectors in a\n\
+dense matrix and evaluates kernels with the best SIMD instruction\n\
+set available on the running CPU. Linear models default to\n\
+``'dense'``, which collapses their support vectors into a single\n\
+weight vector per decision function: prediction cost then does not\n\
+depend on the number of support vectors. All other models default\n\
+to ``'libsvm'``. Results are the same, up to rounding. Models that are too sparse (or that use\n\
+pre-computed kernels) keep on using ``'libsvm'`` even if\n\
+``'dense'`` is requested: read this property back to find out.\n\
+``'dense32'`` is like ``'dense'``, but stores support vectors in\n\
+single precision: they take half the memory and dot products use\n\
+twice as many SIMD lanes, while kernel and decision values are\n\
+still computed in double precision. Scores then differ from the\n\
+ones of ``'libsvm'`` by about ``1e-6``, relatively.\n\
+Do not set this while other threads use this machine.\n\
+");
+
+static PyObject* PyBobLearnLibsvmMachine_getEngine
+(PyBobLearnLibsvmMachineObject* self, void* /*closure*/) {
+  switch (self->cxx->engine()) {
+    case bob::learn::libsvm::LIBSVM_ENGINE:
+      return Py_BuildValue("s", "libsvm");
+    case bob::learn::libsvm::DENSE_ENGINE:
+      return Py_BuildValue("s", "dense");
+    case bob::learn::libsvm::DENSE_SINGLE_ENGINE:
+      return Py_BuildValue("s", "dense32");
+    default:
+      PyErr_Format(PyExc_AssertionError, "illegal engine (%d) - DEBUG ME", self->cxx->engine());
+      return 0;
+  }
+}
+
+static int PyBobLearnLibsvmMachine_setEngine
+(PyBobLearnLibsvmMachineObject* self, PyObject* o, void* /*closure*/) {
+
+  if (!o) {
+    PyErr_SetString(PyExc_TypeError, "cannot delete attribute");
+    return -1;
+  }
+
+  //portable way to extract a string from an object w/o macros
+  PyObject* args = Py_BuildValue("(O)", o);
+  auto args_ = make_safe(args);
+  const char* s = 0;
+  if (!PyArg_ParseTuple(args, "s", &s)) return -1;
+
+  std::string s_(s);
+  bob::learn::libsvm::engine_t engine;
+  if (s_ == "libsvm") engine = bob::learn::libsvm::LIBSVM_ENGINE;
+  else if (s_ == "dense") engine = bob::learn::libsvm::DENSE_ENGINE;
+  else if (s_ == "dense32") engine = bob::learn::libsvm::DENSE_SINGLE_ENGINE;
+  else {
+    PyErr_Format(PyExc_ValueError, "prediction engine `%s' is not supported by `%s' - choose from `libsvm', `dense' or `dense32'", s, Py_TYPE(self)->tp_name);
+    return -1;
+  }
+
+  try {
+    self->cxx->setEngine(engine);
+  }
+  catch (std::exception& ex) {
+    PyErr_SetString(PyExc_RuntimeError, ex.what());
+    return -1;
+  }
+  catch (...) {
+    PyErr_Format(PyExc_RuntimeError, "cannot reset `engine' of %s: unknown exception caught", Py_TYPE(self)->tp_name);
+    return -1;
+  }
+
+  return 0;
+
+}
+
+PyDoc_STRVAR(s_coupling_str, "probability_coupling");
+PyDoc_STRVAR(s_coupling_doc,
+"How pairwise probabilities are coupled into class probabilities,\n\
+in :py:meth:`predict_class_and_probabilities`:\n\
+\n\
+``'iterative'``\n\
+  libsvm's iterative solver (the default), which gives the same\n\
+  probabilities as libsvm\n\
+``'approximate'``\n\
+  the closed form of Price, Knerr, Personnaz and Dreyfus, which\n\
+  costs one division per pair of classes, so probabilities cost\n\
+  about as much as scores. Probabilities are the same as libsvm's\n\
+  for two classes, but differ for more, even if the most probable\n\
+  class is usually the same.\n\
+\n\
+Changing it drops all cached predictions (see :py:attr:`cache_size`).\n\
+");
+
+static PyObject* PyBobLearnLibsvmMachine_getCoupling
+(PyBobLearnLibsvmMachineObject* self, void* /*closure*/) {
+  switch (self->cxx->getProbabilityCoupling()) {
+    case bob::learn::libsvm::ITERATIVE_COUPLING:
+      return Py_BuildValue("s", "iterative");
+    case bob::learn::libsvm::APPROXIMATE_COUPLING:
+      return Py_BuildValue("s", "approximate");
+    default:
+      PyErr_Format(PyExc_AssertionError, "illegal coupling (%d) - DEBUG ME", self->cxx->getProbabilityCoupling());
+      return 0;
+  }
+}
+
+static int PyBobLearnLibsvmMachine_setCoupling
+(PyBobLearnLibsvmMachineObject* self, PyObject* o, void* /*closure*/) {
+
+  if (!o) {
+    PyErr_SetString(PyExc_TypeError, "cannot delete attribute");
+    return -1;
+  }
+
+  //portable way to extract a string from an object w/o macros
+  PyObject* args = Py_BuildValue("(O)", o);
+  auto args_ = make_safe(args);
+  const char* s = 0;
+  if (!PyArg_ParseTuple(args, "s", &s)) return -1;
+
+  std::string s_(s);
+  bob::learn::libsvm::coupling_t coupling;
+  if (s_ == "iterative") coupling = bob::learn::libsvm::ITERATIVE_COUPLING;
+  else if (s_ == "approximate")
+    coupling = bob::learn::libsvm::APPROXIMATE_COUPLING;
+  else {
+    PyErr_Format(PyExc_ValueError, "probability coupling `%s' is not supported by `%s' - choose from `iterative' or `approximate'", s, Py_TYPE(self)->tp_name);
+    return -1;
+  }
+
+  self->cxx->setProbabilityCoupling(coupling);
+  return 0;
+
+}
+
+PyDoc_STRVAR(s_huge_pages_str, "huge_pages");
+PyDoc_STRVAR(s_huge_pages_doc,
+"Pages backing the arrays of the dense engines (support vectors\n\
+or primal weights), when they take at least 2 megabytes:\n\
+\n\
+``'none'``\n\
+  whatever the system allocator gives (the default)\n\
+``'transparent'``\n\
+  asks the kernel for transparent huge pages, which cuts TLB\n\
+  misses when predicting with large models\n\
+``'explicit'``\n\
+  takes pages from the pool of reserved huge pages, falling back\n\
+  to transparent ones if there are none\n\
+\n\
+It is ignored on systems other than Linux and when predictions use\n\
+libsvm (see :py:attr:`engine`). Setting it rebuilds the dense engine.\n\
+");
+
+static PyObject* PyBobLearnLibsvmMachine_getHugePages
+(PyBobLearnLibsvmMachineObject* self, void* /*closure*/) {
+  switch (self->cxx->getMemoryPolicy().pages) {
+    case bob::learn::libsvm::DEFAULT_PAGES:
+      return Py_BuildValue("s", "none");
+    case bob::learn::libsvm::TRANSPARENT_HUGE_PAGES:
+      return Py_BuildValue("s", "transparent");
+    case bob::learn::libsvm::EXPLICIT_HUGE_PAGES:
+      return Py_BuildValue("s", "explicit");
+    default:
+      PyErr_Format(PyExc_AssertionError, "illegal pages (%d) - DEBUG ME", self->cxx->getMemoryPolicy().pages);
+      return 0;
+  }
+}
+
+static int PyBobLearnLibsvmMachine_setHugePages
+(PyBobLearnLibsvmMachineObject* self, PyObject* o, void* /*closure*/) {
+
+  if (!o) {
+    PyErr_SetString(PyExc_TypeError, "cannot delete attribute");
+    return -1;
+  }
+
+  //portable way to extract a string from an object w/o macros
+  PyObject* args = Py_BuildValue("(O)", o);
+  auto args_ = make_safe(args);
+  const char* s = 0;
+  if (!PyArg_ParseTuple(args, "s", &s)) return -1;
+
+  std::string s_(s);
+  bob::learn::libsvm::MemoryPolicy policy = self->cxx->getMemoryPolicy();
+  if (s_ == "none") policy.pages = bob::learn::libsvm::DEFAULT_PAGES;
+  else if (s_ == "transparent")
+    policy.pages = bob::learn::libsvm::TRANSPARENT_HUGE_PAGES;
+  else if (s_ == "explicit")
+    policy.pages = bob::learn::libsvm::EXPLICIT_HUGE_PAGES;
+  else {
+    PyErr_Format(PyExc_ValueError, "huge pages `%s' are not supported by `%s' - choose from `none', `transparent' or `explicit'", s, Py_TYPE(self)->tp_name);
+    return -1;
+  }
+
+  try {
+    self->cxx->setMemoryPolicy(policy);
+  }
+  catch (std::exception& ex) {
+    PyErr_SetString(PyExc_RuntimeError, ex.what());
+    return -1;
+  }
+  catch (...) {
+    PyErr_Format(PyExc_RuntimeError, "cannot reset `huge_pages' of %s: unknown exception caught", Py_TYPE(self)->tp_name);
+    return -1;
+  }
+
+  return 0;
+
+}
+
+PyDoc_STRVAR(s_replicate_str, "replicate");
+PyDoc_STRVAR(s_replicate_doc,
+"If set to ``True``, the dense engine is copied on each NUMA node\n\
+of this host, each copy being built by a thread running on its\n\
+node. The workers of batch predictions are then pinned to the\n\
+nodes in turn, each reading the copy of its node, and single\n\
+predictions read the copy of the node they run on. This trades\n\
+memory for bandwidth with large models on multi-socket hosts. It\n\
+is ``False`` by default, and has no effect on hosts with a single\n\
+node or when predictions use libsvm, see :py:attr:`replicas`.\n\
+Setting it rebuilds the dense engine.\n\
+");
+
+static PyObject* PyBobLearnLibsvmMachine_getReplicate
+(PyBobLearnLibsvmMachineObject* self, void* /*closure*/) {
+  if (self->cxx->getMemoryPolicy().replicate) Py_RETURN_TRUE;
+  Py_RETURN_FALSE;
+}
+
+static int PyBobLearnLibsvmMachine_setReplicate
+(PyBobLearnLibsvmMachineObject* self, PyObject* o, void* /*closure*/) {
+
+  if (!o) {
+    PyErr_SetString(PyExc_TypeError, "cannot delete attribute");
+    return -1;
+  }
+
+  int v = PyObject_IsTrue(o);
+  if (v < 0) return -1;
+
+  bob::learn::libsvm::MemoryPolicy policy = self->cxx->getMemoryPolicy();
+  policy.replicate = v;
+
+  try {
+    self->cxx->setMemoryPolicy(policy);
+  }
+  catch (std::exception& ex) {
+    PyErr_SetString(PyExc_RuntimeError, ex.what());
+    return -1;
+  }
+  catch (...) {
+    PyErr_Format(PyExc_RuntimeError, "cannot reset `replicate' of %s: unknown exception caught", Py_TYPE(self)->tp_name);
+    return -1;
+  }
+
+  return 0;
+
+}
+
+PyDoc_STRVAR(s_replicas_str, "replicas");
+PyDoc_STRVAR(s_replicas_doc,
+"The number of copies of the dense engine this machine keeps: one\n\
+per NUMA node if :py:attr:`replicate` is set, one otherwise, and\n\
+zero if predictions use libsvm (read-only)\n\
+");
+
+static PyObject* PyBobLearnLibsvmMachine_getReplicas
+(PyBobLearnLibsvmMachineObject* self, void* /*closure*/) {
+  return Py_BuildValue("n", self->cxx->replicas());
+}
+
+PyDoc_STRVAR(s_collect_statistics_str, "collect_statistics");
+PyDoc_STRVAR(s_collect_statistics_doc,
+"If set to ``True``, this machine counts its predictions, the\n\
+kernel values they required and the time they took, see\n\
+:py:meth:`statistics`. Switching counters on starts from zero.\n\
+They are off by default and copies of this machine have their own.\n\
+");
+
+static PyObject* PyBobLearnLibsvmMachine_getCollectStatistics
+(PyBobLearnLibsvmMachineObject* self, void* /*closure*/) {
+  if (self->cxx->getCollectStatistics()) Py_RETURN_TRUE;
+  Py_RETURN_FALSE;
+}
+
+static int PyBobLearnLibsvmMachine_setCollectStatistics
+(PyBobLearnLibsvmMachineObject* self, PyObject* o, void* /*closure*/) {
+  if (!o) {
+    PyErr_SetString(PyExc_TypeError, "cannot delete attribute");
+    return -1;
+  }
+  int v = PyObject_IsTrue(o);
+  if (v < 0) return -1;
+  self->cxx->setCollectStatistics(v);
+  return 0;
+}
+
+PyDoc_STRVAR(s_cache_size_str, "cache_size");
+PyDoc_STRVAR(s_cache_size_doc,
+"Maximum size, in megabytes, of the cache of recent predictions,\n\
+keyed by the scaled inputs: inputs seen again are looked up\n\
+instead of being predicted again, see :py:meth:`cache_statistics`.\n\
+Zero, the default, turns the cache off. Setting the size, or the\n\
+:py:attr:`engine`, drops all cached predictions. Copies of this\n\
+machine start with their own, empty, cache of the same size.\n\
+");
+
+static PyObject* PyBobLearnLibsvmMachine_getCacheSize
+(PyBobLearnLibsvmMachineObject* self, void* /*closure*/) {
+  return Py_BuildValue("d", self->cxx->getCacheSize());
+}
+
+static int PyBobLearnLibsvmMachine_setCacheSize
+(PyBobLearnLibsvmMachineObject* self, PyObject* o, void* /*closure*/) {
+
+  if (!o) {
+    PyErr_SetString(PyExc_TypeError, "cannot delete attribute");
+    return -1;
+  }
+
+  double v = PyFloat_AsDouble(o);
+  if (PyErr_Occurred()) return -1;
+
+  if (v < 0.) {
+    PyErr_Format(PyExc_ValueError, "`%s' cannot have a negative cache size (%g megabytes)", Py_TYPE(self)->tp_name, v);
+    return -1;
+  }
+
+  self->cxx->setCacheSize(v);
+  return 0;
+
+}
+
 static PyGetSetDef PyBobLearnLibsvmMachine_getseters[] = {
     {
       s_input_subtract_str,
@@ -427,6 +762,55 @@ static PyGetSetDef PyBobLearnLibsvmMachine_getseters[] = {
       s_probability_doc,
       0
     },
+    {
+      s_engine_str,
+      (getter)PyBobLearnLibsvmMachine_getEngine,
+      (setter)PyBobLearnLibsvmMachine_setEngine,
+      s_engine_doc,
+      0
+    },
+    {
+      s_coupling_str,
+      (getter)PyBobLearnLibsvmMachine_getCoupling,
+      (setter)PyBobLearnLibsvmMachine_setCoupling,
+      s_coupling_doc,
+      0
+    },
+    {
+      s_huge_pages_str,
+      (getter)PyBobLearnLibsvmMachine_getHugePages,
+      (setter)PyBobLearnLibsvmMachine_setHugePages,
+      s_huge_pages_doc,
+      0
+    },
+    {
+      s_replicate_str,
+      (getter)PyBobLearnLibsvmMachine_getReplicate,
+      (setter)PyBobLearnLibsvmMachine_setReplicate,
+      s_replicate_doc,
+      0
+    },
+    {
+      s_replicas_str,
+      (getter)PyBobLearnLibsvmMachine_getReplicas,
+      0,
+      s_replicas_doc,
+      0
+    },
+    {
+      s_collect_statistics_str,
+      (getter)PyBobLearnLibsvmMachine_getCollectStatistics,
+      (setter)PyBobLearnLibsvmMachine_setCollectStatistics,
+      s_collect_statistics_doc,
+      0
+    },
+    {
+      s_cache_size_str,
+      (getter)PyBobLearnLibsvmMachine_getCacheSize,
+      (setter)PyBobLearnLibsvmMachine_setCacheSize,
+      s_cache_size_doc,
+      0
+    },
     {0}  /* Sentinel */
 };
 
@@ -476,48 +860,158 @@ PyObject* PyBobLearnLibsvmMachine_Str(PyBobLearnLibsvmMachineObject* self) {
 
 }
 
+/**
+ * What to compute for sparse inputs
+ */
+enum sparse_output_t {
+  SPARSE_CLASS,
+  SPARSE_SCORES,
+  SPARSE_PROBABILITIES
+};
+
+/**
+ * Batch prediction for inputs that look like a ``scipy.sparse`` CSR matrix,
+ * which are never densified. Outputs follow the rules for 2D inputs;
+ * ``out`` (scores or probabilities) is ignored for SPARSE_CLASS.
+ */
+static PyObject* PyBobLearnLibsvmMachine_predictSparse
+(PyBobLearnLibsvmMachineObject* self, PyObject* X, PyBlitzArrayObject* cls,
+ PyBlitzArrayObject* out, sparse_output_t what, Py_ssize_t threads) {
+
+  auto matrix = PyBobLearnLibsvm_AsSparse(X);
+  if (!matrix) return 0;
+
+  Py_ssize_t rows = matrix->rows();
+  Py_ssize_t N = self->cxx->outputSize();
+  Py_ssize_t columns = (what == SPARSE_SCORES) ?
+    (N < 2 ? 1 : (N*(N-1))/2) : self->cxx->numberOfClasses();
+
+  if (cls && (cls->ndim != 1 || cls->shape[0] != rows)) {
+    PyErr_Format(PyExc_RuntimeError, "the `cls' array should be 1D with %" PY_FORMAT_SIZE_T "d elements matching the number of rows on sparse `input'", rows);
+    return 0;
+  }
+
+  if (what != SPARSE_CLASS && out &&
+      (out->ndim != 2 || out->shape[0] != rows || out->shape[1] != columns)) {
+    PyErr_Format(PyExc_RuntimeError, "output array should be 2D with shape (%" PY_FORMAT_SIZE_T "d, %" PY_FORMAT_SIZE_T "d) for sparse `input' with %" PY_FORMAT_SIZE_T "d rows", rows, columns, rows);
+    return 0;
+  }
+
+  /** allocates outputs that were not given **/
+  if (cls) Py_INCREF(cls);
+  else {
+    cls = (PyBlitzArrayObject*)PyBlitzArray_SimpleNew(NPY_INT64, 1, &rows);
+    if (!cls) return 0;
+  }
+  auto cls_ = make_safe(cls);
+
+  boost::shared_ptr<PyBlitzArrayObject> out_;
+  if (what != SPARSE_CLASS) {
+    if (out) Py_INCREF(out);
+    else {
+      Py_ssize_t osize[2] = {rows, columns};
+      out = (PyBlitzArrayObject*)PyBlitzArray_SimpleNew(NPY_FLOAT64, 2, osize);
+      if (!out) return 0;
+    }
+    out_ = make_safe(out);
+  }
+
+  try {
+    auto bzcls = PyBlitzArrayCxx_AsBlitz<int64_t,1>(cls);
+    if (what == SPARSE_CLASS) {
+      PyBobLearnLibsvmNoGIL nogil;
+      self->cxx->predictClass(*matrix, *bzcls, threads);
+    }
+    else {
+      auto bzout = PyBlitzArrayCxx_AsBlitz<double,2>(out);
+      PyBobLearnLibsvmNoGIL nogil;
+      if (what == SPARSE_SCORES)
+        self->cxx->predictClassAndScores(*matrix, *bzcls, *bzout, threads);
+      else
+        self->cxx->predictClassAndProbabilities(*matrix, *bzcls, *bzout,
+            threads);
+    }
+  }
+  catch (std::exception& e) {
+    PyErr_SetString(PyExc_RuntimeError, e.what());
+    return 0;
+  }
+  catch (...) {
+    PyErr_Format(PyExc_RuntimeError, "%s cannot forward data: unknown exception caught", Py_TYPE(self)->tp_name);
+    return 0;
+  }
+
+  if (what == SPARSE_CLASS) {
+    Py_INCREF(cls);
+    return PyBlitzArray_NUMPY_WRAP(reinterpret_cast<PyObject*>(cls));
+  }
+
+  Py_INCREF(cls);
+  Py_INCREF(out);
+  return Py_BuildValue("OO",
+      PyBlitzArray_NUMPY_WRAP(reinterpret_cast<PyObject*>(cls)),
+      PyBlitzArray_NUMPY_WRAP(reinterpret_cast<PyObject*>(out))
+      );
+
+}
+
 PyDoc_STRVAR(s_forward_str, "forward");
 PyDoc_STRVAR(s_forward_doc,
-"o.forward(input, [output]) -> array\n\
+"o.forward(input, [output, [threads]]) -> array\n\
 \n\
-o.predict_class(input, [output]) -> array\n\
+o.predict_class(input, [output, [threads]]) -> array\n\
 \n\
-o(input, [output]) -> array\n\
+o(input, [output, [threads]]) -> array\n\
 \n\
 Calculates the **predicted class** using this Machine, given\n\
 one single feature vector or multiple ones.\n\
 \n\
-The ``input`` array can be either 1D or 2D 64-bit float arrays.\n\
+The ``input`` array can be either 1D or 2D, 32 or 64-bit float\n\
+arrays. Single precision inputs are scaled as they are predicted,\n\
+without being converted as a whole.\n\
 The ``output`` array, if provided, must be of type ``int64``,\n\
 always uni-dimensional. The output corresponds to the predicted\n\
 classes for each of the input rows.\n\
 \n\
+If ``input`` is 2D, rows are split between ``threads`` workers\n\
+(defaults to 1). If ``threads`` is set to zero, then use as many\n\
+workers as there are hardware threads on this machine. The Python\n\
+global interpreter lock is released during the computation.\n\
+\n\
+The ``input`` may also be a sparse matrix in CSR format, such as a\n\
+:py:class:`scipy.sparse.csr_matrix` or any object with ``indptr``,\n\
+``indices``, ``data`` and ``shape`` attributes. Rows are then\n\
+treated like those of a 2D array, but are never densified. Columns\n\
+not used by the machine are ignored. Sparse inputs require a machine\n\
+that does not subtract values from inputs.\n\
+\n\
 .. note::\n\
 \n\
-   This method only accepts 64-bit float arrays as input and\n\
-   64-bit integers as output.\n\
+   This method only accepts 32 or 64-bit float arrays as input\n\
+   and 64-bit integers as output.\n\
 \n");
 
 static PyObject* PyBobLearnLibsvmMachine_forward
 (PyBobLearnLibsvmMachineObject* self, PyObject* args, PyObject* kwds) {
 
-  static const char* const_kwlist[] = {"input", "output", 0};
+  static const char* const_kwlist[] = {"input", "output", "threads", 0};
   static char** kwlist = const_cast<char**>(const_kwlist);
 
-  PyBlitzArrayObject* input = 0;
+  PyObject* X = 0;
   PyBlitzArrayObject* output = 0;
+  Py_ssize_t threads = 1;
 
-  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&|O&", kwlist,
-        &PyBlitzArray_Converter, &input,
-        &PyBlitzArray_OutputConverter, &output
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|O&n", kwlist,
+        &X,
+        &PyBlitzArray_OutputConverter, &output,
+        &threads
         )) return 0;
 
   //protects acquired resources through this scope
-  auto input_ = make_safe(input);
   auto output_ = make_xsafe(output);
 
-  if (input->type_num != NPY_FLOAT64) {
-    PyErr_Format(PyExc_TypeError, "`%s' only supports 64-bit float arrays for input array `input'", Py_TYPE(self)->tp_name);
+  if (threads < 0) {
+    PyErr_Format(PyExc_ValueError, "`%s' requires a non-negative number of `threads' (or zero, to use all available cores), not %" PY_FORMAT_SIZE_T "d", Py_TYPE(self)->tp_name, threads);
     return 0;
   }
 
@@ -526,6 +1020,19 @@ static PyObject* PyBobLearnLibsvmMachine_forward
     return 0;
   }
 
+  if (PyBobLearnLibsvm_IsSparse(X))
+    return PyBobLearnLibsvmMachine_predictSparse(self, X, output, 0,
+        SPARSE_CLASS, threads);
+
+  PyBlitzArrayObject* input = 0;
+  if (!PyBlitzArray_Converter(X, &input)) return 0;
+  auto input_ = make_safe(input);
+
+  if (input->type_num != NPY_FLOAT64 && input->type_num != NPY_FLOAT32) {
+    PyErr_Format(PyExc_TypeError, "`%s' only supports 32 or 64-bit float arrays for input array `input'", Py_TYPE(self)->tp_name);
+    return 0;
+  }
+
   if (input->ndim < 1 || input->ndim > 2) {
     PyErr_Format(PyExc_TypeError, "`%s' only accepts 1 or 2-dimensional arrays (not %" PY_FORMAT_SIZE_T "dD arrays)", Py_TYPE(self)->tp_name, input->ndim);
     return 0;
@@ -567,18 +1074,25 @@ static PyObject* PyBobLearnLibsvmMachine_forward
 
   /** all basic checks are done, can call the machine now **/
   try {
-    if (input->ndim == 1) {
+    if (input->ndim == 1 && input->type_num == NPY_FLOAT32) {
+      auto bzout = PyBlitzArrayCxx_AsBlitz<int64_t,1>(output);
+      (*bzout)(0) = self->cxx->predictClass_(*PyBlitzArrayCxx_AsBlitz<float,1>(input));
+    }
+    else if (input->ndim == 1) {
       auto bzout = PyBlitzArrayCxx_AsBlitz<int64_t,1>(output);
       (*bzout)(0) = self->cxx->predictClass_(*PyBlitzArrayCxx_AsBlitz<double,1>(input));
     }
+    else if (input->type_num == NPY_FLOAT32) {
+      auto bzin = PyBlitzArrayCxx_AsBlitz<float,2>(input);
+      auto bzout = PyBlitzArrayCxx_AsBlitz<int64_t,1>(output);
+      PyBobLearnLibsvmNoGIL nogil;
+      self->cxx->predictClass_(*bzin, *bzout, threads); ///< no need to re-check
+    }
     else {
       auto bzin = PyBlitzArrayCxx_AsBlitz<double,2>(input);
       auto bzout = PyBlitzArrayCxx_AsBlitz<int64_t,1>(output);
-      blitz::Range all = blitz::Range::all();
-      for (int k=0; k<bzin->extent(0); ++k) {
-        blitz::Array<double,1> i_ = (*bzin)(k, all);
-        (*bzout)(k) = self->cxx->predictClass_(i_); ///< no need to re-check
-      }
+      PyBobLearnLibsvmNoGIL nogil;
+      self->cxx->predictClass_(*bzin, *bzout, threads); ///< no need to re-check
     }
   }
   catch (std::exception& e) {
@@ -597,13 +1111,14 @@ static PyObject* PyBobLearnLibsvmMachine_forward
 
 PyDoc_STRVAR(s_scores_str, "predict_class_and_scores");
 PyDoc_STRVAR(s_scores_doc,
-"o.predict_class_and_scores(input, [cls, [score]]) -> (array, array)\n\
+"o.predict_class_and_scores(input, [cls, [score, [threads]]]) -> (array, array)\n\
 \n\
 Calculates the **predicted class** and output scores for the SVM\n\
 using the this Machine, given one single feature vector or multiple\n\
 ones.\n\
 \n\
-The ``input`` array can be either 1D or 2D 64-bit float arrays.\n\
+The ``input`` array can be either 1D or 2D, 32 or 64-bit float\n\
+arrays.\n\
 The ``cls`` array, if provided, must be of type ``int64``,\n\
 always uni-dimensional. The ``cls`` output corresponds to the\n\
 predicted classes for each of the input rows. The ``score`` array,\n\
@@ -625,36 +1140,72 @@ If you don't provide the arrays upon calling this method, we will\n\
 allocate new ones internally and return them. If you are calling\n\
 this method on a tight loop, it is recommended you pass the ``cls``\n\
 and ``score`` arrays to avoid constant re-allocation.\n\
+\n\
+If ``input`` is 2D, rows are split between ``threads`` workers\n\
+(defaults to 1). If ``threads`` is set to zero, then use as many\n\
+workers as there are hardware threads on this machine. The Python\n\
+global interpreter lock is released during the computation.\n\
+\n\
+The ``input`` may also be a sparse matrix in CSR format, such as a\n\
+:py:class:`scipy.sparse.csr_matrix` or any object with ``indptr``,\n\
+``indices``, ``data`` and ``shape`` attributes. Rows are then\n\
+treated like those of a 2D array, but are never densified. Columns\n\
+not used by the machine are ignored. Sparse inputs require a machine\n\
+that does not subtract values from inputs.\n\
 ");
 
 static PyObject* PyBobLearnLibsvmMachine_predictClassAndScores
 (PyBobLearnLibsvmMachineObject* self, PyObject* args, PyObject* kwds) {
 
-  static const char* const_kwlist[] = {"input", "cls", "score", 0};
+  static const char* const_kwlist[] = {"input", "cls", "score", "threads", 0};
   static char** kwlist = const_cast<char**>(const_kwlist);
 
-  PyBlitzArrayObject* input = 0;
+  PyObject* X = 0;
   PyBlitzArrayObject* cls = 0;
   PyBlitzArrayObject* score = 0;
 
-  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&|O&O&", kwlist,
-        &PyBlitzArray_Converter, &input,
+  Py_ssize_t threads = 1;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|O&O&n", kwlist,
+        &X,
         &PyBlitzArray_OutputConverter, &cls,
-        &PyBlitzArray_OutputConverter, &score
+        &PyBlitzArray_OutputConverter, &score,
+        &threads
         )) return 0;
 
   //protects acquired resources through this scope
-  auto input_ = make_safe(input);
   auto cls_ = make_xsafe(cls);
   auto score_ = make_xsafe(score);
 
+  if (PyBobLearnLibsvm_IsSparse(X)) {
+    if (threads < 0) {
+      PyErr_Format(PyExc_ValueError, "`%s' requires a non-negative number of `threads' (or zero, to use all available cores), not %" PY_FORMAT_SIZE_T "d", Py_TYPE(self)->tp_name, threads);
+      return 0;
+    }
+    if ((cls && cls->type_num != NPY_INT64) || (score && score->type_num != NPY_FLOAT64)) {
+      PyErr_Format(PyExc_TypeError, "`%s' only supports 64-bit integer arrays for `cls' and 64-bit float arrays for `score'", Py_TYPE(self)->tp_name);
+      return 0;
+    }
+    return PyBobLearnLibsvmMachine_predictSparse(self, X, cls, score,
+        SPARSE_SCORES, threads);
+  }
+
+  PyBlitzArrayObject* input = 0;
+  if (!PyBlitzArray_Converter(X, &input)) return 0;
+  auto input_ = make_safe(input);
+
   //calculates the number of scores expected: combinatorics between
   //all class outputs
   Py_ssize_t N = self->cxx->outputSize();
   Py_ssize_t number_of_scores = N < 2 ? 1 : (N*(N-1))/2;
 
-  if (input->type_num != NPY_FLOAT64) {
-    PyErr_Format(PyExc_TypeError, "`%s' only supports 64-bit float arrays for input array `input'", Py_TYPE(self)->tp_name);
+  if (input->type_num != NPY_FLOAT64 && input->type_num != NPY_FLOAT32) {
+    PyErr_Format(PyExc_TypeError, "`%s' only supports 32 or 64-bit float arrays for input array `input'", Py_TYPE(self)->tp_name);
+    return 0;
+  }
+
+  if (threads < 0) {
+    PyErr_Format(PyExc_ValueError, "`%s' requires a non-negative number of `threads' (or zero, to use all available cores), not %" PY_FORMAT_SIZE_T "d", Py_TYPE(self)->tp_name, threads);
     return 0;
   }
 
@@ -740,22 +1291,31 @@ static PyObject* PyBobLearnLibsvmMachine_predictClassAndScores
 
   /** all basic checks are done, can call the machine now **/
   try {
-    if (input->ndim == 1) {
+    if (input->ndim == 1 && input->type_num == NPY_FLOAT32) {
+      auto bzin = PyBlitzArrayCxx_AsBlitz<float,1>(input);
+      auto bzcls = PyBlitzArrayCxx_AsBlitz<int64_t,1>(cls);
+      auto bzscore = PyBlitzArrayCxx_AsBlitz<double,1>(score);
+      (*bzcls)(0) = self->cxx->predictClassAndScores_(*bzin, *bzscore);
+    }
+    else if (input->ndim == 1) {
       auto bzin = PyBlitzArrayCxx_AsBlitz<double,1>(input);
       auto bzcls = PyBlitzArrayCxx_AsBlitz<int64_t,1>(cls);
       auto bzscore = PyBlitzArrayCxx_AsBlitz<double,1>(score);
       (*bzcls)(0) = self->cxx->predictClassAndScores_(*bzin, *bzscore);
     }
+    else if (input->type_num == NPY_FLOAT32) {
+      auto bzin = PyBlitzArrayCxx_AsBlitz<float,2>(input);
+      auto bzcls = PyBlitzArrayCxx_AsBlitz<int64_t,1>(cls);
+      auto bzscore = PyBlitzArrayCxx_AsBlitz<double,2>(score);
+      PyBobLearnLibsvmNoGIL nogil;
+      self->cxx->predictClassAndScores_(*bzin, *bzcls, *bzscore, threads);
+    }
     else {
       auto bzin = PyBlitzArrayCxx_AsBlitz<double,2>(input);
       auto bzcls = PyBlitzArrayCxx_AsBlitz<int64_t,1>(cls);
       auto bzscore = PyBlitzArrayCxx_AsBlitz<double,2>(score);
-      blitz::Range all = blitz::Range::all();
-      for (int k=0; k<bzin->extent(0); ++k) {
-        blitz::Array<double,1> i_ = (*bzin)(k, all);
-        blitz::Array<double,1> s_ = (*bzscore)(k, all);
-        (*bzcls)(k) = self->cxx->predictClassAndScores_(i_, s_);
-      }
+      PyBobLearnLibsvmNoGIL nogil;
+      self->cxx->predictClassAndScores_(*bzin, *bzcls, *bzscore, threads);
     }
   }
   catch (std::exception& e) {
@@ -778,13 +1338,14 @@ static PyObject* PyBobLearnLibsvmMachine_predictClassAndScores
 
 PyDoc_STRVAR(s_probabilities_str, "predict_class_and_probabilities");
 PyDoc_STRVAR(s_probabilities_doc,
-"o.predict_class_and_probabilities(input, [cls, [prob]]) -> (array, array)\n\
+"o.predict_class_and_probabilities(input, [cls, [prob, [threads]]]) -> (array, array)\n\
 \n\
 Calculates the **predicted class** and output probabilities for the\n\
 SVM using the this Machine, given one single feature vector or\n\
 multiple ones.\n\
 \n\
-The ``input`` array can be either 1D or 2D 64-bit float arrays.\n\
+The ``input`` array can be either 1D or 2D, 32 or 64-bit float\n\
+arrays.\n\
 The ``cls`` array, if provided, must be of type ``int64``,\n\
 always uni-dimensional. The ``cls`` output corresponds to the\n\
 predicted classes for each of the input rows. The ``prob`` array,\n\
@@ -799,6 +1360,18 @@ array. If you don't provide the arrays upon calling this method, we\n\
 will allocate new ones internally and return them. If you are calling\n\
 this method on a tight loop, it is recommended you pass the ``cls``\n\
 and ``prob`` arrays to avoid constant re-allocation.\n\
+\n\
+If ``input`` is 2D, rows are split between ``threads`` workers\n\
+(defaults to 1). If ``threads`` is set to zero, then use as many\n\
+workers as there are hardware threads on this machine. The Python\n\
+global interpreter lock is released during the computation.\n\
+\n\
+The ``input`` may also be a sparse matrix in CSR format, such as a\n\
+:py:class:`scipy.sparse.csr_matrix` or any object with ``indptr``,\n\
+``indices``, ``data`` and ``shape`` attributes. Rows are then\n\
+treated like those of a 2D array, but are never densified. Columns\n\
+not used by the machine are ignored. Sparse inputs require a machine\n\
+that does not subtract values from inputs.\n\
 ");
 
 static PyObject* PyBobLearnLibsvmMachine_predictClassAndProbabilities
@@ -809,26 +1382,50 @@ static PyObject* PyBobLearnLibsvmMachine_predictClassAndProbabilities
     return 0;
   }
 
-  static const char* const_kwlist[] = {"input", "cls", "prob", 0};
+  static const char* const_kwlist[] = {"input", "cls", "prob", "threads", 0};
   static char** kwlist = const_cast<char**>(const_kwlist);
 
-  PyBlitzArrayObject* input = 0;
+  PyObject* X = 0;
   PyBlitzArrayObject* cls = 0;
   PyBlitzArrayObject* prob= 0;
 
-  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&|O&O&", kwlist,
-        &PyBlitzArray_Converter, &input,
+  Py_ssize_t threads = 1;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|O&O&n", kwlist,
+        &X,
         &PyBlitzArray_OutputConverter, &cls,
-        &PyBlitzArray_OutputConverter, &prob
+        &PyBlitzArray_OutputConverter, &prob,
+        &threads
         )) return 0;
 
   //protects acquired resources through this scope
-  auto input_ = make_safe(input);
   auto cls_ = make_xsafe(cls);
   auto prob_ = make_xsafe(prob);
 
-  if (input->type_num != NPY_FLOAT64) {
-    PyErr_Format(PyExc_TypeError, "`%s' only supports 64-bit float arrays for input array `input'", Py_TYPE(self)->tp_name);
+  if (PyBobLearnLibsvm_IsSparse(X)) {
+    if (threads < 0) {
+      PyErr_Format(PyExc_ValueError, "`%s' requires a non-negative number of `threads' (or zero, to use all available cores), not %" PY_FORMAT_SIZE_T "d", Py_TYPE(self)->tp_name, threads);
+      return 0;
+    }
+    if ((cls && cls->type_num != NPY_INT64) || (prob && prob->type_num != NPY_FLOAT64)) {
+      PyErr_Format(PyExc_TypeError, "`%s' only supports 64-bit integer arrays for `cls' and 64-bit float arrays for `prob'", Py_TYPE(self)->tp_name);
+      return 0;
+    }
+    return PyBobLearnLibsvmMachine_predictSparse(self, X, cls, prob,
+        SPARSE_PROBABILITIES, threads);
+  }
+
+  PyBlitzArrayObject* input = 0;
+  if (!PyBlitzArray_Converter(X, &input)) return 0;
+  auto input_ = make_safe(input);
+
+  if (input->type_num != NPY_FLOAT64 && input->type_num != NPY_FLOAT32) {
+    PyErr_Format(PyExc_TypeError, "`%s' only supports 32 or 64-bit float arrays for input array `input'", Py_TYPE(self)->tp_name);
+    return 0;
+  }
+
+  if (threads < 0) {
+    PyErr_Format(PyExc_ValueError, "`%s' requires a non-negative number of `threads' (or zero, to use all available cores), not %" PY_FORMAT_SIZE_T "d", Py_TYPE(self)->tp_name, threads);
     return 0;
   }
 
@@ -914,22 +1511,31 @@ static PyObject* PyBobLearnLibsvmMachine_predictClassAndProbabilities
 
   /** all basic checks are done, can call the machine now **/
   try {
-    if (input->ndim == 1) {
+    if (input->ndim == 1 && input->type_num == NPY_FLOAT32) {
+      auto bzin = PyBlitzArrayCxx_AsBlitz<float,1>(input);
+      auto bzcls = PyBlitzArrayCxx_AsBlitz<int64_t,1>(cls);
+      auto bzprob = PyBlitzArrayCxx_AsBlitz<double,1>(prob);
+      (*bzcls)(0) = self->cxx->predictClassAndProbabilities_(*bzin, *bzprob);
+    }
+    else if (input->ndim == 1) {
       auto bzin = PyBlitzArrayCxx_AsBlitz<double,1>(input);
       auto bzcls = PyBlitzArrayCxx_AsBlitz<int64_t,1>(cls);
       auto bzprob = PyBlitzArrayCxx_AsBlitz<double,1>(prob);
       (*bzcls)(0) = self->cxx->predictClassAndProbabilities_(*bzin, *bzprob);
     }
+    else if (input->type_num == NPY_FLOAT32) {
+      auto bzin = PyBlitzArrayCxx_AsBlitz<float,2>(input);
+      auto bzcls = PyBlitzArrayCxx_AsBlitz<int64_t,1>(cls);
+      auto bzprob = PyBlitzArrayCxx_AsBlitz<double,2>(prob);
+      PyBobLearnLibsvmNoGIL nogil;
+      self->cxx->predictClassAndProbabilities_(*bzin, *bzcls, *bzprob, threads);
+    }
     else {
       auto bzin = PyBlitzArrayCxx_AsBlitz<double,2>(input);
       auto bzcls = PyBlitzArrayCxx_AsBlitz<int64_t,1>(cls);
       auto bzprob = PyBlitzArrayCxx_AsBlitz<double,2>(prob);
-      blitz::Range all = blitz::Range::all();
-      for (int k=0; k<bzin->extent(0); ++k) {
-        blitz::Array<double,1> i_ = (*bzin)(k, all);
-        blitz::Array<double,1> p_ = (*bzprob)(k, all);
-        (*bzcls)(k) = self->cxx->predictClassAndProbabilities_(i_, p_);
-      }
+      PyBobLearnLibsvmNoGIL nogil;
+      self->cxx->predictClassAndProbabilities_(*bzin, *bzcls, *bzprob, threads);
     }
   }
   catch (std::exception& e) {
@@ -1017,6 +1623,338 @@ static PyObject* PyBobLearnLibsvmMachine_Save
 
 }
 
+PyDoc_STRVAR(s_save_binary_str, "save_binary");
+PyDoc_STRVAR(s_save_binary_doc,
+"o.save_binary(path) -> None\n\
+\n\
+Saves itself, including input normalization options, in a\n\
+compact binary format. Machines built from such files map the\n\
+model in memory: support vectors are neither parsed nor\n\
+copied, which makes loading very large models nearly\n\
+instantaneous. Files are only portable between machines with\n\
+the same byte order.\n\
+");
+
+static PyObject* PyBobLearnLibsvmMachine_SaveBinary
+(PyBobLearnLibsvmMachineObject* self, PyObject* f) {
+
+  PyObject* filename = 0;
+  int ok = PyBobIo_FilenameConverter(f, &filename);
+  if (!ok) {
+    PyErr_Format(PyExc_TypeError, "cannot convert `%s' into a valid string for a file path", Py_TYPE(f)->tp_name);
+    return 0;
+  }
+
+  auto filename_ = make_safe(filename);
+
+#if PY_VERSION_HEX >= 0x03000000
+  const char* c_filename = PyBytes_AS_STRING(filename);
+#else
+  const char* c_filename = PyString_AS_STRING(filename);
+#endif
+
+  try {
+    self->cxx->saveBinary(c_filename);
+  }
+  catch (std::exception& ex) {
+    PyErr_SetString(PyExc_RuntimeError, ex.what());
+    return 0;
+  }
+  catch (...) {
+    PyErr_Format(PyExc_RuntimeError, "`%s' cannot write data to file `%s' (using the binary format): unknown exception caught", Py_TYPE(self)->tp_name, c_filename);
+    return 0;
+  }
+
+  Py_RETURN_NONE;
+
+}
+
+PyDoc_STRVAR(s_compress_str, "compress");
+PyDoc_STRVAR(s_compress_doc,
+"o.compress(max_error, [size=0, [threads=1]]) -> Machine\n\
+\n\
+Returns a new machine, with less support vectors than this one,\n\
+whose scores never differ by more than ``max_error`` from the\n\
+scores of this machine, whatever the input. Prediction time is\n\
+proportional to the number of support vectors.\n\
+\n\
+Support vectors of each class are repeatedly merged with their\n\
+nearest neighbour, or pruned if their coefficients are small,\n\
+cheapest first. Each operation is bounded by the norm of what it\n\
+leaves out in the kernel's feature space, and operations stop when\n\
+the sum of these bounds would exceed ``max_error`` for any\n\
+decision function, or when only ``size`` support vectors are left,\n\
+if ``size`` is not zero. Each class keeps, at least, one support\n\
+vector.\n\
+\n\
+Only machines with RBF kernels can be compressed. Neighbours are\n\
+searched for with up to ``threads`` threads (zero means one per\n\
+hardware thread). Probability estimates, if any, are kept as they\n\
+are. Use :py:meth:`fidelity` to measure the effects of compression\n\
+on validation data.\n\
+");
+
+static PyObject* PyBobLearnLibsvmMachine_Compress
+(PyBobLearnLibsvmMachineObject* self, PyObject* args, PyObject* kwds) {
+
+  static const char* const_kwlist[] = {"max_error", "size", "threads", 0};
+  static char** kwlist = const_cast<char**>(const_kwlist);
+
+  double max_error = 0.;
+  Py_ssize_t size = 0;
+  Py_ssize_t threads = 1;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "d|nn", kwlist,
+        &max_error, &size, &threads)) return 0;
+
+  if (size < 0) {
+    PyErr_Format(PyExc_ValueError, "`%s' requires a non-negative `size' (or zero, to only bound the error), not %" PY_FORMAT_SIZE_T "d", Py_TYPE(self)->tp_name, size);
+    return 0;
+  }
+
+  if (threads < 0) {
+    PyErr_Format(PyExc_ValueError, "`%s' requires a non-negative number of `threads' (or zero, to use all available cores), not %" PY_FORMAT_SIZE_T "d", Py_TYPE(self)->tp_name, threads);
+    return 0;
+  }
+
+  bob::learn::libsvm::Machine* retval = 0;
+  try {
+    PyBobLearnLibsvmNoGIL nogil;
+    retval = self->cxx->compress(max_error, size, threads);
+  }
+  catch (std::exception& ex) {
+    PyErr_SetString(PyExc_RuntimeError, ex.what());
+    return 0;
+  }
+  catch (...) {
+    PyErr_Format(PyExc_RuntimeError, "`%s' cannot be compressed: unknown exception caught", Py_TYPE(self)->tp_name);
+    return 0;
+  }
+
+  return PyBobLearnLibsvmMachine_NewFromMachine(retval);
+
+}
+
+PyDoc_STRVAR(s_fidelity_str, "fidelity");
+PyDoc_STRVAR(s_fidelity_doc,
+"o.fidelity(other, validation, [threads=1]) -> (int, float, float, float)\n\
+\n\
+Compares the predictions of the machine ``other`` (typically,\n\
+one returned by :py:meth:`compress`) with the ones of this\n\
+machine, on all rows of the 2D 64-bit float array\n\
+``validation``. Both machines must have the same input size and\n\
+classes. Predictions are run on up to ``threads`` threads.\n\
+\n\
+Returns the number of validation samples, the fraction of them\n\
+predicted in the same class by both machines, and the largest\n\
+and the mean absolute differences between their scores.\n\
+");
+
+static PyObject* PyBobLearnLibsvmMachine_Fidelity
+(PyBobLearnLibsvmMachineObject* self, PyObject* args, PyObject* kwds) {
+
+  static const char* const_kwlist[] = {"other", "validation", "threads", 0};
+  static char** kwlist = const_cast<char**>(const_kwlist);
+
+  PyBobLearnLibsvmMachineObject* other = 0;
+  PyBlitzArrayObject* validation = 0;
+  Py_ssize_t threads = 1;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!O&|n", kwlist,
+        &PyBobLearnLibsvmMachine_Type, &other,
+        &PyBlitzArray_Converter, &validation,
+        &threads)) return 0;
+
+  auto validation_ = make_safe(validation);
+
+  if (validation->type_num != NPY_FLOAT64 || validation->ndim != 2) {
+    PyErr_Format(PyExc_TypeError, "`%s' only supports 2D 64-bit float arrays for `validation'", Py_TYPE(self)->tp_name);
+    return 0;
+  }
+
+  if (threads < 0) {
+    PyErr_Format(PyExc_ValueError, "`%s' requires a non-negative number of `threads' (or zero, to use all available cores), not %" PY_FORMAT_SIZE_T "d", Py_TYPE(self)->tp_name, threads);
+    return 0;
+  }
+
+  bob::learn::libsvm::Fidelity retval;
+  try {
+    auto bzvalidation = PyBlitzArrayCxx_AsBlitz<double,2>(validation);
+    PyBobLearnLibsvmNoGIL nogil;
+    retval = self->cxx->fidelity(*other->cxx, *bzvalidation, threads);
+  }
+  catch (std::exception& ex) {
+    PyErr_SetString(PyExc_RuntimeError, ex.what());
+    return 0;
+  }
+  catch (...) {
+    PyErr_Format(PyExc_RuntimeError, "`%s' cannot be compared: unknown exception caught", Py_TYPE(self)->tp_name);
+    return 0;
+  }
+
+  return Py_BuildValue("nddd", (Py_ssize_t)retval.samples, retval.agreement,
+      retval.max_error, retval.mean_error);
+
+}
+
+PyDoc_STRVAR(s_copy_str, "__copy__");
+PyDoc_STRVAR(s_copy_doc,
+"o.__copy__() -> Machine\n\
+\n\
+Returns an independent copy of this machine, including the\n\
+input normalization parameters. The underlying LIBSVM model\n\
+is copied in memory, without going through disk or through\n\
+LIBSVM's text format.\n\
+");
+
+static PyObject* PyBobLearnLibsvmMachine_Copy
+(PyBobLearnLibsvmMachineObject* self) {
+
+  try {
+    return PyBobLearnLibsvmMachine_NewFromMachine(new bob::learn::libsvm::Machine(*self->cxx));
+  }
+  catch (std::exception& ex) {
+    PyErr_SetString(PyExc_RuntimeError, ex.what());
+    return 0;
+  }
+  catch (...) {
+    PyErr_Format(PyExc_RuntimeError, "`%s' cannot be copied: unknown exception caught", Py_TYPE(self)->tp_name);
+    return 0;
+  }
+
+}
+
+PyDoc_STRVAR(s_deepcopy_str, "__deepcopy__");
+PyDoc_STRVAR(s_deepcopy_doc,
+"o.__deepcopy__(memo) -> Machine\n\
+\n\
+Same as :py:meth:`__copy__`, machines hold no references to\n\
+other Python objects.\n\
+");
+
+static PyObject* PyBobLearnLibsvmMachine_DeepCopy
+(PyBobLearnLibsvmMachineObject* self, PyObject*) {
+  return PyBobLearnLibsvmMachine_Copy(self);
+}
+
+PyDoc_STRVAR(s_statistics_str, "statistics");
+PyDoc_STRVAR(s_statistics_doc,
+"o.statistics() -> dict\n\
+\n\
+Returns the counters on the predictions of this machine, since\n\
+:py:attr:`collect_statistics` was set or since the last call to\n\
+:py:meth:`reset_statistics`, which are all zero if counters are\n\
+off. Keys are:\n\
+\n\
+``calls``\n\
+  calls to prediction methods, for single inputs or for batches\n\
+``predictions``\n\
+  inputs predicted\n\
+``kernel_evaluations``\n\
+  kernel values computed (zero for linear models on the\n\
+  ``'dense'`` engines, which do not evaluate kernels)\n\
+``conversion``, ``kernel``, ``voting``\n\
+  seconds spent scaling and converting inputs, computing kernel\n\
+  and decision values, and voting and estimating probabilities,\n\
+  summed over all threads. The ``'libsvm'`` engine does not tell\n\
+  kernels and voting apart: its time is all under ``kernel``.\n\
+``latency``\n\
+  a histogram of the duration of calls, as a list: position 0\n\
+  counts calls that took less than a microsecond and position\n\
+  ``k`` those that took between ``2**(k-1)`` and ``2**k``\n\
+  microseconds.\n\
+\n\
+");
+
+static PyObject* PyBobLearnLibsvmMachine_Statistics
+(PyBobLearnLibsvmMachineObject* self) {
+
+  bob::learn::libsvm::PredictionStatistics s = self->cxx->getStatistics();
+
+  PyObject* latency = PyList_New(s.latency.size());
+  if (!latency) return 0;
+  auto latency_ = make_safe(latency);
+  for (size_t k=0; k<s.latency.size(); ++k) {
+    PyObject* v = PyLong_FromUnsignedLongLong(s.latency[k]);
+    if (!v) return 0;
+    PyList_SET_ITEM(latency, k, v);
+  }
+
+  return Py_BuildValue("{s:K,s:K,s:K,s:d,s:d,s:d,s:O}",
+      "calls", (unsigned long long)s.calls,
+      "predictions", (unsigned long long)s.predictions,
+      "kernel_evaluations", (unsigned long long)s.kernel_evaluations,
+      "conversion", s.conversion,
+      "kernel", s.kernel,
+      "voting", s.voting,
+      "latency", latency);
+
+}
+
+PyDoc_STRVAR(s_reset_statistics_str, "reset_statistics");
+PyDoc_STRVAR(s_reset_statistics_doc,
+"o.reset_statistics() -> None\n\
+\n\
+Sets all counters returned by :py:meth:`statistics` back to zero.\n\
+");
+
+static PyObject* PyBobLearnLibsvmMachine_ResetStatistics
+(PyBobLearnLibsvmMachineObject* self) {
+  self->cxx->resetStatistics();
+  Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(s_cache_statistics_str, "cache_statistics");
+PyDoc_STRVAR(s_cache_statistics_doc,
+"o.cache_statistics() -> dict\n\
+\n\
+Returns the counters of the cache of predictions (see\n\
+:py:attr:`cache_size`), which are all zero if it is off. Keys are:\n\
+\n\
+``hits``\n\
+  predictions found in the cache\n\
+``misses``\n\
+  predictions computed, and added to the cache\n\
+``evictions``\n\
+  entries dropped to make room for new ones\n\
+``entries``\n\
+  entries currently in the cache\n\
+``used``, ``size``\n\
+  megabytes currently used and maximum size of the cache\n\
+\n\
+Scores and probabilities are cached separately: an input whose\n\
+scores are cached is a miss when its probabilities are asked for.\n\
+");
+
+static PyObject* PyBobLearnLibsvmMachine_CacheStatistics
+(PyBobLearnLibsvmMachineObject* self) {
+
+  bob::learn::libsvm::CacheStatistics s = self->cxx->getCacheStatistics();
+
+  return Py_BuildValue("{s:K,s:K,s:K,s:K,s:d,s:d}",
+      "hits", (unsigned long long)s.hits,
+      "misses", (unsigned long long)s.misses,
+      "evictions", (unsigned long long)s.evictions,
+      "entries", (unsigned long long)s.entries,
+      "used", s.used,
+      "size", s.size);
+
+}
+
+PyDoc_STRVAR(s_clear_cache_str, "clear_cache");
+PyDoc_STRVAR(s_clear_cache_doc,
+"o.clear_cache() -> None\n\
+\n\
+Drops all cached predictions and sets the counters returned by\n\
+:py:meth:`cache_statistics` back to zero.\n\
+");
+
+static PyObject* PyBobLearnLibsvmMachine_ClearCache
+(PyBobLearnLibsvmMachineObject* self) {
+  self->cxx->clearCache();
+  Py_RETURN_NONE;
+}
+
 PyDoc_STRVAR(s_predict_class_str, "predict_class");
 
 static PyMethodDef PyBobLearnLibsvmMachine_methods[] = {
@@ -1044,6 +1982,60 @@ static PyMethodDef PyBobLearnLibsvmMachine_methods[] = {
     METH_VARARGS|METH_KEYWORDS,
     s_probabilities_doc,
   },
+  {
+    s_save_binary_str,
+    (PyCFunction)PyBobLearnLibsvmMachine_SaveBinary,
+    METH_O,
+    s_save_binary_doc,
+  },
+  {
+    s_compress_str,
+    (PyCFunction)PyBobLearnLibsvmMachine_Compress,
+    METH_VARARGS|METH_KEYWORDS,
+    s_compress_doc,
+  },
+  {
+    s_fidelity_str,
+    (PyCFunction)PyBobLearnLibsvmMachine_Fidelity,
+    METH_VARARGS|METH_KEYWORDS,
+    s_fidelity_doc,
+  },
+  {
+    s_copy_str,
+    (PyCFunction)PyBobLearnLibsvmMachine_Copy,
+    METH_NOARGS,
+    s_copy_doc,
+  },
+  {
+    s_deepcopy_str,
+    (PyCFunction)PyBobLearnLibsvmMachine_DeepCopy,
+    METH_O,
+    s_deepcopy_doc,
+  },
+  {
+    s_statistics_str,
+    (PyCFunction)PyBobLearnLibsvmMachine_Statistics,
+    METH_NOARGS,
+    s_statistics_doc,
+  },
+  {
+    s_reset_statistics_str,
+    (PyCFunction)PyBobLearnLibsvmMachine_ResetStatistics,
+    METH_NOARGS,
+    s_reset_statistics_doc,
+  },
+  {
+    s_cache_statistics_str,
+    (PyCFunction)PyBobLearnLibsvmMachine_CacheStatistics,
+    METH_NOARGS,
+    s_cache_statistics_doc,
+  },
+  {
+    s_clear_cache_str,
+    (PyCFunction)PyBobLearnLibsvmMachine_ClearCache,
+    METH_NOARGS,
+    s_clear_cache_doc,
+  },
   {
     s_save_str,
     (PyCFunction)PyBobLearnLibsvmMachine_Save,
@@ -40,9 +40,23 @@ static PyObject* create_module (void) {
   PyBobLearnLibsvmFile_Type.tp_new = PyType_GenericNew;
   if (PyType_Ready(&PyBobLearnLibsvmFile_Type) < 0) return 0;
 
+  if (PyType_Ready(&PyBobLearnLibsvmFileChunks_Type) < 0) return 0;
+
   PyBobLearnLibsvmMachine_Type.tp_new = PyType_GenericNew;
   if (PyType_Ready(&PyBobLearnLibsvmMachine_Type) < 0) return 0;
 
+  PyBobLearnLibsvmOneVsRestMachine_Type.tp_new = PyType_GenericNew;
+  if (PyType_Ready(&PyBobLearnLibsvmOneVsRestMachine_Type) < 0) return 0;
+
+  PyBobLearnLibsvmApproximateMachine_Type.tp_new = PyType_GenericNew;
+  if (PyType_Ready(&PyBobLearnLibsvmApproximateMachine_Type) < 0) return 0;
+
+  PyBobLearnLibsvmEnsemble_Type.tp_new = PyType_GenericNew;
+  if (PyType_Ready(&PyBobLearnLibsvmEnsemble_Type) < 0) return 0;
+
+  PyBobLearnLibsvmPredictionServer_Type.tp_new = PyType_GenericNew;
+  if (PyType_Ready(&PyBobLearnLibsvmPredictionServer_Type) < 0) return 0;
+
   PyBobLearnLibsvmTrainer_Type.tp_new = PyType_GenericNew;
   if (PyType_Ready(&PyBobLearnLibsvmTrainer_Type) < 0) return 0;
 
@@ -63,6 +77,18 @@ static PyObject* create_module (void) {
   Py_INCREF(&PyBobLearnLibsvmMachine_Type);
   if (PyModule_AddObject(module, "Machine", (PyObject *)&PyBobLearnLibsvmMachine_Type) < 0) return 0;
 
+  Py_INCREF(&PyBobLearnLibsvmOneVsRestMachine_Type);
+  if (PyModule_AddObject(module, "OneVsRestMachine", (PyObject *)&PyBobLearnLibsvmOneVsRestMachine_Type) < 0) return 0;
+
+  Py_INCREF(&PyBobLearnLibsvmApproximateMachine_Type);
+  if (PyModule_AddObject(module, "ApproximateMachine", (PyObject *)&PyBobLearnLibsvmApproximateMachine_Type) < 0) return 0;
+
+  Py_INCREF(&PyBobLearnLibsvmEnsemble_Type);
+  if (PyModule_AddObject(module, "Ensemble", (PyObject *)&PyBobLearnLibsvmEnsemble_Type) < 0) return 0;
+
+  Py_INCREF(&PyBobLearnLibsvmPredictionServer_Type);
+  if (PyModule_AddObject(module, "PredictionServer", (PyObject *)&PyBobLearnLibsvmPredictionServer_Type) < 0) return 0;
+
   Py_INCREF(&PyBobLearnLibsvmTrainer_Type);
   if (PyModule_AddObject(module, "Trainer", (PyObject *)&PyBobLearnLibsvmTrainer_Type) < 0) return 0;
 
@@ -0,0 +1,420 @@
+/**
+ * @date Wed 14 Oct 2026 16:02:18 CEST
+ *
+ * @brief Bindings for one-vs-rest multi-class machines
+ *
+ * Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+ */
+
+#define BOB_LEARN_LIBSVM_MODULE
+#include <bob.blitz/cppapi.h>
+#include <bob.blitz/cleanup.h>
+#include <bob.io.base/api.h>
+#include <bob.learn.libsvm/api.h>
+
+/********************************************************
+ * Implementation of bob.learn.libsvm.OneVsRestMachine *
+ ********************************************************/
+
+PyDoc_STRVAR(s_ovr_str, BOB_EXT_MODULE_PREFIX ".OneVsRestMachine");
+
+PyDoc_STRVAR(s_ovr_doc,
+"OneVsRestMachine(hdf5file)\n\
+\n\
+A multi-class classifier made of one binary :py:class:`Machine`\n\
+per class, that separates that class from all others. The\n\
+predicted class is the one whose machine gives the highest\n\
+decision value. Contrary to the one-vs-one machines trained by\n\
+:py:meth:`Trainer.train`, that evaluate :math:`N\\cdot(N-1)/2`\n\
+decision functions for ``N`` classes, these machines only\n\
+evaluate ``N`` of them, so they are better suited to problems\n\
+with many classes.\n\
+\n\
+Such machines are created by :py:meth:`Trainer.train_one_vs_rest`\n\
+and can be saved to and reloaded from a\n\
+:py:class:`bob.io.base.HDF5File`, together with their scaling\n\
+parameters.\n\
+\n\
+");
+
+static int PyBobLearnLibsvmOneVsRestMachine_init
+(PyBobLearnLibsvmOneVsRestMachineObject* self, PyObject* args,
+ PyObject* kwds) {
+
+  /* Parses input arguments in a single shot */
+  static const char* const_kwlist[] = {"config", 0};
+  static char** kwlist = const_cast<char**>(const_kwlist);
+
+  PyObject* config = 0;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!", kwlist,
+        &PyBobIoHDF5File_Type, &config)) return -1;
+
+  auto h5f = reinterpret_cast<PyBobIoHDF5FileObject*>(config);
+
+  try {
+    self->cxx = new bob::learn::libsvm::OneVsRestMachine(*(h5f->f));
+  }
+  catch (std::exception& ex) {
+    PyErr_SetString(PyExc_RuntimeError, ex.what());
+    return -1;
+  }
+  catch (...) {
+    PyErr_Format(PyExc_RuntimeError, "cannot create new object of type `%s' - unknown exception thrown", Py_TYPE(self)->tp_name);
+    return -1;
+  }
+
+  return 0;
+
+}
+
+static void PyBobLearnLibsvmOneVsRestMachine_delete
+(PyBobLearnLibsvmOneVsRestMachineObject* self) {
+
+  delete self->cxx;
+  Py_TYPE(self)->tp_free((PyObject*)self);
+
+}
+
+PyDoc_STRVAR(s_shape_str, "shape");
+PyDoc_STRVAR(s_shape_doc,
+"A tuple with the size of the input vector, followed by the\n\
+number of classes (and of scores per input), in the format\n\
+``(input, output)``.\n\
+");
+
+static PyObject* PyBobLearnLibsvmOneVsRestMachine_getShape
+(PyBobLearnLibsvmOneVsRestMachineObject* self, void* /*closure*/) {
+  return Py_BuildValue("(nn)", self->cxx->inputSize(),
+      self->cxx->numberOfClasses());
+}
+
+PyDoc_STRVAR(s_labels_str, "labels");
+PyDoc_STRVAR(s_labels_doc, "The class labels this machine will output");
+
+static PyObject* PyBobLearnLibsvmOneVsRestMachine_getLabels
+(PyBobLearnLibsvmOneVsRestMachineObject* self, void* /*closure*/) {
+  PyObject* retval = PyList_New(self->cxx->numberOfClasses());
+  for (size_t k=0; k<self->cxx->numberOfClasses(); ++k) {
+    PyList_SET_ITEM(retval, k, Py_BuildValue("i", self->cxx->classLabel(k)));
+  }
+  return retval;
+}
+
+static PyGetSetDef PyBobLearnLibsvmOneVsRestMachine_getseters[] = {
+    {
+      s_shape_str,
+      (getter)PyBobLearnLibsvmOneVsRestMachine_getShape,
+      0,
+      s_shape_doc,
+      0
+    },
+    {
+      s_labels_str,
+      (getter)PyBobLearnLibsvmOneVsRestMachine_getLabels,
+      0,
+      s_labels_doc,
+      0
+    },
+    {0}  /* Sentinel */
+};
+
+/**
+ * Predicts the classes (and scores, if ``scores`` is set) of a 1D or 2D
+ * array, or of a sparse matrix, allocating the outputs
+ */
+static PyObject* PyBobLearnLibsvmOneVsRestMachine_predict
+(PyBobLearnLibsvmOneVsRestMachineObject* self, PyObject* X,
+ Py_ssize_t threads, bool scores) {
+
+  if (threads < 0) {
+    PyErr_Format(PyExc_ValueError, "`%s' requires a non-negative number of `threads' (or zero, to use all available cores), not %" PY_FORMAT_SIZE_T "d", Py_TYPE(self)->tp_name, threads);
+    return 0;
+  }
+
+  boost::shared_ptr<bob::learn::libsvm::SparseMatrix> matrix;
+  PyBlitzArrayObject* input = 0;
+  boost::shared_ptr<PyBlitzArrayObject> input_;
+  Py_ssize_t ndim = 2;
+  Py_ssize_t rows = 0;
+
+  if (PyBobLearnLibsvm_IsSparse(X)) {
+    matrix = PyBobLearnLibsvm_AsSparse(X);
+    if (!matrix) return 0;
+    rows = matrix->rows();
+  }
+  else {
+    if (!PyBlitzArray_Converter(X, &input)) return 0;
+    input_ = make_safe(input);
+
+    if (input->type_num != NPY_FLOAT64) {
+      PyErr_Format(PyExc_TypeError, "`%s' only supports 64-bit float arrays for input array `input'", Py_TYPE(self)->tp_name);
+      return 0;
+    }
+
+    if (input->ndim < 1 || input->ndim > 2) {
+      PyErr_Format(PyExc_TypeError, "`%s' only accepts 1 or 2-dimensional arrays (not %" PY_FORMAT_SIZE_T "dD arrays)", Py_TYPE(self)->tp_name, input->ndim);
+      return 0;
+    }
+
+    ndim = input->ndim;
+    Py_ssize_t columns = input->shape[ndim-1];
+    if (columns != (Py_ssize_t)self->cxx->inputSize()) {
+      PyErr_Format(PyExc_RuntimeError, "`input' array should have %" PY_FORMAT_SIZE_T "d columns, matching `%s' input size, not %" PY_FORMAT_SIZE_T "d", self->cxx->inputSize(), Py_TYPE(self)->tp_name, columns);
+      return 0;
+    }
+    rows = (ndim == 1) ? 1 : input->shape[0];
+  }
+
+  PyObject* cls = PyBlitzArray_SimpleNew(NPY_INT64, 1, &rows);
+  if (!cls) return 0;
+  auto cls_ = make_safe(cls);
+
+  Py_ssize_t osize[2] = {rows, (Py_ssize_t)self->cxx->numberOfClasses()};
+  PyObject* score = PyBlitzArray_SimpleNew(NPY_FLOAT64, 2, osize);
+  if (!score) return 0;
+  auto score_ = make_safe(score);
+
+  try {
+    auto bzcls = PyBlitzArrayCxx_AsBlitz<int64_t,1>(reinterpret_cast<PyBlitzArrayObject*>(cls));
+    auto bzscore = PyBlitzArrayCxx_AsBlitz<double,2>(reinterpret_cast<PyBlitzArrayObject*>(score));
+    if (matrix) {
+      PyBobLearnLibsvmNoGIL nogil;
+      self->cxx->predictClassAndScores(*matrix, *bzcls, *bzscore, threads);
+    }
+    else if (ndim == 1) {
+      blitz::Array<double,1> row((*bzscore)(0, blitz::Range::all()));
+      (*bzcls)(0) = self->cxx->predictClassAndScores(*PyBlitzArrayCxx_AsBlitz<double,1>(input), row);
+    }
+    else {
+      auto bzin = PyBlitzArrayCxx_AsBlitz<double,2>(input);
+      PyBobLearnLibsvmNoGIL nogil;
+      self->cxx->predictClassAndScores(*bzin, *bzcls, *bzscore, threads);
+    }
+  }
+  catch (std::exception& e) {
+    PyErr_SetString(PyExc_RuntimeError, e.what());
+    return 0;
+  }
+  catch (...) {
+    PyErr_Format(PyExc_RuntimeError, "%s cannot forward data: unknown exception caught", Py_TYPE(self)->tp_name);
+    return 0;
+  }
+
+  //1D inputs produce 1D scores
+  if (ndim == 1) {
+    Py_ssize_t k = self->cxx->numberOfClasses();
+    PyObject* flat = PyBlitzArray_SimpleNew(NPY_FLOAT64, 1, &k);
+    if (!flat) return 0;
+    *PyBlitzArrayCxx_AsBlitz<double,1>(reinterpret_cast<PyBlitzArrayObject*>(flat)) = (*PyBlitzArrayCxx_AsBlitz<double,2>(reinterpret_cast<PyBlitzArrayObject*>(score)))(0, blitz::Range::all());
+    score_ = make_safe(flat);
+    score = flat;
+  }
+
+  if (!scores) {
+    Py_INCREF(cls);
+    return PyBlitzArray_NUMPY_WRAP(cls);
+  }
+
+  Py_INCREF(cls);
+  Py_INCREF(score);
+  return Py_BuildValue("OO",
+      PyBlitzArray_NUMPY_WRAP(cls),
+      PyBlitzArray_NUMPY_WRAP(score)
+      );
+
+}
+
+PyDoc_STRVAR(s_forward_str, "forward");
+PyDoc_STRVAR(s_forward_doc,
+"o.forward(input, [threads=1]) -> array\n\
+\n\
+o.predict_class(input, [threads=1]) -> array\n\
+\n\
+o(input, [threads=1]) -> array\n\
+\n\
+Calculates the **predicted class** of one single feature vector\n\
+or of multiple ones, returned in a 1D ``int64`` array.\n\
+\n\
+The ``input`` may be a 1D or 2D 64-bit float array or a sparse\n\
+matrix in CSR format, like for :py:meth:`Machine.forward`. Each\n\
+binary machine goes through all rows in turn, splitting them\n\
+between ``threads`` workers (zero means one per core). The Python\n\
+global interpreter lock is released during the computation.\n\
+\n\
+");
+
+static PyObject* PyBobLearnLibsvmOneVsRestMachine_forward
+(PyBobLearnLibsvmOneVsRestMachineObject* self, PyObject* args,
+ PyObject* kwds) {
+
+  static const char* const_kwlist[] = {"input", "threads", 0};
+  static char** kwlist = const_cast<char**>(const_kwlist);
+
+  PyObject* X = 0;
+  Py_ssize_t threads = 1;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|n", kwlist,
+        &X, &threads)) return 0;
+
+  return PyBobLearnLibsvmOneVsRestMachine_predict(self, X, threads, false);
+
+}
+
+PyDoc_STRVAR(s_scores_str, "predict_class_and_scores");
+PyDoc_STRVAR(s_scores_doc,
+"o.predict_class_and_scores(input, [threads=1]) -> (array, array)\n\
+\n\
+Calculates the **predicted class** and the decision values of all\n\
+binary machines, given one single feature vector or multiple ones.\n\
+Returns a tuple with the predicted classes, in a 1D ``int64``\n\
+array, and the scores, in a ``float64`` array with one column per\n\
+class, in the order of :py:attr:`labels` (1D if ``input`` is 1D).\n\
+Inputs and ``threads`` are like for :py:meth:`forward`.\n\
+\n\
+");
+
+static PyObject* PyBobLearnLibsvmOneVsRestMachine_predictClassAndScores
+(PyBobLearnLibsvmOneVsRestMachineObject* self, PyObject* args,
+ PyObject* kwds) {
+
+  static const char* const_kwlist[] = {"input", "threads", 0};
+  static char** kwlist = const_cast<char**>(const_kwlist);
+
+  PyObject* X = 0;
+  Py_ssize_t threads = 1;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|n", kwlist,
+        &X, &threads)) return 0;
+
+  return PyBobLearnLibsvmOneVsRestMachine_predict(self, X, threads, true);
+
+}
+
+PyDoc_STRVAR(s_save_str, "save");
+PyDoc_STRVAR(s_save_doc,
+"o.save(hdf5file) -> None\n\
+\n\
+Saves itself into a :py:class:`bob.io.base.HDF5File`: the class\n\
+labels go to the current group and each binary machine, with its\n\
+scaling parameters, to a sub-group of its own.\n\
+");
+
+static PyObject* PyBobLearnLibsvmOneVsRestMachine_Save
+(PyBobLearnLibsvmOneVsRestMachineObject* self, PyObject* f) {
+
+  if (!PyBobIoHDF5File_Check(f)) {
+    PyErr_Format(PyExc_TypeError, "`%s' can only save to HDF5 files, not to objects of type `%s'", Py_TYPE(self)->tp_name, Py_TYPE(f)->tp_name);
+    return 0;
+  }
+
+  auto h5f = reinterpret_cast<PyBobIoHDF5FileObject*>(f);
+  try {
+    self->cxx->save(*h5f->f);
+  }
+  catch (std::exception& e) {
+    PyErr_SetString(PyExc_RuntimeError, e.what());
+    return 0;
+  }
+  catch (...) {
+    PyErr_Format(PyExc_RuntimeError, "`%s' cannot write data to file `%s' (at group `%s'): unknown exception caught", Py_TYPE(self)->tp_name,
+        h5f->f->filename().c_str(), h5f->f->cwd().c_str());
+    return 0;
+  }
+
+  Py_RETURN_NONE;
+
+}
+
+static PyMethodDef PyBobLearnLibsvmOneVsRestMachine_methods[] = {
+  {
+    s_forward_str,
+    (PyCFunction)PyBobLearnLibsvmOneVsRestMachine_forward,
+    METH_VARARGS|METH_KEYWORDS,
+    s_forward_doc
+  },
+  {
+    "predict_class",
+    (PyCFunction)PyBobLearnLibsvmOneVsRestMachine_forward,
+    METH_VARARGS|METH_KEYWORDS,
+    s_forward_doc
+  },
+  {
+    s_scores_str,
+    (PyCFunction)PyBobLearnLibsvmOneVsRestMachine_predictClassAndScores,
+    METH_VARARGS|METH_KEYWORDS,
+    s_scores_doc,
+  },
+  {
+    s_save_str,
+    (PyCFunction)PyBobLearnLibsvmOneVsRestMachine_Save,
+    METH_O,
+    s_save_doc
+  },
+  {0} /* Sentinel */
+};
+
+static PyObject* PyBobLearnLibsvmOneVsRestMachine_new
+(PyTypeObject* type, PyObject*, PyObject*) {
+
+  /* Allocates the python object itself */
+  PyBobLearnLibsvmOneVsRestMachineObject* self =
+    (PyBobLearnLibsvmOneVsRestMachineObject*)type->tp_alloc(type, 0);
+
+  self->cxx = 0;
+
+  return reinterpret_cast<PyObject*>(self);
+
+}
+
+PyObject* PyBobLearnLibsvmOneVsRestMachine_NewFromMachine
+(bob::learn::libsvm::OneVsRestMachine* m) {
+
+  PyBobLearnLibsvmOneVsRestMachineObject* retval = (PyBobLearnLibsvmOneVsRestMachineObject*)PyBobLearnLibsvmOneVsRestMachine_new(&PyBobLearnLibsvmOneVsRestMachine_Type, 0, 0);
+
+  retval->cxx = m; ///< takes ownership
+
+  return reinterpret_cast<PyObject*>(retval);
+
+}
+
+PyTypeObject PyBobLearnLibsvmOneVsRestMachine_Type = {
+    PyVarObject_HEAD_INIT(0, 0)
+    s_ovr_str,                                        /* tp_name */
+    sizeof(PyBobLearnLibsvmOneVsRestMachineObject),   /* tp_basicsize */
+    0,                                                /* tp_itemsize */
+    (destructor)PyBobLearnLibsvmOneVsRestMachine_delete, /* tp_dealloc */
+    0,                                                /* tp_print */
+    0,                                                /* tp_getattr */
+    0,                                                /* tp_setattr */
+    0,                                                /* tp_compare */
+    0,                                                /* tp_repr */
+    0,                                                /* tp_as_number */
+    0,                                                /* tp_as_sequence */
+    0,                                                /* tp_as_mapping */
+    0,                                                /* tp_hash */
+    (ternaryfunc)PyBobLearnLibsvmOneVsRestMachine_forward, /* tp_call */
+    0,                                                /* tp_str */
+    0,                                                /* tp_getattro */
+    0,                                                /* tp_setattro */
+    0,                                                /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,         /* tp_flags */
+    s_ovr_doc,                                        /* tp_doc */
+    0,                                                /* tp_traverse */
+    0,                                                /* tp_clear */
+    0,                                                /* tp_richcompare */
+    0,                                                /* tp_weaklistoffset */
+    0,                                                /* tp_iter */
+    0,                                                /* tp_iternext */
+    PyBobLearnLibsvmOneVsRestMachine_methods,         /* tp_methods */
+    0,                                                /* tp_members */
+    PyBobLearnLibsvmOneVsRestMachine_getseters,       /* tp_getset */
+    0,                                                /* tp_base */
+    0,                                                /* tp_dict */
+    0,                                                /* tp_descr_get */
+    0,                                                /* tp_descr_set */
+    0,                                                /* tp_dictoffset */
+    (initproc)PyBobLearnLibsvmOneVsRestMachine_init,  /* tp_init */
+    0,                                                /* tp_alloc */
+    PyBobLearnLibsvmOneVsRestMachine_new,             /* tp_new */
+};
@@ -0,0 +1,543 @@
+/**
+ * @date Thu 15 Oct 2026 17:41:52 CEST
+ *
+ * @brief Bindings for the prediction server
+ *
+ * Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+ */
+
+#define BOB_LEARN_LIBSVM_MODULE
+#include <bob.blitz/cppapi.h>
+#include <bob.blitz/cleanup.h>
+#include <bob.learn.libsvm/api.h>
+#include <boost/make_shared.hpp>
+#include <cstring>
+
+/********************************************************
+ * Implementation of bob.learn.libsvm.PredictionServer *
+ ********************************************************/
+
+PyDoc_STRVAR(s_server_str, BOB_EXT_MODULE_PREFIX ".PredictionServer");
+
+PyDoc_STRVAR(s_server_doc,
+"PredictionServer(machine, [output='LABELS', [workers=1, [batch_size=64, [max_latency=0.001]]]])\n\
+\n\
+Serves predictions of a :py:class:`Machine` to many threads, each\n\
+submitting single inputs with :py:meth:`submit`.\n\
+\n\
+Requests are queued and picked up by ``workers`` threads (zero\n\
+means one per core), that predict them in batches, so kernel\n\
+evaluations are shared between requests. A batch starts once\n\
+``batch_size`` requests are queued, or once the oldest of them\n\
+waited ``max_latency`` seconds. Only one worker gathers requests\n\
+at a time, while the others predict the batches gathered before,\n\
+without the Python global interpreter lock.\n\
+\n\
+The server predicts with a copy of ``machine``, which may thus be\n\
+modified afterwards. ``output`` tells what each request resolves\n\
+to: ``'LABELS'``, the predicted class, ``'SCORES'``, a tuple with\n\
+the class and the decision values, or ``'PROBABILITIES'``, a\n\
+tuple with the class and the class probabilities (like\n\
+:py:meth:`Machine.predict_class_and_scores` and\n\
+:py:meth:`Machine.predict_class_and_probabilities` on 1D inputs).\n\
+\n\
+Servers should be closed with :py:meth:`close`, or used in a\n\
+``with`` block, once they are no longer needed.\n\
+\n\
+");
+
+static int PyBobLearnLibsvmPredictionServer_init
+(PyBobLearnLibsvmPredictionServerObject* self, PyObject* args,
+ PyObject* kwds) {
+
+  /* Parses input arguments in a single shot */
+  static const char* const_kwlist[] = {"machine", "output", "workers",
+    "batch_size", "max_latency", 0};
+  static char** kwlist = const_cast<char**>(const_kwlist);
+
+  PyObject* machine = 0;
+  const char* output = "LABELS";
+  Py_ssize_t workers = 1;
+  Py_ssize_t batch_size = 64;
+  double max_latency = 1e-3;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!|snnd", kwlist,
+        &PyBobLearnLibsvmMachine_Type, &machine, &output, &workers,
+        &batch_size, &max_latency)) return -1;
+
+  bob::learn::libsvm::output_t kind;
+  if (!std::strcmp(output, "LABELS")) kind = bob::learn::libsvm::LABELS;
+  else if (!std::strcmp(output, "SCORES")) kind = bob::learn::libsvm::SCORES;
+  else if (!std::strcmp(output, "PROBABILITIES")) kind = bob::learn::libsvm::PROBABILITIES;
+  else {
+    PyErr_Format(PyExc_ValueError, "`%s' output should be one of 'LABELS', 'SCORES' or 'PROBABILITIES', not `%s'", Py_TYPE(self)->tp_name, output);
+    return -1;
+  }
+
+  if (workers < 0) {
+    PyErr_Format(PyExc_ValueError, "`%s' requires a non-negative number of `workers' (or zero, to use all available cores), not %" PY_FORMAT_SIZE_T "d", Py_TYPE(self)->tp_name, workers);
+    return -1;
+  }
+
+  if (batch_size < 1) {
+    PyErr_Format(PyExc_ValueError, "`%s' requires a positive `batch_size', not %" PY_FORMAT_SIZE_T "d", Py_TYPE(self)->tp_name, batch_size);
+    return -1;
+  }
+
+  auto m = reinterpret_cast<PyBobLearnLibsvmMachineObject*>(machine);
+
+  try {
+    auto copy = boost::make_shared<const bob::learn::libsvm::Machine>(*m->cxx);
+    self->cxx = new bob::learn::libsvm::PredictionServer(copy, kind,
+        workers, batch_size, max_latency);
+  }
+  catch (std::exception& ex) {
+    PyErr_SetString(PyExc_RuntimeError, ex.what());
+    return -1;
+  }
+  catch (...) {
+    PyErr_Format(PyExc_RuntimeError, "cannot create new object of type `%s' - unknown exception thrown", Py_TYPE(self)->tp_name);
+    return -1;
+  }
+
+  return 0;
+
+}
+
+static void PyBobLearnLibsvmPredictionServer_delete
+(PyBobLearnLibsvmPredictionServerObject* self) {
+
+  if (self->cxx) {
+    //workers complete the requests left, which requires the GIL
+    PyBobLearnLibsvmNoGIL nogil;
+    delete self->cxx;
+  }
+  Py_TYPE(self)->tp_free((PyObject*)self);
+
+}
+
+/**
+ * Checks the server was initialized, setting a Python exception if not
+ */
+static int check_server(PyBobLearnLibsvmPredictionServerObject* self) {
+  if (self->cxx) return 1;
+  PyErr_Format(PyExc_RuntimeError, "`%s' was not initialized", Py_TYPE(self)->tp_name);
+  return 0;
+}
+
+PyDoc_STRVAR(s_output_str, "output");
+PyDoc_STRVAR(s_output_doc,
+"What requests resolve to: ``'LABELS'``, ``'SCORES'`` or\n\
+``'PROBABILITIES'``\n\
+");
+
+static PyObject* PyBobLearnLibsvmPredictionServer_getOutput
+(PyBobLearnLibsvmPredictionServerObject* self, void* /*closure*/) {
+  if (!check_server(self)) return 0;
+  switch (self->cxx->getOutput()) {
+    case bob::learn::libsvm::SCORES:
+      return Py_BuildValue("s", "SCORES");
+    case bob::learn::libsvm::PROBABILITIES:
+      return Py_BuildValue("s", "PROBABILITIES");
+    default:
+      return Py_BuildValue("s", "LABELS");
+  }
+}
+
+PyDoc_STRVAR(s_workers_str, "workers");
+PyDoc_STRVAR(s_workers_doc, "The number of worker threads");
+
+static PyObject* PyBobLearnLibsvmPredictionServer_getWorkers
+(PyBobLearnLibsvmPredictionServerObject* self, void* /*closure*/) {
+  if (!check_server(self)) return 0;
+  return Py_BuildValue("n", self->cxx->getWorkers());
+}
+
+PyDoc_STRVAR(s_batch_size_str, "batch_size");
+PyDoc_STRVAR(s_batch_size_doc, "The maximum number of requests per batch");
+
+static PyObject* PyBobLearnLibsvmPredictionServer_getBatchSize
+(PyBobLearnLibsvmPredictionServerObject* self, void* /*closure*/) {
+  if (!check_server(self)) return 0;
+  return Py_BuildValue("n", self->cxx->getBatchSize());
+}
+
+PyDoc_STRVAR(s_max_latency_str, "max_latency");
+PyDoc_STRVAR(s_max_latency_doc,
+"The longest time, in seconds, a request waits for others to\n\
+fill its batch\n\
+");
+
+static PyObject* PyBobLearnLibsvmPredictionServer_getMaxLatency
+(PyBobLearnLibsvmPredictionServerObject* self, void* /*closure*/) {
+  if (!check_server(self)) return 0;
+  return Py_BuildValue("d", self->cxx->getMaxLatency());
+}
+
+PyDoc_STRVAR(s_pending_str, "pending");
+PyDoc_STRVAR(s_pending_doc,
+"The number of requests queued, that no worker picked up yet");
+
+static PyObject* PyBobLearnLibsvmPredictionServer_getPending
+(PyBobLearnLibsvmPredictionServerObject* self, void* /*closure*/) {
+  if (!check_server(self)) return 0;
+  return Py_BuildValue("n", self->cxx->pending());
+}
+
+PyDoc_STRVAR(s_closed_str, "closed");
+PyDoc_STRVAR(s_closed_doc, "Tells if the server was closed");
+
+static PyObject* PyBobLearnLibsvmPredictionServer_getClosed
+(PyBobLearnLibsvmPredictionServerObject* self, void* /*closure*/) {
+  if (!check_server(self)) return 0;
+  if (self->cxx->closed()) Py_RETURN_TRUE;
+  Py_RETURN_FALSE;
+}
+
+static PyGetSetDef PyBobLearnLibsvmPredictionServer_getseters[] = {
+    {
+      s_output_str,
+      (getter)PyBobLearnLibsvmPredictionServer_getOutput,
+      0,
+      s_output_doc,
+      0
+    },
+    {
+      s_workers_str,
+      (getter)PyBobLearnLibsvmPredictionServer_getWorkers,
+      0,
+      s_workers_doc,
+      0
+    },
+    {
+      s_batch_size_str,
+      (getter)PyBobLearnLibsvmPredictionServer_getBatchSize,
+      0,
+      s_batch_size_doc,
+      0
+    },
+    {
+      s_max_latency_str,
+      (getter)PyBobLearnLibsvmPredictionServer_getMaxLatency,
+      0,
+      s_max_latency_doc,
+      0
+    },
+    {
+      s_pending_str,
+      (getter)PyBobLearnLibsvmPredictionServer_getPending,
+      0,
+      s_pending_doc,
+      0
+    },
+    {
+      s_closed_str,
+      (getter)PyBobLearnLibsvmPredictionServer_getClosed,
+      0,
+      s_closed_doc,
+      0
+    },
+    {0}  /* Sentinel */
+};
+
+/**
+ * Releases Python objects held by completions, that may be destroyed on
+ * worker threads
+ */
+static void decref_with_gil(PyObject* o) {
+  PyGILState_STATE gil = PyGILState_Ensure();
+  Py_DECREF(o);
+  PyGILState_Release(gil);
+}
+
+/**
+ * Completes a ``concurrent.futures.Future`` with the result of a request,
+ * on a worker thread
+ */
+class python_completion {
+
+  public:
+
+    python_completion(PyObject* future, bob::learn::libsvm::output_t output):
+      m_future(future, decref_with_gil), m_output(output) {
+      Py_INCREF(future);
+    }
+
+    void operator()(const bob::learn::libsvm::PredictionResult* result,
+        std::exception_ptr error) const {
+
+      PyGILState_STATE gil = PyGILState_Ensure();
+      PyObject* future = m_future.get();
+
+      //futures cancelled by their owner are left alone
+      PyObject* running = PyObject_CallMethod(future,
+          const_cast<char*>("set_running_or_notify_cancel"), 0);
+      if (running && PyObject_IsTrue(running)) {
+        PyObject* value = result ? convert(*result) : exception(error);
+        if (value) {
+          PyObject* r = PyObject_CallMethod(future,
+              const_cast<char*>(result ? "set_result" : "set_exception"),
+              const_cast<char*>("O"), value);
+          Py_XDECREF(r);
+          Py_DECREF(value);
+        }
+      }
+      Py_XDECREF(running);
+
+      //there is no one to report errors to, at this point
+      if (PyErr_Occurred()) PyErr_WriteUnraisable(future);
+
+      PyGILState_Release(gil);
+
+    }
+
+  private:
+
+    PyObject* convert(const bob::learn::libsvm::PredictionResult& result) const {
+
+      if (m_output == bob::learn::libsvm::LABELS) {
+        return Py_BuildValue("L", (long long)result.label);
+      }
+
+      Py_ssize_t n = result.values.size();
+      PyObject* values = PyBlitzArray_SimpleNew(NPY_FLOAT64, 1, &n);
+      if (!values) return 0;
+      auto bzvalues = PyBlitzArrayCxx_AsBlitz<double,1>(reinterpret_cast<PyBlitzArrayObject*>(values));
+      for (Py_ssize_t k=0; k<n; ++k) (*bzvalues)(k) = result.values[k];
+
+      return Py_BuildValue("LN", (long long)result.label,
+          PyBlitzArray_NUMPY_WRAP(values));
+
+    }
+
+    static PyObject* exception(std::exception_ptr error) {
+      try {
+        std::rethrow_exception(error);
+      }
+      catch (std::exception& e) {
+        return PyObject_CallFunction(PyExc_RuntimeError,
+            const_cast<char*>("s"), e.what());
+      }
+      catch (...) {
+        return PyObject_CallFunction(PyExc_RuntimeError,
+            const_cast<char*>("s"), "prediction failed: unknown exception caught");
+      }
+    }
+
+    boost::shared_ptr<PyObject> m_future;
+    bob::learn::libsvm::output_t m_output;
+
+};
+
+/**
+ * Returns ``concurrent.futures.Future``, imported once
+ */
+static PyObject* future_type() {
+  static PyObject* type = 0;
+  if (type) return type;
+  PyObject* module = PyImport_ImportModule("concurrent.futures");
+  if (!module) return 0;
+  type = PyObject_GetAttrString(module, "Future");
+  Py_DECREF(module);
+  return type;
+}
+
+PyDoc_STRVAR(s_submit_str, "submit");
+PyDoc_STRVAR(s_submit_doc,
+"o.submit(input) -> concurrent.futures.Future\n\
+\n\
+Queues a single ``input``, a 1D 32 or 64-bit float array with as\n\
+many elements as the machine's input size, which is copied. Returns\n\
+a :py:class:`concurrent.futures.Future`, that resolves to the\n\
+prediction, as described in :py:attr:`output`, or to a\n\
+:py:exc:`RuntimeError` if it failed. Use :py:func:`asyncio.wrap_future`\n\
+to await it from a coroutine.\n\
+\n\
+Futures are completed on the worker threads. Cancelling a future\n\
+before it completes leaves it cancelled, though the input may still\n\
+be predicted.\n\
+\n\
+");
+
+static PyObject* PyBobLearnLibsvmPredictionServer_submit
+(PyBobLearnLibsvmPredictionServerObject* self, PyObject* args,
+ PyObject* kwds) {
+
+  static const char* const_kwlist[] = {"input", 0};
+  static char** kwlist = const_cast<char**>(const_kwlist);
+
+  PyBlitzArrayObject* input = 0;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&", kwlist,
+        &PyBlitzArray_Converter, &input)) return 0;
+
+  auto input_ = make_safe(input);
+
+  if (!check_server(self)) return 0;
+
+  if (input->type_num != NPY_FLOAT64 && input->type_num != NPY_FLOAT32) {
+    PyErr_Format(PyExc_TypeError, "`%s' only supports 32 or 64-bit float arrays for input array `input'", Py_TYPE(self)->tp_name);
+    return 0;
+  }
+
+  if (input->ndim != 1) {
+    PyErr_Format(PyExc_TypeError, "`%s' only accepts 1-dimensional arrays (not %" PY_FORMAT_SIZE_T "dD arrays)", Py_TYPE(self)->tp_name, input->ndim);
+    return 0;
+  }
+
+  Py_ssize_t size = self->cxx->inputSize();
+  if (input->shape[0] != size) {
+    PyErr_Format(PyExc_RuntimeError, "1D `input' array should have %" PY_FORMAT_SIZE_T "d elements matching `%s' input size, not %" PY_FORMAT_SIZE_T "d elements", size, Py_TYPE(self)->tp_name, input->shape[0]);
+    return 0;
+  }
+
+  std::vector<double> row(size);
+  if (input->type_num == NPY_FLOAT32) {
+    auto bzin = PyBlitzArrayCxx_AsBlitz<float,1>(input);
+    for (Py_ssize_t k=0; k<size; ++k) row[k] = (*bzin)(k);
+  }
+  else {
+    auto bzin = PyBlitzArrayCxx_AsBlitz<double,1>(input);
+    for (Py_ssize_t k=0; k<size; ++k) row[k] = (*bzin)(k);
+  }
+
+  PyObject* type = future_type();
+  if (!type) return 0;
+  PyObject* future = PyObject_CallObject(type, 0);
+  if (!future) return 0;
+  auto future_ = make_safe(future);
+
+  try {
+    self->cxx->submit(row.data(),
+        python_completion(future, self->cxx->getOutput()));
+  }
+  catch (std::exception& e) {
+    PyErr_SetString(PyExc_RuntimeError, e.what());
+    return 0;
+  }
+  catch (...) {
+    PyErr_Format(PyExc_RuntimeError, "`%s' cannot submit input: unknown exception caught", Py_TYPE(self)->tp_name);
+    return 0;
+  }
+
+  Py_INCREF(future);
+  return future;
+
+}
+
+PyDoc_STRVAR(s_close_str, "close");
+PyDoc_STRVAR(s_close_doc,
+"o.close() -> None\n\
+\n\
+Stops accepting requests and waits for the ones queued to complete,\n\
+releasing the Python global interpreter lock meanwhile. Calling it\n\
+again has no effect.\n\
+");
+
+static PyObject* PyBobLearnLibsvmPredictionServer_close
+(PyBobLearnLibsvmPredictionServerObject* self) {
+
+  if (!check_server(self)) return 0;
+
+  {
+    PyBobLearnLibsvmNoGIL nogil;
+    self->cxx->close();
+  }
+
+  Py_RETURN_NONE;
+
+}
+
+static PyObject* PyBobLearnLibsvmPredictionServer_enter
+(PyBobLearnLibsvmPredictionServerObject* self) {
+  if (!check_server(self)) return 0;
+  Py_INCREF(self);
+  return reinterpret_cast<PyObject*>(self);
+}
+
+static PyObject* PyBobLearnLibsvmPredictionServer_exit
+(PyBobLearnLibsvmPredictionServerObject* self, PyObject* /*args*/) {
+  return PyBobLearnLibsvmPredictionServer_close(self);
+}
+
+static PyMethodDef PyBobLearnLibsvmPredictionServer_methods[] = {
+  {
+    s_submit_str,
+    (PyCFunction)PyBobLearnLibsvmPredictionServer_submit,
+    METH_VARARGS|METH_KEYWORDS,
+    s_submit_doc
+  },
+  {
+    s_close_str,
+    (PyCFunction)PyBobLearnLibsvmPredictionServer_close,
+    METH_NOARGS,
+    s_close_doc
+  },
+  {
+    "__enter__",
+    (PyCFunction)PyBobLearnLibsvmPredictionServer_enter,
+    METH_NOARGS,
+    0
+  },
+  {
+    "__exit__",
+    (PyCFunction)PyBobLearnLibsvmPredictionServer_exit,
+    METH_VARARGS,
+    s_close_doc
+  },
+  {0} /* Sentinel */
+};
+
+static PyObject* PyBobLearnLibsvmPredictionServer_new
+(PyTypeObject* type, PyObject*, PyObject*) {
+
+  /* Allocates the python object itself */
+  PyBobLearnLibsvmPredictionServerObject* self =
+    (PyBobLearnLibsvmPredictionServerObject*)type->tp_alloc(type, 0);
+
+  self->cxx = 0;
+
+  return reinterpret_cast<PyObject*>(self);
+
+}
+
+PyTypeObject PyBobLearnLibsvmPredictionServer_Type = {
+    PyVarObject_HEAD_INIT(0, 0)
+    s_server_str,                                     /* tp_name */
+    sizeof(PyBobLearnLibsvmPredictionServerObject),   /* tp_basicsize */
+    0,                                                /* tp_itemsize */
+    (destructor)PyBobLearnLibsvmPredictionServer_delete, /* tp_dealloc */
+    0,                                                /* tp_print */
+    0,                                                /* tp_getattr */
+    0,                                                /* tp_setattr */
+    0,                                                /* tp_compare */
+    0,                                                /* tp_repr */
+    0,                                                /* tp_as_number */
+    0,                                                /* tp_as_sequence */
+    0,                                                /* tp_as_mapping */
+    0,                                                /* tp_hash */
+    0,                                                /* tp_call */
+    0,                                                /* tp_str */
+    0,                                                /* tp_getattro */
+    0,                                                /* tp_setattro */
+    0,                                                /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,         /* tp_flags */
+    s_server_doc,                                     /* tp_doc */
+    0,                                                /* tp_traverse */
+    0,                                                /* tp_clear */
+    0,                                                /* tp_richcompare */
+    0,                                                /* tp_weaklistoffset */
+    0,                                                /* tp_iter */
+    0,                                                /* tp_iternext */
+    PyBobLearnLibsvmPredictionServer_methods,         /* tp_methods */
+    0,                                                /* tp_members */
+    PyBobLearnLibsvmPredictionServer_getseters,       /* tp_getset */
+    0,                                                /* tp_base */
+    0,                                                /* tp_dict */
+    0,                                                /* tp_descr_get */
+    0,                                                /* tp_descr_set */
+    0,                                                /* tp_dictoffset */
+    (initproc)PyBobLearnLibsvmPredictionServer_init,  /* tp_init */
+    0,                                                /* tp_alloc */
+    PyBobLearnLibsvmPredictionServer_new,             /* tp_new */
+};
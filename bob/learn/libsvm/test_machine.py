@@ -15,7 +15,7 @@ import pkg_resources
 import nose.tools
 import bob.io.base
 
-from . import File, Machine
+from . import File, Machine, PredictionServer, Ensemble
 
 def F(f):
   """Returns the test file on the "data" subdirectory"""
@@ -122,6 +122,121 @@ def test_can_save_hdf5():
 
   os.unlink(tmp)
 
+def test_can_save_binary():
+
+  machine = Machine(HEART_MACHINE)
+  machine.input_subtract = numpy.linspace(0, 0.1, 13)
+  machine.input_divide = numpy.linspace(1, 2, 13)
+  tmp = tempname('.bin')
+  machine.save_binary(tmp)
+
+  # the binary file is detected and memory-mapped on load
+  other = Machine(tmp)
+  nose.tools.eq_(other.shape, machine.shape)
+  nose.tools.eq_(other.n_support_vectors, machine.n_support_vectors)
+  nose.tools.eq_(other.kernel_type, machine.kernel_type)
+  nose.tools.eq_(other.machine_type, machine.machine_type)
+  nose.tools.eq_(other.labels, machine.labels)
+  nose.tools.eq_(other.gamma, machine.gamma)
+  assert numpy.array_equal(other.input_subtract, machine.input_subtract)
+  assert numpy.array_equal(other.input_divide, machine.input_divide)
+
+  labels, data = File(HEART_DATA).read_all()
+  for a, b in zip(other.predict_class_and_scores(data),
+      machine.predict_class_and_scores(data)):
+    assert numpy.array_equal(a, b)
+  for a, b in zip(other.predict_class_and_probabilities(data),
+      machine.predict_class_and_probabilities(data)):
+    assert numpy.array_equal(a, b)
+
+  del other
+  os.unlink(tmp)
+
+def test_corrupted_binary_raises():
+
+  import struct
+
+  machine = Machine(HEART_MACHINE)
+  tmp = tempname('.bin')
+  machine.save_binary(tmp)
+  with open(tmp, 'rb') as f: original = bytearray(f.read())
+
+  #offsets of the nodes, of the support vector starts and of the numbers of
+  #support vectors per class, in the header
+  nodes = struct.unpack_from('=Q', original, 80)[0]
+  sv_start = struct.unpack_from('=Q', original, 88)[0]
+  nsv = struct.unpack_from('=Q', original, 136)[0]
+  flags = struct.unpack_from('=Q', original, 72)[0]
+
+  def corrupt(offset, fmt, value):
+    data = bytearray(original)
+    struct.pack_into(fmt, data, offset, value)
+    with open(tmp, 'wb') as f: f.write(data)
+    nose.tools.assert_raises(RuntimeError, Machine, tmp)
+
+  try:
+    corrupt(sv_start + 8, '=Q', 0) #second SV starts with the first
+    corrupt(sv_start, '=Q', 2**40) #first SV starts past the nodes
+    corrupt(nsv, '=i', struct.unpack_from('=i', original, nsv)[0] + 1)
+    corrupt(20, '=i', 5) #unknown machine type
+    corrupt(24, '=i', -1) #unknown kernel type
+    corrupt(72, '=Q', flags & ~1) #classifier without labels
+    corrupt(nodes, '=i', 14) #feature index past the input size
+    corrupt(nodes, '=i', 0) #feature index before the first one
+    #truncated file
+    with open(tmp, 'wb') as f: f.write(original[:len(original)//2])
+    nose.tools.assert_raises(RuntimeError, Machine, tmp)
+  finally:
+    os.unlink(tmp)
+
+def test_copy():
+
+  import copy
+
+  machine = Machine(HEART_MACHINE)
+  machine.input_subtract = numpy.linspace(0, 0.1, 13)
+  labels, data = File(HEART_DATA).read_all()
+
+  for other in (copy.copy(machine), copy.deepcopy(machine)):
+    nose.tools.eq_(other.shape, machine.shape)
+    nose.tools.eq_(other.n_support_vectors, machine.n_support_vectors)
+    nose.tools.eq_(other.gamma, machine.gamma)
+    assert numpy.array_equal(other.input_subtract, machine.input_subtract)
+    assert numpy.array_equal(other.input_divide, machine.input_divide)
+    assert numpy.array_equal(other.predict_class_and_probabilities(data)[1],
+        machine.predict_class_and_probabilities(data)[1])
+
+  # copies are independent
+  other = copy.copy(machine)
+  other.input_subtract = numpy.zeros((13,), 'float64')
+  assert not numpy.array_equal(other.input_subtract, machine.input_subtract)
+
+def test_input_scaling():
+
+  labels, data = File(HEART_DATA).read_all()
+  sub = numpy.linspace(0, 0.1, 13)
+  div = numpy.linspace(1, 2, 13)
+  scaled = (data - sub) / div
+
+  for engine in ('libsvm', 'dense'):
+    machine = Machine(HEART_MACHINE)
+    machine.engine = engine
+    ref_labels, ref_scores = machine.predict_class_and_scores(scaled)
+
+    machine.input_subtract = sub
+    machine.input_divide = div
+    #contiguous and strided rows take different paths
+    for values in (data, numpy.asfortranarray(data)):
+      pred_labels, pred_scores = machine.predict_class_and_scores(values)
+      assert numpy.array_equal(pred_labels, ref_labels)
+      assert numpy.all(abs(pred_scores - ref_scores) < 1e-10)
+
+    #identity scaling skips arithmetic altogether
+    machine.input_subtract = numpy.zeros((13,), 'float64')
+    machine.input_divide = numpy.ones((13,), 'float64')
+    pred_scores = machine.predict_class_and_scores(scaled)[1]
+    assert numpy.array_equal(pred_scores, ref_scores)
+
 def test_data_loading():
 
   #tests if I can load data in libsvm format using SVMFile
@@ -182,6 +297,61 @@ def test_data_loading():
 
 
 @nose.tools.raises(RuntimeError)
+def write_data(contents):
+  tmp = tempname('.svmdata')
+  with open(tmp, 'wb') as f: f.write(contents)
+  return tmp
+
+def test_data_parsing():
+
+  #tabs, CRLF line endings, blank lines and a last line without a new line
+  tmp = write_data(b'1 1:0.5\t3:-2\r\n\r\n-1\t2:1e-3 \r\n+1 1:1.5 2:.25')
+  try:
+    f = File(tmp)
+    nose.tools.eq_(f.shape, (3,))
+    nose.tools.eq_(f.samples, 3)
+    labels, data = f.read_all()
+  finally:
+    os.unlink(tmp)
+  assert numpy.array_equal(labels, [1, -1, 1])
+  assert numpy.array_equal(data, [[0.5, 0, -2], [0, 1e-3, 0], [1.5, .25, 0]])
+
+def test_data_parsing_raises():
+
+  def check(contents):
+    tmp = write_data(contents)
+    try:
+      nose.tools.assert_raises(RuntimeError, lambda: File(tmp).read_all())
+    finally:
+      os.unlink(tmp)
+
+  check(b'1 1:0.5\n1 x:1\n') #malformed index
+  check(b'1 1:0.5\n1 2:abc\n') #malformed value
+  check(b'1 1:0.5\n1 2\n') #missing value
+  check(b'1 1:0.5\n1.5x 2:1\n') #malformed label
+  check(b'1 1:0.5\n1 0:1\n') #indices start at 1
+  check(b'1 1:0.5\n1 -2:1\n')
+
+def test_data_parsing_chunks():
+
+  #files are scanned in chunks of 1 MB, in parallel: samples must come out
+  #in order, with exactly the values written
+  numpy.random.seed(3)
+  values = numpy.random.randn(20000, 5)
+  labels = numpy.random.randint(-1, 2, 20000)
+  lines = ['%d %s' % (l, ' '.join('%d:%.17g' % (i+1, v) for i, v in
+    enumerate(row))) for l, row in zip(labels, values)]
+  tmp = write_data('\n'.join(lines).encode('ascii'))
+  try:
+    f = File(tmp)
+    assert os.path.getsize(tmp) > 2 * (1 << 20)
+    nose.tools.eq_(f.samples, len(values))
+    read_labels, read_values = f.read_all()
+  finally:
+    os.unlink(tmp)
+  assert numpy.array_equal(read_labels, labels)
+  assert numpy.array_equal(read_values, values)
+
 def test_raises():
 
   #tests that the normal machine raises because probabilities are not
@@ -252,6 +422,509 @@ def test_correctness_iris():
   assert numpy.array_equal(pred_labels, real_labels)
   assert numpy.all(abs(numpy.vstack(pred_probs) - numpy.vstack(real_probs)) < 1e-6)
 
+def test_correctness_threaded():
+
+  #multi-threaded batch prediction must match the single-threaded one
+  machine = Machine(IRIS_MACHINE)
+  labels, data = File(IRIS_DATA).read_all()
+
+  pred_label = machine.predict_class(data)
+  pred_labels, pred_scores = machine.predict_class_and_scores(data)
+  pred_plabels, pred_probs = machine.predict_class_and_probabilities(data)
+
+  for threads in (0, 2, 7, 1000):
+    assert numpy.array_equal(pred_label,
+        machine.predict_class(data, threads=threads))
+    labels_t, scores_t = machine.predict_class_and_scores(data,
+        threads=threads)
+    assert numpy.array_equal(pred_labels, labels_t)
+    assert numpy.array_equal(pred_scores, scores_t)
+    labels_t, probs_t = machine.predict_class_and_probabilities(data,
+        threads=threads)
+    assert numpy.array_equal(pred_plabels, labels_t)
+    assert numpy.array_equal(pred_probs, probs_t)
+
+def test_workspace_per_thread():
+
+  #every worker fills its own workspace: with enough rows for all threads to
+  #get a block, results must be the same as on the calling thread alone
+  for model, data in ((HEART_MACHINE, HEART_DATA), (IRIS_MACHINE, IRIS_DATA)):
+
+    machine = Machine(model)
+    labels, data = File(data).read_all()
+    data = numpy.vstack([data] * 8)
+
+    for engine in ('libsvm', 'dense'):
+      machine.engine = engine
+      serial_labels = machine.predict_class(data, threads=1)
+      serial_scores = machine.predict_class_and_scores(data, threads=1)
+      serial_probs = machine.predict_class_and_probabilities(data, threads=1)
+
+      for threads in (2, 3, 8):
+        assert numpy.array_equal(machine.predict_class(data,
+          threads=threads), serial_labels)
+        labels_t, scores_t = machine.predict_class_and_scores(data,
+            threads=threads)
+        assert numpy.array_equal(labels_t, serial_scores[0])
+        assert numpy.array_equal(scores_t, serial_scores[1])
+        labels_t, probs_t = machine.predict_class_and_probabilities(data,
+            threads=threads)
+        assert numpy.array_equal(labels_t, serial_probs[0])
+        assert numpy.array_equal(probs_t, serial_probs[1])
+
+def test_dense_engine():
+
+  #the dense engine must give the same results as libsvm, up to rounding
+  for model, data, expected, predictions in (
+      (HEART_MACHINE, HEART_DATA, HEART_EXPECTED, expected_heart_predictions),
+      (IRIS_MACHINE, IRIS_DATA, IRIS_EXPECTED, expected_iris_predictions),
+      ):
+
+    machine = Machine(model)
+    nose.tools.eq_(machine.engine, 'libsvm')
+    labels, data = File(data).read_all()
+    ref_labels, ref_scores = machine.predict_class_and_scores(data)
+
+    machine.engine = 'dense'
+    nose.tools.eq_(machine.engine, 'dense')
+
+    assert numpy.array_equal(machine.predict_class(data), predictions)
+    pred_labels, pred_scores = machine.predict_class_and_scores(data)
+    assert numpy.array_equal(pred_labels, ref_labels)
+    assert numpy.all(abs(pred_scores - ref_scores) < 1e-10)
+
+    for k, x in enumerate(data):
+      nose.tools.eq_(machine.predict_class(x), predictions[k])
+
+    #batches are evaluated in tiles, but results must be exactly the same
+    single = numpy.vstack([machine.predict_class_and_scores(x)[1] for x in data])
+    assert numpy.array_equal(pred_scores, single)
+
+    all_labels, real_labels, real_probs = load_expected(expected)
+    pred_labels, pred_probs = machine.predict_class_and_probabilities(data,
+        threads=2)
+    assert numpy.array_equal(pred_labels, real_labels)
+    assert numpy.all(abs(numpy.vstack(pred_probs) - numpy.vstack(real_probs)) < 1e-6)
+
+    #copies share the engine
+    nose.tools.eq_(machine.__copy__().engine, 'dense')
+
+    machine.engine = 'libsvm'
+    nose.tools.eq_(machine.engine, 'libsvm')
+
+def test_probability_coupling():
+
+  for model, data in ((HEART_MACHINE, HEART_DATA), (IRIS_MACHINE, IRIS_DATA)):
+
+    machine = Machine(model)
+    nose.tools.eq_(machine.probability_coupling, 'iterative')
+    labels, data = File(data).read_all()
+    ref_labels, ref_probs = machine.predict_class_and_probabilities(data)
+    ref_labels = numpy.array(ref_labels)
+    ref_probs = numpy.vstack(ref_probs)
+
+    machine.probability_coupling = 'approximate'
+    nose.tools.eq_(machine.probability_coupling, 'approximate')
+    results = []
+    for engine in ('libsvm', 'dense'):
+      machine.engine = engine
+      pred_labels, pred_probs = machine.predict_class_and_probabilities(data,
+          threads=2)
+      pred_labels = numpy.array(pred_labels)
+      pred_probs = numpy.vstack(pred_probs)
+      assert numpy.all(abs(pred_probs.sum(axis=1) - 1.) < 1e-10)
+
+      #batches and single inputs are estimated the same way
+      single = numpy.vstack([machine.predict_class_and_probabilities(x)[1]
+        for x in data])
+      assert numpy.all(abs(single - pred_probs) < 1e-10)
+
+      #same as libsvm with two classes, mostly the same class otherwise
+      if len(machine.labels) == 2:
+        assert numpy.all(abs(pred_probs - ref_probs) < 1e-2)
+      assert numpy.mean(pred_labels == ref_labels) >= 0.95
+      results.append(pred_probs)
+
+    assert numpy.all(abs(results[0] - results[1]) < 1e-6)
+
+    machine.probability_coupling = 'iterative'
+    pred_probs = numpy.vstack(machine.predict_class_and_probabilities(data)[1])
+    assert numpy.all(abs(pred_probs - ref_probs) < 1e-6)
+
+  nose.tools.assert_raises(ValueError, setattr, machine,
+      'probability_coupling', 'exact')
+
+def test_memory_policy():
+
+  machine = Machine(IRIS_MACHINE)
+  nose.tools.eq_(machine.huge_pages, 'none')
+  nose.tools.eq_(machine.replicate, False)
+  nose.tools.eq_(machine.replicas, 0) #libsvm engine
+  labels, data = File(IRIS_DATA).read_all()
+  machine.engine = 'dense'
+  nose.tools.eq_(machine.replicas, 1)
+  ref_labels, ref_scores = machine.predict_class_and_scores(data)
+  ref_scores = numpy.vstack(ref_scores)
+
+  #placement never changes results, on any host
+  for pages in ('none', 'transparent', 'explicit'):
+    for replicate in (False, True):
+      machine.huge_pages = pages
+      machine.replicate = replicate
+      nose.tools.eq_(machine.huge_pages, pages)
+      nose.tools.eq_(machine.replicate, replicate)
+      nose.tools.eq_(machine.engine, 'dense')
+      assert machine.replicas >= 1
+      if not replicate: nose.tools.eq_(machine.replicas, 1)
+      for threads in (1, 4):
+        pred_labels, pred_scores = machine.predict_class_and_scores(data,
+            threads=threads)
+        nose.tools.eq_(list(pred_labels), list(ref_labels))
+        assert numpy.all(numpy.vstack(pred_scores) == ref_scores)
+
+  #copies keep the policy
+  copy = machine.__copy__()
+  nose.tools.eq_(copy.huge_pages, machine.huge_pages)
+  nose.tools.eq_(copy.replicas, machine.replicas)
+
+  nose.tools.assert_raises(ValueError, setattr, machine, 'huge_pages', 'big')
+
+def test_single_precision():
+
+  #support vectors and inputs are rounded to float32: labels must not change
+  for model, data, predictions in (
+      (HEART_MACHINE, HEART_DATA, expected_heart_predictions),
+      (IRIS_MACHINE, IRIS_DATA, expected_iris_predictions),
+      ):
+
+    machine = Machine(model)
+    f = File(data)
+    labels, data = f.read_all()
+    ref_labels, ref_scores = machine.predict_class_and_scores(data)
+
+    single = numpy.ndarray(data.shape, 'float32')
+    f.read_all(labels, single)
+    assert numpy.array_equal(single, data.astype('float32'))
+
+    machine.engine = 'dense32'
+    nose.tools.eq_(machine.engine, 'dense32')
+
+    for values in (data, single):
+      assert numpy.array_equal(machine.predict_class(values), predictions)
+      pred_labels, pred_scores = machine.predict_class_and_scores(values,
+          threads=2)
+      assert numpy.array_equal(pred_labels, ref_labels)
+      assert numpy.all(abs(pred_scores - ref_scores) < 1e-5)
+      for k, x in enumerate(values):
+        nose.tools.eq_(machine.predict_class(x), predictions[k])
+      pred_labels, pred_probs = machine.predict_class_and_probabilities(values)
+      assert numpy.array_equal(pred_labels, ref_labels)
+
+    #other engines take float32 inputs as well
+    for engine in ('libsvm', 'dense'):
+      machine.engine = engine
+      pred_labels, pred_scores = machine.predict_class_and_scores(single)
+      ref = machine.predict_class_and_scores(single.astype('float64'))[1]
+      assert numpy.array_equal(pred_scores, ref)
+
+def test_compress():
+
+  #compressed machines have less support vectors, and scores within bounds
+  for model, data in ((HEART_MACHINE, HEART_DATA), (IRIS_MACHINE, IRIS_DATA)):
+
+    machine = Machine(model)
+    labels, data = File(data).read_all()
+
+    samples, agreement, max_diff, mean_diff = \
+        machine.fidelity(machine.compress(0.), data)
+    nose.tools.eq_(agreement, 1.)
+    assert max_diff < 1e-10
+
+    for max_error in (0.05, 0.2, 1.):
+      small = machine.compress(max_error, threads=2)
+      nose.tools.eq_(small.shape, machine.shape)
+      nose.tools.eq_(small.labels, machine.labels)
+      assert sum(small.n_support_vectors) <= sum(machine.n_support_vectors)
+      assert min(small.n_support_vectors) >= 1
+      samples, agreement, max_diff, mean_diff = machine.fidelity(small, data)
+      nose.tools.eq_(samples, len(data))
+      assert max_diff <= max_error + 1e-10
+      assert mean_diff <= max_diff
+      assert 0. <= agreement <= 1.
+
+    #a target size stops compression early
+    small = machine.compress(1e10, size=20)
+    nose.tools.eq_(sum(small.n_support_vectors), 20)
+
+def test_statistics():
+
+  labels, data = File(HEART_DATA).read_all()
+  machine = Machine(HEART_MACHINE)
+  nose.tools.eq_(machine.collect_statistics, False)
+  machine.predict_class(data)
+  stats = machine.statistics()
+  nose.tools.eq_(stats['calls'], 0)
+  nose.tools.eq_(stats['predictions'], 0)
+
+  support_vectors = sum(machine.n_support_vectors)
+  for engine in ('libsvm', 'dense'):
+    machine.engine = engine
+    machine.collect_statistics = True
+    machine.predict_class_and_scores(data, threads=2)
+    for x in data[:10]: machine.predict_class_and_probabilities(x)
+    stats = machine.statistics()
+    nose.tools.eq_(stats['calls'], 11)
+    nose.tools.eq_(stats['predictions'], len(data) + 10)
+    nose.tools.eq_(stats['kernel_evaluations'],
+        (len(data) + 10) * support_vectors)
+    nose.tools.eq_(sum(stats['latency']), stats['calls'])
+    for key in ('conversion', 'kernel', 'voting'): assert stats[key] >= 0.
+
+    machine.reset_statistics()
+    nose.tools.eq_(machine.statistics()['predictions'], 0)
+    machine.collect_statistics = False
+
+def test_prediction_cache():
+
+  labels, data = File(IRIS_DATA).read_all()
+  unique = len(set(tuple(x) for x in data)) #iris has a few repeated rows
+  machine = Machine(IRIS_MACHINE)
+  nose.tools.eq_(machine.cache_size, 0.)
+  nose.tools.eq_(machine.cache_statistics()['entries'], 0)
+
+  for engine in ('libsvm', 'dense'):
+    machine.engine = engine
+    machine.cache_size = 0
+    labels, scores = machine.predict_class_and_scores(data)
+    plabels, probabilities = machine.predict_class_and_probabilities(data)
+
+    #cached predictions are the ones computed
+    machine.cache_size = 1.
+    nose.tools.eq_(machine.cache_size, 1.)
+    for k in range(2):
+      l, s = machine.predict_class_and_scores(data, threads=2)
+      assert numpy.array_equal(l, labels)
+      assert numpy.array_equal(s, scores)
+      l, p = machine.predict_class_and_probabilities(data)
+      assert numpy.array_equal(l, plabels)
+      assert numpy.array_equal(p, probabilities)
+    for x, label in zip(data, labels):
+      nose.tools.eq_(machine.predict_class(x), label)
+
+    #scores and probabilities are cached separately
+    stats = machine.cache_statistics()
+    nose.tools.eq_(stats['misses'], 2 * unique)
+    nose.tools.eq_(stats['hits'], 5 * len(data) - 2 * unique)
+    nose.tools.eq_(stats['entries'], unique)
+    assert 0. < stats['used'] <= stats['size']
+
+    machine.clear_cache()
+    nose.tools.eq_(machine.cache_statistics()['hits'], 0)
+    nose.tools.eq_(machine.cache_statistics()['entries'], 0)
+
+  #too small to hold everything: the least recently used entries go
+  machine.cache_size = 0.01
+  machine.predict_class(data)
+  stats = machine.cache_statistics()
+  assert stats['evictions'] > 0
+  assert stats['used'] <= stats['size']
+  nose.tools.eq_(stats['entries'] + stats['evictions'], stats['misses'])
+
+  nose.tools.eq_(machine.__copy__().cache_size, machine.cache_size)
+  nose.tools.assert_raises(ValueError, setattr, machine, 'cache_size', -1)
+
+def test_prediction_server():
+
+  import threading
+  labels, data = File(IRIS_DATA).read_all()
+  machine = Machine(IRIS_MACHINE)
+  expected_labels, expected_probs = machine.predict_class_and_probabilities(data)
+
+  with PredictionServer(machine, 'PROBABILITIES', workers=2, batch_size=8,
+      max_latency=0.01) as server:
+    nose.tools.eq_(server.output, 'PROBABILITIES')
+    nose.tools.eq_(server.workers, 2)
+    nose.tools.eq_(server.batch_size, 8)
+
+    #submits rows from several threads at once
+    futures = [None] * len(data)
+    def submit(rows):
+      for k in rows: futures[k] = server.submit(data[k])
+    threads = [threading.Thread(target=submit, args=(range(k, len(data), 4),))
+        for k in range(4)]
+    for t in threads: t.start()
+    for t in threads: t.join()
+
+    for k, f in enumerate(futures):
+      label, probs = f.result()
+      nose.tools.eq_(label, expected_labels[k])
+      assert numpy.allclose(probs, expected_probs[k])
+
+  assert server.closed
+  nose.tools.eq_(server.pending, 0)
+  nose.tools.assert_raises(RuntimeError, server.submit, data[0])
+
+def test_prediction_server_labels():
+
+  labels, data = File(HEART_DATA).read_all()
+  machine = Machine(HEART_MACHINE)
+  server = PredictionServer(machine)
+  futures = [server.submit(x) for x in data]
+  server.close()
+  nose.tools.eq_([f.result() for f in futures], list(expected_heart_predictions))
+
+@nose.tools.raises(RuntimeError)
+def test_prediction_server_no_probabilities():
+
+  PredictionServer(Machine(TEST_MACHINE_NO_PROBS), 'PROBABILITIES')
+
+def test_ensemble():
+
+  labels, data = File(HEART_DATA).read_all()
+  machine = Machine(HEART_MACHINE)
+  scaled = Machine(HEART_MACHINE)
+  scaled.input_subtract = numpy.linspace(0, 0.1, 13)
+  scaled.input_divide = numpy.linspace(1, 2, 13)
+  machines = [machine, machine.__copy__(), scaled]
+
+  ensemble = Ensemble(machines)
+  nose.tools.eq_(len(ensemble), 3)
+  nose.tools.eq_(ensemble.shape, (13, 3))
+  nose.tools.eq_(ensemble.offsets, [0, 1, 2, 3])
+  nose.tools.eq_(ensemble.scalings, 2)
+  l = sum(machine.n_support_vectors)
+  nose.tools.eq_(ensemble.support_vectors, (3*l, 2*l))
+
+  pred_labels, pred_scores = ensemble.predict_class_and_scores(data, threads=2)
+  nose.tools.eq_(pred_labels.shape, (len(data), 3))
+  nose.tools.eq_(pred_scores.shape, (len(data), 3))
+  for k, m in enumerate(machines):
+    ref_labels, ref_scores = m.predict_class_and_scores(data)
+    assert numpy.array_equal(pred_labels[:,k], ref_labels)
+    assert numpy.all(abs(pred_scores[:,k:k+1] - ref_scores) < 1e-10)
+
+  #single inputs give 1D outputs
+  single_labels, single_scores = ensemble(data[0])
+  assert numpy.array_equal(single_labels, pred_labels[0])
+  assert numpy.all(abs(single_scores - pred_scores[0]) < 1e-10)
+
+def test_ensemble_multiclass():
+
+  labels, data = File(IRIS_DATA).read_all()
+  machine = Machine(IRIS_MACHINE)
+  ensemble = Ensemble([machine])
+  pred_labels, pred_scores = ensemble(data)
+  ref_labels, ref_scores = machine.predict_class_and_scores(data)
+  assert numpy.array_equal(pred_labels[:,0], ref_labels)
+  assert numpy.all(abs(pred_scores - ref_scores) < 1e-10)
+
+@nose.tools.raises(RuntimeError)
+def test_ensemble_input_size_mismatch():
+
+  Ensemble([Machine(HEART_MACHINE), Machine(IRIS_MACHINE)])
+
+@nose.tools.raises(RuntimeError)
+def test_compress_negative_error():
+
+  machine = Machine(IRIS_MACHINE)
+  machine.compress(-1.)
+
+class CSR(object):
+  """A minimal stand-in for :py:class:`scipy.sparse.csr_matrix`"""
+
+  def __init__(self, data, indices, indptr, shape):
+    self.data = data
+    self.indices = indices
+    self.indptr = indptr
+    self.shape = shape
+
+def test_sparse_input():
+
+  f = File(HEART_DATA)
+  labels, data = f.read_all()
+  csr_labels, indptr, indices, values = f.read_csr()
+  assert numpy.array_equal(csr_labels, labels)
+  nose.tools.eq_(indptr[-1], len(values))
+
+  dense = numpy.zeros(data.shape)
+  for k in range(len(labels)):
+    row = slice(indptr[k], indptr[k+1])
+    dense[k, indices[row]] = values[row]
+  assert numpy.array_equal(dense, data)
+
+  #indices are converted to 64-bit integers, if required
+  X = CSR(values, indices.astype('int32'), indptr, (f.samples, f.shape))
+
+  for engine in ('libsvm', 'dense'):
+    machine = Machine(HEART_MACHINE)
+    machine.engine = engine
+    assert numpy.array_equal(machine.predict_class(X, threads=2),
+        machine.predict_class(data))
+    sparse_labels, sparse_scores = machine.predict_class_and_scores(X)
+    dense_labels, dense_scores = machine.predict_class_and_scores(data)
+    assert numpy.array_equal(sparse_labels, dense_labels)
+    assert numpy.array_equal(sparse_scores, dense_scores)
+    sparse_labels, sparse_probs = machine.predict_class_and_probabilities(X)
+    dense_labels, dense_probs = machine.predict_class_and_probabilities(data)
+    assert numpy.array_equal(sparse_labels, dense_labels)
+    assert numpy.array_equal(sparse_probs, dense_probs)
+
+@nose.tools.raises(RuntimeError)
+def test_sparse_input_cannot_subtract():
+
+  f = File(HEART_DATA)
+  labels, indptr, indices, values = f.read_csr()
+  machine = Machine(HEART_MACHINE)
+  machine.input_subtract = numpy.ones(machine.shape[0])
+  machine.predict_class(CSR(values, indices, indptr, (f.samples, f.shape)))
+
+def test_chunked_reading():
+
+  f = File(HEART_DATA)
+  labels, data = f.read_all()
+  machine = Machine(HEART_MACHINE)
+  expected = machine.predict_class(data)
+
+  #dense chunks, the last one being shorter
+  chunks = list(f.read_chunks(100, threads=2))
+  nose.tools.eq_([len(k[0]) for k in chunks], [100, 100, 70])
+  assert numpy.array_equal(numpy.hstack([k[0] for k in chunks]), labels)
+  assert numpy.array_equal(numpy.vstack([k[1] for k in chunks]), data)
+  assert numpy.array_equal(numpy.hstack([machine.predict_class(k[1]) for k in
+    chunks]), expected)
+
+  #sparse chunks, with row pointers relative to each chunk
+  predicted = []
+  start = 0
+  for chunk_labels, indptr, indices, values in f.read_chunks(100, sparse=True):
+    n = len(chunk_labels)
+    assert numpy.array_equal(chunk_labels, labels[start:start+n])
+    nose.tools.eq_(indptr[0], 0)
+    nose.tools.eq_(indptr[-1], len(values))
+    X = CSR(values, indices, indptr, (n, f.shape))
+    predicted.append(machine.predict_class(X))
+    start += n
+  nose.tools.eq_(start, f.samples)
+  assert numpy.array_equal(numpy.hstack(predicted), expected)
+
+  #iteration does not interfere with sequential reads
+  f.reset()
+  entry = f.read()
+  nose.tools.eq_(entry[0], labels[0])
+
+@nose.tools.raises(ValueError)
+def test_invalid_engine():
+
+  machine = Machine(IRIS_MACHINE)
+  machine.engine = 'gpu'
+
+@nose.tools.raises(ValueError)
+def test_negative_threads():
+
+  machine = Machine(IRIS_MACHINE)
+  labels, data = File(IRIS_DATA).read_all()
+  machine.predict_class(data, threads=-1)
+
 @nose.tools.raises(RuntimeError)
 def test_correctness_inputsize_exceeds():
 
@@ -14,8 +14,10 @@ import numpy
 import tempfile
 import pkg_resources
 import nose.tools
+import bob.io.base
 
-from . import File, Machine, Trainer
+from . import File, Machine, OneVsRestMachine, ApproximateMachine, Trainer
+from .version import externals
 
 def F(f):
   """Returns the test file on the "data" subdirectory"""
@@ -34,6 +36,8 @@ HEART_DATA = F('heart.svmdata') #13 inputs
 HEART_MACHINE = F('heart.svmmodel') #supports probabilities
 HEART_EXPECTED = F('heart.out') #expected probabilities
 
+IRIS_DATA = F('iris.svmdata') #4 inputs, 3 classes
+
 def test_initialization():
 
   # tests and examplifies some initialization parameters
@@ -111,12 +115,15 @@ def test_training():
   # bindings to libsvm do not include scaling. If you want to implement that
   # generically, please do it.
 
+  # The reference models were saved by libsvm, which rounds gamma and rho to
+  # 6 significant digits, while trained machines keep all their digits.
+
   trainer = Trainer()
   machine = trainer.train((pos, neg)) #ordering only affects labels
   previous = Machine(TEST_MACHINE_NO_PROBS)
   nose.tools.eq_(machine.machine_type, previous.machine_type)
   nose.tools.eq_(machine.kernel_type, previous.kernel_type)
-  nose.tools.eq_(machine.gamma, previous.gamma)
+  assert abs(machine.gamma - previous.gamma) < 1e-6
   nose.tools.eq_(machine.shape, previous.shape)
   assert numpy.all(abs(machine.input_subtract - previous.input_subtract) < 1e-8)
   assert numpy.all(abs(machine.input_divide - previous.input_divide) < 1e-8)
@@ -131,7 +138,107 @@ def test_training():
 
   curr_scores = numpy.array(curr_scores)
   prev_scores = numpy.array(prev_scores)
-  assert numpy.all(abs(curr_scores - prev_scores) < 1e-8)
+  assert numpy.all(abs(curr_scores - prev_scores) < 1e-4)
+
+def test_trained_model_is_not_rounded():
+
+  #trained models and their copies keep all digits: only saving them rounds
+  #values, with the precision of libsvm's text files
+  import copy
+  labels, data = File(IRIS_DATA).read_all()
+  classes = [data[labels == k] for k in numpy.unique(labels)]
+
+  trainer = Trainer()
+  trainer.probability = True
+  trainer.gamma = 1./3
+  for threads in (1, 3):
+    machine = trainer.train(classes, threads=threads)
+    nose.tools.eq_(machine.gamma, 1./3)
+    other = copy.copy(machine)
+    nose.tools.eq_(other.gamma, machine.gamma)
+    curr_scores = machine.predict_class_and_scores(data)[1]
+    assert numpy.array_equal(other.predict_class_and_scores(data)[1],
+        curr_scores)
+    curr_probs = machine.predict_class_and_probabilities(data)[1]
+    assert numpy.array_equal(other.predict_class_and_probabilities(data)[1],
+        curr_probs)
+
+    tmp = tempname('.svmmodel')
+    try:
+      machine.save(tmp)
+      loaded = Machine(tmp)
+    finally:
+      if os.path.exists(tmp): os.unlink(tmp)
+    nose.tools.eq_(loaded.shape, machine.shape)
+    assert numpy.allclose(loaded.predict_class_and_scores(data)[1],
+        curr_scores, atol=1e-4)
+    assert numpy.allclose(loaded.predict_class_and_probabilities(data)[1],
+        curr_probs, atol=1e-4)
+
+def test_pickle_matches_svm_save_model():
+
+  # models within HDF5 files are written like svm_save_model() does, with the
+  # precision of the libsvm we are linked against
+  labels, data = File(IRIS_DATA).read_all()
+  classes = [data[labels == k] for k in numpy.unique(labels)]
+
+  trainer = Trainer()
+  trainer.probability = True
+  machines = [trainer.train(classes)]
+  trainer = Trainer(machine_type='ONE_CLASS', kernel_type='POLY')
+  #one-class probabilities (density marks) only exist from libsvm 3.3 on
+  libsvm = tuple(int(k) for k in externals['LIBSVM'].split('.'))
+  trainer.probability = libsvm >= (3, 30)
+  machines.append(trainer.train(classes[:1]))
+
+  for machine in machines:
+    text = tempname('.svmmodel')
+    hdf5 = tempname('.hdf5')
+    try:
+      machine.save(text)
+      machine.save(bob.io.base.HDF5File(hdf5, 'w'))
+      with open(text, 'rb') as f: expected = f.read()
+      pickled = bob.io.base.HDF5File(hdf5).read('svm_model')
+    finally:
+      if os.path.exists(text): os.unlink(text)
+      if os.path.exists(hdf5): os.unlink(hdf5)
+    nose.tools.eq_(pickled.tobytes(), expected)
+
+class CSR(object):
+  """A minimal stand-in for :py:class:`scipy.sparse.csr_matrix`"""
+
+  def __init__(self, array):
+    mask = array != 0
+    self.data = array[mask]
+    self.indices = numpy.nonzero(mask)[1]
+    self.indptr = numpy.concatenate(([0], numpy.cumsum(mask.sum(axis=1))))
+    self.shape = array.shape
+
+def test_training_sparse():
+
+  f = File(HEART_DATA)
+  labels, data = f.read_all()
+  neg = numpy.vstack([k for i,k in enumerate(data) if labels[i] < 0])
+  pos = numpy.vstack([k for i,k in enumerate(data) if labels[i] > 0])
+
+  #sparse data leads to exactly the same problem, thus the same machine
+  trainer = Trainer()
+  dense = trainer.train((pos, neg))
+  sparse = trainer.train((CSR(pos), CSR(neg)))
+  nose.tools.eq_(sparse.gamma, dense.gamma)
+  nose.tools.eq_(sparse.shape, dense.shape)
+
+  dense_labels, dense_scores = dense.predict_class_and_scores(data)
+  sparse_labels, sparse_scores = sparse.predict_class_and_scores(CSR(data))
+  assert numpy.array_equal(sparse_labels, dense_labels)
+  assert numpy.array_equal(sparse_scores, dense_scores)
+
+@nose.tools.raises(TypeError)
+def test_training_mixed_sparse_and_dense():
+
+  f = File(HEART_DATA)
+  labels, data = f.read_all()
+  Trainer().train((CSR(data[labels < 0]), data[labels > 0]))
 
 def test_training_with_probability():
 
@@ -150,7 +257,7 @@ def test_training_with_probability():
   previous = Machine(HEART_MACHINE)
   nose.tools.eq_(machine.machine_type, previous.machine_type)
   nose.tools.eq_(machine.kernel_type, previous.kernel_type)
-  nose.tools.eq_(machine.gamma, previous.gamma)
+  assert abs(machine.gamma - previous.gamma) < 1e-6
   nose.tools.eq_(machine.shape, previous.shape)
   assert numpy.all(abs(machine.input_subtract - previous.input_subtract) < 1e-8)
   assert numpy.all(abs(machine.input_divide - previous.input_divide) < 1e-8)
@@ -167,7 +274,7 @@ def test_training_with_probability():
 
   curr_scores = numpy.array(curr_scores)
   prev_scores = numpy.array(prev_scores)
-  assert numpy.all(abs(curr_scores - prev_scores) < 1e-8)
+  assert numpy.all(abs(curr_scores - prev_scores) < 1e-4)
 
   # check probabilities -- probA and probB do not get the exact same values
   # as when using libsvm's svm-train.c. The reason may lie in the order in
@@ -198,7 +305,7 @@ def test_training_one_class():
   previous = Machine(TEST_MACHINE_ONE_CLASS)
   nose.tools.eq_(machine.machine_type, previous.machine_type)
   nose.tools.eq_(machine.kernel_type, previous.kernel_type)
-  nose.tools.eq_(machine.gamma, previous.gamma)
+  assert abs(machine.gamma - previous.gamma) < 1e-6
   nose.tools.eq_(machine.shape, previous.shape)
   assert numpy.all(abs(machine.input_subtract - previous.input_subtract) < 1e-8)
   assert numpy.all(abs(machine.input_divide - previous.input_divide) < 1e-8)
@@ -213,5 +320,456 @@ def test_training_one_class():
 
   curr_scores = numpy.array(curr_scores)
   prev_scores = numpy.array(prev_scores)
-  assert numpy.all(abs(curr_scores - prev_scores) < 1e-8)
+  assert numpy.all(abs(curr_scores - prev_scores) < 1e-4)
  
+
+def test_training_one_vs_rest():
+
+  # more classes than one-vs-one machines used to support
+  numpy.random.seed(1)
+  classes = [0.3 * numpy.random.randn(10, 20) + 3 * numpy.eye(20)[k]
+      for k in range(20)]
+
+  trainer = Trainer(kernel_type='LINEAR')
+  machine = trainer.train_one_vs_rest(classes, threads=0)
+  nose.tools.eq_(machine.shape, (20, 20))
+  nose.tools.eq_(machine.labels, list(range(1, 21)))
+
+  data = numpy.vstack(classes)
+  expected = numpy.repeat(numpy.arange(1, 21), 10)
+  labels, scores = machine.predict_class_and_scores(data)
+  nose.tools.eq_(scores.shape, (200, 20))
+  assert numpy.array_equal(labels, expected)
+  assert numpy.array_equal(machine(data[0]), expected[:1])
+
+  tmp = tempname('.hdf5')
+  try:
+    machine.save(bob.io.base.HDF5File(tmp, 'w'))
+    loaded = OneVsRestMachine(bob.io.base.HDF5File(tmp))
+    nose.tools.eq_(loaded.labels, machine.labels)
+    loaded_labels, loaded_scores = loaded.predict_class_and_scores(data)
+    assert numpy.array_equal(loaded_labels, labels)
+    assert numpy.allclose(loaded_scores, scores)
+  finally:
+    if os.path.exists(tmp): os.unlink(tmp)
+
+def test_training_approximate():
+
+  f = File(HEART_DATA)
+  labels, data = f.read_all()
+  neg = numpy.vstack([k for i,k in enumerate(data) if labels[i] < 0])
+  pos = numpy.vstack([k for i,k in enumerate(data) if labels[i] > 0])
+
+  trainer = Trainer()
+  exact = trainer.train((pos, neg))
+  exact_accuracy = numpy.mean(exact.predict_class(data) == labels)
+
+  for approximation in ('FOURIER', 'NYSTROM'):
+    machine = trainer.train_approximate((pos, neg),
+        approximation=approximation, components=300, seed=3)
+    nose.tools.eq_(machine.shape, (13, 1))
+    nose.tools.eq_(machine.labels, [+1, -1])
+    nose.tools.eq_(machine.approximation, approximation)
+    nose.tools.eq_(machine.components, 300)
+
+    predicted, scores = machine.predict_class_and_scores(data)
+    nose.tools.eq_(scores.shape, (len(data), 1))
+    assert numpy.array_equal(predicted, numpy.where(scores[:,0] > 0, 1, -1))
+    assert numpy.mean(predicted == labels) > exact_accuracy - 0.05
+
+    #results do not depend on the number of threads
+    threaded = trainer.train_approximate((pos, neg),
+        approximation=approximation, components=300, seed=3, threads=3)
+    assert numpy.array_equal(threaded.predict_class(data, threads=3),
+        predicted)
+
+    tmp = tempname('.hdf5')
+    try:
+      machine.save(bob.io.base.HDF5File(tmp, 'w'))
+      loaded = ApproximateMachine(bob.io.base.HDF5File(tmp))
+      nose.tools.eq_(loaded.approximation, approximation)
+      loaded_labels, loaded_scores = loaded.predict_class_and_scores(data)
+      assert numpy.array_equal(loaded_labels, predicted)
+      assert numpy.allclose(loaded_scores, scores)
+    finally:
+      if os.path.exists(tmp): os.unlink(tmp)
+
+def test_approximate_scaling_must_match():
+
+  f = File(HEART_DATA)
+  labels, data = f.read_all()
+  machine = Trainer().train_approximate((data[labels > 0],
+    data[labels < 0]), components=50, seed=3)
+
+  tmp = tempname('.hdf5')
+  try:
+    for key in ('input_subtract', 'input_divide'):
+      for size in (12, 14):
+        config = bob.io.base.HDF5File(tmp, 'w')
+        machine.save(config)
+        config.unlink(key)
+        config.set(key, numpy.ones(size))
+        del config
+        nose.tools.assert_raises(RuntimeError, ApproximateMachine,
+            bob.io.base.HDF5File(tmp))
+  finally:
+    if os.path.exists(tmp): os.unlink(tmp)
+
+def test_approximate_default_gamma():
+
+  # like for train(), a gamma of zero stands for one over the highest
+  # feature index that is not zero, so trailing empty features are ignored
+  f = File(HEART_DATA)
+  labels, data = f.read_all()
+  neg = numpy.vstack([k for i,k in enumerate(data) if labels[i] < 0])
+  pos = numpy.vstack([k for i,k in enumerate(data) if labels[i] > 0])
+  pad = lambda x: numpy.hstack((x, numpy.zeros((len(x), 2))))
+
+  trainer = Trainer()
+  default = trainer.train_approximate((pad(pos), pad(neg)), seed=3)
+  trainer.gamma = 1./13
+  explicit = trainer.train_approximate((pad(pos), pad(neg)), seed=3)
+  assert numpy.allclose(default.predict_class_and_scores(pad(data))[1],
+      explicit.predict_class_and_scores(pad(data))[1])
+
+def test_training_linear():
+
+  # linear machines evaluate decision functions with primal weights, which
+  # must give the same results as going through all support vectors
+  f = File(HEART_DATA)
+  labels, data = f.read_all()
+  neg = numpy.vstack([k for i,k in enumerate(data) if labels[i] < 0])
+  pos = numpy.vstack([k for i,k in enumerate(data) if labels[i] > 0])
+
+  trainer = Trainer(kernel_type='LINEAR')
+  machine = trainer.train((pos, neg))
+  nose.tools.eq_(machine.engine, 'dense')
+  curr_labels, curr_scores = machine.predict_class_and_scores(data)
+
+  machine.engine = 'libsvm'
+  prev_labels, prev_scores = machine.predict_class_and_scores(data)
+  assert numpy.array_equal(curr_labels, prev_labels)
+  assert numpy.all(abs(curr_scores - prev_scores) < 1e-8)
+
+  for k, x in enumerate(data):
+    machine.engine = 'dense'
+    curr = machine.predict_class_and_scores(x)
+    machine.engine = 'libsvm'
+    prev = machine.predict_class_and_scores(x)
+    nose.tools.eq_(curr[0], prev[0])
+    assert numpy.all(abs(numpy.array(curr[1]) - numpy.array(prev[1])) < 1e-8)
+
+def test_concurrent_training():
+
+  # training releases the GIL, so several threads may train at once using
+  # the same trainer - results must not change
+  import threading
+
+  f = File(HEART_DATA)
+  labels, data = f.read_all()
+  neg = numpy.vstack([k for i,k in enumerate(data) if labels[i] < 0])
+  pos = numpy.vstack([k for i,k in enumerate(data) if labels[i] > 0])
+
+  trainer = Trainer()
+  machines = [None] * 4
+
+  def train(i):
+    machines[i] = trainer.train((pos, neg))
+
+  threads = [threading.Thread(target=train, args=(i,)) for i in range(len(machines))]
+  for t in threads: t.start()
+  for t in threads: t.join()
+
+  previous = Machine(TEST_MACHINE_NO_PROBS)
+  prev_labels, prev_scores = previous.predict_class_and_scores(data)
+  first_scores = machines[0].predict_class_and_scores(data)[1]
+  for machine in machines:
+    assert abs(machine.gamma - previous.gamma) < 1e-6
+    curr_labels, curr_scores = machine.predict_class_and_scores(data)
+    assert numpy.array_equal(curr_labels, prev_labels)
+    assert numpy.all(abs(curr_scores - prev_scores) < 1e-4)
+    assert numpy.array_equal(curr_scores, first_scores)
+
+def test_parallel_multiclass_training():
+
+  # one-vs-one sub-problems solved concurrently give the same machine
+  f = File(IRIS_DATA)
+  labels, data = f.read_all()
+  classes = [data[labels == k] for k in numpy.unique(labels)]
+
+  trainer = Trainer(kernel_type='LINEAR')
+  trainer.cost = 10
+  sequential = trainer.train(classes)
+  parallel = trainer.train(classes, threads=3)
+
+  nose.tools.eq_(parallel.shape, sequential.shape)
+  nose.tools.eq_(parallel.labels, sequential.labels)
+  nose.tools.eq_(parallel.n_support_vectors, sequential.n_support_vectors)
+  seq_labels, seq_scores = sequential.predict_class_and_scores(data)
+  par_labels, par_scores = parallel.predict_class_and_scores(data)
+  assert numpy.array_equal(par_labels, seq_labels)
+  assert numpy.allclose(par_scores, seq_scores)
+
+def test_retraining():
+
+  f = File(HEART_DATA)
+  labels, data = f.read_all()
+  neg = numpy.vstack([k for i,k in enumerate(data) if labels[i] < 0])
+  pos = numpy.vstack([k for i,k in enumerate(data) if labels[i] > 0])
+
+  #the previous machine did not see the last few samples of each class
+  trainer = Trainer()
+  previous = trainer.train((pos[:-3], neg[:-3]))
+  retrained = trainer.train((pos, neg), previous=previous, threads=2)
+  full = trainer.train((pos, neg))
+
+  nose.tools.eq_(retrained.gamma, full.gamma)
+  nose.tools.eq_(retrained.shape, full.shape)
+  retrained_labels, retrained_scores = retrained.predict_class_and_scores(data)
+  full_labels, full_scores = full.predict_class_and_scores(data)
+  assert numpy.allclose(retrained_scores, full_scores, atol=1e-2)
+  assert numpy.array_equal(retrained_labels[abs(full_scores[:,0]) > 1e-2],
+      full_labels[abs(full_scores[:,0]) > 1e-2])
+
+def test_retraining_with_probability():
+
+  f = File(HEART_DATA)
+  labels, data = f.read_all()
+  neg = numpy.vstack([k for i,k in enumerate(data) if labels[i] < 0])
+  pos = numpy.vstack([k for i,k in enumerate(data) if labels[i] > 0])
+
+  #probabilities are fitted on all samples: the machine is trained from
+  #scratch, so scores are those of a full training
+  trainer = Trainer()
+  trainer.probability = True
+  previous = trainer.train((pos[:-3], neg[:-3]))
+  retrained = trainer.train((pos, neg), previous=previous)
+  full = trainer.train((pos, neg))
+
+  nose.tools.eq_(retrained.n_support_vectors, full.n_support_vectors)
+  assert retrained.probability
+  retrained_scores = retrained.predict_class_and_scores(data)[1]
+  full_scores = full.predict_class_and_scores(data)[1]
+  assert numpy.allclose(retrained_scores, full_scores, atol=1e-8)
+
+@nose.tools.raises(RuntimeError)
+def test_retraining_cannot_rescale():
+
+  f = File(HEART_DATA)
+  labels, data = f.read_all()
+  trainer = Trainer()
+  previous = trainer.train((data[labels > 0], data[labels < 0]))
+  trainer.train((data[labels > 0], data[labels < 0]), numpy.zeros(13),
+      numpy.ones(13), previous)
+
+def test_grid_search():
+
+  f = File(HEART_DATA)
+  labels, data = f.read_all()
+  neg = numpy.vstack([k for i,k in enumerate(data) if labels[i] < 0])
+  pos = numpy.vstack([k for i,k in enumerate(data) if labels[i] > 0])
+
+  trainer = Trainer()
+  costs = (0.1, 1, 10)
+  gammas = (0, 0.01, 1)
+  accuracy, mse, seconds = trainer.grid_search((pos, neg), costs, gammas,
+      folds=3, threads=2)
+  nose.tools.eq_(accuracy.shape, (3, 3))
+  nose.tools.eq_(mse.shape, (3, 3))
+  nose.tools.eq_(seconds.shape, (3, 3))
+  assert numpy.all((accuracy >= 0) & (accuracy <= 1))
+  assert numpy.all(seconds >= 0)
+
+  #labels are +1 and -1: each error costs 4 to the mean squared error
+  assert numpy.allclose(mse, 4 * (1 - accuracy))
+
+  #results do not depend on the number of threads or on the data format
+  serial = trainer.grid_search((pos, neg), costs, gammas, folds=3, threads=1)
+  assert numpy.array_equal(serial[0], accuracy)
+  sparse = trainer.grid_search((CSR(pos), CSR(neg)), costs, gammas, folds=3)
+  assert numpy.array_equal(sparse[0], accuracy)
+
+  #a single cell, with the trainer's own parameters
+  trainer.cost = costs[1]
+  cv_accuracy, cv_mse, cv_seconds = trainer.cross_validate((pos, neg), folds=3)
+  nose.tools.eq_(cv_accuracy, accuracy[1,0])
+  nose.tools.eq_(cv_mse, mse[1,0])
+
+def test_shared_kernel_cache():
+
+  f = File(HEART_DATA)
+  labels, data = f.read_all()
+  neg = numpy.vstack([k for i,k in enumerate(data) if labels[i] < 0])
+  pos = numpy.vstack([k for i,k in enumerate(data) if labels[i] > 0])
+
+  plain = Trainer()
+  cached = Trainer()
+  nose.tools.eq_(cached.shared_cache_size, 0)
+  cached.shared_cache_size = 20
+  nose.tools.eq_(cached.shared_cache_size, 20)
+
+  #kernel matrices are re-used across costs, without changing the results
+  for cost in (1, 10):
+    plain.cost = cost
+    cached.cost = cost
+    expected = plain.train((pos, neg))
+    machine = cached.train((pos, neg))
+    nose.tools.eq_(machine.n_support_vectors, expected.n_support_vectors)
+    assert numpy.allclose(machine.predict_class_and_scores(data)[1],
+        expected.predict_class_and_scores(data)[1])
+
+  costs = (0.1, 1, 10)
+  gammas = (0, 0.01, 1)
+  expected = plain.grid_search((pos, neg), costs, gammas, folds=3)
+  accuracy = cached.grid_search((pos, neg), costs, gammas, folds=3)[0]
+  assert numpy.array_equal(accuracy, expected[0])
+
+  #matrices that do not fit are simply not used
+  cached.shared_cache_size = 0.1
+  assert numpy.array_equal(cached.train((pos, neg)).predict_class(data),
+      plain.train((pos, neg)).predict_class(data))
+  cached.shared_cache_size = 0
+  nose.tools.eq_(cached.shared_cache_size, 0)
+
+def test_statistics():
+
+  f = File(HEART_DATA)
+  labels, data = f.read_all()
+  neg = numpy.vstack([k for i,k in enumerate(data) if labels[i] < 0])
+  pos = numpy.vstack([k for i,k in enumerate(data) if labels[i] > 0])
+
+  trainer = Trainer()
+  nose.tools.eq_(trainer.collect_statistics, False)
+  trainer.train((pos, neg))
+  nose.tools.eq_(trainer.statistics()['trainings'], 0)
+
+  trainer.collect_statistics = True
+  trainer.shared_cache_size = 20
+  trainer.train((pos, neg))
+  trainer.cost = 10
+  trainer.train((pos, neg))
+  stats = trainer.statistics()
+  nose.tools.eq_(stats['trainings'], 2)
+  nose.tools.eq_(stats['problems'], 2)
+  assert stats['iterations'] > 0
+  nose.tools.eq_(stats['kernel_misses'], 1)
+  nose.tools.eq_(stats['kernel_hits'], 1)
+  assert stats['build'] >= 0.
+  assert stats['solve'] > 0.
+
+  #one problem per cell and fold
+  trainer.reset_statistics()
+  trainer.grid_search((pos, neg), (1, 10), (0,), folds=3)
+  stats = trainer.statistics()
+  nose.tools.eq_(stats['trainings'], 1)
+  nose.tools.eq_(stats['problems'], 6)
+
+  #one problem per pair of classes, solved on separate threads
+  labels, data = File(IRIS_DATA).read_all()
+  classes = [data[labels == k] for k in numpy.unique(labels)]
+  trainer.reset_statistics()
+  trainer.train(classes, threads=2)
+  nose.tools.eq_(trainer.statistics()['problems'], 3)
+
+def test_progress():
+
+  f = File(HEART_DATA)
+  labels, data = f.read_all()
+  neg = numpy.vstack([k for i,k in enumerate(data) if labels[i] < 0])
+  pos = numpy.vstack([k for i,k in enumerate(data) if labels[i] > 0])
+
+  trainer = Trainer()
+  nose.tools.eq_(trainer.progress, None)
+  nose.tools.eq_(trainer.time_limit, 0)
+  expected = trainer.train((pos, neg))
+
+  reports = []
+  trainer.progress = reports.append
+  nose.tools.eq_(trainer.progress, reports.append)
+  machine = trainer.train((pos, neg))
+  assert numpy.array_equal(machine.predict_class(data),
+      expected.predict_class(data))
+  assert reports
+  nose.tools.eq_(reports[-1]['problems'], 1)
+  assert reports[-1]['iterations'] > 0
+  assert reports[-1]['elapsed'] >= 0.
+  assert not numpy.isnan(reports[-1]['objective'])
+
+  #one report per cell and fold, at least
+  del reports[:]
+  trainer.grid_search((pos, neg), (1, 10), (0,), folds=3, threads=2)
+  nose.tools.eq_(max(k['problems'] for k in reports), 6)
+
+  #returning False cancels, exceptions are raised again
+  trainer.progress = lambda p: False
+  nose.tools.assert_raises(RuntimeError, trainer.train, (pos, neg))
+  def fail(p): raise ValueError('hopeless')
+  trainer.progress = fail
+  nose.tools.assert_raises(ValueError, trainer.grid_search, (pos, neg),
+      (1, 10), (0,), 3, threads=2)
+
+  #solvers are only interrupted if asked for
+  nose.tools.eq_(trainer.interrupt_solver, False)
+  trainer.progress = lambda p: False
+  nose.tools.assert_raises(RuntimeError, trainer.train, (pos, neg))
+  trainer.interrupt_solver = True
+  nose.tools.eq_(trainer.interrupt_solver, True)
+  nose.tools.assert_raises(RuntimeError, trainer.train, (pos, neg))
+  trainer.interrupt_solver = False
+
+  trainer.progress = None
+  trainer.time_limit = 1e-9
+  nose.tools.assert_raises(RuntimeError, trainer.train, (pos, neg))
+  trainer.time_limit = 0
+  trainer.train((pos, neg))
+
+def test_approximate_progress_and_statistics():
+
+  labels, data = File(IRIS_DATA).read_all()
+  classes = [data[labels == k] for k in numpy.unique(labels)]
+
+  #approximate trainings solve one problem per class, one-vs-rest
+  trainer = Trainer()
+  trainer.collect_statistics = True
+  reports = []
+  trainer.progress = reports.append
+  trainer.train_approximate(classes, components=50, threads=2)
+  stats = trainer.statistics()
+  nose.tools.eq_(stats['trainings'], 1)
+  nose.tools.eq_(stats['problems'], 3)
+  assert stats['iterations'] > 0
+  assert stats['solve'] > 0.
+  nose.tools.eq_(max(k['problems'] for k in reports), 3)
+  nose.tools.eq_(reports[-1]['iterations'], stats['iterations'])
+  assert not numpy.isnan(reports[-1]['objective'])
+
+  #and may be cancelled like any other
+  trainer.progress = lambda p: False
+  nose.tools.assert_raises(RuntimeError, trainer.train_approximate, classes,
+      components=50)
+  trainer.progress = None
+  trainer.time_limit = 1e-9
+  nose.tools.assert_raises(RuntimeError, trainer.train_approximate, classes,
+      components=50)
+
+@nose.tools.raises(TypeError)
+def test_progress_must_be_callable():
+
+  Trainer().progress = 3
+
+@nose.tools.raises(ValueError)
+def test_grid_search_needs_folds():
+
+  f = File(HEART_DATA)
+  labels, data = f.read_all()
+  Trainer().cross_validate((data[labels < 0], data[labels > 0]), folds=1)
+
+def test_grid_search_needs_values():
+
+  f = File(HEART_DATA)
+  labels, data = f.read_all()
+  trainer = Trainer()
+  trainer.shared_cache_size = 20
+  for costs, gammas in (((), (0,)), ((1,), ()), ((), ())):
+    nose.tools.assert_raises(RuntimeError, trainer.grid_search,
+        (data[labels < 0], data[labels > 0]), costs, gammas, folds=3)
@@ -13,6 +13,7 @@
 #include <bob.io.base/api.h>
 #include <bob.learn.libsvm/api.h>
 #include <structmember.h>
+#include <boost/make_shared.hpp>
 
 /*******************************************************
  * Implementation of Support Vector Trainer base class *
@@ -272,6 +273,45 @@ static int PyBobLearnLibsvmTrainer_setCacheSize
   return 0;
 }
 
+PyDoc_STRVAR(s_shared_cache_size_str, "shared_cache_size");
+PyDoc_STRVAR(s_shared_cache_size_doc,
+"Size (in megabytes) of the kernel matrices kept by this trainer between\n\
+trainings, or zero (the default) if none are kept.\n\
+\n\
+When set, full kernel matrices are computed once and re-used by all\n\
+trainings on the same samples with the same kernel parameters, e.g.\n\
+while trying several values of :py:attr:`cost` or :py:attr:`nu`, during\n\
+:py:meth:`grid_search` or by the binary machines of\n\
+:py:meth:`train_one_vs_rest`. The matrices used the longest time ago are\n\
+dropped when they no longer fit and matrices that do not fit at all are\n\
+never computed. Results are the same as without the shared cache.\n\
+Trainings starting from a previous machine do not use it.");
+
+static PyObject* PyBobLearnLibsvmTrainer_getSharedCacheSize
+(PyBobLearnLibsvmTrainerObject* self, void* /*closure*/) {
+  auto cache = self->cxx->getKernelCache();
+  return Py_BuildValue("d", cache ? cache->getSizeInMb() : 0.);
+}
+
+static int PyBobLearnLibsvmTrainer_setSharedCacheSize
+(PyBobLearnLibsvmTrainerObject* self, PyObject* o, void* /*closure*/) {
+  if (!o) {
+    PyErr_SetString(PyExc_TypeError, "cannot delete attribute");
+    return -1;
+  }
+  double v = PyFloat_AsDouble(o);
+  if (PyErr_Occurred()) return -1;
+  if (v < 0.) {
+    PyErr_Format(PyExc_ValueError, "`%s.%s' must be non-negative", Py_TYPE(self)->tp_name, s_shared_cache_size_str);
+    return -1;
+  }
+  auto cache = self->cxx->getKernelCache();
+  if (v == 0.) self->cxx->setKernelCache(boost::shared_ptr<bob::learn::libsvm::KernelCache>());
+  else if (cache) cache->setSizeInMb(v);
+  else self->cxx->setKernelCache(boost::make_shared<bob::learn::libsvm::KernelCache>(v));
+  return 0;
+}
+
 PyDoc_STRVAR(s_stop_epsilon_str, "stop_epsilon");
 PyDoc_STRVAR(s_stop_epsilon_doc,
 "The epsilon used for stop training");
@@ -409,6 +449,238 @@ static int PyBobLearnLibsvmTrainer_setShrinking
   return 0;
 }
 
+/**
+ * A progress callback calling a Python callable. Python errors it raises
+ * cancel the training and are kept, to be raised again once it is over.
+ */
+class python_progress {
+
+  public:
+
+    python_progress(PyObject* callable):
+      m_state(boost::make_shared<state>(callable)) {}
+
+    bool operator()(const bob::learn::libsvm::TrainingProgress& p) const {
+      PyGILState_STATE gil = PyGILState_Ensure();
+      bool retval = false;
+      PyObject* result = 0;
+      PyObject* arg = Py_BuildValue("{s:K,s:K,s:d,s:d}",
+          "problems", (unsigned long long)p.problems,
+          "iterations", (unsigned long long)p.iterations,
+          "objective", p.objective,
+          "elapsed", p.elapsed);
+      if (arg) {
+        result = PyObject_CallFunctionObjArgs(m_state->callable, arg, 0);
+        Py_DECREF(arg);
+      }
+      if (result) {
+        //only an explicit False cancels
+        retval = (result != Py_False);
+        Py_DECREF(result);
+      }
+      else if (!m_state->type) {
+        PyErr_Fetch(&m_state->type, &m_state->value, &m_state->traceback);
+      }
+      else PyErr_Clear();
+      PyGILState_Release(gil);
+      return retval;
+    }
+
+    PyObject* callable() const { return m_state->callable; }
+
+    /**
+     * Raises the Python error kept, if any. Returns 1 if it did. The GIL
+     * must be held.
+     */
+    int restore() const {
+      if (!m_state->type) return 0;
+      PyErr_Restore(m_state->type, m_state->value, m_state->traceback);
+      m_state->type = m_state->value = m_state->traceback = 0;
+      return 1;
+    }
+
+  private:
+
+    struct state {
+      PyObject* callable;
+      PyObject* type;
+      PyObject* value;
+      PyObject* traceback;
+
+      state(PyObject* c): callable(c), type(0), value(0), traceback(0) {
+        Py_INCREF(callable);
+      }
+
+      ~state() {
+        //the last copy may be released by a worker thread
+        PyGILState_STATE gil = PyGILState_Ensure();
+        Py_DECREF(callable);
+        Py_XDECREF(type);
+        Py_XDECREF(value);
+        Py_XDECREF(traceback);
+        PyGILState_Release(gil);
+      }
+    };
+
+    boost::shared_ptr<state> m_state;
+
+};
+
+/**
+ * Sets the Python error of a training that raised a C++ exception: the one
+ * the progress callback raised, if any, or ``what``
+ */
+static void set_training_error(PyBobLearnLibsvmTrainerObject* self,
+    const char* what) {
+  bob::learn::libsvm::ProgressCallback callback =
+    self->cxx->getProgressCallback();
+  python_progress* progress = callback.target<python_progress>();
+  if (progress && progress->restore()) return;
+  PyErr_SetString(PyExc_RuntimeError, what);
+}
+
+PyDoc_STRVAR(s_progress_str, "progress");
+PyDoc_STRVAR(s_progress_doc,
+"A callable the progress of trainings is reported to, or ``None``\n\
+(the default). It is called with a dictionary, whenever another\n\
+problem is solved and about every thousand SMO iterations, with\n\
+keys:\n\
+\n\
+``problems``\n\
+  optimization problems solved so far (e.g. one per pair of classes\n\
+  for multi-class machines, one per grid cell and fold for\n\
+  :py:meth:`grid_search`, one per linear function for\n\
+  :py:meth:`train_approximate`)\n\
+``iterations``\n\
+  SMO iterations so far, over all problems (counted by thousands\n\
+  for problems being solved)\n\
+``objective``\n\
+  the objective value of the last problem solved (NaN before the\n\
+  first one is)\n\
+``elapsed``\n\
+  seconds since the training started\n\
+\n\
+Returning ``False`` (not just any false value) cancels the training,\n\
+which raises :py:exc:`RuntimeError`. Exceptions raised by the\n\
+callable cancel the training as well and are raised again by the\n\
+training method. Calls never overlap, but come from the threads of\n\
+the training. Cancelled trainings stop before LIBSVM solves their\n\
+next problem (see :py:attr:`interrupt_solver`).\n\
+");
+
+static PyObject* PyBobLearnLibsvmTrainer_getProgress
+(PyBobLearnLibsvmTrainerObject* self, void* /*closure*/) {
+  bob::learn::libsvm::ProgressCallback callback =
+    self->cxx->getProgressCallback();
+  python_progress* progress = callback.target<python_progress>();
+  if (!progress) Py_RETURN_NONE;
+  Py_INCREF(progress->callable());
+  return progress->callable();
+}
+
+static int PyBobLearnLibsvmTrainer_setProgress
+(PyBobLearnLibsvmTrainerObject* self, PyObject* o, void* /*closure*/) {
+  if (!o) {
+    PyErr_SetString(PyExc_TypeError, "cannot delete attribute");
+    return -1;
+  }
+  if (o == Py_None) {
+    self->cxx->setProgressCallback(bob::learn::libsvm::ProgressCallback());
+    return 0;
+  }
+  if (!PyCallable_Check(o)) {
+    PyErr_Format(PyExc_TypeError, "`%s.%s' must be callable or None, not `%s'", Py_TYPE(self)->tp_name, s_progress_str, Py_TYPE(o)->tp_name);
+    return -1;
+  }
+  self->cxx->setProgressCallback(python_progress(o));
+  return 0;
+}
+
+PyDoc_STRVAR(s_time_limit_str, "time_limit");
+PyDoc_STRVAR(s_time_limit_doc,
+"Trainings running for longer than this many seconds are cancelled\n\
+and raise :py:exc:`RuntimeError`, or zero (the default) for no limit.\n\
+The limit is checked whenever :py:attr:`progress` would be called,\n\
+and takes effect before LIBSVM solves the next problem (see\n\
+:py:attr:`interrupt_solver`).\n\
+");
+
+static PyObject* PyBobLearnLibsvmTrainer_getTimeLimit
+(PyBobLearnLibsvmTrainerObject* self, void* /*closure*/) {
+  return Py_BuildValue("d", self->cxx->getTimeLimit());
+}
+
+static int PyBobLearnLibsvmTrainer_setTimeLimit
+(PyBobLearnLibsvmTrainerObject* self, PyObject* o, void* /*closure*/) {
+  if (!o) {
+    PyErr_SetString(PyExc_TypeError, "cannot delete attribute");
+    return -1;
+  }
+  double v = PyFloat_AsDouble(o);
+  if (PyErr_Occurred()) return -1;
+  if (v < 0.) {
+    PyErr_Format(PyExc_ValueError, "`%s.%s' must be non-negative", Py_TYPE(self)->tp_name, s_time_limit_str);
+    return -1;
+  }
+  self->cxx->setTimeLimit(v);
+  return 0;
+}
+
+PyDoc_STRVAR(s_interrupt_solver_str, "interrupt_solver");
+PyDoc_STRVAR(s_interrupt_solver_doc,
+"Cancelled trainings (see :py:attr:`progress` and\n\
+:py:attr:`time_limit`) stop before LIBSVM solves their next\n\
+problem and, if this is ``True``, also in the middle of the\n\
+problems being solved. LIBSVM cannot free the memory of\n\
+interrupted solvers: each one leaks its kernel cache (up to\n\
+:py:attr:`cache_size` megabytes), so keep this off in processes\n\
+cancelling many trainings. ``False`` by default.\n\
+");
+
+static PyObject* PyBobLearnLibsvmTrainer_getInterruptSolver
+(PyBobLearnLibsvmTrainerObject* self, void* /*closure*/) {
+  if (self->cxx->getInterruptSolver()) Py_RETURN_TRUE;
+  Py_RETURN_FALSE;
+}
+
+static int PyBobLearnLibsvmTrainer_setInterruptSolver
+(PyBobLearnLibsvmTrainerObject* self, PyObject* o, void* /*closure*/) {
+  if (!o) {
+    PyErr_SetString(PyExc_TypeError, "cannot delete attribute");
+    return -1;
+  }
+  int v = PyObject_IsTrue(o);
+  if (v < 0) return -1;
+  self->cxx->setInterruptSolver(v);
+  return 0;
+}
+
+PyDoc_STRVAR(s_collect_statistics_str, "collect_statistics");
+PyDoc_STRVAR(s_collect_statistics_doc,
+"If set to ``True``, this trainer counts its trainings, the work\n\
+libsvm did for them and the time they took, see\n\
+:py:meth:`statistics`. Switching counters on starts from zero.\n\
+Off by default.\n\
+");
+
+static PyObject* PyBobLearnLibsvmTrainer_getCollectStatistics
+(PyBobLearnLibsvmTrainerObject* self, void* /*closure*/) {
+  if (self->cxx->getCollectStatistics()) Py_RETURN_TRUE;
+  Py_RETURN_FALSE;
+}
+
+static int PyBobLearnLibsvmTrainer_setCollectStatistics
+(PyBobLearnLibsvmTrainerObject* self, PyObject* o, void* /*closure*/) {
+  if (!o) {
+    PyErr_SetString(PyExc_TypeError, "cannot delete attribute");
+    return -1;
+  }
+  int v = PyObject_IsTrue(o);
+  if (v < 0) return -1;
+  self->cxx->setCollectStatistics(v);
+  return 0;
+}
+
 static PyGetSetDef PyBobLearnLibsvmTrainer_getseters[] = {
     {
       s_machine_type_str,
@@ -452,6 +724,13 @@ static PyGetSetDef PyBobLearnLibsvmTrainer_getseters[] = {
       s_cache_size_doc,
       0
     },
+    {
+      s_shared_cache_size_str,
+      (getter)PyBobLearnLibsvmTrainer_getSharedCacheSize,
+      (setter)PyBobLearnLibsvmTrainer_setSharedCacheSize,
+      s_shared_cache_size_doc,
+      0
+    },
     {
       s_stop_epsilon_str,
       (getter)PyBobLearnLibsvmTrainer_getStopEpsilon,
@@ -494,6 +773,34 @@ static PyGetSetDef PyBobLearnLibsvmTrainer_getseters[] = {
       s_shrinking_doc,
       0
     },
+    {
+      s_collect_statistics_str,
+      (getter)PyBobLearnLibsvmTrainer_getCollectStatistics,
+      (setter)PyBobLearnLibsvmTrainer_setCollectStatistics,
+      s_collect_statistics_doc,
+      0
+    },
+    {
+      s_progress_str,
+      (getter)PyBobLearnLibsvmTrainer_getProgress,
+      (setter)PyBobLearnLibsvmTrainer_setProgress,
+      s_progress_doc,
+      0
+    },
+    {
+      s_time_limit_str,
+      (getter)PyBobLearnLibsvmTrainer_getTimeLimit,
+      (setter)PyBobLearnLibsvmTrainer_setTimeLimit,
+      s_time_limit_doc,
+      0
+    },
+    {
+      s_interrupt_solver_str,
+      (getter)PyBobLearnLibsvmTrainer_getInterruptSolver,
+      (setter)PyBobLearnLibsvmTrainer_setInterruptSolver,
+      s_interrupt_solver_doc,
+      0
+    },
     {0}  /* Sentinel */
 };
 
@@ -551,7 +858,7 @@ PyObject* PyBobLearnLibsvmTrainer_Str(PyBobLearnLibsvmTrainerObject* self) {
 
 PyDoc_STRVAR(s_train_str, "train");
 PyDoc_STRVAR(s_train_doc,
-"o.train(data, [subtract, divide]) -> array\n\
+"o.train(data, [subtract, divide, [previous, [threads=1]]]) -> array\n\
 \n\
 Trains a new machine for multi-class classification. If the\n\
 number of classes in data is 2, then the assigned labels will\n\
@@ -567,6 +874,13 @@ array should be organized row-wise (i.e. 1 row represents 1\n\
 sample). All rows for all arrays should have exactly the same\n\
 number of columns - this will be checked.\n\
 \n\
+Instead of 2D arrays, ``data`` may contain sparse matrices in CSR\n\
+format, such as :py:class:`scipy.sparse.csr_matrix` objects (or any\n\
+objects with ``indptr``, ``indices``, ``data`` and ``shape``\n\
+attributes), which are fed to LIBSVM without being densified. In\n\
+this case, ``subtract`` must be zero everywhere, as zeros are not\n\
+stored.\n\
+\n\
 Optionally, you may also provide **both** input arrays\n\
 ``subtract`` and ``divide``, which will be used to normalize\n\
 the input data **before** it is fed into the training code.\n\
@@ -578,28 +892,52 @@ floats with the same width as all data in the input array\n\
 \n\
    d' = \\frac{d-\\text{subtract}}{\\text{divide}}\n\
 \n\
+To retrain a machine after adding some data, pass the\n\
+:py:class:`Machine` obtained before as ``previous``, instead of\n\
+``subtract`` and ``divide``: ``data`` should then contain all\n\
+samples (old and new, with classes in the same order), which are\n\
+scaled like for ``previous``. Samples that ``previous`` classifies\n\
+with a large margin are left out of the optimization, as long as\n\
+the new solution does not need them, so the result is the same\n\
+as with a full training (up to the stopping tolerance) for a\n\
+fraction of the cost. Margins are evaluated on up to ``threads``\n\
+threads (zero means one per core). Only ``'C_SVC'`` machines\n\
+without :py:attr:`probability` estimates are retrained this way,\n\
+the others are trained from scratch: LIBSVM fits probabilities on\n\
+the samples it is given, which must then be all of them.\n\
+\n\
+With more than 2 classes, ``'C_SVC'`` and ``'NU_SVC'`` machines\n\
+solve their one-vs-one binary sub-problems concurrently, on up to\n\
+``threads`` threads (zero means one per core). The kernel cache\n\
+is then split evenly between the threads. The resulting machine\n\
+is the same as with a single thread, up to probability estimates,\n\
+which LIBSVM fits on random folds.\n\
+\n\
+The Python global interpreter lock is released while training,\n\
+so that several trainings may run concurrently on different\n\
+threads.\n\
+\n\
 ");
 
-static PyObject* PyBobLearnLibsvmTrainer_train
-(PyBobLearnLibsvmTrainerObject* self, PyObject* args, PyObject* kwds) {
-
-  static const char* const_kwlist[] = {"data", "subtract", "divide", 0};
-  static char** kwlist = const_cast<char**>(const_kwlist);
-
-  PyObject* X = 0;
-  PyBlitzArrayObject* subtract = 0;
-  PyBlitzArrayObject* divide = 0;
-
-  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|O&O&", kwlist,
-        &X,
-        &PyBlitzArray_OutputConverter, &subtract,
-        &PyBlitzArray_OutputConverter, &divide
-        )) return 0;
+/**
+ * Training data, as converted from a Python iterable of arrays or sparse
+ * matrices (one per class). Only references the data, which is kept alive
+ * for the lifetime of the object.
+ */
+struct training_data {
+  std::vector<blitz::Array<double,2> > dense;
+  std::vector<boost::shared_ptr<PyBlitzArrayObject>> dense_;
+  std::vector<bob::learn::libsvm::SparseMatrix> sparse;
+  std::vector<boost::shared_ptr<bob::learn::libsvm::SparseMatrix>> sparse_;
+  size_t classes() const { return dense.size() + sparse.size(); }
+};
 
-  //protects acquired resources through this scope
-  auto X_ = make_safe(X);
-  auto subtract_ = make_xsafe(subtract);
-  auto divide_ = make_xsafe(divide);
+/**
+ * Checks and converts all entries of ``X`` into ``data``. Returns 0, with a
+ * Python exception set, on errors.
+ */
+static int convert_data(PyBobLearnLibsvmTrainerObject* self, PyObject* X,
+    training_data& data) {
 
   /**
   // Note: strangely, if you pass dict.values(), this check does not work
@@ -609,9 +947,8 @@ static PyObject* PyBobLearnLibsvmTrainer_train
   }
   **/
 
-  /* Checks and converts all entries */
-  std::vector<blitz::Array<double,2> > Xseq;
-  std::vector<boost::shared_ptr<PyBlitzArrayObject>> Xseq_;
+  std::vector<blitz::Array<double,2> >& Xseq = data.dense;
+  std::vector<bob::learn::libsvm::SparseMatrix>& Sseq = data.sparse;
 
   PyObject* iterator = PyObject_GetIter(X);
   if (!iterator) return 0;
@@ -620,6 +957,23 @@ static PyObject* PyBobLearnLibsvmTrainer_train
   while (PyObject* item = PyIter_Next(iterator)) {
     auto item_ = make_safe(item);
 
+    if (PyBobLearnLibsvm_IsSparse(item)) {
+      if (Xseq.size()) {
+        PyErr_Format(PyExc_TypeError, "`%s' cannot mix dense and sparse matrices in input sequence `X', but found a sparse matrix at position %" PY_FORMAT_SIZE_T "d", Py_TYPE(self)->tp_name, Xseq.size());
+        return 0;
+      }
+      auto sparse = PyBobLearnLibsvm_AsSparse(item);
+      if (!sparse) return 0;
+      data.sparse_.push_back(sparse); ///< prevents data deletion
+      Sseq.push_back(*sparse); ///< only references the arrays
+      continue;
+    }
+
+    if (Sseq.size()) {
+      PyErr_Format(PyExc_TypeError, "`%s' cannot mix dense and sparse matrices in input sequence `X', but found a dense array at position %" PY_FORMAT_SIZE_T "d", Py_TYPE(self)->tp_name, Sseq.size());
+      return 0;
+    }
+
     PyBlitzArrayObject* bz = 0;
 
     if (!PyBlitzArray_Converter(item, &bz)) {
@@ -633,25 +987,37 @@ static PyObject* PyBobLearnLibsvmTrainer_train
       return 0;
     }
 
-    Xseq_.push_back(make_safe(bz)); ///< prevents data deletion
-    Xseq.push_back(*PyBlitzArrayCxx_AsBlitz<double,2>(bz)); ///< only a view!  
+    data.dense_.push_back(make_safe(bz)); ///< prevents data deletion
+    Xseq.push_back(*PyBlitzArrayCxx_AsBlitz<double,2>(bz)); ///< only a view!
   }
 
   if (PyErr_Occurred()) return 0;
 
+  size_t n_classes = data.classes();
+
 
   // To Review this checks. It is probably that we have to create differents chechs when machine type is ONE_CLASS
 
-  if ( (Xseq.size() < 2) && (self->cxx->getMachineType()!=bob::learn::libsvm::machine_t::ONE_CLASS) ) {
-    PyErr_Format(PyExc_RuntimeError, "`%s' requires an iterable for parameter `X' leading to, at least, two entries (representing two classes), but you have passed something that has only %" PY_FORMAT_SIZE_T "d entries", Py_TYPE(self)->tp_name, Xseq.size());
+  if ( (n_classes < 2) && (self->cxx->getMachineType()!=bob::learn::libsvm::machine_t::ONE_CLASS) ) {
+    PyErr_Format(PyExc_RuntimeError, "`%s' requires an iterable for parameter `X' leading to, at least, two entries (representing two classes), but you have passed something that has only %" PY_FORMAT_SIZE_T "d entries", Py_TYPE(self)->tp_name, n_classes);
     return 0;
   }
-  
-  if ( (Xseq.size() < 1) && (self->cxx->getMachineType()==bob::learn::libsvm::machine_t::ONE_CLASS) ) {
-    PyErr_Format(PyExc_RuntimeError, "`%s' requires an iterable for parameter `X' leading to, at least, one entry (representing one class), but you have passed something that has only %" PY_FORMAT_SIZE_T "d entries", Py_TYPE(self)->tp_name, Xseq.size());
+
+  if ( (n_classes < 1) && (self->cxx->getMachineType()==bob::learn::libsvm::machine_t::ONE_CLASS) ) {
+    PyErr_Format(PyExc_RuntimeError, "`%s' requires an iterable for parameter `X' leading to, at least, one entry (representing one class), but you have passed something that has only %" PY_FORMAT_SIZE_T "d entries", Py_TYPE(self)->tp_name, n_classes);
     return 0;
   }
 
+  return 1;
+}
+
+/**
+ * Checks the optional scaling arrays. Returns 0, with a Python exception
+ * set, on errors.
+ */
+static int check_scaling(PyBobLearnLibsvmTrainerObject* self,
+    PyBlitzArrayObject* subtract, PyBlitzArrayObject* divide) {
+
   if (subtract && !divide) {
     PyErr_Format(PyExc_RuntimeError, "`%s' requires you provide both `subtract' and `divide' or neither, but you provided only `subtract'", Py_TYPE(self)->tp_name);
     return 0;
@@ -664,31 +1030,85 @@ static PyObject* PyBobLearnLibsvmTrainer_train
 
   if (subtract && subtract->type_num != NPY_FLOAT64) {
     PyErr_Format(PyExc_TypeError, "`%s' only supports 64-bit float arrays for input array `subtract'", Py_TYPE(self)->tp_name);
+    return 0;
   }
 
   if (divide && divide->type_num != NPY_FLOAT64) {
     PyErr_Format(PyExc_TypeError, "`%s' only supports 64-bit float arrays for input array `divide'", Py_TYPE(self)->tp_name);
+    return 0;
   }
 
+  return 1;
+}
+
+static PyObject* PyBobLearnLibsvmTrainer_train
+(PyBobLearnLibsvmTrainerObject* self, PyObject* args, PyObject* kwds) {
+
+  static const char* const_kwlist[] = {"data", "subtract", "divide",
+    "previous", "threads", 0};
+  static char** kwlist = const_cast<char**>(const_kwlist);
+
+  PyObject* X = 0;
+  PyBlitzArrayObject* subtract = 0;
+  PyBlitzArrayObject* divide = 0;
+  PyBobLearnLibsvmMachineObject* previous = 0;
+  Py_ssize_t threads = 1;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|O&O&O!n", kwlist,
+        &X,
+        &PyBlitzArray_OutputConverter, &subtract,
+        &PyBlitzArray_OutputConverter, &divide,
+        &PyBobLearnLibsvmMachine_Type, &previous,
+        &threads
+        )) return 0;
+
+  //protects acquired resources through this scope
+  auto X_ = make_safe(X);
+  auto subtract_ = make_xsafe(subtract);
+  auto divide_ = make_xsafe(divide);
+
+  /* Checks and converts all entries */
+  training_data data;
+  if (!convert_data(self, X, data)) return 0;
+  if (!check_scaling(self, subtract, divide)) return 0;
+
+  if (previous && subtract) {
+    PyErr_Format(PyExc_RuntimeError, "`%s' scales data like the `previous' machine when retraining, so you cannot provide `subtract' and `divide'", Py_TYPE(self)->tp_name);
+    return 0;
+  }
+
+  if (threads < 0) {
+    PyErr_Format(PyExc_ValueError, "`%s' requires a non-negative number of `threads' (or zero, to use all available cores), not %" PY_FORMAT_SIZE_T "d", Py_TYPE(self)->tp_name, threads);
+    return 0;
+  }
+
+  std::vector<blitz::Array<double,2> >& Xseq = data.dense;
+  std::vector<bob::learn::libsvm::SparseMatrix>& Sseq = data.sparse;
+
   /** all basic checks are done, can call the machine now **/
 
   //std::cout << "all basic checks are done, can call the machine now..."  << std::endl;
   try {
     bob::learn::libsvm::Machine* machine;
     
-    if(self->cxx->getMachineType()==bob::learn::libsvm::machine_t::ONE_CLASS)
     {
-       if (subtract && divide) machine = self->cxx->train(Xseq,*PyBlitzArrayCxx_AsBlitz<double,1>(subtract),*PyBlitzArrayCxx_AsBlitz<double,1>(divide));
-       else  machine = self->cxx->train(Xseq);   
-    }
-    else { 
-      if (subtract && divide) machine = self->cxx->train(Xseq,*PyBlitzArrayCxx_AsBlitz<double,1>(subtract),*PyBlitzArrayCxx_AsBlitz<double,1>(divide));
-      else machine = self->cxx->train(Xseq);
+      // training may take long; let other Python threads run meanwhile
+      PyBobLearnLibsvmNoGIL nogil;
+      if (previous) {
+        if (Sseq.size()) machine = self->cxx->train(Sseq, *previous->cxx, threads);
+        else machine = self->cxx->train(Xseq, *previous->cxx, threads);
+      }
+      else if (Sseq.size()) {
+        if (subtract && divide) machine = self->cxx->train(Sseq,*PyBlitzArrayCxx_AsBlitz<double,1>(subtract),*PyBlitzArrayCxx_AsBlitz<double,1>(divide), threads);
+        else machine = self->cxx->train(Sseq, threads);
+      }
+      else if (subtract && divide) machine = self->cxx->train(Xseq,*PyBlitzArrayCxx_AsBlitz<double,1>(subtract),*PyBlitzArrayCxx_AsBlitz<double,1>(divide), threads);
+      else machine = self->cxx->train(Xseq, threads);
     }
     return PyBobLearnLibsvmMachine_NewFromMachine(machine);
   }
   catch (std::exception& e) {
-    PyErr_SetString(PyExc_RuntimeError, e.what());
+    set_training_error(self, e.what());
     return 0;
   }
   catch (...) {
@@ -700,6 +1120,499 @@ static PyObject* PyBobLearnLibsvmTrainer_train
   return 0;
 }
 
+PyDoc_STRVAR(s_train_one_vs_rest_str, "train_one_vs_rest");
+PyDoc_STRVAR(s_train_one_vs_rest_doc,
+"o.train_one_vs_rest(data, [subtract, divide, [threads=1]]) -> OneVsRestMachine\n\
+\n\
+Trains a new :py:class:`OneVsRestMachine` for multi-class\n\
+classification: one binary machine per class in ``data``, that\n\
+separates it from all other classes, instead of one per pair of\n\
+classes, like :py:meth:`train` does. Prediction costs, therefore,\n\
+only grow linearly with the number of classes. Labels are\n\
+assigned like for :py:meth:`train` and ``data``, ``subtract``\n\
+and ``divide`` are the same.\n\
+\n\
+The training problem is built once and binary machines are\n\
+trained on up to ``threads`` threads (zero means one per core),\n\
+that split the kernel cache evenly. Only ``'C_SVC'`` and\n\
+``'NU_SVC'`` machines may be trained this way. The Python\n\
+global interpreter lock is released while training.\n\
+\n\
+");
+
+static PyObject* PyBobLearnLibsvmTrainer_train_one_vs_rest
+(PyBobLearnLibsvmTrainerObject* self, PyObject* args, PyObject* kwds) {
+
+  static const char* const_kwlist[] = {"data", "subtract", "divide",
+    "threads", 0};
+  static char** kwlist = const_cast<char**>(const_kwlist);
+
+  PyObject* X = 0;
+  PyBlitzArrayObject* subtract = 0;
+  PyBlitzArrayObject* divide = 0;
+  Py_ssize_t threads = 1;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|O&O&n", kwlist,
+        &X,
+        &PyBlitzArray_OutputConverter, &subtract,
+        &PyBlitzArray_OutputConverter, &divide,
+        &threads
+        )) return 0;
+
+  //protects acquired resources through this scope
+  auto subtract_ = make_xsafe(subtract);
+  auto divide_ = make_xsafe(divide);
+
+  training_data data;
+  if (!convert_data(self, X, data)) return 0;
+  if (!check_scaling(self, subtract, divide)) return 0;
+
+  if (threads < 0) {
+    PyErr_Format(PyExc_ValueError, "`%s' requires a non-negative number of `threads' (or zero, to use all available cores), not %" PY_FORMAT_SIZE_T "d", Py_TYPE(self)->tp_name, threads);
+    return 0;
+  }
+
+  std::vector<blitz::Array<double,2> >& Xseq = data.dense;
+  std::vector<bob::learn::libsvm::SparseMatrix>& Sseq = data.sparse;
+
+  try {
+    bob::learn::libsvm::OneVsRestMachine* machine;
+
+    {
+      // training may take long; let other Python threads run meanwhile
+      PyBobLearnLibsvmNoGIL nogil;
+      if (Sseq.size()) {
+        if (subtract && divide) machine = self->cxx->trainOneVsRest(Sseq, *PyBlitzArrayCxx_AsBlitz<double,1>(subtract), *PyBlitzArrayCxx_AsBlitz<double,1>(divide), threads);
+        else machine = self->cxx->trainOneVsRest(Sseq, threads);
+      }
+      else if (subtract && divide) machine = self->cxx->trainOneVsRest(Xseq, *PyBlitzArrayCxx_AsBlitz<double,1>(subtract), *PyBlitzArrayCxx_AsBlitz<double,1>(divide), threads);
+      else machine = self->cxx->trainOneVsRest(Xseq, threads);
+    }
+    return PyBobLearnLibsvmOneVsRestMachine_NewFromMachine(machine);
+  }
+  catch (std::exception& e) {
+    set_training_error(self, e.what());
+    return 0;
+  }
+  catch (...) {
+    PyErr_Format(PyExc_RuntimeError, "%s cannot train: unknown exception caught", Py_TYPE(self)->tp_name);
+    return 0;
+  }
+
+}
+
+PyDoc_STRVAR(s_train_approximate_str, "train_approximate");
+PyDoc_STRVAR(s_train_approximate_doc,
+"o.train_approximate(data, [subtract, divide], [approximation='FOURIER', [components=1000, [seed=0, [threads=1]]]]) -> ApproximateMachine\n\
+\n\
+Trains a new :py:class:`ApproximateMachine`: a linear classifier\n\
+on an explicit map of the samples, whose dot products approximate\n\
+the RBF kernel of this trainer. Training costs grow linearly with\n\
+the number of samples, instead of quadratically for\n\
+:py:meth:`train`, which makes much larger problems tractable, and\n\
+prediction costs depend on the number of ``components`` of the\n\
+map, instead of the number of support vectors.\n\
+\n\
+The ``approximation`` may be ``'FOURIER'``, for random Fourier\n\
+features, or ``'NYSTROM'``, for the Nyström method, on\n\
+``components`` landmarks picked among the training samples (or\n\
+all of them, if there are fewer). Both are drawn from a random\n\
+generator initialized with ``seed``. More components give better\n\
+approximations, at a higher cost.\n\
+\n\
+Only ``'C_SVC'`` trainers with ``'RBF'`` kernels may be used.\n\
+:py:attr:`cost` and :py:attr:`gamma` are used as for\n\
+:py:meth:`train`, as is the default for a gamma of zero. Linear\n\
+problems are solved by dual coordinate descent, until the gap\n\
+between projected gradients is under :py:attr:`stop_epsilon`, but\n\
+never under 0.1. Labels are assigned like for :py:meth:`train`: 2\n\
+classes are separated by a single linear function, more get one\n\
+function per class, one-vs-rest.\n\
+\n\
+``data``, ``subtract`` and ``divide`` are like for\n\
+:py:meth:`train`, but sparse matrices are not supported. Samples\n\
+are mapped on up to ``threads`` threads (zero means one per\n\
+core), which then solve the linear functions concurrently. The\n\
+results do not depend on the number of threads. The Python global\n\
+interpreter lock is released while training.\n\
+\n\
+:py:attr:`progress`, :py:attr:`time_limit` and\n\
+:py:attr:`collect_statistics` apply as for :py:meth:`train`, each\n\
+linear function being a problem. Cancelled trainings stop after\n\
+the current pass over the samples.\n\
+\n\
+");
+
+static PyObject* PyBobLearnLibsvmTrainer_train_approximate
+(PyBobLearnLibsvmTrainerObject* self, PyObject* args, PyObject* kwds) {
+
+  static const char* const_kwlist[] = {"data", "subtract", "divide",
+    "approximation", "components", "seed", "threads", 0};
+  static char** kwlist = const_cast<char**>(const_kwlist);
+
+  PyObject* X = 0;
+  PyBlitzArrayObject* subtract = 0;
+  PyBlitzArrayObject* divide = 0;
+  const char* approximation = "FOURIER";
+  Py_ssize_t components = 1000;
+  unsigned int seed = 0;
+  Py_ssize_t threads = 1;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|O&O&snIn", kwlist,
+        &X,
+        &PyBlitzArray_OutputConverter, &subtract,
+        &PyBlitzArray_OutputConverter, &divide,
+        &approximation, &components, &seed, &threads
+        )) return 0;
+
+  //protects acquired resources through this scope
+  auto subtract_ = make_xsafe(subtract);
+  auto divide_ = make_xsafe(divide);
+
+  training_data data;
+  if (!convert_data(self, X, data)) return 0;
+  if (!check_scaling(self, subtract, divide)) return 0;
+
+  if (data.sparse.size()) {
+    PyErr_Format(PyExc_TypeError, "`%s' cannot train approximate machines on sparse matrices - densify them first", Py_TYPE(self)->tp_name);
+    return 0;
+  }
+
+  auto c_approximation = PyBobLearnLibsvm_CStringAsApproximation(approximation);
+  if (PyErr_Occurred()) return 0;
+
+  if (components <= 0) {
+    PyErr_Format(PyExc_ValueError, "`%s' requires a positive number of `components', not %" PY_FORMAT_SIZE_T "d", Py_TYPE(self)->tp_name, components);
+    return 0;
+  }
+
+  if (threads < 0) {
+    PyErr_Format(PyExc_ValueError, "`%s' requires a non-negative number of `threads' (or zero, to use all available cores), not %" PY_FORMAT_SIZE_T "d", Py_TYPE(self)->tp_name, threads);
+    return 0;
+  }
+
+  std::vector<blitz::Array<double,2> >& Xseq = data.dense;
+
+  try {
+    bob::learn::libsvm::ApproximateMachine* machine;
+
+    {
+      // training may take long; let other Python threads run meanwhile
+      PyBobLearnLibsvmNoGIL nogil;
+      if (subtract && divide) machine = self->cxx->trainApproximate(Xseq, *PyBlitzArrayCxx_AsBlitz<double,1>(subtract), *PyBlitzArrayCxx_AsBlitz<double,1>(divide), c_approximation, components, seed, threads);
+      else machine = self->cxx->trainApproximate(Xseq, c_approximation, components, seed, threads);
+    }
+    return PyBobLearnLibsvmApproximateMachine_NewFromMachine(machine);
+  }
+  catch (std::exception& e) {
+    set_training_error(self, e.what());
+    return 0;
+  }
+  catch (...) {
+    PyErr_Format(PyExc_RuntimeError, "%s cannot train: unknown exception caught", Py_TYPE(self)->tp_name);
+    return 0;
+  }
+
+}
+
+/**
+ * Converts an iterable of numbers into ``values``. Returns 0, with a Python
+ * exception set, on errors.
+ */
+static int convert_values(PyBobLearnLibsvmTrainerObject* self, PyObject* o,
+    const char* name, std::vector<double>& values) {
+
+  PyObject* seq = PySequence_Fast(o, "");
+  if (!seq) {
+    PyErr_Format(PyExc_TypeError, "`%s' requires an iterable of numbers for parameter `%s', but you passed `%s'", Py_TYPE(self)->tp_name, name, Py_TYPE(o)->tp_name);
+    return 0;
+  }
+  auto seq_ = make_safe(seq);
+
+  Py_ssize_t size = PySequence_Fast_GET_SIZE(seq);
+  if (!size) {
+    PyErr_Format(PyExc_RuntimeError, "`%s' requires, at least, one value for parameter `%s'", Py_TYPE(self)->tp_name, name);
+    return 0;
+  }
+
+  values.resize(size);
+  for (Py_ssize_t k=0; k<size; ++k) {
+    values[k] = PyFloat_AsDouble(PySequence_Fast_GET_ITEM(seq, k));
+    if (PyErr_Occurred()) return 0;
+  }
+
+  return 1;
+}
+
+/**
+ * Runs a grid search with the given parameters, returns 0, with a Python
+ * exception set, on errors
+ */
+static int grid_search(PyBobLearnLibsvmTrainerObject* self,
+    const training_data& data, PyBlitzArrayObject* subtract,
+    PyBlitzArrayObject* divide, Py_ssize_t folds,
+    const std::vector<double>& costs, const std::vector<double>& gammas,
+    Py_ssize_t threads, bob::learn::libsvm::GridSearchResults& results) {
+
+  if (folds < 2) {
+    PyErr_Format(PyExc_ValueError, "`%s' requires, at least, 2 `folds' for cross-validation, not %" PY_FORMAT_SIZE_T "d", Py_TYPE(self)->tp_name, folds);
+    return 0;
+  }
+
+  if (threads < 0) {
+    PyErr_Format(PyExc_ValueError, "`%s' requires a non-negative number of `threads' (or zero, to use all available cores), not %" PY_FORMAT_SIZE_T "d", Py_TYPE(self)->tp_name, threads);
+    return 0;
+  }
+
+  try {
+    // searches may take long; let other Python threads run meanwhile
+    PyBobLearnLibsvmNoGIL nogil;
+    size_t n_features = data.sparse.size() ? data.sparse[0].columns() :
+      data.dense[0].extent(1);
+    blitz::Array<double,1> sub(n_features);
+    sub = 0.;
+    blitz::Array<double,1> div(n_features);
+    div = 1.;
+    if (subtract && divide) {
+      sub.reference(*PyBlitzArrayCxx_AsBlitz<double,1>(subtract));
+      div.reference(*PyBlitzArrayCxx_AsBlitz<double,1>(divide));
+    }
+    if (data.sparse.size())
+      results = self->cxx->gridSearch(data.sparse, sub, div, folds, costs,
+          gammas, threads);
+    else
+      results = self->cxx->gridSearch(data.dense, sub, div, folds, costs,
+          gammas, threads);
+  }
+  catch (std::exception& e) {
+    set_training_error(self, e.what());
+    return 0;
+  }
+  catch (...) {
+    PyErr_Format(PyExc_RuntimeError, "%s cannot cross-validate: unknown exception caught", Py_TYPE(self)->tp_name);
+    return 0;
+  }
+
+  return 1;
+}
+
+/**
+ * Returns a new array with a copy of ``a``, or 0 with a Python exception set
+ */
+static PyObject* copy_array(const blitz::Array<double,2>& a) {
+  Py_ssize_t shape[2] = {a.extent(0), a.extent(1)};
+  PyObject* retval = PyBlitzArray_SimpleNew(NPY_FLOAT64, 2, shape);
+  if (!retval) return 0;
+  *PyBlitzArrayCxx_AsBlitz<double,2>(reinterpret_cast<PyBlitzArrayObject*>(retval)) = a;
+  return retval;
+}
+
+PyDoc_STRVAR(s_grid_search_str, "grid_search");
+PyDoc_STRVAR(s_grid_search_doc,
+"o.grid_search(data, costs, gammas, [folds=5, [subtract, [divide, [threads=1]]]]) -> (array, array, array)\n\
+\n\
+Evaluates, by ``folds``-fold cross-validation, machines trained\n\
+with every combination of the values in ``costs`` and ``gammas``\n\
+(iterables of numbers). A gamma of zero stands for the default,\n\
+one over the number of features. All other parameters are taken\n\
+from this trainer, and ``data``, ``subtract`` and ``divide`` are\n\
+the same as for :py:meth:`train`.\n\
+\n\
+Returns a tuple ``(accuracy, mse, seconds)`` of 2D 64-bit float\n\
+arrays with one row per cost and one column per gamma value,\n\
+containing the fraction of held-out samples whose label was\n\
+predicted right (relevant for classification), the mean squared\n\
+error of the predictions (relevant for regression) and the time\n\
+spent training and testing all folds.\n\
+\n\
+The training problem is built a single time and shared by all\n\
+folds, which are stratified: the samples of each class are\n\
+assigned to folds in a round-robin fashion. Every pair of\n\
+grid cell and fold is trained on a separate task, run on up\n\
+to ``threads`` threads (zero means one per core). Each task\n\
+allocates its own kernel cache, of :py:attr:`cache_size`\n\
+megabytes. The Python global interpreter lock is released\n\
+while the search runs.\n\
+\n\
+");
+
+static PyObject* PyBobLearnLibsvmTrainer_grid_search
+(PyBobLearnLibsvmTrainerObject* self, PyObject* args, PyObject* kwds) {
+
+  static const char* const_kwlist[] = {"data", "costs", "gammas", "folds",
+    "subtract", "divide", "threads", 0};
+  static char** kwlist = const_cast<char**>(const_kwlist);
+
+  PyObject* X = 0;
+  PyObject* C = 0;
+  PyObject* G = 0;
+  Py_ssize_t folds = 5;
+  PyBlitzArrayObject* subtract = 0;
+  PyBlitzArrayObject* divide = 0;
+  Py_ssize_t threads = 1;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "OOO|nO&O&n", kwlist,
+        &X, &C, &G, &folds,
+        &PyBlitzArray_OutputConverter, &subtract,
+        &PyBlitzArray_OutputConverter, &divide,
+        &threads
+        )) return 0;
+
+  //protects acquired resources through this scope
+  auto subtract_ = make_xsafe(subtract);
+  auto divide_ = make_xsafe(divide);
+
+  training_data data;
+  if (!convert_data(self, X, data)) return 0;
+  if (!check_scaling(self, subtract, divide)) return 0;
+
+  std::vector<double> costs, gammas;
+  if (!convert_values(self, C, "costs", costs)) return 0;
+  if (!convert_values(self, G, "gammas", gammas)) return 0;
+
+  bob::learn::libsvm::GridSearchResults results;
+  if (!grid_search(self, data, subtract, divide, folds, costs, gammas,
+        threads, results)) return 0;
+
+  PyObject* accuracy = copy_array(results.accuracy);
+  if (!accuracy) return 0;
+  auto accuracy_ = make_safe(accuracy);
+  PyObject* mse = copy_array(results.mse);
+  if (!mse) return 0;
+  auto mse_ = make_safe(mse);
+  PyObject* seconds = copy_array(results.seconds);
+  if (!seconds) return 0;
+  auto seconds_ = make_safe(seconds);
+
+  Py_INCREF(accuracy);
+  Py_INCREF(mse);
+  Py_INCREF(seconds);
+  return Py_BuildValue("OOO",
+      PyBlitzArray_NUMPY_WRAP(accuracy),
+      PyBlitzArray_NUMPY_WRAP(mse),
+      PyBlitzArray_NUMPY_WRAP(seconds)
+      );
+
+}
+
+PyDoc_STRVAR(s_cross_validate_str, "cross_validate");
+PyDoc_STRVAR(s_cross_validate_doc,
+"o.cross_validate(data, [folds=5, [subtract, [divide, [threads=1]]]]) -> (float, float, float)\n\
+\n\
+Evaluates, by ``folds``-fold cross-validation, machines trained\n\
+with the current parameters of this trainer. Returns a tuple\n\
+``(accuracy, mse, seconds)``, like a :py:meth:`grid_search` with\n\
+a single cost and gamma value, :py:attr:`cost` and\n\
+:py:attr:`gamma`.\n\
+\n\
+");
+
+static PyObject* PyBobLearnLibsvmTrainer_cross_validate
+(PyBobLearnLibsvmTrainerObject* self, PyObject* args, PyObject* kwds) {
+
+  static const char* const_kwlist[] = {"data", "folds", "subtract",
+    "divide", "threads", 0};
+  static char** kwlist = const_cast<char**>(const_kwlist);
+
+  PyObject* X = 0;
+  Py_ssize_t folds = 5;
+  PyBlitzArrayObject* subtract = 0;
+  PyBlitzArrayObject* divide = 0;
+  Py_ssize_t threads = 1;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|nO&O&n", kwlist,
+        &X, &folds,
+        &PyBlitzArray_OutputConverter, &subtract,
+        &PyBlitzArray_OutputConverter, &divide,
+        &threads
+        )) return 0;
+
+  //protects acquired resources through this scope
+  auto subtract_ = make_xsafe(subtract);
+  auto divide_ = make_xsafe(divide);
+
+  training_data data;
+  if (!convert_data(self, X, data)) return 0;
+  if (!check_scaling(self, subtract, divide)) return 0;
+
+  std::vector<double> costs(1, self->cxx->getCost());
+  std::vector<double> gammas(1, self->cxx->getGamma());
+
+  bob::learn::libsvm::GridSearchResults results;
+  if (!grid_search(self, data, subtract, divide, folds, costs, gammas,
+        threads, results)) return 0;
+
+  return Py_BuildValue("ddd", results.accuracy(0,0), results.mse(0,0),
+      results.seconds(0,0));
+
+}
+
+PyDoc_STRVAR(s_statistics_str, "statistics");
+PyDoc_STRVAR(s_statistics_doc,
+"o.statistics() -> dict\n\
+\n\
+Returns the counters on the trainings of this trainer, since\n\
+:py:attr:`collect_statistics` was set or since the last call to\n\
+:py:meth:`reset_statistics`, which are all zero if counters are\n\
+off. Keys are:\n\
+\n\
+``trainings``\n\
+  calls to :py:meth:`train`, :py:meth:`train_one_vs_rest`,\n\
+  :py:meth:`train_approximate`, :py:meth:`grid_search` and\n\
+  :py:meth:`cross_validate`\n\
+``problems``\n\
+  optimization problems solved (e.g. one per pair of classes when\n\
+  training with several threads, one per cell and fold of a grid\n\
+  search, one per linear function of an approximate training)\n\
+``iterations``, ``reconstructions``\n\
+  SMO iterations (coordinate descent steps, for approximate\n\
+  trainings) and gradient reconstructions (when shrinking), over\n\
+  all problems, as reported by libsvm\n\
+``iteration_blocks``\n\
+  blocks of SMO iterations reported by libsvm while solving, one\n\
+  every 1000 iterations (or every as many iterations as there are\n\
+  samples, if less), whether shrinking is on or not\n\
+``kernel_hits``, ``kernel_misses``\n\
+  kernel matrices found in, or computed for, the shared kernel\n\
+  cache (see :py:attr:`shared_cache_size`). libsvm does not report\n\
+  on its own, internal, cache.\n\
+``build``, ``solve``\n\
+  seconds spent building problems from the data and solving\n\
+  them, the latter summed over all threads\n\
+\n\
+");
+
+static PyObject* PyBobLearnLibsvmTrainer_Statistics
+(PyBobLearnLibsvmTrainerObject* self) {
+
+  bob::learn::libsvm::TrainingStatistics s = self->cxx->getStatistics();
+
+  return Py_BuildValue("{s:K,s:K,s:K,s:K,s:K,s:K,s:K,s:d,s:d}",
+      "trainings", (unsigned long long)s.trainings,
+      "problems", (unsigned long long)s.problems,
+      "iterations", (unsigned long long)s.iterations,
+      "iteration_blocks", (unsigned long long)s.iteration_blocks,
+      "reconstructions", (unsigned long long)s.reconstructions,
+      "kernel_hits", (unsigned long long)s.kernel_hits,
+      "kernel_misses", (unsigned long long)s.kernel_misses,
+      "build", s.build,
+      "solve", s.solve);
+
+}
+
+PyDoc_STRVAR(s_reset_statistics_str, "reset_statistics");
+PyDoc_STRVAR(s_reset_statistics_doc,
+"o.reset_statistics() -> None\n\
+\n\
+Sets all counters returned by :py:meth:`statistics` back to zero.\n\
+");
+
+static PyObject* PyBobLearnLibsvmTrainer_ResetStatistics
+(PyBobLearnLibsvmTrainerObject* self) {
+  self->cxx->resetStatistics();
+  Py_RETURN_NONE;
+}
+
 static PyMethodDef PyBobLearnLibsvmTrainer_methods[] = {
   {
     s_train_str,
@@ -707,6 +1620,42 @@ static PyMethodDef PyBobLearnLibsvmTrainer_methods[] = {
     METH_VARARGS|METH_KEYWORDS,
     s_train_doc
   },
+  {
+    s_train_one_vs_rest_str,
+    (PyCFunction)PyBobLearnLibsvmTrainer_train_one_vs_rest,
+    METH_VARARGS|METH_KEYWORDS,
+    s_train_one_vs_rest_doc
+  },
+  {
+    s_train_approximate_str,
+    (PyCFunction)PyBobLearnLibsvmTrainer_train_approximate,
+    METH_VARARGS|METH_KEYWORDS,
+    s_train_approximate_doc
+  },
+  {
+    s_grid_search_str,
+    (PyCFunction)PyBobLearnLibsvmTrainer_grid_search,
+    METH_VARARGS|METH_KEYWORDS,
+    s_grid_search_doc
+  },
+  {
+    s_cross_validate_str,
+    (PyCFunction)PyBobLearnLibsvmTrainer_cross_validate,
+    METH_VARARGS|METH_KEYWORDS,
+    s_cross_validate_doc
+  },
+  {
+    s_statistics_str,
+    (PyCFunction)PyBobLearnLibsvmTrainer_Statistics,
+    METH_NOARGS,
+    s_statistics_doc
+  },
+  {
+    s_reset_statistics_str,
+    (PyCFunction)PyBobLearnLibsvmTrainer_ResetStatistics,
+    METH_NOARGS,
+    s_reset_statistics_doc
+  },
   {0} /* Sentinel */
 };
 
@@ -8,6 +8,7 @@
  */
 
 #define BOB_LEARN_LIBSVM_MODULE
+#include <bob.blitz/cppapi.h>
 #include <bob.blitz/cleanup.h>
 #include <bob.learn.libsvm/api.h>
 
@@ -128,3 +129,124 @@ bob::learn::libsvm::kernel_t PyBobLearnLibsvm_CStringAsKernelType(const char* s)
   return (bob::learn::libsvm::kernel_t)(-1);
 
 }
+
+PyObject* PyBobLearnLibsvm_ApproximationAsString(bob::learn::libsvm::approximation_t s) {
+  switch(s) {
+    case bob::learn::libsvm::FOURIER:
+      return Py_BuildValue("s", "FOURIER");
+    case bob::learn::libsvm::NYSTROM:
+      return Py_BuildValue("s", "NYSTROM");
+    default:
+      PyErr_Format(PyExc_AssertionError, "illegal kernel approximation (%d) - DEBUG ME", s);
+      return 0;
+  }
+}
+
+bob::learn::libsvm::approximation_t PyBobLearnLibsvm_CStringAsApproximation(const char* s) {
+
+  static const char* available = "`FOURIER' or `NYSTROM'";
+
+  std::string s_(s);
+
+  if (s_ == "FOURIER") {
+    return bob::learn::libsvm::FOURIER;
+  }
+  else if (s_ == "NYSTROM") {
+    return bob::learn::libsvm::NYSTROM;
+  }
+
+  PyErr_Format(PyExc_ValueError, "kernel approximation `%s' is not supported by these bindings - choose from %s", s, available);
+  return (bob::learn::libsvm::approximation_t)(-1);
+
+}
+
+int PyBobLearnLibsvm_IsSparse(PyObject* o) {
+  return PyObject_HasAttrString(o, "indptr") &&
+    PyObject_HasAttrString(o, "indices") &&
+    PyObject_HasAttrString(o, "data") && PyObject_HasAttrString(o, "shape");
+}
+
+/**
+ * Converts attribute ``name`` of ``o`` into a 1D array of the given type,
+ * casting it with ``astype()`` if needed. Returns a new reference.
+ */
+static PyBlitzArrayObject* sparse_attribute(PyObject* o, const char* name,
+    int type_num, const char* type_name) {
+
+  PyObject* attr = PyObject_GetAttrString(o, name);
+  if (!attr) return 0;
+  auto attr_ = make_safe(attr);
+
+  PyBlitzArrayObject* bz = 0;
+  if (!PyBlitzArray_Converter(attr, &bz)) return 0;
+
+  if (bz->type_num != type_num) {
+    Py_DECREF(bz);
+    bz = 0;
+    PyObject* cast = PyObject_CallMethod(attr, const_cast<char*>("astype"),
+        const_cast<char*>("s"), type_name);
+    if (!cast) return 0;
+    auto cast_ = make_safe(cast);
+    if (!PyBlitzArray_Converter(cast, &bz)) return 0;
+  }
+
+  if (bz->ndim != 1 || bz->type_num != type_num) {
+    PyErr_Format(PyExc_TypeError, "attribute `%s' of sparse matrices should be a 1D array of type `%s', but I have found a %" PY_FORMAT_SIZE_T "dD array of type `%s'", name, type_name, bz->ndim, PyBlitzArray_TypenumAsString(bz->type_num));
+    Py_DECREF(bz);
+    return 0;
+  }
+
+  return bz;
+
+}
+
+boost::shared_ptr<bob::learn::libsvm::SparseMatrix>
+PyBobLearnLibsvm_AsSparse(PyObject* o) {
+
+  boost::shared_ptr<bob::learn::libsvm::SparseMatrix> retval;
+
+  PyObject* shape = PyObject_GetAttrString(o, "shape");
+  if (!shape) return retval;
+  auto shape_ = make_safe(shape);
+  Py_ssize_t rows = 0, columns = 0;
+  if (!PyArg_ParseTuple(shape, "nn", &rows, &columns)) return retval;
+  if (rows < 0 || columns < 0) {
+    PyErr_Format(PyExc_ValueError, "sparse matrices cannot have a negative shape, such as (%" PY_FORMAT_SIZE_T "d, %" PY_FORMAT_SIZE_T "d)", rows, columns);
+    return retval;
+  }
+
+  PyBlitzArrayObject* indptr = sparse_attribute(o, "indptr", NPY_INT64, "int64");
+  if (!indptr) return retval;
+  auto indptr_ = make_safe(indptr);
+  PyBlitzArrayObject* indices = sparse_attribute(o, "indices", NPY_INT64, "int64");
+  if (!indices) return retval;
+  auto indices_ = make_safe(indices);
+  PyBlitzArrayObject* data = sparse_attribute(o, "data", NPY_FLOAT64, "float64");
+  if (!data) return retval;
+  auto data_ = make_safe(data);
+
+  if (indptr->shape[0] != rows + 1) {
+    PyErr_Format(PyExc_ValueError, "sparse matrix with %" PY_FORMAT_SIZE_T "d rows should have %" PY_FORMAT_SIZE_T "d row pointers, not %" PY_FORMAT_SIZE_T "d", rows, rows+1, indptr->shape[0]);
+    return retval;
+  }
+
+  try {
+    //the arrays are released together with the matrix that references them
+    retval.reset(new bob::learn::libsvm::SparseMatrix(
+          *PyBlitzArrayCxx_AsBlitz<int64_t,1>(indptr),
+          *PyBlitzArrayCxx_AsBlitz<int64_t,1>(indices),
+          *PyBlitzArrayCxx_AsBlitz<double,1>(data), columns),
+        [indptr_, indices_, data_](bob::learn::libsvm::SparseMatrix* m) {
+          delete m;
+        });
+  }
+  catch (std::exception& e) {
+    PyErr_SetString(PyExc_ValueError, e.what());
+  }
+  catch (...) {
+    PyErr_SetString(PyExc_RuntimeError, "cannot convert sparse matrix: unknown exception caught");
+  }
+
+  return retval;
+
+}
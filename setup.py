@@ -9,6 +9,7 @@ from setuptools import setup, find_packages, dist
 dist.Distribution(dict(setup_requires=['bob.extension', 'bob.blitz'] + bob_packages))
 from bob.extension.utils import egrep, find_header, find_library
 from bob.blitz.extension import Extension, Library, build_ext
+from bob.extension import Executable
 
 from bob.extension.utils import load_requirements
 build_requires = load_requirements()
@@ -17,7 +18,7 @@ build_requires = load_requirements()
 version = open("version.txt").read().rstrip()
 
 packages = ['boost']
-boost_modules = ['system', 'filesystem']
+boost_modules = ['system', 'filesystem', 'thread']
 
 # process libsvm requirement
 import os
@@ -192,6 +193,21 @@ setup(
         [
           "bob/learn/libsvm/cpp/file.cpp",
           "bob/learn/libsvm/cpp/machine.cpp",
+          "bob/learn/libsvm/cpp/pickle.cpp",
+          "bob/learn/libsvm/cpp/binary.cpp",
+          "bob/learn/libsvm/cpp/engine.cpp",
+          "bob/learn/libsvm/cpp/probability.cpp",
+          "bob/learn/libsvm/cpp/memory.cpp",
+          "bob/learn/libsvm/cpp/sparse.cpp",
+          "bob/learn/libsvm/cpp/multiclass.cpp",
+          "bob/learn/libsvm/cpp/kernel_cache.cpp",
+          "bob/learn/libsvm/cpp/prediction_cache.cpp",
+          "bob/learn/libsvm/cpp/approximate.cpp",
+          "bob/learn/libsvm/cpp/ensemble.cpp",
+          "bob/learn/libsvm/cpp/compress.cpp",
+          "bob/learn/libsvm/cpp/stats.cpp",
+          "bob/learn/libsvm/cpp/progress.cpp",
+          "bob/learn/libsvm/cpp/server.cpp",
           "bob/learn/libsvm/cpp/trainer.cpp",
         ],
         bob_packages = bob_packages,
@@ -204,12 +220,32 @@ setup(
         boost_modules = boost_modules,
       ),
 
+      # times predictions, training and I/O on synthetic data: run it with
+      # --help for options, results are printed as JSON lines
+      Executable("bob_learn_libsvm_benchmark.exe",
+        [
+          "bob/learn/libsvm/benchmark/main.cpp",
+        ],
+        bob_packages = bob_packages,
+        version = version,
+        system_include_dirs = system_include_dirs,
+        define_macros = define_macros,
+        library_dirs = library_dirs,
+        libraries = libraries,
+        packages = packages,
+        boost_modules = boost_modules,
+      ),
+
       Extension("bob.learn.libsvm._library",
         [
           "bob/learn/libsvm/utils.cpp",
           "bob/learn/libsvm/file.cpp",
           "bob/learn/libsvm/machine.cpp",
+          "bob/learn/libsvm/multiclass.cpp",
+          "bob/learn/libsvm/approximate.cpp",
+          "bob/learn/libsvm/ensemble.cpp",
           "bob/learn/libsvm/trainer.cpp",
+          "bob/learn/libsvm/server.cpp",
           "bob/learn/libsvm/main.cpp",
         ],
         bob_packages = bob_packages,